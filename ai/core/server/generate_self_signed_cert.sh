@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# Self-signed certificate to test WSS locally:
+#   TLS_CERT_FILE=certs/server.crt TLS_KEY_FILE=certs/server.key
+# With --ticket-key, also the key shared by the instances to resume the sessions:
+#   TLS_TICKET_KEY_FILE=certs/ticket.key
+
+DEST_DIR="certs"
+DAYS=365
+
+if ! command -v openssl > /dev/null; then
+    echo "[ERROR] ❌ : Failed to find openssl."
+    exit 1
+fi
+
+if [ ! -d "$DEST_DIR" ]; then
+    mkdir -p "$DEST_DIR"
+fi
+
+openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:P-256 -nodes -days "$DAYS" \
+    -keyout "$DEST_DIR/server.key" -out "$DEST_DIR/server.crt" \
+    -subj "/CN=localhost" -addext "subjectAltName=DNS:localhost,IP:127.0.0.1"
+
+if [ $? -eq 0 ]; then
+    echo "[INFO] 💡 : Generated $DEST_DIR/server.crt and $DEST_DIR/server.key"
+else
+    echo "[ERROR] ❌ : Failed to generate the certificate."
+    exit 1
+fi
+
+if [ "$1" == "--ticket-key" ]; then
+    openssl rand -out "$DEST_DIR/ticket.key" 80
+
+    if [ $? -eq 0 ]; then
+        echo "[INFO] 💡 : Generated $DEST_DIR/ticket.key"
+    else
+        echo "[ERROR] ❌ : Failed to generate the ticket key."
+        exit 1
+    fi
+fi
@@ -55,6 +55,16 @@ class ExceptionManager {
                 const char *what() const noexcept override;
         };
 
+        /**
+         * @brief Exception thrown when TLS can't be set up (certificate, key,
+         * ticket key, or a server built without TLS).
+         *
+         */
+        class ServerTlsException : public std::exception {
+            public:
+                const char *what() const noexcept override;
+        };
+
         // Network category
 
         /**
@@ -103,6 +113,43 @@ class ExceptionManager {
                 const char *what() const noexcept override;
         };
 
+        /**
+         * @brief Exception thrown when a binary frame is neither CBOR nor MessagePack.
+         *
+         */
+        class NetworkUnsupportedEncodingException : public std::exception {
+            public:
+                const char *what() const noexcept override;
+        };
+
+        /**
+         * @brief Exception thrown when a message is sent for a stream bound to another connection.
+         *
+         */
+        class NetworkStreamOwnedException : public std::exception {
+            public:
+                const char *what() const noexcept override;
+        };
+
+        /**
+         * @brief Exception thrown when too many utterances are on the way, for the
+         * server or for the connection.
+         *
+         */
+        class NetworkSpeechBusyException : public std::exception {
+            public:
+                const char *what() const noexcept override;
+        };
+
+        /**
+         * @brief Exception thrown when a stream can't be resumed (unknown, expired or bad token).
+         *
+         */
+        class NetworkResumeFailedException : public std::exception {
+            public:
+                const char *what() const noexcept override;
+        };
+
     protected:
     private:
 };
@@ -10,6 +10,7 @@
 
 #include <string>
 #include <iostream>
+#include "ITransport.hpp"
 #include "Router.hpp"
 #include "MicroservicesManager.hpp"
 #include "Notifications.hpp"
@@ -34,11 +35,11 @@ class IServer {
         /**
          * @brief Start the server on a specific port.
          *
-         * @param port
+         * @param transport The HTTP/WebSocket stack serving the routes.
          * @return true
          * @return false
          */
-        virtual bool start_server(crow::SimpleApp &app) = 0;
+        virtual bool start_server(ITransport &transport) = 0;
 
         /**
          * @brief Stop the server.
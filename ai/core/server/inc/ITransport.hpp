@@ -0,0 +1,53 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the ITransport class, which is an interface for the
+** HTTP/WebSocket stack serving the routes of the Router.
+*/
+
+#pragma once
+
+#include <string>
+#include "Router.hpp"
+
+class ITransport {
+    public:
+        /**
+         * @brief Destroy the ITransport object
+         *
+         */
+        virtual ~ITransport() = default;
+
+        /**
+         * @brief Serve the routes of the router on a port, until stop is called.
+         *
+         * @param router The router handling the requests and messages.
+         * @param port
+         * @return true
+         * @return false if the transport couldn't start.
+         */
+        virtual bool run(talkup_network::Router &router, int port) = 0;
+
+        /**
+         * @brief Block until the transport accepts connections.
+         *
+         */
+        virtual void wait_for_start(void) = 0;
+
+        /**
+         * @brief Stop serving. run returns once the connections are closed.
+         *
+         */
+        virtual void stop(void) = 0;
+
+        /**
+         * @brief Get the transport name (e.g. crow).
+         *
+         * @return std::string
+         */
+        virtual std::string get_transport_name(void) const = 0;
+
+    protected:
+    private:
+};
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <thread>
 #include "IServer.hpp"
 
 namespace talkup_network {
@@ -33,11 +35,11 @@ namespace talkup_network {
             /**
              * @brief Start the server on a specific port.
              *
-             * @param port
+             * @param transport The HTTP/WebSocket stack serving the routes.
              * @return true
              * @return false
              */
-            bool start_server(crow::SimpleApp &app) override;
+            bool start_server(ITransport &transport) override;
 
             /**
              * @brief Stop the server.
@@ -86,5 +88,10 @@ namespace talkup_network {
             int __port;
 
             bool __console_notification;
+
+            ITransport *__transport = nullptr;
+
+            std::atomic<bool> __stop_warmup{false};
+            std::thread __warmup_thread;
     };
 }
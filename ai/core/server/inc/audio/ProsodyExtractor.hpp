@@ -0,0 +1,141 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the ProsodyExtractor class, which turns the audio of a
+** stream into delivery features (loudness, pitch, zero-crossing rate, pauses,
+** speaking rate) as it comes, so the analyzers don't need the raw samples.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace talkup_network {
+    class ProsodyExtractor {
+        public:
+            // 16 kHz mono PCM16, one frame every 20 ms, analyzed over the last 40 ms.
+            static constexpr int SAMPLE_RATE = 16000;
+            static constexpr size_t HOP = 320;
+            static constexpr size_t WINDOW = 2 * HOP;
+            static constexpr int64_t FRAME_MS = 20;
+
+            /**
+             * @brief Pitch range and detection thresholds.
+             */
+            struct Options {
+                float min_pitch_hz = 70;
+                float max_pitch_hz = 400;
+                // YIN aperiodicity under which a frame is voiced.
+                float yin_threshold = 0.15f;
+                // Frames under this loudness, or close to the noise floor, are silent.
+                float silence_db = -45;
+                float floor_margin_db = 10;
+                std::chrono::milliseconds min_pause{250};
+            };
+
+            /**
+             * @brief Features of one 20 ms frame.
+             */
+            struct Frame {
+                int64_t start_ms = 0;
+                // Loudness in dBFS, -100 for digital silence.
+                float rms_db = -100;
+                // Fundamental frequency, 0 when the frame isn't voiced.
+                float pitch_hz = 0;
+                // Zero crossings per sample.
+                float zcr = 0;
+                bool voiced = false;
+                bool silent = true;
+            };
+
+            /**
+             * @brief A silence between two stretches of speech.
+             */
+            struct Pause {
+                int64_t start_ms = 0;
+                int64_t duration_ms = 0;
+            };
+
+            /**
+             * @brief What a piece of audio adds to the stream.
+             */
+            struct Features {
+                std::vector<Frame> frames;
+                // The pauses which ended in this piece of audio.
+                std::vector<Pause> pauses;
+                // Syllables per second of speech over the last 10 seconds.
+                double speaking_rate = 0;
+            };
+
+            /**
+             * @brief Construct a new ProsodyExtractor object
+             *
+             */
+            ProsodyExtractor(void);
+
+            /**
+             * @brief Construct a new ProsodyExtractor object
+             *
+             * @param options
+             */
+            ProsodyExtractor(const Options &options);
+
+            /**
+             * @brief Destroy the ProsodyExtractor object
+             *
+             */
+            ~ProsodyExtractor() = default;
+
+            /**
+             * @brief Add the next samples of the stream.
+             * Audio which doesn't fill a frame is kept for the next call.
+             *
+             * @param pcm16 Little-endian 16-bit samples.
+             * @return Features The frames completed by these samples.
+             */
+            Features push(std::string_view pcm16);
+
+            /**
+             * @brief Encode features compactly: one array per feature rather
+             * than one object per frame.
+             *
+             * @param features
+             * @return nlohmann::json
+             */
+            static nlohmann::json to_json(const Features &features);
+
+        protected:
+        private:
+            void __analyze(const float *window, Frame &frame);
+            float __pitch(const float *window);
+            void __track(Frame &frame, Features &features);
+
+            Options __options;
+            std::mutex __mutex;
+            std::vector<float> __samples;
+            std::string __partial;
+            int64_t __position_ms = 0;
+            std::vector<float> __difference;
+            // Pauses and noise floor.
+            float __noise_floor_db = -60;
+            bool __spoken = false;
+            int64_t __silence_start_ms = -1;
+            // Syllable nuclei: loudness peaks of voiced speech, 3 dB above their valleys.
+            bool __rising = true;
+            float __peak_db = -100;
+            bool __peak_voiced = false;
+            float __valley_db = -100;
+            // One entry per frame of the last 10 seconds: bit 0 speech, bit 1 syllable.
+            std::deque<uint8_t> __recent;
+            size_t __recent_speech = 0;
+            size_t __recent_syllables = 0;
+    };
+}
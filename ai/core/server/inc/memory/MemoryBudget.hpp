@@ -0,0 +1,244 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the MemoryBudget class, which accounts for the data the
+** server buffers for its streams against a global cap, and evicts the stalest
+** inactive streams when it is reached.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace talkup_network {
+    class MemoryBudget {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            /**
+             * @brief What the memory is used for.
+             */
+            enum class Pool {
+                // The replay windows of the streams.
+                STREAM_WINDOW,
+                // The audio waiting for a microservice.
+                PENDING_AUDIO,
+            };
+
+            static constexpr size_t POOLS = 2;
+
+            /**
+             * @brief Releases the memory of a stream. Detached streams may be
+             * dropped, the others only lose what they can do without.
+             */
+            using Evictor = std::function<void(const std::string &stream_id, bool detached)>;
+
+            /**
+             * @brief The memory used by the streams of a session, which can
+             * be read without any lock. It outlives the session if its streams do.
+             */
+            using SessionUsage = std::shared_ptr<std::atomic<int64_t>>;
+
+            /**
+             * @brief The global cap, and how long a stream still bound to its
+             * connection has to be idle before its memory is reclaimed.
+             */
+            struct Options {
+                size_t limit = size_t(256) << 20;
+                std::chrono::milliseconds min_idle{30000};
+            };
+
+            /**
+             * @brief Memory reserved for a stream, released when it is destroyed.
+             */
+            class Reservation {
+                public:
+                    Reservation(MemoryBudget &budget, const std::string &stream_id,
+                        Pool pool, size_t bytes);
+                    ~Reservation();
+                    Reservation(const Reservation &) = delete;
+                    Reservation &operator=(const Reservation &) = delete;
+
+                private:
+                    MemoryBudget &__budget;
+                    std::string __stream_id;
+                    Pool __pool;
+                    size_t __bytes;
+            };
+
+            /**
+             * @brief Construct a new MemoryBudget object
+             *
+             */
+            MemoryBudget(void);
+
+            /**
+             * @brief Construct a new MemoryBudget object
+             *
+             * @param options
+             */
+            MemoryBudget(const Options &options);
+
+            /**
+             * @brief Destroy the MemoryBudget object
+             *
+             */
+            ~MemoryBudget() = default;
+
+            MemoryBudget(const MemoryBudget &) = delete;
+            MemoryBudget &operator=(const MemoryBudget &) = delete;
+
+            /**
+             * @brief Set the global cap.
+             *
+             * @param bytes
+             */
+            void set_limit(size_t bytes);
+
+            /**
+             * @brief Set the callback releasing the memory of a stream.
+             * It is called without any lock of the budget held.
+             *
+             * @param evictor
+             */
+            void set_evictor(Evictor evictor);
+
+            /**
+             * @brief Reserve memory for a stream. Over the cap, the stalest
+             * inactive streams are evicted first: the detached ones, then the
+             * ones idle for min_idle.
+             *
+             * @param stream_id The stream ID.
+             * @param pool
+             * @param bytes
+             * @return true if it fits, false if nothing could be evicted.
+             */
+            bool reserve(const std::string &stream_id, Pool pool, size_t bytes);
+
+            /**
+             * @brief Account for memory which can't be refused (e.g. the answer
+             * to a chunk already admitted). It may go over the cap.
+             *
+             * @param stream_id The stream ID.
+             * @param pool
+             * @param bytes
+             */
+            void charge(const std::string &stream_id, Pool pool, size_t bytes);
+
+            /**
+             * @brief Give back memory reserved or charged.
+             *
+             * @param stream_id The stream ID.
+             * @param pool
+             * @param bytes
+             */
+            void release(const std::string &stream_id, Pool pool, size_t bytes);
+
+            /**
+             * @brief Mark a stream detached from its connection (or bound again),
+             * which makes it the first to be evicted.
+             *
+             * @param stream_id The stream ID.
+             * @param detached
+             */
+            void set_detached(const std::string &stream_id, bool detached);
+
+            /**
+             * @brief Forget a stream which is gone. What it still holds stays
+             * accounted until it is released.
+             *
+             * @param stream_id The stream ID.
+             */
+            void forget(const std::string &stream_id);
+
+            /**
+             * @brief Count the memory of a stream in the usage of its session
+             * (e.g. its connection), from now on. What it holds already moves
+             * there from its previous session.
+             *
+             * @param stream_id The stream ID.
+             * @param usage
+             */
+            void bind(const std::string &stream_id, SessionUsage usage);
+
+            /**
+             * @brief Get the memory in use, without taking the lock.
+             *
+             * @return size_t
+             */
+            size_t get_used(void);
+
+            /**
+             * @brief Get the memory in use by a stream.
+             *
+             * @param stream_id The stream ID.
+             * @return size_t
+             */
+            size_t get_used(const std::string &stream_id);
+
+            /**
+             * @brief Get the usage report: cap, use per pool, evictions and
+             * rejections. It takes no lock, so it can be built on every status.
+             *
+             * @return nlohmann::json
+             */
+            nlohmann::json get_report(void);
+
+            /**
+             * @brief Estimate the memory held by a JSON value.
+             *
+             * @param json
+             * @return size_t
+             */
+            static size_t estimate(const nlohmann::json &json);
+
+            /**
+             * @brief Get the name of a pool.
+             *
+             * @param pool
+             * @return std::string
+             */
+            static std::string get_pool_name(Pool pool);
+
+        protected:
+        private:
+            struct __Session {
+                std::array<size_t, POOLS> used{};
+                size_t total = 0;
+                Clock::time_point last_active;
+                bool detached = false;
+                SessionUsage usage;
+            };
+
+            void __account(const std::string &stream_id, Pool pool, size_t bytes);
+            void __publish(void);
+            std::vector<std::pair<std::string, bool>> __get_candidates(Clock::time_point now);
+
+            Options __options;
+            std::mutex __mutex;
+            Evictor __evictor;
+            std::unordered_map<std::string, __Session> __sessions;
+            std::array<size_t, POOLS> __used{};
+            size_t __total = 0;
+            // Copies of the counters above, read without the lock by the reports.
+            std::array<std::atomic<size_t>, POOLS> __published_used{};
+            std::atomic<size_t> __published_total{0};
+            std::atomic<size_t> __published_limit{0};
+            std::atomic<size_t> __published_streams{0};
+            std::atomic<uint64_t> __evicted{0};
+            std::atomic<uint64_t> __rejected{0};
+    };
+}
@@ -0,0 +1,196 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the MessageArena class, a per-thread monotonic arena
+** backing everything built while a /ws message is handled, and the
+** arena-backed JSON type used by the envelope, the handlers and the replies.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace talkup_network {
+    class MessageArena : public std::pmr::memory_resource {
+        public:
+
+            /**
+             * @brief Activates the arena of the calling thread for one message.
+             * When it goes out of scope the message allocations are reported
+             * to the ServerMetrics and the arena is reset.
+             * Memory taken through the ArenaAllocator may outlive the scope:
+             * its blocks are then kept until the last value using them is gone.
+             */
+            class Scope {
+                public:
+                    Scope();
+                    ~Scope();
+                    Scope(const Scope &) = delete;
+                    Scope &operator=(const Scope &) = delete;
+
+                private:
+                    MessageArena *__previous;
+            };
+
+            static constexpr size_t BLOCK_SIZE = 64 * 1024;
+            static constexpr size_t MAX_RETAINED = 1024 * 1024;
+            // Put before each allocation of the ArenaAllocator to tell where it comes from.
+            static constexpr size_t TAG_SIZE = alignof(std::max_align_t);
+
+            MessageArena();
+            ~MessageArena() override;
+            MessageArena(const MessageArena &) = delete;
+            MessageArena &operator=(const MessageArena &) = delete;
+
+            /**
+             * @brief Get the arena of the calling thread.
+             *
+             * @return MessageArena&
+             */
+            static MessageArena &local(void);
+
+            /**
+             * @brief Get the arena of the message handled by the calling thread.
+             *
+             * @return MessageArena* nullptr outside of a Scope.
+             */
+            static MessageArena *active(void);
+
+            /**
+             * @brief Allocate from the active arena, or from the heap outside
+             * of a Scope, with a tag telling which.
+             *
+             * @param bytes
+             * @return void* Aligned for any type up to TAG_SIZE.
+             */
+            static void *allocate_tagged(size_t bytes);
+
+            /**
+             * @brief Release memory from allocate_tagged. It may be called from
+             * any thread and after the Scope ended: arena memory is given back
+             * to its arena, heap memory to the heap.
+             *
+             * @param ptr
+             * @param bytes The size given to allocate_tagged.
+             */
+            static void deallocate_tagged(void *ptr, size_t bytes) noexcept;
+
+            /**
+             * @brief Whether a pointer was allocated in this arena.
+             *
+             * @param ptr
+             * @return true
+             * @return false
+             */
+            bool owns(const void *ptr) const;
+
+            /**
+             * @brief Release every allocation at once. The first blocks are
+             * kept for the next message, up to MAX_RETAINED bytes.
+             * When tagged allocations are still in use, their blocks are left
+             * to them and the arena starts over with new ones.
+             *
+             */
+            void reset(void);
+
+            /**
+             * @brief Get the number of allocations since the last reset.
+             *
+             * @return size_t
+             */
+            size_t get_allocations(void) const;
+
+            /**
+             * @brief Get the number of bytes allocated since the last reset.
+             *
+             * @return size_t
+             */
+            size_t get_bytes(void) const;
+
+        protected:
+            void *do_allocate(size_t bytes, size_t alignment) override;
+            void do_deallocate(void *ptr, size_t bytes, size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+        private:
+            struct __Block {
+                char *data;
+                size_t size;
+            };
+
+            // The blocks used between two resets.
+            struct __Generation {
+                std::vector<__Block> blocks;
+                // The tagged allocations in use, and one for the arena while it allocates here.
+                std::atomic<size_t> references{1};
+            };
+
+            static void __release(__Generation *generation) noexcept;
+
+            __Generation *__generation;
+            size_t __current = 0;
+            size_t __offset = 0;
+            size_t __allocations = 0;
+            size_t __bytes = 0;
+    };
+
+    /**
+     * @brief Allocator taking its memory from the active MessageArena,
+     * and from the heap when no message is being handled.
+     * Each allocation is tagged with its origin, so it can be freed on any
+     * thread: arena memory is released with the last value using its blocks.
+     */
+    template <typename T>
+    class ArenaAllocator {
+        public:
+            using value_type = T;
+
+            ArenaAllocator() noexcept = default;
+
+            template <typename U>
+            ArenaAllocator(const ArenaAllocator<U> &) noexcept {}
+
+            T *allocate(size_t n)
+            {
+                static_assert(alignof(T) <= MessageArena::TAG_SIZE, "over-aligned type");
+                return static_cast<T *>(MessageArena::allocate_tagged(n * sizeof(T)));
+            }
+
+            void deallocate(T *ptr, size_t n) noexcept
+            {
+                MessageArena::deallocate_tagged(ptr, n * sizeof(T));
+            }
+    };
+
+    template <typename T, typename U>
+    bool operator==(const ArenaAllocator<T> &, const ArenaAllocator<U> &) noexcept
+    {
+        return true;
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const ArenaAllocator<T> &, const ArenaAllocator<U> &) noexcept
+    {
+        return false;
+    }
+
+    /**
+     * @brief JSON whose objects, arrays and values live in the MessageArena.
+     * Strings stay std::string: keys and short values fit in the small string
+     * buffer, and it keeps get<std::string>() and the binary readers working.
+     * A message_json may outlive its message, but holds the arena blocks
+     * until then: converted to nlohmann::json, a value kept for long doesn't.
+     */
+    using message_json = nlohmann::basic_json<std::map, std::vector, std::string, bool,
+        std::int64_t, std::uint64_t, double, ArenaAllocator, nlohmann::adl_serializer,
+        std::vector<std::uint8_t, ArenaAllocator<std::uint8_t>>>;
+}
@@ -0,0 +1,131 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the ServerMetrics class, which holds the live counters
+** of the server and builds the load report sent to the clients.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace talkup_network {
+    class ServerMetrics {
+        public:
+
+            /**
+             * @brief Live counters of one microservice.
+             */
+            struct ServiceStats {
+                std::string name;
+                std::atomic<int64_t> queue_depth{0};
+                std::atomic<int64_t> latency_us{0};
+                std::atomic<uint64_t> requests{0};
+                std::atomic<uint64_t> errors{0};
+                std::atomic<uint64_t> hedged{0};
+                std::atomic<uint64_t> batched{0};
+            };
+
+            static constexpr size_t MAX_SERVICES = 16;
+            static constexpr int64_t MAX_CONNECTIONS = 1000;
+            static constexpr int64_t MAX_QUEUE_DEPTH = 32;
+            // The byte rate of the 16 kHz mono PCM16 audio the clients upload.
+            static constexpr int64_t AUDIO_BYTES_PER_MS = 32;
+
+            ServerMetrics() = delete;
+
+            /**
+             * @brief Register a microservice so its counters can be reported.
+             * Registering an already known service does nothing.
+             *
+             * @param name The service name (e.g. stt).
+             */
+            static void register_service(const std::string &name);
+
+            /**
+             * @brief Get the counters of a microservice.
+             *
+             * @param name The service name.
+             * @return ServiceStats* nullptr if the service isn't registered.
+             */
+            static ServiceStats *get_service(const std::string &name);
+
+            /**
+             * @brief Account for a request sent to a microservice.
+             *
+             * @param name The service name.
+             */
+            static void service_request_started(const std::string &name);
+
+            /**
+             * @brief Account for a microservice answer (or failure)
+             * and fold its latency into the moving average.
+             *
+             * @param name The service name.
+             * @param latency_us The latency of the request in microseconds.
+             * @param success Whether the request succeeded.
+             */
+            static void service_request_finished(const std::string &name,
+                int64_t latency_us, bool success);
+
+            /**
+             * @brief Account for a request also sent to a second replica
+             * because the first one was slow.
+             *
+             * @param name The service name.
+             */
+            static void service_request_hedged(const std::string &name);
+
+            /**
+             * @brief Account for the segments sent together in one batched request.
+             *
+             * @param name The service name.
+             * @param size The number of segments in the batch.
+             */
+            static void service_batch_sent(const std::string &name, size_t size);
+
+            /**
+             * @brief Get the load of the server between 0 and 1.
+             * It is the highest of the connection, microservice queue and
+             * memory budget usages.
+             *
+             * @return double
+             */
+            static double get_load(void);
+
+            /**
+             * @brief Get the requests waiting on every microservice.
+             *
+             * @return int64_t
+             */
+            static int64_t get_queue_depth(void);
+
+            /**
+             * @brief Build the status report from the counters, without taking any lock.
+             * It contains the recommended upload settings for the client.
+             *
+             * @return nlohmann::json
+             */
+            static nlohmann::json get_status_report(void);
+
+            static inline std::atomic<int64_t> open_connections{0};
+            static inline std::atomic<int64_t> active_streams{0};
+            static inline std::atomic<uint64_t> messages_received{0};
+            static inline std::atomic<uint64_t> bytes_received{0};
+            static inline std::atomic<uint64_t> arena_messages{0};
+            static inline std::atomic<uint64_t> arena_allocations{0};
+            static inline std::atomic<uint64_t> arena_bytes{0};
+            static inline std::atomic<int64_t> memory_used{0};
+            static inline std::atomic<int64_t> memory_limit{0};
+
+        protected:
+        private:
+            static std::array<ServiceStats, MAX_SERVICES> __services;
+            static std::atomic<size_t> __service_count;
+    };
+}
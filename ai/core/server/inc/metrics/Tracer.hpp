@@ -0,0 +1,167 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the Tracer class, which records the time spent by
+** each message in the server and exports it as Chrome trace events.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace talkup_network {
+    class Tracer {
+        public:
+
+            /**
+             * @brief A timed step of a traced message.
+             * Times are microseconds on the monotonic clock.
+             */
+            struct Span {
+                char name[32];
+                uint64_t trace_id;
+                int64_t start_us;
+                int64_t duration_us;
+                uint32_t thread_id;
+            };
+
+            /**
+             * @brief Times a step of the current trace, from its construction
+             * to its destruction. Does nothing when the message isn't traced.
+             */
+            class ScopedSpan {
+                public:
+                    ScopedSpan(const char *name);
+
+                    /**
+                     * @brief Name the span prefix + name, e.g. "ms_call:" + the service.
+                     * The name is only built when the message is traced.
+                     */
+                    ScopedSpan(const char *prefix, const std::string &name);
+                    ~ScopedSpan();
+
+                    ScopedSpan(const ScopedSpan &) = delete;
+                    ScopedSpan &operator=(const ScopedSpan &) = delete;
+
+                private:
+                    char __name[sizeof(Span::name)];
+                    int64_t __start_us;
+            };
+
+            /**
+             * @brief Makes a trace current on this thread, e.g. when a
+             * microservice answer is handled on another thread.
+             */
+            class TraceScope {
+                public:
+                    TraceScope(uint64_t trace_id);
+                    ~TraceScope();
+
+                    TraceScope(const TraceScope &) = delete;
+                    TraceScope &operator=(const TraceScope &) = delete;
+
+                private:
+                    uint64_t __previous;
+            };
+
+            static constexpr size_t BUFFER_SIZE = 8192;
+
+            Tracer() = delete;
+
+            /**
+             * @brief Set the share of messages traced without being asked to.
+             *
+             * @param rate Between 0 (only flagged messages) and 1 (every message).
+             */
+            static void set_sample_rate(double rate);
+
+            /**
+             * @brief Start tracing the message handled by this thread
+             * if it is sampled or if tracing is forced.
+             *
+             * @param forced Whether the session asked to be traced.
+             * @return uint64_t The trace ID, 0 when the message isn't traced.
+             */
+            static uint64_t begin_trace(bool forced);
+
+            /**
+             * @brief Stop tracing the message handled by this thread.
+             *
+             */
+            static void end_trace(void);
+
+            /**
+             * @brief Get the trace current on this thread.
+             *
+             * @return uint64_t 0 when no message is traced.
+             */
+            static uint64_t current(void);
+
+            /**
+             * @brief Whether the message handled by this thread is traced,
+             * to skip building what only a span would use.
+             *
+             * @return true
+             * @return false
+             */
+            static bool enabled(void);
+
+            /**
+             * @brief Get the monotonic clock, in microseconds.
+             *
+             * @return int64_t
+             */
+            static int64_t now_us(void);
+
+            /**
+             * @brief Record a span of the current trace in this thread's ring buffer.
+             *
+             * @param name The step name.
+             * @param start_us The start of the step.
+             * @param end_us The end of the step.
+             */
+            static void record(const char *name, int64_t start_us, int64_t end_us);
+
+            /**
+             * @brief Write the spans of every thread as Chrome trace_event JSON,
+             * readable by chrome://tracing and Perfetto.
+             *
+             * @param out
+             */
+            static void dump(std::ostream &out);
+
+        protected:
+        private:
+            static constexpr size_t SPAN_WORDS = (sizeof(Span) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+            // A span is written by its thread while dump may read it: the slot
+            // is a seqlock, its sequence odd during a write and 2 * (n + 1)
+            // once it holds the n-th span of the thread.
+            struct __Slot {
+                std::atomic<uint64_t> sequence{0};
+                std::array<std::atomic<uint64_t>, SPAN_WORDS> words{};
+            };
+
+            struct __ThreadBuffer {
+                std::array<__Slot, BUFFER_SIZE> slots;
+                std::atomic<uint64_t> head{0};
+                uint32_t thread_id = 0;
+            };
+
+            static __ThreadBuffer &__get_thread_buffer(void);
+
+            static inline std::atomic<double> __sample_rate{0};
+            static inline std::atomic<uint64_t> __next_trace_id{1};
+            static inline std::atomic<uint32_t> __next_thread_id{1};
+            static inline std::mutex __buffers_mutex;
+            static inline std::vector<std::shared_ptr<__ThreadBuffer>> __buffers;
+    };
+}
@@ -0,0 +1,141 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the Batcher class, which gathers the audio segments of
+** many sessions bound to the same microservice and sends them as a single
+** batched task_request, then hands each segment its own part of the result.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "ServicePool.hpp"
+#include "TimerService.hpp"
+#include "WorkerPool.hpp"
+
+namespace talkup_network {
+    class Batcher {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            /**
+             * @brief Called once per segment with its result, or with an
+             * error message ({"message": ...}) when ok is false.
+             */
+            using Callback = std::function<void(bool ok, const nlohmann::json &result)>;
+
+            /**
+             * @brief Sends a batched task with the samples of all its segments.
+             * ServicePool::post_samples by default.
+             */
+            using Sender = std::function<ServicePool::Result(const std::string &service,
+                const nlohmann::json &task, std::string_view samples, Clock::time_point deadline)>;
+
+            /**
+             * @brief When a batch is sent: as soon as it holds max_batch segments,
+             * or when its oldest segment has waited for budget.
+             * A segment fails if its result isn't back within timeout, right
+             * at its deadline when the Batcher has timers.
+             * At most max_in_flight batches are sent side by side: past that,
+             * the segments wait and make bigger batches.
+             */
+            struct Options {
+                size_t max_batch = 16;
+                std::chrono::milliseconds budget{20};
+                std::chrono::milliseconds timeout{5000};
+                size_t max_in_flight = 4;
+            };
+
+            /**
+             * @brief One segment of a session.
+             */
+            struct Segment {
+                nlohmann::json meta;
+                std::string samples;
+                Callback on_result;
+                // Set by submit to the trace of its thread, the batch is sent in it.
+                uint64_t trace_id = 0;
+            };
+
+            /**
+             * @brief Construct a new Batcher object sending to a microservice
+             * through the ServicePool, with its options from services.json.
+             *
+             * @param service The service name (e.g. stt).
+             * @param timers Runs the deadline of each segment, if any.
+             */
+            Batcher(const std::string &service, TimerService *timers = nullptr);
+
+            /**
+             * @brief Construct a new Batcher object
+             *
+             * @param service The service name (e.g. stt).
+             * @param options
+             * @param sender
+             * @param timers Runs the deadline of each segment, if any.
+             */
+            Batcher(const std::string &service, const Options &options, Sender sender,
+                TimerService *timers = nullptr);
+
+            /**
+             * @brief Destroy the Batcher object.
+             * Waiting segments fail, and the batches on the way are waited for.
+             *
+             */
+            ~Batcher();
+
+            Batcher(const Batcher &) = delete;
+            Batcher &operator=(const Batcher &) = delete;
+
+            /**
+             * @brief Queue a segment for the next batch.
+             *
+             * @param segment Its meta (stream_id, seq...) is sent as it is
+             * with the position of its samples in the payload of the batch.
+             */
+            void submit(Segment segment);
+
+            /**
+             * @brief Get the batching options of a microservice:
+             * "BatchSize", "BatchBudgetMs" and "BatchInFlight" in services.json.
+             *
+             * @param service The service name.
+             * @return Options
+             */
+            static Options get_options(const std::string &service);
+
+        protected:
+        private:
+            struct __Waiting {
+                Segment segment;
+                Clock::time_point queued;
+            };
+
+            void __run(void);
+            void __flush(std::vector<Segment> batch, Clock::time_point deadline);
+
+            std::string __service;
+            Options __options;
+            Sender __sender;
+            TimerService *__timers;
+            std::mutex __mutex;
+            std::condition_variable __changed;
+            std::vector<__Waiting> __waiting;
+            size_t __in_flight = 0;
+            bool __stopping = false;
+            std::thread __worker;
+            // Last, so the batches on the way are done before the rest goes away.
+            WorkerPool __senders;
+    };
+}
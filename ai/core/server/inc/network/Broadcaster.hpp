@@ -0,0 +1,110 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the Broadcaster class, which fans out the events of a
+** session to the observers subscribed to it (coach dashboard, recorder...).
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <crow.h>
+#include "Envelope.hpp"
+
+namespace talkup_network {
+    class Broadcaster {
+        public:
+
+            /**
+             * @brief An encoded event, shared by every subscriber using the same encoding.
+             */
+            using Frame = std::shared_ptr<const std::string>;
+
+            /**
+             * @brief Construct a new Broadcaster object and start its sending thread.
+             *
+             * @param max_queue Events kept per subscriber before the oldest are dropped.
+             */
+            Broadcaster(size_t max_queue = 256);
+
+            /**
+             * @brief Destroy the Broadcaster object and stop its sending thread.
+             *
+             */
+            ~Broadcaster();
+
+            /**
+             * @brief Subscribe a connection to the events of a stream.
+             *
+             * @param stream_id The stream ID.
+             * @param conn The WebSocket connection object.
+             * @param encoding The encoding used by the subscriber.
+             */
+            void subscribe(const std::string &stream_id, crow::websocket::connection &conn,
+                Envelope::Encoding encoding);
+
+            /**
+             * @brief Unsubscribe a connection from the events of a stream.
+             *
+             * @param stream_id The stream ID.
+             * @param conn The WebSocket connection object.
+             */
+            void unsubscribe(const std::string &stream_id, crow::websocket::connection &conn);
+
+            /**
+             * @brief Unsubscribe a closing connection from every stream.
+             * No event is sent on it once this returns.
+             *
+             * @param conn The WebSocket connection object.
+             */
+            void unsubscribe_all(crow::websocket::connection &conn);
+
+            /**
+             * @brief Publish an event to the subscribers of a stream.
+             * The event is encoded once per encoding in use, then queued to each subscriber.
+             *
+             * @param stream_id The stream ID.
+             * @param event The event.
+             */
+            void publish(const std::string &stream_id, const nlohmann::json &event);
+
+        protected:
+        private:
+            struct __Subscriber {
+                crow::websocket::connection *conn;
+                Envelope::Encoding encoding;
+                // Held while sending, so a slow connection only holds its own sends.
+                std::mutex send_mutex;
+                std::mutex mutex;
+                std::deque<Frame> queue;
+                bool scheduled = false;
+                bool closed = false;
+                uint64_t dropped = 0;
+            };
+
+            void __remove(const std::string &stream_id, crow::websocket::connection &conn);
+            void __run(void);
+
+            size_t __max_queue;
+            std::unordered_map<std::string, std::vector<std::shared_ptr<__Subscriber>>> __topics;
+            std::unordered_map<crow::websocket::connection *, std::vector<std::string>> __topics_by_conn;
+            std::shared_mutex __topics_mutex;
+
+            std::deque<std::shared_ptr<__Subscriber>> __ready;
+            std::mutex __ready_mutex;
+            std::condition_variable __ready_cv;
+            bool __stopping = false;
+            std::thread __worker;
+    };
+}
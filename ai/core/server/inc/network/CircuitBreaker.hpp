@@ -0,0 +1,133 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the CircuitBreaker class, which tracks the health of one
+** microservice replica and stops sending it requests while it misbehaves.
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace talkup_network {
+    class CircuitBreaker {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            /**
+             * @brief Breaker states.
+             * CLOSED lets every call through, OPEN rejects them until the cooldown
+             * is over, HALF_OPEN lets a few probe calls through to test the replica.
+             */
+            enum class State {
+                CLOSED,
+                OPEN,
+                HALF_OPEN,
+            };
+
+            /**
+             * @brief When the breaker trips and how it recovers.
+             * It trips when, over the last calls, the share of errors or the
+             * share of calls slower than slow_call_us reaches its threshold.
+             */
+            struct Thresholds {
+                double error_rate = 0.5;
+                double slow_rate = 0.5;
+                int64_t slow_call_us = 2000000;
+                size_t min_calls = 5;
+                std::chrono::milliseconds open_for{5000};
+                size_t probes = 1;
+            };
+
+            static constexpr size_t WINDOW = 32;
+
+            /**
+             * @brief Construct a new CircuitBreaker object with the default thresholds
+             *
+             */
+            CircuitBreaker(void);
+
+            /**
+             * @brief Construct a new CircuitBreaker object
+             *
+             * @param thresholds
+             */
+            CircuitBreaker(const Thresholds &thresholds);
+
+            /**
+             * @brief Destroy the CircuitBreaker object
+             *
+             */
+            ~CircuitBreaker() = default;
+
+            /**
+             * @brief Whether a call may be sent to the replica.
+             * An open breaker turns half-open once its cooldown is over, and a
+             * half-open breaker only lets its probe calls through.
+             * Every allowed call has to be followed by a call to record.
+             *
+             * @param now
+             * @return true
+             * @return false
+             */
+            bool allow(Clock::time_point now = Clock::now());
+
+            /**
+             * @brief Account for the outcome of an allowed call.
+             *
+             * @param ok Whether the replica answered successfully.
+             * @param latency_us The time the call took.
+             * @param now
+             */
+            void record(bool ok, int64_t latency_us, Clock::time_point now = Clock::now());
+
+            /**
+             * @brief Get the state of the breaker.
+             *
+             * @return State
+             */
+            State get_state(void) const;
+
+            /**
+             * @brief Get the 95th percentile latency of the recent successful calls.
+             *
+             * @param fallback_us Returned while there are too few calls to tell.
+             * @return int64_t
+             */
+            int64_t get_latency_p95_us(int64_t fallback_us) const;
+
+            /**
+             * @brief Get the name of a state.
+             *
+             * @param state
+             * @return std::string
+             */
+            static std::string get_state_name(State state);
+
+        protected:
+        private:
+            struct __Call {
+                bool ok = false;
+                int64_t latency_us = 0;
+            };
+
+            void __trip(Clock::time_point now);
+            void __close(void);
+
+            Thresholds __thresholds;
+            mutable std::mutex __mutex;
+            State __state = State::CLOSED;
+            std::array<__Call, WINDOW> __calls;
+            size_t __count = 0;
+            size_t __next = 0;
+            Clock::time_point __opened_at;
+            size_t __probes_in_flight = 0;
+            size_t __probes_passed = 0;
+    };
+}
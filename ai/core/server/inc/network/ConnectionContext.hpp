@@ -0,0 +1,86 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the ConnectionContext struct, which holds the state
+** kept for each WebSocket connection for as long as it is open.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <crow.h>
+#include "Envelope.hpp"
+#include "MemoryBudget.hpp"
+#include "RateLimiter.hpp"
+#include "TimerService.hpp"
+
+namespace talkup_network {
+    struct ConnectionContext {
+        /**
+         * @brief Encoding negotiated by the client, replies are sent with it.
+         * It is set from the /ws URL before the connection opens.
+         */
+        std::atomic<Envelope::Encoding> encoding{Envelope::Encoding::JSON};
+
+        /**
+         * @brief Token buckets limiting the traffic of this connection.
+         */
+        RateLimiter::Buckets limits;
+
+        /**
+         * @brief Address of the client, which has its own key bucket.
+         */
+        std::string client;
+
+        /**
+         * @brief Whether the session asked for its messages to be traced.
+         */
+        std::atomic<bool> trace{false};
+
+        /**
+         * @brief Memory used by the streams of this connection, counted by
+         * the MemoryBudget so the status is built without its lock.
+         */
+        MemoryBudget::SessionUsage memory = std::make_shared<std::atomic<int64_t>>(0);
+
+        /**
+         * @brief When the last message came in, and the last ping, in
+         * milliseconds of the steady clock.
+         */
+        std::atomic<int64_t> last_seen_ms{0};
+        std::atomic<int64_t> last_ping_ms{0};
+
+        /**
+         * @brief Average interval between the pings of the client, 0 until
+         * it has sent two. The connection is expected to stay alive
+         * for a few of them.
+         */
+        std::atomic<int64_t> ping_interval_ms{0};
+
+        /**
+         * @brief The timer checking the connection is still alive.
+         */
+        std::atomic<TimerService::Handle> heartbeat{TimerService::NONE};
+
+        /**
+         * @brief Set once the connection is closed, so its heartbeat stops.
+         */
+        std::atomic<bool> closed{false};
+
+        /**
+         * @brief Get the context attached to a connection.
+         * It is attached when the connection opens and released when it closes.
+         *
+         * @param conn The WebSocket connection object.
+         * @return ConnectionContext* The context, nullptr if none is attached.
+         */
+        static ConnectionContext *get(crow::websocket::connection &conn)
+        {
+            return static_cast<ConnectionContext *>(conn.userdata());
+        }
+    };
+}
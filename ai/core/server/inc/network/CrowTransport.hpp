@@ -0,0 +1,74 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the CrowTransport class, which serves the routes
+** with Crow's Asio stack.
+*/
+
+#pragma once
+
+#include <memory>
+#include <crow.h>
+#include "ITransport.hpp"
+#include "TlsContext.hpp"
+
+namespace talkup_network {
+    class CrowTransport : public ITransport {
+        public:
+
+            /**
+             * @brief Construct a new CrowTransport object
+             *
+             * @param tls Serve HTTPS and WSS with these settings, plain HTTP if null.
+             */
+            CrowTransport(std::shared_ptr<TlsContext> tls = nullptr);
+
+            /**
+             * @brief Destroy the CrowTransport object
+             *
+             */
+            ~CrowTransport() override = default;
+
+            /**
+             * @brief Bind the routes of the router to the Crow application and run it.
+             *
+             * @param router The router handling the requests and messages.
+             * @param port
+             * @return true
+             * @return false
+             */
+            bool run(Router &router, int port) override;
+
+            /**
+             * @brief Block until the Crow application accepts connections.
+             *
+             */
+            void wait_for_start(void) override;
+
+            /**
+             * @brief Stop the Crow application.
+             *
+             */
+            void stop(void) override;
+
+            /**
+             * @brief Get the transport name.
+             *
+             * @return std::string
+             */
+            std::string get_transport_name(void) const override;
+
+            /**
+             * @brief Get the Crow application.
+             *
+             * @return crow::SimpleApp&
+             */
+            crow::SimpleApp &get_app(void);
+
+        protected:
+        private:
+            crow::SimpleApp __app;
+            std::shared_ptr<TlsContext> __tls;
+    };
+}
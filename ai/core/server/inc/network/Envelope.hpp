@@ -0,0 +1,126 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the Envelope class, which is responsible for
+** encoding and decoding the messages exchanged on the WebSocket.
+*/
+
+#pragma once
+
+#include <string>
+#include <nlohmann/json.hpp>
+#include <crow.h>
+#include "MessageArena.hpp"
+
+namespace talkup_network {
+    class Envelope {
+        public:
+
+            /**
+             * @brief Encodings a client can negotiate for the /ws traffic.
+             * JSON is always available and used as the fallback.
+             */
+            enum class Encoding {
+                JSON,
+                CBOR,
+                MSGPACK,
+            };
+
+            /**
+             * @brief Version of the protocol announced to the clients.
+             */
+            static inline const std::string PROTOCOL_VERSION = "1.1";
+
+            /**
+             * @brief Construct a new Envelope object
+             *
+             */
+            Envelope() = default;
+
+            /**
+             * @brief Destroy the Envelope object
+             *
+             */
+            ~Envelope() = default;
+
+            /**
+             * @brief Pick the encoding to use from the initialization request.
+             * The client lists the encodings it supports in the optional
+             * `encodings` field, by order of preference.
+             *
+             * @param request The initialization request.
+             * @return Encoding The first supported encoding, JSON otherwise.
+             */
+            static Encoding negotiate(const nlohmann::json &request);
+
+            /**
+             * @brief Get the name of an encoding, as written in the protocol.
+             *
+             * @param encoding
+             * @return std::string
+             */
+            static std::string get_encoding_name(Encoding encoding);
+
+            /**
+             * @brief Get an encoding from its name, as written in the protocol.
+             *
+             * @param name
+             * @param encoding Set to the encoding if the name is known.
+             * @return true if the name is known.
+             */
+            static bool get_encoding(const std::string &name, Encoding &encoding);
+
+            /**
+             * @brief Decode a WebSocket frame.
+             * Text frames are JSON, binary frames are CBOR or MessagePack
+             * and are told apart by their first byte.
+             *
+             * @param data The raw frame.
+             * @param is_binary Whether the frame is a binary frame.
+             * @param encoding Set to the encoding of the frame.
+             * @return message_json The decoded message, in the active MessageArena.
+             */
+            static message_json decode(const std::string &data, bool is_binary,
+                Encoding &encoding);
+
+            /**
+             * @brief Encode a message with the given encoding.
+             * Defined for nlohmann::json and message_json.
+             *
+             * @param json The message.
+             * @param encoding The encoding to use.
+             * @return std::string The encoded frame.
+             */
+            template <typename Json>
+            static std::string encode(const Json &json, Encoding encoding);
+
+            /**
+             * @brief Encode a message into a buffer, after its current content.
+             * Defined for nlohmann::json and message_json.
+             *
+             * @param json The message.
+             * @param encoding The encoding to use.
+             * @param out The buffer.
+             */
+            template <typename Json>
+            static void encode_into(const Json &json, Encoding encoding, std::string &out);
+
+            /**
+             * @brief Encode a message and send it on the connection,
+             * as a text frame for JSON and a binary frame otherwise.
+             * The frame is built in a buffer reused by every reply of the thread.
+             * Defined for nlohmann::json and message_json.
+             *
+             * @param conn The WebSocket connection object.
+             * @param json The message.
+             * @param encoding The encoding to use.
+             */
+            template <typename Json>
+            static void send(crow::websocket::connection &conn,
+                const Json &json, Encoding encoding);
+
+        protected:
+        private:
+    };
+}
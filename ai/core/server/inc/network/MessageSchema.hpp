@@ -0,0 +1,484 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the message schemas: a message is a plain struct which
+** lists its fields once, and its validator, parser and serializer are
+** generated from that list. It also defines the perfect hashes the message
+** types and formats are dispatched with, built at compile time.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace talkup_network {
+    namespace schema {
+
+        /**
+         * @brief FNV-1a of a name, with the seed mixed in the offset basis.
+         *
+         * @param name
+         * @param seed
+         * @return uint32_t
+         */
+        constexpr uint32_t hash(std::string_view name, uint32_t seed = 0)
+        {
+            uint32_t value = 2166136261u ^ (seed * 0x9e3779b9u);
+
+            for (char c : name) {
+                value ^= static_cast<unsigned char>(c);
+                value *= 16777619u;
+            }
+            return value ^ (value >> 16);
+        }
+
+        /**
+         * @brief Perfect hash over a fixed set of names: every name has its
+         * own slot, so a lookup is one hash and one comparison.
+         * The seed is searched when the table is built, at compile time when
+         * it is constexpr: two equal names, or no seed found, don't compile.
+         */
+        template <size_t N>
+        class PerfectHash {
+            public:
+                // Half full at most, a seed is found in a few tries.
+                static constexpr size_t SIZE = [] {
+                    size_t size = 1;
+
+                    while (size < N * 2)
+                        size <<= 1;
+                    return size;
+                }();
+
+                constexpr explicit PerfectHash(const std::array<std::string_view, N> &names)
+                    : __names(names)
+                {
+                    for (size_t i = 0; i < N; i++) {
+                        for (size_t j = i + 1; j < N; j++) {
+                            if (names[i] == names[j])
+                                throw std::invalid_argument("duplicate name");
+                        }
+                    }
+                    for (__seed = 0; __seed < MAX_SEED; __seed++) {
+                        if (__place())
+                            return;
+                    }
+                    throw std::invalid_argument("no perfect hash found");
+                }
+
+                /**
+                 * @brief Get the index of a name in the set.
+                 *
+                 * @param name
+                 * @return int The index given to the constructor, -1 if unknown.
+                 */
+                constexpr int find(std::string_view name) const
+                {
+                    int index = __slots[hash(name, __seed) & (SIZE - 1)];
+
+                    return index >= 0 && __names[index] == name ? index : -1;
+                }
+
+                constexpr std::string_view get_name(size_t index) const
+                {
+                    return __names[index];
+                }
+
+                constexpr uint32_t get_seed(void) const
+                {
+                    return __seed;
+                }
+
+            protected:
+            private:
+                static constexpr uint32_t MAX_SEED = 1u << 16;
+
+                constexpr bool __place(void)
+                {
+                    for (auto &slot : __slots)
+                        slot = -1;
+                    for (size_t i = 0; i < N; i++) {
+                        int &slot = __slots[hash(__names[i], __seed) & (SIZE - 1)];
+
+                        if (slot >= 0)
+                            return false;
+                        slot = static_cast<int>(i);
+                    }
+                    return true;
+                }
+
+                std::array<std::string_view, N> __names;
+                std::array<int, SIZE> __slots{};
+                uint32_t __seed = 0;
+        };
+
+        /**
+         * @brief Handlers looked up by name through a PerfectHash.
+         *
+         * @tparam Handler A function or member function pointer.
+         */
+        template <typename Handler, size_t N>
+        class Dispatcher {
+            public:
+                using Route = std::pair<std::string_view, Handler>;
+
+                constexpr explicit Dispatcher(const Route (&routes)[N])
+                    : __names(__get_names(routes))
+                {
+                    for (size_t i = 0; i < N; i++)
+                        __handlers[i] = routes[i].second;
+                }
+
+                /**
+                 * @brief Get the handler of a name.
+                 *
+                 * @param name
+                 * @return Handler nullptr if the name is unknown.
+                 */
+                constexpr Handler find(std::string_view name) const
+                {
+                    int index = __names.find(name);
+
+                    return index < 0 ? nullptr : __handlers[index];
+                }
+
+            protected:
+            private:
+                static constexpr std::array<std::string_view, N> __get_names(const Route (&routes)[N])
+                {
+                    std::array<std::string_view, N> names{};
+
+                    for (size_t i = 0; i < N; i++)
+                        names[i] = routes[i].first;
+                    return names;
+                }
+
+                PerfectHash<N> __names;
+                std::array<Handler, N> __handlers{};
+        };
+
+        /**
+         * @brief Build a Dispatcher, the number of routes deduced.
+         *
+         * @param routes The names and their handler.
+         * @return Dispatcher<Handler, N>
+         */
+        template <typename Handler, size_t N>
+        constexpr Dispatcher<Handler, N> make_dispatcher(const std::pair<std::string_view, Handler> (&routes)[N])
+        {
+            return Dispatcher<Handler, N>(routes);
+        }
+
+        /**
+         * @brief A field which has to be there, whatever its value.
+         * It is neither read nor written: the value stays in the message,
+         * for the handler to read it where it is.
+         */
+        struct Any {};
+
+        /**
+         * @brief Raw bytes: a byte string in CBOR/MessagePack, Base64 in JSON.
+         */
+        struct Bytes {
+            std::string value;
+        };
+
+        std::string decode_base64(const std::string &text);
+        std::string encode_base64(const std::string &bytes);
+
+        /**
+         * @brief How a field type is checked, read from and written to JSON.
+         * Generic over the JSON type, so it reads a message_json in place.
+         */
+        template <typename T, typename = void>
+        struct Codec;
+
+        template <>
+        struct Codec<std::string> {
+            template <typename Json>
+            static bool is(const Json &json) { return json.is_string(); }
+
+            template <typename Json>
+            static void read(const Json &json, std::string &value) { value = json.template get<std::string>(); }
+
+            template <typename Json>
+            static void write(Json &json, const std::string &value) { json = value; }
+        };
+
+        // Any number, like get<int64_t>() did: a client may send a float timestamp.
+        template <typename T>
+        struct Codec<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+            template <typename Json>
+            static bool is(const Json &json) { return json.is_number(); }
+
+            template <typename Json>
+            static void read(const Json &json, T &value) { value = json.template get<T>(); }
+
+            template <typename Json>
+            static void write(Json &json, T value) { json = value; }
+        };
+
+        template <>
+        struct Codec<bool> {
+            template <typename Json>
+            static bool is(const Json &json) { return json.is_boolean(); }
+
+            template <typename Json>
+            static void read(const Json &json, bool &value) { value = json.template get<bool>(); }
+
+            template <typename Json>
+            static void write(Json &json, bool value) { json = value; }
+        };
+
+        template <>
+        struct Codec<double> {
+            template <typename Json>
+            static bool is(const Json &json) { return json.is_number(); }
+
+            template <typename Json>
+            static void read(const Json &json, double &value) { value = json.template get<double>(); }
+
+            template <typename Json>
+            static void write(Json &json, double value) { json = value; }
+        };
+
+        template <>
+        struct Codec<std::vector<std::string>> {
+            template <typename Json>
+            static bool is(const Json &json)
+            {
+                if (!json.is_array())
+                    return false;
+                for (const auto &item : json) {
+                    if (!item.is_string())
+                        return false;
+                }
+                return true;
+            }
+
+            template <typename Json>
+            static void read(const Json &json, std::vector<std::string> &value)
+            {
+                value.clear();
+                for (const auto &item : json)
+                    value.push_back(item.template get<std::string>());
+            }
+
+            template <typename Json>
+            static void write(Json &json, const std::vector<std::string> &value)
+            {
+                json = Json::array();
+                for (const auto &item : value)
+                    json.push_back(item);
+            }
+        };
+
+        // A free-form value, copied out of the message.
+        template <>
+        struct Codec<nlohmann::json> {
+            template <typename Json>
+            static bool is(const Json &) { return true; }
+
+            template <typename Json>
+            static void read(const Json &json, nlohmann::json &value)
+            {
+                if constexpr (std::is_same_v<Json, nlohmann::json>)
+                    value = json;
+                else
+                    value = nlohmann::json::parse(json.dump());
+            }
+
+            template <typename Json>
+            static void write(Json &json, const nlohmann::json &value)
+            {
+                if constexpr (std::is_same_v<Json, nlohmann::json>)
+                    json = value;
+                else
+                    json = Json::parse(value.dump());
+            }
+        };
+
+        template <>
+        struct Codec<Any> {
+            template <typename Json>
+            static bool is(const Json &) { return true; }
+
+            template <typename Json>
+            static void read(const Json &, Any &) {}
+        };
+
+        template <>
+        struct Codec<Bytes> {
+            template <typename Json>
+            static bool is(const Json &json) { return json.is_binary() || json.is_string(); }
+
+            template <typename Json>
+            static void read(const Json &json, Bytes &value)
+            {
+                if (json.is_binary())
+                    value.value.assign(json.get_binary().begin(), json.get_binary().end());
+                else
+                    value.value = decode_base64(json.template get<std::string>());
+            }
+
+            template <typename Json>
+            static void write(Json &json, const Bytes &value) { json = encode_base64(value.value); }
+        };
+
+        /**
+         * @brief A field of a message: its name in the JSON and its member.
+         * A std::optional member makes the field optional.
+         */
+        template <typename Message, typename T>
+        struct Field {
+            std::string_view name;
+            T Message::*member;
+        };
+
+        template <typename Message, typename T>
+        constexpr Field<Message, T> field(std::string_view name, T Message::*member)
+        {
+            return { name, member };
+        }
+
+        namespace detail {
+            template <typename T>
+            struct is_optional : std::false_type {
+                using type = T;
+            };
+
+            template <typename T>
+            struct is_optional<std::optional<T>> : std::true_type {
+                using type = T;
+            };
+
+            template <typename Message, typename Function>
+            void for_each_field(Function &&function)
+            {
+                std::apply([&function](const auto &...fields) { (function(fields), ...); },
+                    Message::get_fields());
+            }
+        }
+
+        /**
+         * @brief Check a JSON object against the schema of a message.
+         *
+         * @param json
+         * @return std::string_view The name of the first field missing or of
+         * the wrong type, empty if the message is valid.
+         */
+        template <typename Message, typename Json>
+        std::string_view check(const Json &json)
+        {
+            std::string_view invalid;
+
+            if (!json.is_object())
+                return "object";
+            detail::for_each_field<Message>([&json, &invalid](const auto &field) {
+                using T = std::decay_t<decltype(std::declval<Message>().*(field.member))>;
+
+                if (!invalid.empty())
+                    return;
+                auto it = json.find(std::string(field.name));
+                if (it == json.end()) {
+                    if (!detail::is_optional<T>::value)
+                        invalid = field.name;
+                } else if (!Codec<typename detail::is_optional<T>::type>::is(*it)) {
+                    invalid = field.name;
+                }
+            });
+            return invalid;
+        }
+
+        /**
+         * @brief Whether a JSON object matches the schema of a message.
+         *
+         * @param json
+         * @return true
+         * @return false
+         */
+        template <typename Message, typename Json>
+        bool validate(const Json &json)
+        {
+            return check<Message>(json).empty();
+        }
+
+        /**
+         * @brief Read a message from a JSON object, if it matches its schema.
+         * The optional fields missing are reset.
+         *
+         * @param json
+         * @param message
+         * @return true if the message was read.
+         */
+        template <typename Message, typename Json>
+        bool parse(const Json &json, Message &message)
+        {
+            if (!validate<Message>(json))
+                return false;
+            detail::for_each_field<Message>([&json, &message](const auto &field) {
+                auto &value = message.*(field.member);
+                using T = std::decay_t<decltype(value)>;
+                auto it = json.find(std::string(field.name));
+
+                if constexpr (detail::is_optional<T>::value) {
+                    if (it == json.end()) {
+                        value.reset();
+                        return;
+                    }
+                    Codec<typename T::value_type>::read(*it, value.emplace());
+                } else {
+                    Codec<T>::read(*it, value);
+                }
+            });
+            return true;
+        }
+
+        /**
+         * @brief Write a message to a JSON object, the optional fields
+         * without a value left out.
+         *
+         * @param message
+         * @param json
+         */
+        template <typename Message, typename Json>
+        void serialize(const Message &message, Json &json)
+        {
+            detail::for_each_field<Message>([&json, &message](const auto &field) {
+                const auto &value = message.*(field.member);
+                using T = std::decay_t<decltype(value)>;
+                std::string name(field.name);
+
+                if constexpr (std::is_same_v<T, Any>) {
+                    return;
+                } else if constexpr (detail::is_optional<T>::value) {
+                    if (value)
+                        Codec<typename T::value_type>::write(json[name], *value);
+                } else {
+                    Codec<T>::write(json[name], value);
+                }
+            });
+        }
+
+        template <typename Json = nlohmann::json, typename Message>
+        Json serialize(const Message &message)
+        {
+            Json json = Json::object();
+
+            serialize(message, json);
+            return json;
+        }
+    }
+}
@@ -0,0 +1,172 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file declares the schemas of the messages exchanged with the
+** frontend and with the microservices, and the message formats.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "MessageSchema.hpp"
+
+namespace talkup_network {
+    namespace messages {
+
+        /**
+         * @brief What every message sent on /ws carries. The type-specific
+         * part is in data, read by the handler of the type.
+         */
+        struct Header {
+            std::string type;
+            std::string key;
+            std::string stream_id;
+            std::string format;
+            int64_t timestamp = 0;
+            schema::Any data;
+            std::optional<int64_t> seq;
+
+            static constexpr auto get_fields(void)
+            {
+                return std::make_tuple(
+                    schema::field("type", &Header::type),
+                    schema::field("key", &Header::key),
+                    schema::field("stream_id", &Header::stream_id),
+                    schema::field("format", &Header::format),
+                    schema::field("timestamp", &Header::timestamp),
+                    schema::field("data", &Header::data),
+                    schema::field("seq", &Header::seq));
+            }
+        };
+
+        /**
+         * @brief A stream_chunk to process. Without a sequence number,
+         * the chunk is only acknowledged.
+         */
+        struct StreamChunk {
+            schema::Bytes data;
+            int64_t seq = -1;
+
+            static constexpr auto get_fields(void)
+            {
+                return std::make_tuple(
+                    schema::field("data", &StreamChunk::data),
+                    schema::field("seq", &StreamChunk::seq));
+            }
+        };
+
+        /**
+         * @brief The data of a resume message.
+         */
+        struct ResumeData {
+            std::string resume_token;
+            int64_t last_acked_seq = -1;
+
+            static constexpr auto get_fields(void)
+            {
+                return std::make_tuple(
+                    schema::field("resume_token", &ResumeData::resume_token),
+                    schema::field("last_acked_seq", &ResumeData::last_acked_seq));
+            }
+        };
+
+        /**
+         * @brief The data of a transcript_query asking for the words of a
+         * time range. Without it, the whole text is sent.
+         */
+        struct TranscriptRange {
+            int64_t from_ms = 0;
+            int64_t to_ms = 0;
+
+            static constexpr auto get_fields(void)
+            {
+                return std::make_tuple(
+                    schema::field("from_ms", &TranscriptRange::from_ms),
+                    schema::field("to_ms", &TranscriptRange::to_ms));
+            }
+        };
+
+        /**
+         * @brief The data of a speak message.
+         */
+        struct SpeakData {
+            std::string text;
+
+            static constexpr auto get_fields(void)
+            {
+                return std::make_tuple(schema::field("text", &SpeakData::text));
+            }
+        };
+
+        /**
+         * @brief The body of POST /process/initialization. The optional
+         * instance asks for the instance holding the streams to resume.
+         */
+        struct InitializationRequest {
+            std::string key;
+            std::string type;
+            std::string format;
+            std::optional<std::string> instance;
+
+            static constexpr auto get_fields(void)
+            {
+                return std::make_tuple(
+                    schema::field("key", &InitializationRequest::key),
+                    schema::field("type", &InitializationRequest::type),
+                    schema::field("format", &InitializationRequest::format),
+                    schema::field("instance", &InitializationRequest::instance));
+            }
+        };
+
+        /**
+         * @brief A task sent to the microservices.
+         */
+        struct TaskRequest {
+            std::vector<std::string> services;
+            std::string type = "task_request";
+            int64_t timestamp = 0;
+            nlohmann::json data;
+
+            static constexpr auto get_fields(void)
+            {
+                return std::make_tuple(
+                    schema::field("services", &TaskRequest::services),
+                    schema::field("type", &TaskRequest::type),
+                    schema::field("timestamp", &TaskRequest::timestamp),
+                    schema::field("data", &TaskRequest::data));
+            }
+        };
+
+        /**
+         * @brief Formats of the messages sent by the frontend.
+         */
+        enum class Format {
+            TEXT,
+            AUDIO,
+            UNKNOWN,
+        };
+
+        // In the order of Format.
+        inline constexpr schema::PerfectHash<2> FORMATS({ "text", "audio" });
+
+        /**
+         * @brief Get the format of a message from its name.
+         *
+         * @param name
+         * @return Format UNKNOWN if it isn't one.
+         */
+        constexpr Format get_format(std::string_view name)
+        {
+            int index = FORMATS.find(name);
+
+            return index < 0 ? Format::UNKNOWN : static_cast<Format>(index);
+        }
+    }
+}
@@ -11,6 +11,7 @@
 #include <nlohmann/json.hpp>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <iostream>
 #include <fstream>
 
@@ -38,6 +39,15 @@ namespace talkup_network {
              */
             static std::string get_microservice_url(const std::string &service_name);
 
+            /**
+             * @brief Get the URLs of the replicas of a microservice.
+             * They come from its "Urls" list, or from its "Url" when it has a single one.
+             *
+             * @param service_name
+             * @return std::vector<std::string> Empty if the service is unknown.
+             */
+            static std::vector<std::string> get_replica_urls(const std::string &service_name);
+
             /**
              * @brief Load the microservices information from a JSON file.
              *
@@ -58,5 +68,7 @@ namespace talkup_network {
         private:
             static inline std::unordered_map<std::string,
                 std::unordered_map<std::string, std::string>> __services_list;
+            static inline std::unordered_map<std::string,
+                std::vector<std::string>> __replicas;
     };
 }
@@ -0,0 +1,186 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the PlacementRegistry class, which shares the load of
+** the server instances through a common directory, places the new sessions
+** on the least loaded one and signs the placement with a token.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace talkup_network {
+    class PlacementRegistry {
+        public:
+
+            /**
+             * @brief What an instance publishes about itself.
+             */
+            struct Instance {
+                std::string id;
+                std::string address;
+                int64_t sessions = 0;
+                // Share of the machine used by the process, between 0 and 1.
+                double cpu = 0;
+                int64_t queue_depth = 0;
+                // Wall clock, the instances don't share a steady clock.
+                int64_t updated_ms = 0;
+            };
+
+            /**
+             * @brief Where the registry is, who this instance is, and the
+             * secret shared by the instances to sign the tokens.
+             */
+            struct Options {
+                std::string directory;
+                std::string id;
+                std::string address;
+                std::string secret;
+                std::chrono::milliseconds publish_interval{1000};
+                // An instance which stopped publishing is gone.
+                std::chrono::milliseconds stale_after{5000};
+                // Covers the reconnects which resume the streams on the same instance.
+                std::chrono::milliseconds token_ttl{600000};
+            };
+
+            /**
+             * @brief Construct a new PlacementRegistry object, disabled
+             * until it is configured.
+             *
+             */
+            PlacementRegistry() = default;
+
+            /**
+             * @brief Destroy the PlacementRegistry object
+             *
+             */
+            ~PlacementRegistry() = default;
+
+            /**
+             * @brief Enable the registry. An empty directory or secret keeps it
+             * disabled. A missing id is made from the host name and the process ID.
+             *
+             * @param options
+             */
+            void configure(const Options &options);
+
+            /**
+             * @brief Whether the placement is enabled.
+             *
+             * @return true
+             * @return false
+             */
+            bool is_enabled(void) const;
+
+            /**
+             * @brief Get the ID of this instance.
+             *
+             * @return const std::string&
+             */
+            const std::string &get_id(void) const;
+
+            /**
+             * @brief Get the interval between two publications.
+             *
+             * @return std::chrono::milliseconds
+             */
+            std::chrono::milliseconds get_publish_interval(void) const;
+
+            /**
+             * @brief Write the current load of this instance to the registry,
+             * from the server counters.
+             *
+             * @return true if it was written.
+             */
+            bool publish(void);
+
+            /**
+             * @brief Remove this instance from the registry, on shutdown.
+             *
+             */
+            void withdraw(void);
+
+            /**
+             * @brief Get the instances which published recently, this one included.
+             *
+             * @return std::vector<Instance>
+             */
+            std::vector<Instance> get_instances(void);
+
+            /**
+             * @brief Choose the instance a new session goes to: the preferred
+             * one if it is alive (a client resuming its streams), the least
+             * loaded otherwise. This instance when the registry can't be read.
+             *
+             * @param preferred The ID of the instance asked for, or empty.
+             * @return Instance
+             */
+            Instance place(const std::string &preferred = "");
+
+            /**
+             * @brief Sign a placement on an instance.
+             *
+             * @param instance_id The ID of the chosen instance.
+             * @return std::string The token, made of URL-safe characters.
+             */
+            std::string issue_token(const std::string &instance_id) const;
+
+            /**
+             * @brief Check a token was issued for this instance, hasn't expired
+             * and wasn't used yet. A valid token can't be used again.
+             *
+             * @param token
+             * @return true
+             * @return false
+             */
+            bool validate_token(const std::string &token);
+
+            /**
+             * @brief Get the load of an instance: sessions, CPU and queue
+             * depth, each against what an instance can take.
+             *
+             * @param instance
+             * @return double
+             */
+            static double get_score(const Instance &instance);
+
+            /**
+             * @brief HMAC-SHA1 of a message, in hexadecimal.
+             *
+             * @param key
+             * @param message
+             * @return std::string
+             */
+            static std::string sign(const std::string &key, const std::string &message);
+
+        protected:
+        private:
+            struct __Placed {
+                int64_t count = 0;
+                int64_t since_ms = 0;
+            };
+
+            double __sample_cpu(void);
+
+            Options __options;
+            bool __enabled = false;
+            std::mutex __mutex;
+            // Sessions sent to an instance since its last publication, so a
+            // burst of initializations doesn't all land on the same one.
+            std::unordered_map<std::string, __Placed> __placed;
+            // The nonces of the tokens used, until they expire.
+            std::unordered_set<std::string> __used_nonces;
+            std::multimap<int64_t, std::string> __nonce_expiries;
+            int64_t __cpu_time_us = 0;
+            std::chrono::steady_clock::time_point __cpu_sampled_at;
+    };
+}
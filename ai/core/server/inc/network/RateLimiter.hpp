@@ -0,0 +1,142 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the RateLimiter class, which applies token-bucket
+** limits to the WebSocket traffic, per client of an API key and per connection.
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace talkup_network {
+    class RateLimiter {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            /**
+             * @brief Rates allowed for one scope (a client of a key, or a connection).
+             * The buckets hold `burst` seconds worth of tokens. A scope whose
+             * messages_per_sec is 0 isn't limited.
+             */
+            struct Limits {
+                double messages_per_sec = 50;
+                double bytes_per_sec = 1 << 20;
+                double burst = 2;
+            };
+
+            /**
+             * @brief Limits of a service class, for each scope.
+             * Every client shares the same key, so the key scope is counted per
+             * client address, and is off unless rate_limits.json sets it.
+             */
+            struct ServiceClass {
+                Limits key = {0, 0, 2};
+                Limits connection = {50, 2 << 20, 2};
+            };
+
+            /**
+             * @brief Token buckets for messages and bytes.
+             */
+            struct Buckets {
+                double messages = -1;
+                double bytes = -1;
+                Clock::time_point last_refill;
+            };
+
+            /**
+             * @brief Scope that rejected a message.
+             */
+            enum class Scope {
+                NONE,
+                CONNECTION,
+                KEY,
+            };
+
+            /**
+             * @brief Result of an admission check.
+             */
+            struct Decision {
+                bool allowed = true;
+                Scope scope = Scope::NONE;
+                int64_t retry_after_ms = 0;
+            };
+
+            /**
+             * @brief Construct a new RateLimiter object with the default class only.
+             *
+             */
+            RateLimiter();
+
+            /**
+             * @brief Destroy the RateLimiter object
+             *
+             */
+            ~RateLimiter() = default;
+
+            /**
+             * @brief Load the service classes and the class of each key from a JSON file.
+             * The built-in defaults are kept when the file can't be read.
+             *
+             * @param file_path
+             */
+            void load_limits(const std::string &file_path = "rate_limits.json");
+
+            /**
+             * @brief Check a message against the key and connection buckets,
+             * and take its cost from both when it is allowed.
+             *
+             * @param key The API key of the message.
+             * @param client The address of the client, its key bucket is its own.
+             * @param connection The buckets of the connection the message came from.
+             * @param bytes The size of the message.
+             * @param now The current time.
+             * @return Decision
+             */
+            Decision admit(const std::string &key, const std::string &client,
+                Buckets &connection, size_t bytes, Clock::time_point now = Clock::now());
+
+            /**
+             * @brief Get the service class of a key.
+             *
+             * @param key
+             * @return const ServiceClass&
+             */
+            const ServiceClass &get_service_class(const std::string &key) const;
+
+            /**
+             * @brief Get the name of a scope, as written in the error messages.
+             *
+             * @param scope
+             * @return std::string
+             */
+            static std::string get_scope_name(Scope scope);
+
+        protected:
+        private:
+            static constexpr size_t __SHARD_COUNT = 16;
+            static constexpr size_t __MAX_SHARD_BUCKETS = 1024;
+
+            struct alignas(64) __Shard {
+                std::mutex mutex;
+                std::unordered_map<std::string, Buckets> buckets;
+            };
+
+            static Limits __parse_limits(const nlohmann::json &json, const Limits &fallback);
+            static void __refill(Buckets &buckets, const Limits &limits, Clock::time_point now);
+            static bool __available(const Buckets &buckets, const Limits &limits,
+                size_t bytes, int64_t &retry_after_ms);
+            static void __consume(Buckets &buckets, size_t bytes);
+
+            std::unordered_map<std::string, ServiceClass> __classes;
+            std::unordered_map<std::string, std::string> __key_classes;
+            std::array<__Shard, __SHARD_COUNT> __shards;
+    };
+}
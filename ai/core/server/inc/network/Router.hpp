@@ -8,7 +8,14 @@
 
 #pragma once
 
+#include <chrono>
 #include <crow.h>
+#include "MemoryBudget.hpp"
+#include "PlacementRegistry.hpp"
+#include "WebsocketManager.hpp"
+#include "RateLimiter.hpp"
+#include "TimerService.hpp"
+#include "WorkerPool.hpp"
 
 namespace talkup_network {
     class Router {
@@ -21,10 +28,20 @@ namespace talkup_network {
             Router() = default;
 
             /**
-             * @brief Destroy the Router object
+             * @brief Destroy the Router object.
+             * The timers are stopped first, as they use the rest, then the
+             * instance leaves the placement registry.
              *
              */
-            ~Router() = default;
+            ~Router();
+
+            /**
+             * @brief Load the environment keys, the rate limits and the trace
+             * sample rate, and join the placement registry. Calling it again
+             * does nothing.
+             *
+             */
+            void init(void);
 
             /**
              * @brief Set the routes definitions for the application.
@@ -34,20 +51,134 @@ namespace talkup_network {
              */
             void set_routes_definitions(crow::SimpleApp& app);
 
+            /**
+             * @brief Route an HTTP request to its handler, for the transports
+             * which don't come with their own router.
+             *
+             * @param req The HTTP request.
+             * @return crow::response 404 or 405 if no route matches.
+             */
+            crow::response handle_request(const crow::request& req);
+
+            /**
+             * @brief Handle GET /.
+             *
+             * @return crow::response
+             */
+            crow::response handle_root(void);
+
+            /**
+             * @brief Handle GET /live, which answers as long as the process runs.
+             *
+             * @return crow::response
+             */
+            crow::response handle_live(void);
+
+            /**
+             * @brief Handle GET /ready, which answers 503 until every microservice is warm.
+             *
+             * @return crow::response
+             */
+            crow::response handle_ready(void);
+
+            /**
+             * @brief Handle GET /debug/trace, which dumps the recorded spans.
+             *
+             * @param req The HTTP request, holding the server key in X-Talkup-Key.
+             * @return crow::response
+             */
+            crow::response handle_debug_trace(const crow::request& req);
+
+            /**
+             * @brief Handle POST /process/initialization.
+             *
+             * @param req The HTTP request.
+             * @return crow::response
+             */
+            crow::response handle_initialization(const crow::request& req);
+
+            /**
+             * @brief Decide whether a /ws upgrade is accepted. With placement on,
+             * it must carry a placement token issued for this instance.
+             *
+             * @param req The upgrade request, the token in its placement parameter
+             * and the negotiated encoding in its encoding parameter.
+             * @param userdata Set to the context of the connection once accepted,
+             * given to the connection before on_ws_open.
+             * @return true if the connection can be opened.
+             */
+            bool on_ws_accept(const crow::request& req, void **userdata = nullptr);
+
+            /**
+             * @brief Handle a new /ws connection.
+             * It is closed once it has been silent for too long: a few ping
+             * intervals of the client, the idle timeout at most (IDLE_TIMEOUT,
+             * or IDLE_TIMEOUT_MS in the environment).
+             *
+             * @param conn The WebSocket connection object.
+             */
+            void on_ws_open(crow::websocket::connection& conn);
+
+            /**
+             * @brief Handle a closed /ws connection.
+             * No message is sent on the connection once this returns.
+             *
+             * @param conn The WebSocket connection object.
+             * @param reason Why the connection was closed.
+             */
+            void on_ws_close(crow::websocket::connection& conn, const std::string& reason);
+
+            /**
+             * @brief Handle a /ws message.
+             *
+             * @param conn The WebSocket connection object.
+             * @param data The message.
+             * @param is_binary Whether it came in a binary frame.
+             */
+            void on_ws_message(crow::websocket::connection& conn, const std::string& data,
+                bool is_binary);
+
             /**
              * @brief Get the environment key used by the server.
              *
              */
             void get_env_key(void);
 
+            /**
+             * @brief How long a connection can stay silent, without pings.
+             */
+            static constexpr std::chrono::milliseconds IDLE_TIMEOUT{300000};
+
+            /**
+             * @brief How long a connection can stay silent at least, with pings.
+             */
+            static constexpr std::chrono::milliseconds MIN_HEARTBEAT_TIMEOUT{10000};
+
         protected:
         private:
             enum __ErrorCode {
                 SUCCESS = 200,
                 FAILURE = 400,
                 INV_KEY = 401,
+                NOT_FOUND = 404,
+                METHOD_NOT_ALLOWED = 405,
                 KEY_NOT_SET = 500,
+                UNAVAILABLE = 503,
             };
+            void __schedule_heartbeat(crow::websocket::connection& conn,
+                std::chrono::milliseconds delay);
+            void __check_heartbeat(crow::websocket::connection& conn);
+            void __schedule_publication(void);
+
+            bool __initialized = false;
             std::map<std::string, std::string> __env_variables;
+            std::chrono::milliseconds __idle_timeout = IDLE_TIMEOUT;
+            // First, so the timers are there as long as what they use.
+            TimerService __timers;
+            MemoryBudget __memory;
+            WsManager __ws_manager{__timers, __memory};
+            RateLimiter __rate_limiter;
+            PlacementRegistry __placement;
+            WorkerPool __publisher{"PLACEMENT", 1, 1};
     };
 }
@@ -0,0 +1,236 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the ServicePool class, which keeps pooled keep-alive
+** connections to the microservices and warms them up before traffic comes in.
+** Each replica of a service sits behind a circuit breaker, and idempotent
+** calls are hedged on a second replica when the first one is slow.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <cpr/cpr.h>
+#include <nlohmann/json.hpp>
+#include "CircuitBreaker.hpp"
+#include "ShmChannel.hpp"
+#include "WorkerPool.hpp"
+
+namespace talkup_network {
+    class ServicePool {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            /**
+             * @brief Receives the body of a streamed answer as it arrives.
+             * Returning false aborts the call.
+             */
+            using OnData = std::function<bool(std::string_view data)>;
+
+            /**
+             * @brief Answer of a microservice.
+             */
+            struct Result {
+                bool ok = false;
+                long status = 0;
+                std::string body;
+                int64_t latency_us = 0;
+                std::string error;
+            };
+
+            /**
+             * @brief Warmup state of a microservice.
+             */
+            enum class State {
+                COLD,
+                WARMING,
+                READY,
+            };
+
+            static constexpr size_t SESSIONS_PER_SERVICE = 4;
+            // Hedge delay of a replica without enough successful calls for its p95.
+            static constexpr int64_t HEDGE_DELAY_US = 500000;
+            // Threads running the hedged calls, and the calls each can have waiting.
+            static constexpr size_t HEDGE_THREADS = 8;
+            static constexpr size_t HEDGE_QUEUE = 4;
+
+            ServicePool() = delete;
+
+            /**
+             * @brief Create a pool for each replica of each service of the
+             * MicroservicesManager list, with its circuit breaker.
+             * A service may set the slow-call threshold of its breakers with "SlowCallMs",
+             * how long they stay open with "OpenForMs",
+             * and the shared memory segment it creates when it runs on the same host with "Shm".
+             * It has to be called once, before the server starts listening.
+             *
+             */
+            static void open_pools(void);
+
+            /**
+             * @brief Send a request to a microservice on a pooled connection.
+             *
+             * @param service The service name (e.g. stt).
+             * @param path The path under the service URL (e.g. task).
+             * @param body The JSON body.
+             * @param timeout The maximum time to wait for the answer.
+             * @return Result
+             */
+            static Result post(const std::string &service, const std::string &path,
+                const std::string &body,
+                std::chrono::milliseconds timeout = std::chrono::milliseconds(5000));
+
+            /**
+             * @brief Send a request to a microservice before a deadline, usually
+             * the one of the session the request is made for.
+             * The call goes to a replica whose breaker is closed, with the time left
+             * before the deadline as timeout. An idempotent call that the replica
+             * hasn't answered within its p95 latency is sent to a second replica
+             * too, and the first successful answer is kept. Hedged calls run on
+             * a bounded pool of threads: when it is full, the call is sent from
+             * the caller and isn't hedged.
+             *
+             * @param service The service name (e.g. stt).
+             * @param path The path under the service URL (e.g. task).
+             * @param body The JSON body.
+             * @param deadline The time by which the answer is needed.
+             * @param idempotent Whether the request may be sent twice.
+             * @return Result Failed right away if the deadline is over or
+             * every breaker of the service is open.
+             */
+            static Result post(const std::string &service, const std::string &path,
+                const std::string &body, Clock::time_point deadline, bool idempotent);
+
+            /**
+             * @brief Send an audio task to a microservice with its raw samples.
+             * A service running on the same host with a "Shm" segment gets the
+             * samples as they are through shared memory. Otherwise, or while its
+             * segment isn't available, they are Base64-encoded into the payload of
+             * the task and sent over the network like any other post.
+             *
+             * @param service The service name (e.g. stt).
+             * @param task The task_request message, without its payload.
+             * @param samples The raw samples (e.g. PCM16).
+             * @param deadline The time by which the answer is needed.
+             * @param idempotent Whether the request may be sent twice.
+             * @return Result
+             */
+            static Result post_samples(const std::string &service, const nlohmann::json &task,
+                std::string_view samples, Clock::time_point deadline, bool idempotent);
+
+            /**
+             * @brief Send a request to a microservice and read its answer as a stream,
+             * e.g. audio that the service sends while it is still producing it.
+             * The call is never hedged.
+             *
+             * @param service The service name (e.g. tts).
+             * @param path The path under the service URL (e.g. stream).
+             * @param body The JSON body.
+             * @param deadline The time by which the whole answer is needed.
+             * @param on_data Called with each part of the body. Result::body stays empty.
+             * @return Result Failed if on_data aborted the call.
+             */
+            static Result post_stream(const std::string &service, const std::string &path,
+                const std::string &body, Clock::time_point deadline, const OnData &on_data);
+
+            /**
+             * @brief Build the warmup task of a microservice: a short silent
+             * clip for audio services and a short sentence for text services.
+             *
+             * @param service The service name.
+             * @return nlohmann::json The task_request message.
+             */
+            static nlohmann::json get_warmup_task(const std::string &service);
+
+            /**
+             * @brief Warm every pooled connection of every service up,
+             * retrying with backoff until it succeeds or stop is set.
+             *
+             * @param stop Set to abort the warmup.
+             */
+            static void warmup_all(const std::atomic<bool> &stop);
+
+            /**
+             * @brief Whether every service is warmed up.
+             *
+             * @return true
+             * @return false
+             */
+            static bool is_ready(void);
+
+            /**
+             * @brief Get the warmup state of each service.
+             *
+             * @return nlohmann::json
+             */
+            static nlohmann::json get_states(void);
+
+            /**
+             * @brief Get the breaker state and the p95 latency of each replica of each service.
+             *
+             * @return nlohmann::json
+             */
+            static nlohmann::json get_circuits(void);
+
+            /**
+             * @brief Get the name of a warmup state.
+             *
+             * @param state
+             * @return std::string
+             */
+            static std::string get_state_name(State state);
+
+        protected:
+        private:
+            struct __Replica {
+                __Replica(const std::string &url, const CircuitBreaker::Thresholds &thresholds)
+                    : url(url), breaker(thresholds) {}
+
+                std::string url;
+                std::mutex mutex;
+                std::condition_variable available;
+                std::vector<std::unique_ptr<cpr::Session>> idle;
+                size_t created = 0;
+                std::atomic<bool> warm{false};
+                CircuitBreaker breaker;
+            };
+
+            struct __Pool {
+                std::vector<std::unique_ptr<__Replica>> replicas;
+                std::atomic<size_t> next{0};
+                std::atomic<State> state{State::COLD};
+                std::unique_ptr<ShmChannel> shm;
+            };
+
+            struct __Race;
+
+            static __Pool *__find(const std::string &service);
+            static __Replica *__pick(__Pool &pool, const __Replica *skip);
+            static Result __send(const std::string &service, __Replica &replica,
+                const std::string &path, const std::string &body, Clock::time_point deadline,
+                const OnData *on_data = nullptr);
+            static bool __launch(const std::shared_ptr<__Race> &race, const std::string &service,
+                __Replica &replica, const std::string &path, const std::string &body,
+                Clock::time_point deadline);
+            static void __warmup(const std::string &service, __Pool &pool, __Replica &replica,
+                const std::atomic<bool> &stop);
+            static std::unique_ptr<cpr::Session> __acquire(__Replica &replica,
+                Clock::time_point deadline);
+            static void __release(__Replica &replica, std::unique_ptr<cpr::Session> session);
+
+            static inline std::unordered_map<std::string, std::unique_ptr<__Pool>> __pools;
+            // After the pools, so the calls on the way are done before they go away.
+            static inline WorkerPool __callers{"SERVICES", HEDGE_THREADS, HEDGE_QUEUE};
+    };
+}
@@ -0,0 +1,112 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the ShmChannel class, which talks to a microservice
+** running on the same host through a shared memory segment it created:
+** one ShmRing for the requests and one for the replies.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include "ShmRing.hpp"
+
+namespace talkup_network {
+    class ShmChannel {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            /**
+             * @brief Outcome of a call.
+             * UNAVAILABLE means nothing was sent and the network path has to be used.
+             */
+            enum class Status {
+                OK,
+                UNAVAILABLE,
+                TIMEOUT,
+            };
+
+            // Segment header: magic, version, ring capacity, service pid and the
+            // heartbeat of the service (CLOCK_MONOTONIC, in ms), then the two rings.
+            static constexpr uint32_t MAGIC = 0x4b4c4154;
+            static constexpr uint32_t VERSION = 1;
+            static constexpr size_t SEGMENT_HEADER_SIZE = 64;
+            static constexpr size_t CAPACITY_OFFSET = 8;
+            static constexpr size_t HEARTBEAT_OFFSET = 16;
+            static constexpr int64_t HEARTBEAT_TIMEOUT_MS = 2000;
+            static constexpr std::chrono::milliseconds RETRY_DELAY{1000};
+
+            /**
+             * @brief Construct a new ShmChannel object. Nothing is opened until the first call.
+             *
+             * @param name The shared memory segment name (e.g. talkup_stt).
+             */
+            ShmChannel(const std::string &name);
+
+            /**
+             * @brief Destroy the ShmChannel object
+             *
+             */
+            ~ShmChannel();
+
+            ShmChannel(const ShmChannel &) = delete;
+            ShmChannel &operator=(const ShmChannel &) = delete;
+
+            /**
+             * @brief Whether the service is attached and alive (its heartbeat is recent).
+             * The segment is opened again at most once per RETRY_DELAY while it isn't.
+             *
+             * @return true
+             * @return false
+             */
+            bool is_available(void);
+
+            /**
+             * @brief Send a request and wait for its reply.
+             *
+             * @param meta The JSON message, without its payload.
+             * @param data The raw payload (e.g. PCM samples), copied as it is.
+             * @param deadline The time by which the reply is needed.
+             * @param reply Set to the JSON reply.
+             * @return Status
+             */
+            Status call(std::string_view meta, std::string_view data, Clock::time_point deadline,
+                std::string &reply);
+
+        protected:
+        private:
+            struct __Pending {
+                std::condition_variable replied;
+                bool done = false;
+                std::string reply;
+            };
+
+            bool __attach(void);
+            void __detach(void);
+            bool __is_alive(void) const;
+            void __read_replies(void);
+
+            std::string __name;
+            std::mutex __mutex;
+            void *__mapping = nullptr;
+            size_t __size = 0;
+            std::unique_ptr<ShmRing> __requests;
+            std::unique_ptr<ShmRing> __replies;
+            std::thread __reader;
+            std::atomic<bool> __stopping{false};
+            Clock::time_point __last_attempt;
+            std::atomic<uint64_t> __next_id{0};
+            std::mutex __pending_mutex;
+            std::unordered_map<uint64_t, __Pending *> __pending;
+    };
+}
@@ -0,0 +1,109 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the ShmRing class, a single-producer/single-consumer
+** ring of records laid out in shared memory, with a futex to wake the consumer.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace talkup_network {
+    class ShmRing {
+        public:
+
+            /**
+             * @brief A record read from the ring.
+             * Its views point into the ring and stay valid until pop is called.
+             */
+            struct Record {
+                uint64_t id = 0;
+                std::string_view meta;
+                std::string_view data;
+            };
+
+            // Ring header: tail, futex word and waiting flag on the producer's
+            // cache line, head on the consumer's one.
+            static constexpr size_t HEADER_SIZE = 128;
+            static constexpr size_t TAIL_OFFSET = 0;
+            static constexpr size_t SEQ_OFFSET = 8;
+            static constexpr size_t WAITING_OFFSET = 12;
+            static constexpr size_t HEAD_OFFSET = 64;
+            // Record header: total size, meta size and id, then meta and data, padded to 8.
+            static constexpr size_t RECORD_HEADER_SIZE = 16;
+            static constexpr uint32_t WRAP_MARKER = 0xffffffff;
+
+            /**
+             * @brief Construct a new ShmRing object over mapped memory.
+             *
+             * @param base Start of the ring header, 64-byte aligned.
+             * @param capacity Size of the data area, a power of two.
+             */
+            ShmRing(void *base, size_t capacity);
+
+            /**
+             * @brief Destroy the ShmRing object. The memory stays mapped.
+             *
+             */
+            ~ShmRing() = default;
+
+            /**
+             * @brief Get the size of a ring in memory.
+             *
+             * @param capacity Size of the data area.
+             * @return size_t
+             */
+            static size_t get_size(size_t capacity);
+
+            /**
+             * @brief Write a record and wake the consumer if it sleeps.
+             * Only one thread may push at a time.
+             *
+             * @param id The record id, used to match the replies.
+             * @param meta The JSON metadata.
+             * @param data The raw bytes, copied as they are.
+             * @return true
+             * @return false if the ring is full or the record can never fit.
+             */
+            bool push(uint64_t id, std::string_view meta, std::string_view data);
+
+            /**
+             * @brief Read the oldest record without consuming it.
+             *
+             * @param record Set to the record.
+             * @return true
+             * @return false if the ring is empty.
+             */
+            bool peek(Record &record);
+
+            /**
+             * @brief Consume the record read by peek.
+             *
+             */
+            void pop(void);
+
+            /**
+             * @brief Sleep until the ring has a record or the timeout is over.
+             *
+             * @param timeout
+             * @return true if the ring has a record.
+             * @return false
+             */
+            bool wait(std::chrono::milliseconds timeout);
+
+        protected:
+        private:
+            uint64_t *__field64(size_t offset) const;
+            uint32_t *__field32(size_t offset) const;
+
+            char *__base;
+            char *__data;
+            size_t __capacity;
+            size_t __peeked = 0;
+    };
+}
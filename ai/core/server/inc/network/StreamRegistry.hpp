@@ -0,0 +1,217 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the StreamRegistry class, which keeps track of the
+** streams opened on the WebSocket so a client can resume them after a reconnect.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <crow.h>
+#include "MemoryBudget.hpp"
+
+namespace talkup_network {
+    class StreamRegistry {
+        public:
+
+            /**
+             * @brief Callback used to send a message on a connection.
+             */
+            using Sender = std::function<void(crow::websocket::connection&,
+                const nlohmann::json&)>;
+
+            /**
+             * @brief Outcome of a chunk submitted to the registry.
+             */
+            enum class ChunkStatus {
+                ACCEPTED,
+                DUPLICATE,
+                OWNED_ELSEWHERE,
+            };
+
+            /**
+             * @brief Who a stream is bound to, seen from a connection.
+             */
+            enum class Ownership {
+                NONE,
+                OWNED,
+                ELSEWHERE,
+            };
+
+            /**
+             * @brief Construct a new StreamRegistry object
+             *
+             * @param window_size Number of outbound messages kept per stream.
+             * @param grace_period How long a detached stream can be resumed.
+             */
+            StreamRegistry(size_t window_size = 512,
+                std::chrono::seconds grace_period = std::chrono::seconds(120));
+
+            /**
+             * @brief Destroy the StreamRegistry object
+             *
+             */
+            ~StreamRegistry() = default;
+
+            /**
+             * @brief Account for the retention windows in a memory budget.
+             * Must be set before the first stream is registered.
+             *
+             * @param budget
+             */
+            void set_budget(MemoryBudget *budget);
+
+            /**
+             * @brief Register a chunk of a stream received on a connection.
+             * The stream is created on its first chunk and bound to the connection.
+             *
+             * @param stream_id The stream ID.
+             * @param seq The sequence number of the chunk.
+             * @param conn The WebSocket connection object.
+             * @param resume_token Set to the resume token when the stream is new.
+             * @return ChunkStatus DUPLICATE when the chunk was already received.
+             */
+            ChunkStatus submit_chunk(const std::string &stream_id, int64_t seq,
+                crow::websocket::connection &conn, std::string &resume_token);
+
+            /**
+             * @brief Keep an outbound message in the stream retention window
+             * and send it if the stream is bound to a connection.
+             *
+             * @param stream_id The stream ID.
+             * @param seq The sequence number of the chunk the message answers.
+             * @param message The message to send.
+             * @param sender The callback used to send the message.
+             */
+            void deliver(const std::string &stream_id, int64_t seq,
+                const nlohmann::json &message, const Sender &sender);
+
+            /**
+             * @brief Send a message to the connection a stream is bound to,
+             * without keeping it for a resume.
+             *
+             * @param stream_id The stream ID.
+             * @param message The message to send.
+             * @param sender The callback used to send the message.
+             * @return true if the stream was bound to a connection.
+             */
+            bool send(const std::string &stream_id, const nlohmann::json &message,
+                const Sender &sender);
+
+            /**
+             * @brief Bind a stream back to a new connection.
+             *
+             * @param stream_id The stream ID.
+             * @param resume_token The token given with the first acknowledge.
+             * @param last_acked_seq The last sequence acknowledged by the client.
+             * @param conn The new WebSocket connection object.
+             * @param last_received_seq Set to the last chunk received by the server.
+             * @param replay Filled with the retained messages after last_acked_seq.
+             * @return true if the stream was resumed.
+             */
+            bool resume(const std::string &stream_id, const std::string &resume_token,
+                int64_t last_acked_seq, crow::websocket::connection &conn,
+                int64_t &last_received_seq, std::vector<nlohmann::json> &replay);
+
+            /**
+             * @brief Detach the streams of a closing connection.
+             * They are kept for the grace period, waiting for a resume.
+             *
+             * @param conn The WebSocket connection object.
+             * @return std::vector<std::string> The IDs of the detached streams.
+             */
+            std::vector<std::string> detach(crow::websocket::connection &conn);
+
+            /**
+             * @brief Drop a stream if it has been detached for longer than the grace period.
+             *
+             * @param stream_id The stream ID.
+             * @return true if the stream was dropped.
+             */
+            bool expire(const std::string &stream_id);
+
+            /**
+             * @brief Drop a detached stream before the end of its grace period,
+             * to give its memory back.
+             *
+             * @param stream_id The stream ID.
+             * @return true if the stream was dropped.
+             */
+            bool drop(const std::string &stream_id);
+
+            /**
+             * @brief Empty the retention window of a stream: the messages it
+             * holds can't be replayed anymore.
+             *
+             * @param stream_id The stream ID.
+             * @return size_t The number of messages dropped.
+             */
+            size_t trim(const std::string &stream_id);
+
+            /**
+             * @brief Get the streams bound to a connection.
+             *
+             * @param conn The WebSocket connection object.
+             * @return std::vector<std::string>
+             */
+            std::vector<std::string> get_streams(crow::websocket::connection &conn);
+
+            /**
+             * @brief Get whether a stream is bound to a connection.
+             *
+             * @param stream_id The stream ID.
+             * @param conn The WebSocket connection object.
+             * @return Ownership NONE for an unknown stream, ELSEWHERE when it is
+             * bound to another connection or detached.
+             */
+            Ownership get_ownership(const std::string &stream_id, crow::websocket::connection &conn);
+
+            /**
+             * @brief Drop the streams detached for longer than the grace period.
+             * It goes through every stream: expire is meant to be called on a
+             * timer for each detached stream instead.
+             *
+             */
+            void reap_expired(void);
+
+            /**
+             * @brief Get how long a detached stream can be resumed.
+             *
+             * @return std::chrono::seconds
+             */
+            std::chrono::seconds get_grace_period(void) const;
+
+        protected:
+        private:
+            struct __Stream {
+                std::string resume_token;
+                crow::websocket::connection *conn = nullptr;
+                int64_t last_received_seq = -1;
+                std::deque<std::pair<int64_t, nlohmann::json>> window;
+                size_t window_bytes = 0;
+                std::chrono::steady_clock::time_point detached_at;
+            };
+
+            std::string __generate_token(void);
+            void __erase(std::unordered_map<std::string, __Stream>::iterator it);
+            bool __is_expired(const __Stream &stream, std::chrono::steady_clock::time_point now) const;
+
+            size_t __window_size;
+            std::chrono::seconds __grace_period;
+            MemoryBudget *__budget = nullptr;
+            std::unordered_map<std::string, __Stream> __streams;
+            std::unordered_map<crow::websocket::connection *,
+                std::vector<std::string>> __streams_by_conn;
+            std::mutex __mutex;
+    };
+}
@@ -0,0 +1,101 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the TlsContext class, which holds the certificate and
+** the session resumption settings the transports terminate TLS with.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+// OpenSSL's context, without its headers.
+struct ssl_ctx_st;
+
+namespace talkup_network {
+    class TlsContext {
+        public:
+
+            /**
+             * @brief Certificate, resumption and offload settings.
+             */
+            struct Options {
+                std::string cert_file;
+                std::string key_file;
+                // 80 bytes shared by the instances, so a ticket is accepted by
+                // any of them. Empty for a random key per process.
+                std::string ticket_key_file;
+                std::chrono::seconds session_timeout{7200};
+                size_t session_cache_size = 20480;
+                // Hand the record layer over to the kernel when it supports it.
+                bool ktls = true;
+            };
+
+            /**
+             * @brief Construct a new TlsContext object
+             *
+             * @param options
+             * @throw ExceptionManager::ServerTlsException if the certificate or
+             * the key can't be loaded, or the server was built without TLS.
+             */
+            TlsContext(const Options &options);
+
+            /**
+             * @brief Destroy the TlsContext object
+             *
+             */
+            ~TlsContext();
+
+            TlsContext(const TlsContext &) = delete;
+            TlsContext &operator=(const TlsContext &) = delete;
+
+            /**
+             * @brief Whether the server was built with TLS (OpenSSL found).
+             *
+             * @return true
+             * @return false
+             */
+            static bool is_supported(void);
+
+            /**
+             * @brief Read the options from the environment: TLS_CERT_FILE,
+             * TLS_KEY_FILE, TLS_TICKET_KEY_FILE and TLS_KTLS (0 to disable).
+             *
+             * @param options Filled with the variables which are set.
+             * @return true if a certificate is configured.
+             */
+            static bool get_env_options(Options &options);
+
+            /**
+             * @brief Apply the settings to another OpenSSL context (e.g. the one
+             * of Crow's Asio stack).
+             *
+             * @param context
+             * @throw ExceptionManager::ServerTlsException
+             */
+            void configure(ssl_ctx_st *context) const;
+
+            /**
+             * @brief Get the OpenSSL context, shared by every connection.
+             *
+             * @return ssl_ctx_st*
+             */
+            ssl_ctx_st *get_native(void) const;
+
+            /**
+             * @brief Get the options.
+             *
+             * @return const Options&
+             */
+            const Options &get_options(void) const;
+
+        protected:
+        private:
+            Options __options;
+            std::string __ticket_keys;
+            ssl_ctx_st *__context = nullptr;
+    };
+}
@@ -0,0 +1,175 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the TtsStreamer class, which relays the audio of the
+** text-to-speech service to the client while it is being synthesized,
+** as fixed-size frames sent at the pace of playback.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "ServicePool.hpp"
+#include "WorkerPool.hpp"
+
+namespace talkup_network {
+    class TtsStreamer {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            /**
+             * @brief One frame of an utterance.
+             * The last frame has last set, and error set if the synthesis failed.
+             */
+            struct Frame {
+                std::string utterance_id;
+                int64_t seq = 0;
+                std::string audio;
+                bool last = false;
+                std::string error;
+            };
+
+            /**
+             * @brief Sends a frame to the client. It is never called after
+             * the utterance has been cancelled.
+             */
+            using Sink = std::function<void(const Frame &frame)>;
+
+            /**
+             * @brief Synthesizes a text, handing the audio to on_audio as it comes.
+             * ServicePool::post_stream on the tts service by default.
+             */
+            using Source = std::function<ServicePool::Result(const std::string &text,
+                Clock::time_point deadline, const ServicePool::OnData &on_audio)>;
+
+            /**
+             * @brief Frame size and pacing. Frames go out as soon as they are
+             * full, but no more than lead ahead of real-time playback, so the
+             * client keeps a jitter buffer of lead without being flooded.
+             * At most max_utterances are synthesized at once, max_per_owner
+             * for one connection, an interrupted one counting until its
+             * synthesis has stopped.
+             */
+            struct Options {
+                size_t frame_bytes = 1280;
+                std::chrono::milliseconds frame_duration{40};
+                std::chrono::milliseconds lead{200};
+                std::chrono::milliseconds timeout{30000};
+                size_t max_utterances = 16;
+                size_t max_per_owner = 4;
+            };
+
+            /**
+             * @brief Outcome of a speak.
+             */
+            enum class SpeakStatus {
+                STARTED,
+                OWNED_ELSEWHERE,
+                BUSY,
+            };
+
+            /**
+             * @brief Construct a new TtsStreamer object using the tts service
+             *
+             */
+            TtsStreamer(void);
+
+            /**
+             * @brief Construct a new TtsStreamer object
+             *
+             * @param options
+             * @param source
+             */
+            TtsStreamer(const Options &options, Source source);
+
+            /**
+             * @brief Destroy the TtsStreamer object.
+             * Every utterance is cancelled, and its threads are waited for.
+             *
+             */
+            ~TtsStreamer();
+
+            TtsStreamer(const TtsStreamer &) = delete;
+            TtsStreamer &operator=(const TtsStreamer &) = delete;
+
+            /**
+             * @brief Start speaking a text on a stream, interrupting what
+             * the stream was saying for the same owner.
+             *
+             * @param stream_id The stream ID.
+             * @param owner The connection the frames go to, for cancel_owner.
+             * @param text The text to say.
+             * @param sink Called with each frame, from another thread.
+             * @param utterance_id Set to the utterance ID when it is started.
+             * @return SpeakStatus OWNED_ELSEWHERE when the stream speaks to
+             * another connection, BUSY when over max_utterances or max_per_owner.
+             */
+            SpeakStatus speak(const std::string &stream_id, const void *owner,
+                const std::string &text, Sink sink, std::string &utterance_id);
+
+            /**
+             * @brief Stop the utterance of a stream (e.g. the user interrupts it).
+             * No frame of it is sent once this returns.
+             *
+             * @param stream_id The stream ID.
+             * @param owner The connection which started it: the utterances
+             * of other connections are left alone.
+             * @return true if the stream was speaking to owner.
+             */
+            bool cancel(const std::string &stream_id, const void *owner);
+
+            /**
+             * @brief Stop the utterances sent to a connection, before it goes away.
+             *
+             * @param owner The connection.
+             */
+            void cancel_owner(const void *owner);
+
+        protected:
+        private:
+            struct __Utterance {
+                std::string id;
+                std::string stream_id;
+                const void *owner = nullptr;
+                // The trace of the speak, its tasks run in it.
+                uint64_t trace_id = 0;
+                Sink sink;
+                std::mutex mutex;
+                std::condition_variable changed;
+                std::string audio;
+                bool synthesized = false;
+                std::string error;
+                std::atomic<bool> cancelled{false};
+                // Its synthesis and pacing tasks still running.
+                std::atomic<int> running{2};
+            };
+
+            void __synthesize(std::shared_ptr<__Utterance> utterance, std::string text,
+                Clock::time_point deadline);
+            void __pace(std::shared_ptr<__Utterance> utterance);
+            void __finish(__Utterance &utterance);
+            static void __stop(__Utterance &utterance);
+
+            Options __options;
+            Source __source;
+            std::mutex __mutex;
+            std::unordered_map<std::string, std::shared_ptr<__Utterance>> __utterances;
+            // Utterances whose tasks still run, in all and per owner.
+            size_t __running = 0;
+            std::unordered_map<const void *, size_t> __running_by_owner;
+            uint64_t __next_id = 0;
+            // Last, so their tasks are done before the rest goes away.
+            WorkerPool __synthesizers;
+            WorkerPool __pacers;
+    };
+}
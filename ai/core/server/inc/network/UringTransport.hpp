@@ -0,0 +1,111 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the UringTransport class, which serves the routes over
+** io_uring: HTTP/1.1, the WebSocket upgrade and the framing are done here.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ITransport.hpp"
+#include "TlsContext.hpp"
+#include "WorkerPool.hpp"
+
+namespace talkup_network {
+    class UringTransport : public ITransport {
+        public:
+            static constexpr unsigned RING_ENTRIES = 4096;
+            static constexpr unsigned RECV_BUFFERS = 1024;
+            static constexpr size_t RECV_BUFFER_SIZE = 16 * 1024;
+            static constexpr size_t ZERO_COPY_THRESHOLD = 16 * 1024;
+            static constexpr size_t MAX_HEADER_SIZE = 16 * 1024;
+            static constexpr size_t MAX_BODY_SIZE = 1024 * 1024;
+            static constexpr size_t MAX_MESSAGE_SIZE = 16 * 1024 * 1024;
+            // Messages of a connection waiting for a handler before it is closed.
+            static constexpr size_t MAX_PENDING_MESSAGES = 256;
+            static constexpr size_t HANDLER_QUEUE = 1024;
+
+            /**
+             * @brief Construct a new UringTransport object
+             *
+             * @param threads Number of event loops, one ring and one listening
+             * socket each. 0 uses one per hardware thread.
+             * @param tls Serve HTTPS and WSS with these settings, plain HTTP if null.
+             * The record layer goes to the kernel (kTLS) when it supports it.
+             */
+            UringTransport(size_t threads = 0, std::shared_ptr<TlsContext> tls = nullptr);
+
+            /**
+             * @brief Destroy the UringTransport object
+             *
+             */
+            ~UringTransport() override;
+
+            /**
+             * @brief Whether the kernel and the headers the server was built
+             * with support every io_uring feature used here (Linux 6.0+).
+             *
+             * @return true
+             * @return false
+             */
+            static bool is_supported(void);
+
+            /**
+             * @brief Open the listening sockets and run the event loops until stop is called.
+             *
+             * @param router The router handling the requests and messages.
+             * @param port
+             * @return true
+             * @return false if a socket or a ring couldn't be set up.
+             */
+            bool run(Router &router, int port) override;
+
+            /**
+             * @brief Block until every event loop accepts connections.
+             *
+             */
+            void wait_for_start(void) override;
+
+            /**
+             * @brief Stop the event loops.
+             *
+             */
+            void stop(void) override;
+
+            /**
+             * @brief Get the transport name.
+             *
+             * @return std::string
+             */
+            std::string get_transport_name(void) const override;
+
+        protected:
+        private:
+            class __Loop;
+
+            /**
+             * @brief Block until stop is called or SIGINT/SIGTERM is received, then stop.
+             *
+             */
+            void __wait_for_stop(void);
+
+            size_t __threads;
+            std::shared_ptr<TlsContext> __tls;
+            // The messages are handled here, not on the loops.
+            std::unique_ptr<WorkerPool> __handlers;
+            std::vector<std::unique_ptr<__Loop>> __loops;
+            std::atomic<bool> __stopping{false};
+            std::mutex __start_mutex;
+            std::condition_variable __start_cv;
+            bool __started = false;
+            int __stop_fd = -1;
+    };
+}
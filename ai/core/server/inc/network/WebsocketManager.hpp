@@ -10,8 +10,24 @@
 
 #include <string>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <nlohmann/json.hpp>
 #include <crow.h>
+#include "Batcher.hpp"
+#include "Broadcaster.hpp"
+#include "MemoryBudget.hpp"
+#include "MessageArena.hpp"
+#include "MessageSchema.hpp"
+#include "Messages.hpp"
+#include "ProsodyExtractor.hpp"
+#include "StreamRegistry.hpp"
+#include "TimerService.hpp"
+#include "TranscriptStore.hpp"
+#include "TtsStreamer.hpp"
+#include "WorkerPool.hpp"
 
 namespace talkup_network {
     class WsManager {
@@ -20,8 +36,12 @@ namespace talkup_network {
             /**
              * @brief Construct a new WsManager object
              *
+             * @param timers Runs the expiry of the abandoned streams and the
+             * deadlines of the services. It must be stopped before the WsManager
+             * is destroyed.
+             * @param memory Accounts for the buffered data of the streams.
              */
-            WsManager();
+            WsManager(TimerService &timers, MemoryBudget &memory);
 
             /**
              * @brief Destroy the WsManager object
@@ -39,6 +59,19 @@ namespace talkup_network {
                 std::string format;
                 int64_t timestamp;
                 std::string data;
+                std::optional<int64_t> seq;
+
+                static constexpr auto get_fields(void)
+                {
+                    return std::make_tuple(
+                        schema::field("type", &WebSocketConnectionInfo::type),
+                        schema::field("key", &WebSocketConnectionInfo::key),
+                        schema::field("stream_id", &WebSocketConnectionInfo::stream_id),
+                        schema::field("format", &WebSocketConnectionInfo::format),
+                        schema::field("timestamp", &WebSocketConnectionInfo::timestamp),
+                        schema::field("data", &WebSocketConnectionInfo::data),
+                        schema::field("seq", &WebSocketConnectionInfo::seq));
+                }
             };
 
             /**
@@ -46,43 +79,237 @@ namespace talkup_network {
              * Based on the communication protocol, it will handle the type of connection.
              * (e.g., ping, stream_chunk, error...)
              *
-             * @param j The JSON object containing the message data.
+             * @param header The fields every message carries, already validated.
+             * @param json The JSON object containing the message data.
              * @param conn The WebSocket connection object.
              */
-            void connection_type_manager(nlohmann::json &json, crow::websocket::connection& conn);
+            void connection_type_manager(const messages::Header &header, message_json &json,
+                crow::websocket::connection& conn);
 
             /**
-             * @brief With the given parameters, it will set the respond JSON format and return it.
+             * @brief Serialize a reply to the client.
              *
-             * @param type The type of the message.
-             * @param key The key associated with the message.
-             * @param stream_id The stream ID associated with the message.
-             * @param format The format of the message.
-             * @param timestamp The timestamp of the message.
-             * @param data The data of the message.
+             * @param info The reply. Its seq is omitted when it has none.
              */
             nlohmann::json set_respond_json_format(const WebSocketConnectionInfo& info) const;
 
+            /**
+             * @brief Get the acknowledge of a message, with its key, stream_id,
+             * format and timestamp.
+             *
+             * @param header The fields of the message acknowledged.
+             * @param data What is acknowledged.
+             * @return WebSocketConnectionInfo
+             */
+            static WebSocketConnectionInfo get_acknowledge(const messages::Header &header,
+                const std::string &data);
+
+            /**
+             * @brief Send a message on the connection, with the encoding
+             * negotiated by the client (JSON by default).
+             *
+             * Defined for nlohmann::json and message_json.
+             *
+             * @param conn The WebSocket connection object.
+             * @param json The message to send.
+             */
+            template <typename Json>
+            void send(crow::websocket::connection &conn, const Json &json) const;
+
+            /**
+             * @brief Release the state bound to a closing connection.
+             * Its streams stay resumable for the grace period, then their
+             * transcript is written to disk and released.
+             * Calling it again for the same connection does nothing.
+             *
+             * @param conn The WebSocket connection object.
+             */
+            void on_connection_closed(crow::websocket::connection& conn);
+
+            /**
+             * @brief Add a speech-to-text result to the transcript of a stream.
+             *
+             * @param stream_id The stream ID.
+             * @param result The speech-to-text result.
+             * @param offset_ms Position of the recognized audio in the stream.
+             */
+            void on_stt_result(const std::string &stream_id, const nlohmann::json &result,
+                int64_t offset_ms);
+
+            /**
+             * @brief Send an event of a stream (analysis result, transcript...)
+             * to the connection owning the stream and to its observers.
+             *
+             * @param stream_id The stream ID.
+             * @param seq The sequence number of the chunk the event comes from.
+             * @param event The event.
+             */
+            void publish_event(const std::string &stream_id, int64_t seq, const nlohmann::json &event);
+
         protected:
 
             /**
              * @brief Handle a ping message from the client.
              *
+             * @param header The fields every message carries.
              * @param json The JSON object containing the ping message.
              * @param conn The WebSocket connection object.
              */
-            void handle_ping(const nlohmann::json& json, crow::websocket::connection& conn);
+            void handle_ping(const messages::Header& header, const message_json& json,
+                crow::websocket::connection& conn);
+
+            /**
+             * @brief Handle a status message from the client.
+             * It answers with the live load report of the server, and the memory
+             * used by the streams of the connection.
+             *
+             * @param header The fields every message carries.
+             * @param json The JSON object containing the status message.
+             * @param conn The WebSocket connection object.
+             */
+            void handle_status(const messages::Header& header, const message_json& json,
+                crow::websocket::connection& conn);
 
             /**
              * @brief Handle a stream chunk message from the client.
+             * A chunk which doesn't fit the memory budget is refused, and can
+             * be sent again with the same seq.
              *
+             * @param header The fields every message carries.
              * @param json The JSON object containing the stream chunk message.
              * @param conn The WebSocket connection object.
              */
-            void handle_stream_chunk(const nlohmann::json& json, crow::websocket::connection& conn);
+            void handle_stream_chunk(const messages::Header& header, const message_json& json,
+                crow::websocket::connection& conn);
+
+            /**
+             * @brief Handle a resume message from a reconnecting client.
+             * The messages the client missed are sent again.
+             *
+             * @param header The fields every message carries.
+             * @param json The JSON object containing the resume message.
+             * @param conn The WebSocket connection object.
+             */
+            void handle_resume(const messages::Header& header, const message_json& json,
+                crow::websocket::connection& conn);
+
+            /**
+             * @brief Handle a transcript query from the client.
+             * It answers with the words of a time range (`from_ms`/`to_ms` in data)
+             * or with the full transcript so far.
+             *
+             * @param header The fields every message carries.
+             * @param json The JSON object containing the query.
+             * @param conn The WebSocket connection object.
+             */
+            void handle_transcript_query(const messages::Header& header, const message_json& json,
+                crow::websocket::connection& conn);
+
+            /**
+             * @brief Handle the end of a stream from the client.
+             * Its transcript is written to disk and its name is sent back.
+             *
+             * @param header The fields every message carries.
+             * @param json The JSON object containing the stream end message.
+             * @param conn The WebSocket connection object.
+             */
+            void handle_stream_end(const messages::Header& header, const message_json& json,
+                crow::websocket::connection& conn);
+
+            /**
+             * @brief Handle a subscribe message from an observer.
+             * The connection then receives the events of the stream.
+             *
+             * @param header The fields every message carries.
+             * @param json The JSON object containing the subscribe message.
+             * @param conn The WebSocket connection object.
+             */
+            void handle_subscribe(const messages::Header& header, const message_json& json,
+                crow::websocket::connection& conn);
+
+            /**
+             * @brief Handle an unsubscribe message from an observer.
+             *
+             * @param header The fields every message carries.
+             * @param json The JSON object containing the unsubscribe message.
+             * @param conn The WebSocket connection object.
+             */
+            void handle_unsubscribe(const messages::Header& header, const message_json& json,
+                crow::websocket::connection& conn);
+
+            /**
+             * @brief Handle a speak message: the text in data is synthesized and
+             * its audio streamed back as stream_output frames while it is produced.
+             * It interrupts what the stream was saying.
+             *
+             * @param header The fields every message carries.
+             * @param json The JSON object containing the speak message.
+             * @param conn The WebSocket connection object.
+             */
+            void handle_speak(const messages::Header& header, const message_json& json,
+                crow::websocket::connection& conn);
+
+            /**
+             * @brief Handle an interrupt message: the stream stops speaking right away.
+             *
+             * @param header The fields every message carries.
+             * @param json The JSON object containing the interrupt message.
+             * @param conn The WebSocket connection object.
+             */
+            void handle_interrupt(const messages::Header& header, const message_json& json,
+                crow::websocket::connection& conn);
+
+            /**
+             * @brief Send an audio chunk to the audio microservices, batched with
+             * the chunks of the other sessions. The analyzers get its prosody
+             * features instead of its samples. Their results are published on the stream.
+             *
+             * @param chunk The acknowledge of the chunk (key, stream_id, seq).
+             * @param samples The PCM16 samples of the chunk.
+             * @param reservation The memory reserved for the samples, held
+             * until the services answer.
+             */
+            void submit_audio(const WebSocketConnectionInfo& chunk, std::string samples,
+                std::shared_ptr<MemoryBudget::Reservation> reservation = nullptr);
 
         private:
-            std::unordered_map<std::string, std::function<void(const nlohmann::json&,
-                crow::websocket::connection&)>> _type_handlers;
+            Batcher *get_batcher(const std::string &service);
+            void expire_stream(const std::string &stream_id);
+            void evict_stream(const std::string &stream_id, bool detached);
+            void compact_stream(const std::string &stream_id, int attempt = 0,
+                std::function<void(const TranscriptStore::Compaction &)> on_done = nullptr);
+
+            using Handler = void (WsManager::*)(const messages::Header&, const message_json&,
+                crow::websocket::connection&);
+
+            // A new type only needs its line here: the perfect hash is built at compile time.
+            static constexpr auto _type_handlers = schema::make_dispatcher<Handler>({
+                { "ping", &WsManager::handle_ping },
+                { "stream_chunk", &WsManager::handle_stream_chunk },
+                { "status", &WsManager::handle_status },
+                { "resume", &WsManager::handle_resume },
+                { "transcript_query", &WsManager::handle_transcript_query },
+                { "stream_end", &WsManager::handle_stream_end },
+                { "subscribe", &WsManager::handle_subscribe },
+                { "unsubscribe", &WsManager::handle_unsubscribe },
+                { "speak", &WsManager::handle_speak },
+                { "interrupt", &WsManager::handle_interrupt },
+            });
+
+            TimerService &_timers;
+            MemoryBudget &_memory;
+            StreamRegistry::Sender _sender;
+            StreamRegistry _streams;
+            TranscriptStore _transcripts;
+            Broadcaster _broadcaster;
+            std::mutex _audio_mutex;
+            std::unordered_map<std::string, int64_t> _audio_bytes;
+            std::unordered_map<std::string, std::shared_ptr<ProsodyExtractor>> _prosody;
+            TtsStreamer _speech;
+            // Writes the transcripts of the finished streams, off the timer threads.
+            WorkerPool _storage{"STORAGE", 1};
+            // Last, so the batches on the way are done before the rest goes away.
+            std::mutex _batchers_mutex;
+            std::unordered_map<std::string, std::unique_ptr<Batcher>> _batchers;
     };
 }
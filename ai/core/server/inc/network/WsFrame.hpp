@@ -0,0 +1,100 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the WsFrame class, which reads and writes the
+** WebSocket (RFC 6455) framing for the transports doing their own I/O.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace talkup_network {
+    class WsFrame {
+        public:
+
+            /**
+             * @brief Frame opcodes.
+             */
+            enum class Opcode : uint8_t {
+                CONTINUATION = 0x0,
+                TEXT = 0x1,
+                BINARY = 0x2,
+                CLOSE = 0x8,
+                PING = 0x9,
+                PONG = 0xa,
+            };
+
+            /**
+             * @brief Frame header, as read from the client.
+             */
+            struct Header {
+                bool fin = false;
+                Opcode opcode = Opcode::CONTINUATION;
+                bool masked = false;
+                uint8_t mask[4] = {0, 0, 0, 0};
+                uint64_t length = 0;
+                size_t size = 0;
+            };
+
+            static constexpr uint16_t CLOSE_NORMAL = 1000;
+            static constexpr uint16_t CLOSE_PROTOCOL_ERROR = 1002;
+            static constexpr uint16_t CLOSE_TOO_BIG = 1009;
+            static constexpr uint16_t CLOSE_TRY_AGAIN = 1013;
+
+            WsFrame() = delete;
+
+            /**
+             * @brief Read a frame header.
+             *
+             * @param data The received bytes.
+             * @param size Their number.
+             * @param header Set to the header.
+             * @return true
+             * @return false if the header isn't fully received yet.
+             */
+            static bool parse_header(const char *data, size_t size, Header &header);
+
+            /**
+             * @brief Unmask a payload in place.
+             *
+             * @param data The payload, or a part of it.
+             * @param size Its size.
+             * @param mask The mask of the frame.
+             * @param offset Position of data in the payload.
+             */
+            static void unmask(char *data, size_t size, const uint8_t mask[4], uint64_t offset = 0);
+
+            /**
+             * @brief Build a server frame (final, unmasked).
+             *
+             * @param opcode
+             * @param payload
+             * @return std::string
+             */
+            static std::string build(Opcode opcode, const std::string &payload);
+
+            /**
+             * @brief Build a close frame.
+             *
+             * @param code The close status code.
+             * @param reason
+             * @return std::string
+             */
+            static std::string build_close(uint16_t code, const std::string &reason);
+
+            /**
+             * @brief Compute the Sec-WebSocket-Accept value of the handshake.
+             *
+             * @param key The Sec-WebSocket-Key sent by the client.
+             * @return std::string
+             */
+            static std::string get_accept_key(const std::string &key);
+
+        protected:
+        private:
+    };
+}
@@ -0,0 +1,135 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the TranscriptStore class, which keeps the transcript
+** of each stream as it is recognized and answers time-range queries on it.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace talkup_network {
+    class TranscriptStore {
+        public:
+
+            /**
+             * @brief A recognized word and its timing in the stream, in milliseconds.
+             */
+            struct Word {
+                std::string text;
+                int64_t start_ms;
+                int64_t end_ms;
+            };
+
+            /**
+             * @brief A recognized segment (an utterance) and its words.
+             */
+            struct Segment {
+                std::string text;
+                int64_t start_ms;
+                int64_t end_ms;
+                std::vector<Word> words;
+            };
+
+            /**
+             * @brief Outcome of a compaction.
+             */
+            struct Compaction {
+                bool ok = true;
+                // The transcript name, empty if the stream has no transcript.
+                std::string name;
+                std::string error;
+            };
+
+            /**
+             * @brief Construct a new TranscriptStore object
+             *
+             * @param directory Where finished transcripts are written.
+             */
+            TranscriptStore(const std::string &directory = "transcripts");
+
+            /**
+             * @brief Destroy the TranscriptStore object
+             *
+             */
+            ~TranscriptStore() = default;
+
+            /**
+             * @brief Build a segment from a speech-to-text result
+             * (`text` and a `result` array of words timed in seconds).
+             *
+             * @param result The speech-to-text result.
+             * @param offset_ms Position of the recognized audio in the stream.
+             * @return Segment
+             */
+            static Segment parse_stt_result(const nlohmann::json &result, int64_t offset_ms = 0);
+
+            /**
+             * @brief Append a segment to the transcript of a stream and index its words.
+             *
+             * @param stream_id The stream ID.
+             * @param segment The recognized segment.
+             */
+            void append(const std::string &stream_id, const Segment &segment);
+
+            /**
+             * @brief Get the words said between two instants of a stream.
+             *
+             * @param stream_id The stream ID.
+             * @param from_ms Start of the range.
+             * @param to_ms End of the range.
+             * @return std::vector<Word> The words overlapping the range, in order.
+             */
+            std::vector<Word> get_words(const std::string &stream_id,
+                int64_t from_ms, int64_t to_ms) const;
+
+            /**
+             * @brief Get the full transcript of a stream so far.
+             *
+             * @param stream_id The stream ID.
+             * @return std::string
+             */
+            std::string get_text(const std::string &stream_id) const;
+
+            /**
+             * @brief Write the transcript of a finished stream to disk and release it.
+             * The file is written aside then renamed into place: a transcript
+             * which couldn't be written is kept, and can be compacted again.
+             * A segment appended once it is written starts a new transcript.
+             * The name is unique, even for two compactions of a stream in the same second.
+             *
+             * @param stream_id The stream ID.
+             * @return Compaction Not ok if the file couldn't be written.
+             */
+            Compaction compact(const std::string &stream_id);
+
+        protected:
+        private:
+            struct __Transcript {
+                mutable std::mutex mutex;
+                std::vector<Segment> segments;
+                std::vector<Word> words;
+                std::string text;
+                int64_t max_word_ms = 0;
+                // Set once written to disk: nothing is appended to it anymore.
+                bool sealed = false;
+            };
+
+            std::shared_ptr<__Transcript> __find(const std::string &stream_id) const;
+
+            std::string __directory;
+            std::atomic<uint64_t> __compactions{0};
+            std::unordered_map<std::string, std::shared_ptr<__Transcript>> __transcripts;
+            mutable std::shared_mutex __mutex;
+    };
+}
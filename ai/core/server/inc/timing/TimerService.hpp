@@ -0,0 +1,115 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the TimerService class, which runs the server timers
+** (heartbeats, idle connections, abandoned streams, service deadlines)
+** on a few timer wheels, each driven by its own thread.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TimerWheel.hpp"
+
+namespace talkup_network {
+    class TimerService {
+        public:
+            using Clock = std::chrono::steady_clock;
+            using Callback = TimerWheel::Callback;
+
+            /**
+             * @brief Identifies a timer of the service, NONE if there is none.
+             */
+            using Handle = uint64_t;
+
+            static constexpr Handle NONE = 0;
+
+            /**
+             * @brief Construct a new TimerService object
+             *
+             * @param shards The number of wheels, 0 for one per core.
+             * @param tick The wheel resolution.
+             */
+            TimerService(size_t shards = 0,
+                std::chrono::milliseconds tick = std::chrono::milliseconds(10));
+
+            /**
+             * @brief Destroy the TimerService object.
+             * Pending timers are dropped without firing.
+             *
+             */
+            ~TimerService();
+
+            /**
+             * @brief Stop the threads: no callback runs once this returns.
+             * Timers can still be cancelled afterwards, but never fire.
+             *
+             */
+            void stop(void);
+
+            TimerService(const TimerService &) = delete;
+            TimerService &operator=(const TimerService &) = delete;
+
+            /**
+             * @brief Run a callback after a delay, rounded up to the tick.
+             * Callbacks run on the thread of their wheel and must not block:
+             * file I/O goes to a WorkerPool. An exception thrown by a callback
+             * is logged.
+             *
+             * @param delay
+             * @param callback
+             * @param key Timers with the same key share a wheel (e.g. the
+             * address of their connection).
+             * @return Handle
+             */
+            Handle schedule_after(std::chrono::milliseconds delay, Callback callback,
+                size_t key = 0);
+
+            /**
+             * @brief Cancel a timer. If its callback is running, wait for it to
+             * return, unless called from that callback's thread: the caller
+             * mustn't hold a lock the callback takes.
+             *
+             * @param handle
+             * @return true if the timer was pending.
+             */
+            bool cancel(Handle handle);
+
+            /**
+             * @brief Get the number of pending timers.
+             *
+             * @return size_t
+             */
+            size_t get_size(void);
+
+        protected:
+        private:
+            struct __Shard {
+                std::mutex mutex;
+                std::condition_variable changed;
+                TimerWheel wheel;
+                // The timers being fired, and the one whose callback is running.
+                std::vector<TimerWheel::Expired> firing;
+                TimerWheel::Handle running = TimerWheel::NONE;
+                std::thread::id worker_id;
+                std::thread worker;
+            };
+
+            void __run(__Shard &shard);
+            uint64_t __ticks(Clock::time_point time) const;
+
+            std::chrono::milliseconds __tick;
+            Clock::time_point __start;
+            std::vector<std::unique_ptr<__Shard>> __shards;
+            std::atomic<size_t> __next{0};
+            std::atomic<bool> __stopping{false};
+    };
+}
@@ -0,0 +1,117 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the TimerWheel class, a hierarchical timing wheel:
+** timers are scheduled and cancelled in constant time, whatever their count.
+** It isn't thread-safe, the TimerService drives one per thread.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace talkup_network {
+    class TimerWheel {
+        public:
+            using Callback = std::function<void(void)>;
+
+            /**
+             * @brief Identifies a scheduled timer. A handle of a fired or
+             * cancelled timer stays invalid, even once its slot is reused.
+             * Only the low 56 bits are used.
+             */
+            using Handle = uint64_t;
+
+            using Expired = std::pair<Handle, Callback>;
+
+            static constexpr Handle NONE = 0;
+            // 4 levels of 64 slots: 64^4 ticks, about 46 hours with 10 ms ticks.
+            static constexpr size_t LEVELS = 4;
+            static constexpr size_t SLOT_BITS = 6;
+            static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+
+            /**
+             * @brief Construct a new TimerWheel object, at tick 0
+             *
+             */
+            TimerWheel(void);
+
+            /**
+             * @brief Destroy the TimerWheel object
+             *
+             */
+            ~TimerWheel() = default;
+
+            /**
+             * @brief Schedule a callback.
+             *
+             * @param tick The tick it fires at. A past tick fires on the next advance.
+             * @param callback
+             * @return Handle
+             */
+            Handle schedule(uint64_t tick, Callback callback);
+
+            /**
+             * @brief Cancel a timer that hasn't fired.
+             *
+             * @param handle
+             * @return true if the timer was pending.
+             */
+            bool cancel(Handle handle);
+
+            /**
+             * @brief Move time forward and collect the callbacks of the timers due.
+             * Timers in the higher levels move down as their time gets close.
+             *
+             * @param tick The new current tick.
+             * @param expired Filled with the timers to run, in firing order.
+             */
+            void advance(uint64_t tick, std::vector<Expired> &expired);
+
+            /**
+             * @brief Get the current tick.
+             *
+             * @return uint64_t
+             */
+            uint64_t get_tick(void) const;
+
+            /**
+             * @brief Get the number of pending timers.
+             *
+             * @return size_t
+             */
+            size_t get_size(void) const;
+
+        protected:
+        private:
+            static constexpr uint32_t NIL = UINT32_MAX;
+            static constexpr uint32_t GENERATIONS = 0xFFFFFF;
+
+            // Timers are kept in a slab and linked in their slot by index.
+            struct __Node {
+                uint64_t tick = 0;
+                uint32_t generation = 1;
+                uint32_t prev = NIL;
+                uint32_t next = NIL;
+                uint16_t slot = 0;
+                bool pending = false;
+                Callback callback;
+            };
+
+            void __insert(uint32_t index);
+            void __unlink(uint32_t index);
+            void __release(uint32_t index);
+            void __cascade(size_t level);
+
+            uint64_t __tick = 0;
+            size_t __size = 0;
+            std::vector<__Node> __nodes;
+            std::vector<uint32_t> __free;
+            std::array<uint32_t, LEVELS * SLOTS> __slots;
+    };
+}
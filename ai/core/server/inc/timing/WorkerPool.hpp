@@ -0,0 +1,105 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** This file defines the WorkerPool class, a fixed set of threads running
+** the work which mustn't block the timers or the network loops (file I/O,
+** calls to the microservices), with bounded queues.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace talkup_network {
+    class WorkerPool {
+        public:
+            using Task = std::function<void(void)>;
+
+            /**
+             * @brief Construct a new WorkerPool object
+             *
+             * @param name Prefixes the errors of the tasks in the logs.
+             * @param threads The number of threads, 0 for one per core.
+             * @param capacity How many tasks each thread can have waiting.
+             */
+            WorkerPool(const std::string &name, size_t threads = 0, size_t capacity = 1024);
+
+            /**
+             * @brief Destroy the WorkerPool object, once the queued tasks are run.
+             *
+             */
+            ~WorkerPool();
+
+            WorkerPool(const WorkerPool &) = delete;
+            WorkerPool &operator=(const WorkerPool &) = delete;
+
+            /**
+             * @brief Run the queued tasks, then stop the threads.
+             * No task can be submitted afterwards.
+             *
+             */
+            void stop(void);
+
+            /**
+             * @brief Queue a task, waiting while the queue of its thread is full.
+             * A task submitted from a thread of the pool never waits, so a
+             * task can't block on its own queue.
+             *
+             * @param task
+             * @param key Tasks with the same key run one after the other, in
+             * order (e.g. the address of their connection). 0 for the least
+             * busy thread.
+             * @return true if queued, false once the pool is stopped.
+             */
+            bool submit(Task task, size_t key = 0);
+
+            /**
+             * @brief Queue a task if its queue has room.
+             *
+             * @param task
+             * @param key See submit.
+             * @return true if queued, false if the queue is full or the pool stopped.
+             */
+            bool try_submit(Task task, size_t key = 0);
+
+            /**
+             * @brief Get the number of tasks waiting.
+             *
+             * @return size_t
+             */
+            size_t get_size(void);
+
+        protected:
+        private:
+            struct __Shard {
+                std::mutex mutex;
+                std::condition_variable ready;
+                std::condition_variable room;
+                std::deque<Task> tasks;
+                // The tasks queued and the one running.
+                std::atomic<size_t> load{0};
+                std::thread::id worker_id;
+                std::thread worker;
+            };
+
+            __Shard &__pick(size_t key);
+            bool __push(Task task, size_t key, bool wait);
+            void __run(__Shard &shard);
+
+            std::string __name;
+            size_t __capacity;
+            std::vector<std::unique_ptr<__Shard>> __shards;
+            std::atomic<size_t> __next{0};
+            std::atomic<bool> __stopping{false};
+    };
+}
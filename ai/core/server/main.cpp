@@ -5,20 +5,48 @@
 ** main of the server
 */
 
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <Server.hpp>
+#include <CrowTransport.hpp>
+#include <UringTransport.hpp>
+#include <TlsContext.hpp>
 
 /**
  * @brief Main function of the microservices manager server.
+ * The TRANSPORT environment variable picks the HTTP/WebSocket stack:
+ * crow (default) or io_uring. With TLS_CERT_FILE (and TLS_KEY_FILE) set,
+ * it serves HTTPS and WSS.
  *
  * @return true
  * @return false
  */
 int main(void)
 {
-    crow::SimpleApp app;
+    const char *name = std::getenv("TRANSPORT");
+    std::unique_ptr<ITransport> transport;
+    std::shared_ptr<talkup_network::TlsContext> tls;
+    talkup_network::TlsContext::Options tls_options;
     talkup_network::Server server("TalkUp.AI Server", "1.0.0", 8088);
 
-    server.start_server(app);
+    if (talkup_network::TlsContext::get_env_options(tls_options)) {
+        try {
+            tls = std::make_shared<talkup_network::TlsContext>(tls_options);
+        } catch (const std::exception &e) {
+            std::cerr << "[SERVER] " << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (name && std::string(name) == "io_uring") {
+        if (talkup_network::UringTransport::is_supported())
+            transport = std::make_unique<talkup_network::UringTransport>(0, tls);
+        else
+            std::cerr << "[SERVER] io_uring is not supported here, using crow" << std::endl;
+    }
+    if (!transport)
+        transport = std::make_unique<talkup_network::CrowTransport>(tls);
+    server.start_server(*transport);
     return EXIT_SUCCESS;
 }
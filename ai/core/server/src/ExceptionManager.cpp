@@ -22,6 +22,11 @@ const char *ExceptionManager::ServerAlreadyRunningException::what() const noexce
     return "The server is already running.";
 }
 
+const char *ExceptionManager::ServerTlsException::what() const noexcept
+{
+    return "Failed to set up TLS: check the certificate, the private key and the ticket key.";
+}
+
 const char *ExceptionManager::NetworkBindException::what() const noexcept
 {
     return "Failed to bind to the specified port.";
@@ -51,3 +56,23 @@ const char *ExceptionManager::NetworkEmptyBodyException::what() const noexcept
 {
     return "Empty body received in network message.";
 }
+
+const char *ExceptionManager::NetworkUnsupportedEncodingException::what() const noexcept
+{
+    return "Unsupported encoding received in network message.";
+}
+
+const char *ExceptionManager::NetworkStreamOwnedException::what() const noexcept
+{
+    return "Stream is bound to another connection, resume it first.";
+}
+
+const char *ExceptionManager::NetworkSpeechBusyException::what() const noexcept
+{
+    return "Too many utterances on the way, try again later.";
+}
+
+const char *ExceptionManager::NetworkResumeFailedException::what() const noexcept
+{
+    return "Stream can't be resumed: unknown, expired or invalid token.";
+}
@@ -7,6 +7,8 @@
 
 #include "Server.hpp"
 #include "ExceptionManager.hpp"
+#include "ServerMetrics.hpp"
+#include "ServicePool.hpp"
 
 talkup_network::Server::Server(const std::string &server_name,
     const std::string &server_version, int port) : __server_name(server_name),
@@ -20,27 +22,41 @@ talkup_network::Server::~Server()
 {
     Notifications n = Notifications();
 
+    __stop_warmup = true;
+    if (__warmup_thread.joinable())
+        __warmup_thread.join();
+
     if (__console_notification) {
         talkup_network::Notifications::send_notification(
             "[SERVER] " + n.types[0].second + " TalkUp.AI server stopped successfully!");
     }
 }
 
-bool talkup_network::Server::start_server(crow::SimpleApp &app)
+bool talkup_network::Server::start_server(ITransport &transport)
 {
     try
     {
         if(is_running) {
             throw ExceptionManager::ServerAlreadyRunningException();
         }
-        router->set_routes_definitions(app);
+        router->init();
         talkup_network::MicroservicesManager::load_microservices_info(
             "services.json");
+        for (const auto &service : talkup_network::MicroservicesManager::get_services_list())
+            talkup_network::ServerMetrics::register_service(service.first);
+        // Traffic is accepted right away but /ready stays down until the
+        // pooled connections and the models of every microservice are warm.
+        talkup_network::ServicePool::open_pools();
+        __warmup_thread = std::thread([this]() {
+            talkup_network::ServicePool::warmup_all(__stop_warmup);
+        });
         if (__console_notification) {
             talkup_network::Notifications::send_start_notification();
         }
         is_running = true;
-        app.port(__port).multithreaded().run();
+        __transport = &transport;
+        if (!transport.run(*router, __port))
+            throw ExceptionManager::StartServerException();
     }
     catch (const std::exception &e)
     {
@@ -61,6 +77,9 @@ bool talkup_network::Server::stop_server(void)
             "[SERVER] " + notif.types[0].second + " Stopping TalkUp.AI server...");
     }
     is_running = false;
+    __stop_warmup = true;
+    if (__transport)
+        __transport->stop();
     return true;
 }
 
@@ -0,0 +1,228 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the ProsodyExtractor class
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "ProsodyExtractor.hpp"
+
+namespace {
+    // 10 seconds of frames for the speaking rate.
+    constexpr size_t RECENT_FRAMES = 500;
+    constexpr uint8_t SPEECH = 1;
+    constexpr uint8_t SYLLABLE = 2;
+    constexpr float NOISE_FLOOR_RISE_DB = 0.01f;
+    constexpr float MAX_NOISE_FLOOR_DB = -35;
+    constexpr float SYLLABLE_DIP_DB = 3;
+
+    // Sum of the squares of a - b, on independent lanes so it is vectorized
+    // without reordering a single float sum.
+    float squared_distance(const float *a, const float *b, size_t size)
+    {
+        float lanes[8] = {};
+        size_t i = 0;
+
+        for (; i + 8 <= size; i += 8) {
+            for (size_t k = 0; k < 8; k++) {
+                float d = a[i + k] - b[i + k];
+                lanes[k] += d * d;
+            }
+        }
+        for (; i < size; i++)
+            lanes[0] += (a[i] - b[i]) * (a[i] - b[i]);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]))
+            + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+
+    // Divided rather than multiplied by the step, so it prints without trailing digits.
+    double round_to(double value, double scale)
+    {
+        return std::round(value * scale) / scale;
+    }
+}
+
+talkup_network::ProsodyExtractor::ProsodyExtractor(void) : ProsodyExtractor(Options())
+{
+}
+
+talkup_network::ProsodyExtractor::ProsodyExtractor(const Options &options)
+    : __options(options), __samples(HOP, 0.0f)
+{
+    // The first frame is analyzed against 20 ms of silence.
+    __samples.reserve(WINDOW * 4);
+}
+
+talkup_network::ProsodyExtractor::Features talkup_network::ProsodyExtractor::push(
+    std::string_view pcm16)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    Features features;
+    size_t i = 0;
+
+    auto append = [this](unsigned char low, unsigned char high) {
+        __samples.push_back(static_cast<int16_t>(low | (high << 8)) / 32768.0f);
+    };
+    if (!__partial.empty() && !pcm16.empty()) {
+        append(__partial[0], pcm16[0]);
+        __partial.clear();
+        i = 1;
+    }
+    for (; i + 1 < pcm16.size(); i += 2)
+        append(pcm16[i], pcm16[i + 1]);
+    if (i < pcm16.size())
+        __partial.assign(pcm16.substr(i));
+
+    size_t offset = 0;
+    for (; offset + WINDOW <= __samples.size(); offset += HOP) {
+        Frame frame;
+
+        frame.start_ms = __position_ms;
+        __position_ms += FRAME_MS;
+        __analyze(__samples.data() + offset, frame);
+        __track(frame, features);
+        features.frames.push_back(frame);
+    }
+    __samples.erase(__samples.begin(), __samples.begin() + offset);
+    double speech_s = __recent_speech * FRAME_MS / 1000.0;
+    features.speaking_rate = speech_s > 0 ? __recent_syllables / speech_s : 0;
+    return features;
+}
+
+nlohmann::json talkup_network::ProsodyExtractor::to_json(const Features &features)
+{
+    nlohmann::json json;
+    nlohmann::json rms_db = nlohmann::json::array();
+    nlohmann::json pitch_hz = nlohmann::json::array();
+    nlohmann::json zcr = nlohmann::json::array();
+    nlohmann::json voiced = nlohmann::json::array();
+    nlohmann::json pauses = nlohmann::json::array();
+
+    for (const auto &frame : features.frames) {
+        rms_db.push_back(round_to(frame.rms_db, 10));
+        pitch_hz.push_back(round_to(frame.pitch_hz, 10));
+        zcr.push_back(round_to(frame.zcr, 1000));
+        voiced.push_back(frame.voiced ? 1 : 0);
+    }
+    for (const auto &pause : features.pauses)
+        pauses.push_back({ pause.start_ms, pause.duration_ms });
+    json["frame_ms"] = FRAME_MS;
+    json["start_ms"] = features.frames.empty() ? 0 : features.frames.front().start_ms;
+    json["rms_db"] = std::move(rms_db);
+    json["pitch_hz"] = std::move(pitch_hz);
+    json["zcr"] = std::move(zcr);
+    json["voiced"] = std::move(voiced);
+    json["pauses"] = std::move(pauses);
+    json["speaking_rate"] = round_to(features.speaking_rate, 100);
+    return json;
+}
+
+void talkup_network::ProsodyExtractor::__analyze(const float *window, Frame &frame)
+{
+    static const float zeros[WINDOW] = {};
+    size_t crossings = 0;
+    float rms = std::sqrt(squared_distance(window, zeros, WINDOW) / WINDOW);
+
+    for (size_t i = 1; i < WINDOW; i++)
+        crossings += (window[i - 1] < 0) != (window[i] < 0);
+    frame.rms_db = rms > 1e-5f ? 20 * std::log10(rms) : -100;
+    frame.zcr = static_cast<float>(crossings) / (WINDOW - 1);
+    frame.pitch_hz = __pitch(window);
+}
+
+float talkup_network::ProsodyExtractor::__pitch(const float *window)
+{
+    size_t tau_min = std::max<size_t>(2, static_cast<size_t>(SAMPLE_RATE / __options.max_pitch_hz));
+    size_t tau_max = std::min<size_t>(WINDOW / 2, static_cast<size_t>(SAMPLE_RATE / __options.min_pitch_hz));
+    size_t size = WINDOW - tau_max;
+    float total = 0;
+    size_t tau = 0;
+
+    if (tau_min >= tau_max)
+        return 0;
+    // YIN: the difference of the window with itself shifted by tau, normalized
+    // by its running mean. The first dip under the threshold is the period.
+    __difference.assign(tau_max + 1, 1.0f);
+    for (size_t t = 1; t <= tau_max; t++) {
+        float difference = squared_distance(window, window + t, size);
+
+        total += difference;
+        __difference[t] = total > 0 ? difference * t / total : 1.0f;
+    }
+    for (size_t t = tau_min; t <= tau_max; t++) {
+        if (__difference[t] < __options.yin_threshold) {
+            tau = t;
+            break;
+        }
+    }
+    if (tau == 0)
+        return 0;
+    while (tau < tau_max && __difference[tau + 1] < __difference[tau])
+        tau++;
+    float period = static_cast<float>(tau);
+    if (tau < tau_max) {
+        float before = __difference[tau - 1];
+        float after = __difference[tau + 1];
+        float curvature = before + after - 2 * __difference[tau];
+
+        if (curvature > 0)
+            period += 0.5f * (before - after) / curvature;
+    }
+    return SAMPLE_RATE / period;
+}
+
+void talkup_network::ProsodyExtractor::__track(Frame &frame, Features &features)
+{
+    bool syllable = false;
+
+    frame.silent = frame.rms_db < std::max(__options.silence_db,
+        __noise_floor_db + __options.floor_margin_db);
+    frame.voiced = !frame.silent && frame.pitch_hz > 0;
+    if (!frame.voiced)
+        frame.pitch_hz = 0;
+    // The floor follows the quietest frames down at once, and creeps up slowly.
+    __noise_floor_db = frame.rms_db < __noise_floor_db ? frame.rms_db
+        : std::min(__noise_floor_db + NOISE_FLOOR_RISE_DB, MAX_NOISE_FLOOR_DB);
+
+    if (frame.silent) {
+        if (__silence_start_ms < 0)
+            __silence_start_ms = frame.start_ms;
+        syllable = __rising && __peak_voiced;
+        __rising = true;
+        __peak_db = -100;
+        __peak_voiced = false;
+    } else {
+        if (__spoken && __silence_start_ms >= 0
+            && frame.start_ms - __silence_start_ms >= __options.min_pause.count())
+            features.pauses.push_back({ __silence_start_ms, frame.start_ms - __silence_start_ms });
+        __silence_start_ms = -1;
+        __spoken = true;
+        if (__rising && frame.rms_db >= __peak_db) {
+            __peak_db = frame.rms_db;
+            __peak_voiced = frame.voiced;
+        } else if (__rising && __peak_db - frame.rms_db >= SYLLABLE_DIP_DB) {
+            syllable = __peak_voiced;
+            __rising = false;
+            __valley_db = frame.rms_db;
+        } else if (!__rising && frame.rms_db <= __valley_db) {
+            __valley_db = frame.rms_db;
+        } else if (!__rising && frame.rms_db - __valley_db >= SYLLABLE_DIP_DB) {
+            __rising = true;
+            __peak_db = frame.rms_db;
+            __peak_voiced = frame.voiced;
+        }
+    }
+
+    uint8_t entry = (frame.silent ? 0 : SPEECH) | (syllable ? SYLLABLE : 0);
+    __recent.push_back(entry);
+    __recent_speech += entry & SPEECH ? 1 : 0;
+    __recent_syllables += entry & SYLLABLE ? 1 : 0;
+    if (__recent.size() > RECENT_FRAMES) {
+        __recent_speech -= __recent.front() & SPEECH ? 1 : 0;
+        __recent_syllables -= __recent.front() & SYLLABLE ? 1 : 0;
+        __recent.pop_front();
+    }
+}
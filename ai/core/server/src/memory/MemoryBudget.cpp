@@ -0,0 +1,277 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the MemoryBudget class
+*/
+
+#include <algorithm>
+
+#include "ServerMetrics.hpp"
+#include "MemoryBudget.hpp"
+
+namespace {
+    // A node of a std::map: its key, three links and the colour.
+    constexpr size_t OBJECT_NODE = sizeof(std::string) + 4 * sizeof(void *);
+}
+
+talkup_network::MemoryBudget::Reservation::Reservation(MemoryBudget &budget,
+    const std::string &stream_id, Pool pool, size_t bytes) : __budget(budget),
+    __stream_id(stream_id), __pool(pool), __bytes(bytes)
+{
+}
+
+talkup_network::MemoryBudget::Reservation::~Reservation()
+{
+    __budget.release(__stream_id, __pool, __bytes);
+}
+
+talkup_network::MemoryBudget::MemoryBudget(void) : MemoryBudget(Options())
+{
+}
+
+talkup_network::MemoryBudget::MemoryBudget(const Options &options) : __options(options)
+{
+    __publish();
+}
+
+void talkup_network::MemoryBudget::set_limit(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+
+    __options.limit = bytes;
+    __publish();
+}
+
+void talkup_network::MemoryBudget::set_evictor(Evictor evictor)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+
+    __evictor = std::move(evictor);
+}
+
+bool talkup_network::MemoryBudget::reserve(const std::string &stream_id, Pool pool,
+    size_t bytes)
+{
+    std::vector<std::pair<std::string, bool>> candidates;
+    Evictor evictor;
+
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+
+        if (__total + bytes <= __options.limit) {
+            __account(stream_id, pool, bytes);
+            return true;
+        }
+        candidates = __get_candidates(Clock::now());
+        evictor = __evictor;
+    }
+    // The evictor takes the locks of the stream owners, which may charge or
+    // release memory: it runs without ours.
+    for (const auto &[candidate, detached] : candidates) {
+        if (candidate == stream_id || !evictor)
+            continue;
+        evictor(candidate, detached);
+        __evicted.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(__mutex);
+        if (__total + bytes <= __options.limit) {
+            __account(stream_id, pool, bytes);
+            return true;
+        }
+    }
+    __rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void talkup_network::MemoryBudget::charge(const std::string &stream_id, Pool pool,
+    size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+
+    __account(stream_id, pool, bytes);
+}
+
+void talkup_network::MemoryBudget::release(const std::string &stream_id, Pool pool,
+    size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    size_t index = static_cast<size_t>(pool);
+    auto it = __sessions.find(stream_id);
+
+    __used[index] -= std::min(__used[index], bytes);
+    __total -= std::min(__total, bytes);
+    if (it != __sessions.end()) {
+        __Session &session = it->second;
+
+        size_t released = std::min(session.total, bytes);
+
+        session.used[index] -= std::min(session.used[index], bytes);
+        session.total -= released;
+        if (session.usage)
+            session.usage->fetch_sub(static_cast<int64_t>(released), std::memory_order_relaxed);
+        // A session bound to a usage is kept until forgotten, with its binding.
+        if (session.total == 0 && !session.detached && !session.usage)
+            __sessions.erase(it);
+    }
+    __publish();
+}
+
+void talkup_network::MemoryBudget::set_detached(const std::string &stream_id, bool detached)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    __Session &session = __sessions[stream_id];
+
+    session.detached = detached;
+    session.last_active = Clock::now();
+    if (session.total == 0 && !detached && !session.usage)
+        __sessions.erase(stream_id);
+    __publish();
+}
+
+void talkup_network::MemoryBudget::forget(const std::string &stream_id)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __sessions.find(stream_id);
+
+    if (it == __sessions.end())
+        return;
+    // What it still holds is released without a session to count it in.
+    if (it->second.usage)
+        it->second.usage->fetch_sub(static_cast<int64_t>(it->second.total),
+            std::memory_order_relaxed);
+    __sessions.erase(it);
+    __publish();
+}
+
+void talkup_network::MemoryBudget::bind(const std::string &stream_id, SessionUsage usage)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    __Session &session = __sessions[stream_id];
+    auto total = static_cast<int64_t>(session.total);
+
+    if (session.usage)
+        session.usage->fetch_sub(total, std::memory_order_relaxed);
+    session.usage = std::move(usage);
+    if (session.usage)
+        session.usage->fetch_add(total, std::memory_order_relaxed);
+    __publish();
+}
+
+size_t talkup_network::MemoryBudget::get_used(void)
+{
+    return __published_total.load(std::memory_order_relaxed);
+}
+
+size_t talkup_network::MemoryBudget::get_used(const std::string &stream_id)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __sessions.find(stream_id);
+
+    return it == __sessions.end() ? 0 : it->second.total;
+}
+
+nlohmann::json talkup_network::MemoryBudget::get_report(void)
+{
+    nlohmann::json pools = nlohmann::json::object();
+
+    for (size_t i = 0; i < POOLS; i++)
+        pools[get_pool_name(static_cast<Pool>(i))] = __published_used[i].load(std::memory_order_relaxed);
+    return {
+        {"limit", __published_limit.load(std::memory_order_relaxed)},
+        {"used", __published_total.load(std::memory_order_relaxed)},
+        {"pools", pools},
+        {"streams", __published_streams.load(std::memory_order_relaxed)},
+        {"evicted", __evicted.load(std::memory_order_relaxed)},
+        {"rejected", __rejected.load(std::memory_order_relaxed)},
+    };
+}
+
+size_t talkup_network::MemoryBudget::estimate(const nlohmann::json &json)
+{
+    size_t size = sizeof(nlohmann::json);
+
+    switch (json.type()) {
+        case nlohmann::json::value_t::string:
+            size += sizeof(std::string) + json.get_ref<const std::string &>().capacity();
+            break;
+        case nlohmann::json::value_t::binary:
+            size += sizeof(nlohmann::json::binary_t) + json.get_binary().size();
+            break;
+        case nlohmann::json::value_t::object:
+            size += sizeof(nlohmann::json::object_t);
+            for (auto it = json.begin(); it != json.end(); ++it)
+                size += OBJECT_NODE + it.key().size() + estimate(it.value());
+            break;
+        case nlohmann::json::value_t::array:
+            size += sizeof(nlohmann::json::array_t);
+            for (const auto &element : json)
+                size += estimate(element);
+            break;
+        default:
+            break;
+    }
+    return size;
+}
+
+std::string talkup_network::MemoryBudget::get_pool_name(Pool pool)
+{
+    switch (pool) {
+        case Pool::STREAM_WINDOW:
+            return "stream_window";
+        case Pool::PENDING_AUDIO:
+            return "pending_audio";
+    }
+    return "unknown";
+}
+
+void talkup_network::MemoryBudget::__account(const std::string &stream_id, Pool pool,
+    size_t bytes)
+{
+    size_t index = static_cast<size_t>(pool);
+    __Session &session = __sessions[stream_id];
+
+    session.used[index] += bytes;
+    session.total += bytes;
+    session.last_active = Clock::now();
+    if (session.usage)
+        session.usage->fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    __used[index] += bytes;
+    __total += bytes;
+    __publish();
+}
+
+void talkup_network::MemoryBudget::__publish(void)
+{
+    for (size_t i = 0; i < POOLS; i++)
+        __published_used[i].store(__used[i], std::memory_order_relaxed);
+    __published_total.store(__total, std::memory_order_relaxed);
+    __published_limit.store(__options.limit, std::memory_order_relaxed);
+    __published_streams.store(__sessions.size(), std::memory_order_relaxed);
+    ServerMetrics::memory_used.store(static_cast<int64_t>(__total), std::memory_order_relaxed);
+    ServerMetrics::memory_limit.store(static_cast<int64_t>(__options.limit),
+        std::memory_order_relaxed);
+}
+
+std::vector<std::pair<std::string, bool>> talkup_network::MemoryBudget::__get_candidates(
+    Clock::time_point now)
+{
+    std::vector<std::pair<const std::string *, const __Session *>> stale;
+    std::vector<std::pair<std::string, bool>> candidates;
+
+    for (const auto &[stream_id, session] : __sessions) {
+        if (session.total > 0 && (session.detached
+            || now - session.last_active >= __options.min_idle))
+            stale.emplace_back(&stream_id, &session);
+    }
+    // Detached streams first, then the longest idle.
+    std::sort(stale.begin(), stale.end(), [](const auto &a, const auto &b) {
+        if (a.second->detached != b.second->detached)
+            return a.second->detached;
+        return a.second->last_active < b.second->last_active;
+    });
+    candidates.reserve(stale.size());
+    for (const auto &[stream_id, session] : stale)
+        candidates.emplace_back(*stream_id, session->detached);
+    return candidates;
+}
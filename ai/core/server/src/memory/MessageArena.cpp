@@ -0,0 +1,175 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the MessageArena class
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "ServerMetrics.hpp"
+#include "MessageArena.hpp"
+
+namespace {
+    thread_local talkup_network::MessageArena *active_arena = nullptr;
+}
+
+talkup_network::MessageArena::Scope::Scope() : __previous(active_arena)
+{
+    active_arena = &MessageArena::local();
+}
+
+talkup_network::MessageArena::Scope::~Scope()
+{
+    active_arena = __previous;
+    if (__previous)
+        return;
+    MessageArena &arena = MessageArena::local();
+
+    ServerMetrics::arena_messages.fetch_add(1, std::memory_order_relaxed);
+    ServerMetrics::arena_allocations.fetch_add(arena.get_allocations(), std::memory_order_relaxed);
+    ServerMetrics::arena_bytes.fetch_add(arena.get_bytes(), std::memory_order_relaxed);
+    arena.reset();
+}
+
+talkup_network::MessageArena::MessageArena() : __generation(new __Generation())
+{
+}
+
+talkup_network::MessageArena::~MessageArena()
+{
+    __release(__generation);
+}
+
+talkup_network::MessageArena &talkup_network::MessageArena::local(void)
+{
+    static thread_local MessageArena arena;
+
+    return arena;
+}
+
+talkup_network::MessageArena *talkup_network::MessageArena::active(void)
+{
+    return active_arena;
+}
+
+void *talkup_network::MessageArena::allocate_tagged(size_t bytes)
+{
+    MessageArena *arena = active_arena;
+    __Generation *generation = nullptr;
+    char *base;
+
+    if (arena) {
+        base = static_cast<char *>(arena->allocate(bytes + TAG_SIZE, TAG_SIZE));
+        generation = arena->__generation;
+        generation->references.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        base = static_cast<char *>(::operator new(bytes + TAG_SIZE));
+    }
+    std::memcpy(base, &generation, sizeof(generation));
+    return base + TAG_SIZE;
+}
+
+void talkup_network::MessageArena::deallocate_tagged(void *ptr, size_t bytes) noexcept
+{
+    char *base = static_cast<char *>(ptr) - TAG_SIZE;
+    __Generation *generation;
+
+    std::memcpy(&generation, base, sizeof(generation));
+    if (generation)
+        __release(generation);
+    else
+        ::operator delete(base, bytes + TAG_SIZE);
+}
+
+void talkup_network::MessageArena::__release(__Generation *generation) noexcept
+{
+    if (generation->references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    for (const auto &block : generation->blocks)
+        ::operator delete(block.data);
+    delete generation;
+}
+
+bool talkup_network::MessageArena::owns(const void *ptr) const
+{
+    const char *p = static_cast<const char *>(ptr);
+
+    for (const auto &block : __generation->blocks) {
+        if (p >= block.data && p < block.data + block.size)
+            return true;
+    }
+    return false;
+}
+
+void talkup_network::MessageArena::reset(void)
+{
+    std::vector<__Block> &blocks = __generation->blocks;
+    size_t retained = 0;
+    size_t kept = 0;
+
+    if (__generation->references.load(std::memory_order_acquire) > 1) {
+        // Values still point into the blocks: they go with the last of them.
+        __release(__generation);
+        __generation = new __Generation();
+    } else {
+        while (kept < blocks.size() && retained + blocks[kept].size <= MAX_RETAINED)
+            retained += blocks[kept++].size;
+        for (size_t i = kept; i < blocks.size(); i++)
+            ::operator delete(blocks[i].data);
+        blocks.resize(kept);
+    }
+    __current = 0;
+    __offset = 0;
+    __allocations = 0;
+    __bytes = 0;
+}
+
+size_t talkup_network::MessageArena::get_allocations(void) const
+{
+    return __allocations;
+}
+
+size_t talkup_network::MessageArena::get_bytes(void) const
+{
+    return __bytes;
+}
+
+void *talkup_network::MessageArena::do_allocate(size_t bytes, size_t alignment)
+{
+    std::vector<__Block> &blocks = __generation->blocks;
+
+    __allocations++;
+    __bytes += bytes;
+    while (__current < blocks.size()) {
+        const __Block &block = blocks[__current];
+        auto base = reinterpret_cast<uintptr_t>(block.data);
+        size_t offset = ((base + __offset + alignment - 1) & ~(alignment - 1)) - base;
+
+        if (offset + bytes <= block.size) {
+            __offset = offset + bytes;
+            return block.data + offset;
+        }
+        __current++;
+        __offset = 0;
+    }
+    // A new block is only needed by the largest messages, it is freed on reset
+    // once the arena holds more than MAX_RETAINED bytes.
+    size_t size = std::max(BLOCK_SIZE, bytes + alignment);
+    blocks.push_back({ static_cast<char *>(::operator new(size)), size });
+    __current = blocks.size() - 1;
+    auto base = reinterpret_cast<uintptr_t>(blocks.back().data);
+    size_t offset = ((base + alignment - 1) & ~(alignment - 1)) - base;
+    __offset = offset + bytes;
+    return blocks.back().data + offset;
+}
+
+void talkup_network::MessageArena::do_deallocate(void *, size_t, size_t)
+{
+}
+
+bool talkup_network::MessageArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
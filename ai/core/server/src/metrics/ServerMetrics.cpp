@@ -0,0 +1,152 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the ServerMetrics class
+*/
+
+#include <algorithm>
+#include <mutex>
+
+#include "ServerMetrics.hpp"
+
+std::array<talkup_network::ServerMetrics::ServiceStats,
+    talkup_network::ServerMetrics::MAX_SERVICES> talkup_network::ServerMetrics::__services;
+std::atomic<size_t> talkup_network::ServerMetrics::__service_count{0};
+
+void talkup_network::ServerMetrics::register_service(const std::string &name)
+{
+    // Only the writers are serialized, readers go through the published count.
+    static std::mutex register_mutex;
+    std::lock_guard<std::mutex> lock(register_mutex);
+    size_t count = __service_count.load(std::memory_order_acquire);
+
+    if (get_service(name) || count >= MAX_SERVICES)
+        return;
+    __services[count].name = name;
+    __service_count.store(count + 1, std::memory_order_release);
+}
+
+talkup_network::ServerMetrics::ServiceStats *talkup_network::ServerMetrics::get_service(
+    const std::string &name)
+{
+    size_t count = __service_count.load(std::memory_order_acquire);
+
+    for (size_t i = 0; i < count; i++) {
+        if (__services[i].name == name)
+            return &__services[i];
+    }
+    return nullptr;
+}
+
+void talkup_network::ServerMetrics::service_request_started(const std::string &name)
+{
+    ServiceStats *stats = get_service(name);
+
+    if (!stats)
+        return;
+    stats->queue_depth.fetch_add(1, std::memory_order_relaxed);
+    stats->requests.fetch_add(1, std::memory_order_relaxed);
+}
+
+void talkup_network::ServerMetrics::service_request_finished(const std::string &name,
+    int64_t latency_us, bool success)
+{
+    ServiceStats *stats = get_service(name);
+
+    if (!stats)
+        return;
+    stats->queue_depth.fetch_sub(1, std::memory_order_relaxed);
+    if (!success)
+        stats->errors.fetch_add(1, std::memory_order_relaxed);
+    int64_t average = stats->latency_us.load(std::memory_order_relaxed);
+    int64_t updated;
+    do {
+        updated = average == 0 ? latency_us : average + (latency_us - average) / 8;
+    } while (!stats->latency_us.compare_exchange_weak(average, updated,
+        std::memory_order_relaxed));
+}
+
+void talkup_network::ServerMetrics::service_request_hedged(const std::string &name)
+{
+    ServiceStats *stats = get_service(name);
+
+    if (stats)
+        stats->hedged.fetch_add(1, std::memory_order_relaxed);
+}
+
+void talkup_network::ServerMetrics::service_batch_sent(const std::string &name, size_t size)
+{
+    ServiceStats *stats = get_service(name);
+
+    if (stats)
+        stats->batched.fetch_add(size, std::memory_order_relaxed);
+}
+
+double talkup_network::ServerMetrics::get_load(void)
+{
+    size_t count = __service_count.load(std::memory_order_acquire);
+    double load = static_cast<double>(open_connections.load(std::memory_order_relaxed))
+        / MAX_CONNECTIONS;
+    int64_t memory = memory_limit.load(std::memory_order_relaxed);
+
+    if (memory > 0)
+        load = std::max(load, static_cast<double>(
+            memory_used.load(std::memory_order_relaxed)) / memory);
+    for (size_t i = 0; i < count; i++) {
+        load = std::max(load, static_cast<double>(
+            __services[i].queue_depth.load(std::memory_order_relaxed)) / MAX_QUEUE_DEPTH);
+    }
+    return std::clamp(load, 0.0, 1.0);
+}
+
+int64_t talkup_network::ServerMetrics::get_queue_depth(void)
+{
+    size_t count = __service_count.load(std::memory_order_acquire);
+    int64_t depth = 0;
+
+    for (size_t i = 0; i < count; i++)
+        depth += __services[i].queue_depth.load(std::memory_order_relaxed);
+    return depth;
+}
+
+nlohmann::json talkup_network::ServerMetrics::get_status_report(void)
+{
+    size_t count = __service_count.load(std::memory_order_acquire);
+    double load = get_load();
+    uint64_t arena_count = arena_messages.load(std::memory_order_relaxed);
+    nlohmann::json report;
+    nlohmann::json services = nlohmann::json::object();
+
+    for (size_t i = 0; i < count; i++) {
+        const ServiceStats &stats = __services[i];
+
+        services[stats.name] = {
+            {"queue_depth", stats.queue_depth.load(std::memory_order_relaxed)},
+            {"latency_ms", stats.latency_us.load(std::memory_order_relaxed) / 1000.0},
+            {"requests", stats.requests.load(std::memory_order_relaxed)},
+            {"errors", stats.errors.load(std::memory_order_relaxed)},
+            {"hedged", stats.hedged.load(std::memory_order_relaxed)},
+            {"batched", stats.batched.load(std::memory_order_relaxed)},
+        };
+    }
+    // Bigger and sparser uploads as the load grows: fewer messages per second
+    // for the same audio, and fewer frames. The PCM16 bitrate itself is fixed.
+    int64_t chunk_ms = static_cast<int64_t>(100 + load * 400);
+    report["load"] = load;
+    report["open_connections"] = open_connections.load(std::memory_order_relaxed);
+    report["active_streams"] = active_streams.load(std::memory_order_relaxed);
+    report["messages_received"] = messages_received.load(std::memory_order_relaxed);
+    report["bytes_received"] = bytes_received.load(std::memory_order_relaxed);
+    report["allocations_per_message"] = arena_count ? static_cast<double>(
+        arena_allocations.load(std::memory_order_relaxed)) / arena_count : 0.0;
+    report["arena_bytes_per_message"] = arena_count ? static_cast<double>(
+        arena_bytes.load(std::memory_order_relaxed)) / arena_count : 0.0;
+    report["services"] = services;
+    report["recommended"] = {
+        {"chunk_ms", chunk_ms},
+        {"chunk_bytes", chunk_ms * AUDIO_BYTES_PER_MS},
+        {"frame_rate", static_cast<int64_t>(15 - load * 10)},
+    };
+    return report;
+}
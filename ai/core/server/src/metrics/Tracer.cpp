@@ -0,0 +1,172 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the Tracer class
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <nlohmann/json.hpp>
+
+#include "Tracer.hpp"
+
+namespace {
+    thread_local uint64_t current_trace_id = 0;
+}
+
+talkup_network::Tracer::ScopedSpan::ScopedSpan(const char *name)
+    : ScopedSpan(name, std::string())
+{
+}
+
+talkup_network::Tracer::ScopedSpan::ScopedSpan(const char *prefix, const std::string &name)
+    : __name(""), __start_us(0)
+{
+    if (!current_trace_id)
+        return;
+    size_t length = std::min(std::strlen(prefix), sizeof(__name) - 1);
+
+    std::memcpy(__name, prefix, length);
+    name.copy(__name + length, sizeof(__name) - 1 - length);
+    __name[std::min(length + name.size(), sizeof(__name) - 1)] = '\0';
+    __start_us = now_us();
+}
+
+talkup_network::Tracer::ScopedSpan::~ScopedSpan()
+{
+    if (current_trace_id && __start_us)
+        record(__name, __start_us, now_us());
+}
+
+talkup_network::Tracer::TraceScope::TraceScope(uint64_t trace_id)
+    : __previous(current_trace_id)
+{
+    current_trace_id = trace_id;
+}
+
+talkup_network::Tracer::TraceScope::~TraceScope()
+{
+    current_trace_id = __previous;
+}
+
+void talkup_network::Tracer::set_sample_rate(double rate)
+{
+    __sample_rate.store(rate < 0 ? 0 : (rate > 1 ? 1 : rate), std::memory_order_relaxed);
+}
+
+uint64_t talkup_network::Tracer::begin_trace(bool forced)
+{
+    static thread_local std::minstd_rand engine(std::random_device{}());
+    double rate = __sample_rate.load(std::memory_order_relaxed);
+
+    if (!forced && (rate <= 0 || std::uniform_real_distribution<double>(0, 1)(engine) >= rate)) {
+        current_trace_id = 0;
+        return 0;
+    }
+    current_trace_id = __next_trace_id.fetch_add(1, std::memory_order_relaxed);
+    return current_trace_id;
+}
+
+void talkup_network::Tracer::end_trace(void)
+{
+    current_trace_id = 0;
+}
+
+uint64_t talkup_network::Tracer::current(void)
+{
+    return current_trace_id;
+}
+
+bool talkup_network::Tracer::enabled(void)
+{
+    return current_trace_id != 0;
+}
+
+int64_t talkup_network::Tracer::now_us(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void talkup_network::Tracer::record(const char *name, int64_t start_us, int64_t end_us)
+{
+    if (!current_trace_id)
+        return;
+    __ThreadBuffer &buffer = __get_thread_buffer();
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    __Slot &slot = buffer.slots[head % BUFFER_SIZE];
+    uint64_t words[SPAN_WORDS] = {};
+    Span span;
+
+    std::memset(&span, 0, sizeof(span));
+    std::strncpy(span.name, name, sizeof(span.name) - 1);
+    span.trace_id = current_trace_id;
+    span.start_us = start_us;
+    span.duration_us = end_us - start_us;
+    span.thread_id = buffer.thread_id;
+    std::memcpy(words, &span, sizeof(span));
+    slot.sequence.store(head * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < SPAN_WORDS; i++)
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    slot.sequence.store(head * 2 + 2, std::memory_order_release);
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void talkup_network::Tracer::dump(std::ostream &out)
+{
+    nlohmann::json events = nlohmann::json::array();
+    std::vector<std::shared_ptr<__ThreadBuffer>> buffers;
+
+    {
+        std::lock_guard<std::mutex> lock(__buffers_mutex);
+        buffers = __buffers;
+    }
+    for (const auto &buffer : buffers) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t first = head > BUFFER_SIZE ? head - BUFFER_SIZE : 0;
+
+        for (uint64_t i = first; i < head; i++) {
+            const __Slot &slot = buffer->slots[i % BUFFER_SIZE];
+            uint64_t words[SPAN_WORDS];
+            Span span;
+
+            // Skipped if the owning thread is writing or wrote a newer span there.
+            if (slot.sequence.load(std::memory_order_acquire) != i * 2 + 2)
+                continue;
+            for (size_t w = 0; w < SPAN_WORDS; w++)
+                words[w] = slot.words[w].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != i * 2 + 2)
+                continue;
+            std::memcpy(&span, words, sizeof(span));
+            events.push_back({
+                {"name", span.name},
+                {"cat", "talkup"},
+                {"ph", "X"},
+                {"ts", span.start_us},
+                {"dur", span.duration_us},
+                {"pid", 1},
+                {"tid", span.thread_id},
+                {"args", { {"trace_id", span.trace_id} }},
+            });
+        }
+    }
+    out << nlohmann::json{ {"traceEvents", events}, {"displayTimeUnit", "ms"} }.dump();
+}
+
+talkup_network::Tracer::__ThreadBuffer &talkup_network::Tracer::__get_thread_buffer(void)
+{
+    static thread_local std::shared_ptr<__ThreadBuffer> buffer;
+
+    if (!buffer) {
+        buffer = std::make_shared<__ThreadBuffer>();
+        buffer->thread_id = __next_thread_id.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(__buffers_mutex);
+        __buffers.push_back(buffer);
+    }
+    return *buffer;
+}
@@ -0,0 +1,218 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the Batcher class
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <cstdlib>
+
+#include "Messages.hpp"
+#include "MicroservicesManager.hpp"
+#include "ServerMetrics.hpp"
+#include "Tracer.hpp"
+#include "Batcher.hpp"
+
+talkup_network::Batcher::Batcher(const std::string &service, TimerService *timers)
+    : Batcher(service, get_options(service), [](const std::string &name,
+        const nlohmann::json &task, std::string_view samples, Clock::time_point deadline) {
+        return ServicePool::post_samples(name, task, samples, deadline, true);
+    }, timers)
+{
+}
+
+talkup_network::Batcher::Batcher(const std::string &service, const Options &options,
+    Sender sender, TimerService *timers) : __service(service), __options(options),
+    __sender(std::move(sender)), __timers(timers),
+    __senders("BATCHER", std::max<size_t>(options.max_in_flight, 1), 1)
+{
+    __options.max_batch = std::max<size_t>(__options.max_batch, 1);
+    __options.max_in_flight = std::max<size_t>(__options.max_in_flight, 1);
+    __worker = std::thread(&Batcher::__run, this);
+}
+
+talkup_network::Batcher::~Batcher()
+{
+    std::vector<__Waiting> waiting;
+
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        __stopping = true;
+    }
+    __changed.notify_all();
+    __worker.join();
+    __senders.stop();
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        waiting.swap(__waiting);
+    }
+    for (auto &entry : waiting)
+        entry.segment.on_result(false, { {"message", "server stopping"} });
+}
+
+void talkup_network::Batcher::submit(Segment segment)
+{
+    bool wake = false;
+
+    if (!segment.trace_id)
+        segment.trace_id = Tracer::current();
+    if (__timers) {
+        // Whichever comes first, the result or the deadline, answers the segment.
+        struct Answer {
+            std::atomic<bool> answered{false};
+            std::atomic<TimerService::Handle> deadline{TimerService::NONE};
+            Callback on_result;
+        };
+        auto answer = std::make_shared<Answer>();
+        std::string error = "deadline exceeded: " + __service;
+        TimerService *timers = __timers;
+
+        answer->on_result = std::move(segment.on_result);
+        segment.on_result = [answer, timers](bool ok, const nlohmann::json &result) {
+            if (answer->answered.exchange(true))
+                return;
+            timers->cancel(answer->deadline);
+            answer->on_result(ok, result);
+        };
+        answer->deadline = __timers->schedule_after(__options.timeout, [answer, error]() {
+            if (!answer->answered.exchange(true))
+                answer->on_result(false, { {"message", error} });
+        });
+    }
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+
+        __waiting.push_back({ std::move(segment), Clock::now() });
+        // The batching thread sleeps until the budget of the first segment is over:
+        // it only has to be woken up to start that wait, or for a full batch.
+        wake = __waiting.size() == 1 || __waiting.size() >= __options.max_batch;
+    }
+    if (wake)
+        __changed.notify_all();
+}
+
+talkup_network::Batcher::Options talkup_network::Batcher::get_options(const std::string &service)
+{
+    Options options;
+    const auto &services = MicroservicesManager::get_services_list();
+    auto info = services.find(service);
+
+    if (info == services.end())
+        return options;
+    auto size = info->second.find("BatchSize");
+    auto budget = info->second.find("BatchBudgetMs");
+    auto in_flight = info->second.find("BatchInFlight");
+    if (size != info->second.end())
+        options.max_batch = std::strtoull(size->second.c_str(), nullptr, 10);
+    if (budget != info->second.end())
+        options.budget = std::chrono::milliseconds(std::strtoll(budget->second.c_str(), nullptr, 10));
+    if (in_flight != info->second.end())
+        options.max_in_flight = std::strtoull(in_flight->second.c_str(), nullptr, 10);
+    return options;
+}
+
+void talkup_network::Batcher::__run(void)
+{
+    std::unique_lock<std::mutex> lock(__mutex);
+
+    while (!__stopping) {
+        if (__waiting.empty() || __in_flight >= __options.max_in_flight) {
+            __changed.wait(lock);
+            continue;
+        }
+        auto flush_at = __waiting.front().queued + __options.budget;
+        if (__waiting.size() < __options.max_batch && Clock::now() < flush_at) {
+            __changed.wait_until(lock, flush_at);
+            continue;
+        }
+        size_t count = std::min(__waiting.size(), __options.max_batch);
+        std::vector<Segment> batch;
+        // The oldest segment sets the deadline of the whole batch.
+        auto deadline = __waiting.front().queued + __options.timeout;
+
+        for (size_t i = 0; i < count; i++)
+            batch.push_back(std::move(__waiting[i].segment));
+        __waiting.erase(__waiting.begin(), __waiting.begin() + count);
+        __in_flight++;
+        lock.unlock();
+        // Batches are sent side by side: the next one fills up while this one is processed.
+        // A sender is free: there are as many as batches in flight.
+        __senders.submit([this, batch = std::move(batch), deadline]() mutable {
+            __flush(std::move(batch), deadline);
+        });
+        lock.lock();
+    }
+}
+
+void talkup_network::Batcher::__flush(std::vector<Segment> batch, Clock::time_point deadline)
+{
+    messages::TaskRequest task;
+    nlohmann::json items = nlohmann::json::array();
+    std::string samples;
+    std::vector<bool> answered(batch.size(), false);
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        nlohmann::json item = batch[i].meta;
+
+        item["id"] = i;
+        item["offset"] = samples.size();
+        item["length"] = batch[i].samples.size();
+        samples += batch[i].samples;
+        items.push_back(std::move(item));
+    }
+    task.services = { __service };
+    task.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    task.data = { {"batch", std::move(items)} };
+    ServerMetrics::service_batch_sent(__service, batch.size());
+    auto traced = std::find_if(batch.begin(), batch.end(),
+        [](const Segment &segment) { return segment.trace_id != 0; });
+    int64_t sent_us = Tracer::now_us();
+    ServicePool::Result result;
+    {
+        // The spans of the call go to the first traced segment, the others get the batch span.
+        Tracer::TraceScope trace(traced == batch.end() ? 0 : traced->trace_id);
+
+        result = __sender(__service, schema::serialize(task), samples, deadline);
+    }
+    int64_t received_us = Tracer::now_us();
+    std::string error = result.error.empty() ? "service error: " + __service : result.error;
+
+    for (const auto &segment : batch) {
+        if (!segment.trace_id)
+            continue;
+        Tracer::TraceScope trace(segment.trace_id);
+        Tracer::record("ms_batch", sent_us, received_us);
+    }
+
+    if (result.ok) {
+        try {
+            auto body = nlohmann::json::parse(result.body);
+
+            for (const auto &item : body.at("data").at("results")) {
+                size_t id = item.at("id").get<size_t>();
+
+                if (id >= batch.size() || answered[id])
+                    continue;
+                answered[id] = true;
+                Tracer::TraceScope trace(batch[id].trace_id);
+                batch[id].on_result(true, item);
+            }
+            error = "no result for the segment: " + __service;
+        } catch (const std::exception &e) {
+            error = "invalid batch result: " + std::string(e.what());
+        }
+    }
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (!answered[i]) {
+            Tracer::TraceScope trace(batch[i].trace_id);
+            batch[i].on_result(false, { {"message", error} });
+        }
+    }
+    std::lock_guard<std::mutex> lock(__mutex);
+    __in_flight--;
+    __changed.notify_all();
+}
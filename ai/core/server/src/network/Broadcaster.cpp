@@ -0,0 +1,168 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the Broadcaster class
+*/
+
+#include <algorithm>
+#include <array>
+
+#include "Broadcaster.hpp"
+
+talkup_network::Broadcaster::Broadcaster(size_t max_queue) : __max_queue(max_queue)
+{
+    __worker = std::thread(&Broadcaster::__run, this);
+}
+
+talkup_network::Broadcaster::~Broadcaster()
+{
+    {
+        std::lock_guard<std::mutex> lock(__ready_mutex);
+        __stopping = true;
+    }
+    __ready_cv.notify_all();
+    if (__worker.joinable())
+        __worker.join();
+}
+
+void talkup_network::Broadcaster::subscribe(const std::string &stream_id,
+    crow::websocket::connection &conn, Envelope::Encoding encoding)
+{
+    std::unique_lock<std::shared_mutex> lock(__topics_mutex);
+    auto &subscribers = __topics[stream_id];
+
+    for (const auto &subscriber : subscribers) {
+        if (subscriber->conn == &conn)
+            return;
+    }
+    auto subscriber = std::make_shared<__Subscriber>();
+    subscriber->conn = &conn;
+    subscriber->encoding = encoding;
+    subscribers.push_back(subscriber);
+    __topics_by_conn[&conn].push_back(stream_id);
+}
+
+void talkup_network::Broadcaster::unsubscribe(const std::string &stream_id,
+    crow::websocket::connection &conn)
+{
+    std::unique_lock<std::shared_mutex> lock(__topics_mutex);
+    auto it = __topics_by_conn.find(&conn);
+
+    __remove(stream_id, conn);
+    if (it != __topics_by_conn.end()) {
+        auto &topics = it->second;
+        topics.erase(std::remove(topics.begin(), topics.end(), stream_id), topics.end());
+        if (topics.empty())
+            __topics_by_conn.erase(it);
+    }
+}
+
+void talkup_network::Broadcaster::unsubscribe_all(crow::websocket::connection &conn)
+{
+    std::unique_lock<std::shared_mutex> lock(__topics_mutex);
+    auto it = __topics_by_conn.find(&conn);
+
+    if (it == __topics_by_conn.end())
+        return;
+    for (const auto &stream_id : it->second)
+        __remove(stream_id, conn);
+    __topics_by_conn.erase(it);
+}
+
+void talkup_network::Broadcaster::publish(const std::string &stream_id,
+    const nlohmann::json &event)
+{
+    std::array<Frame, 3> frames;
+    std::vector<std::shared_ptr<__Subscriber>> woken;
+    std::shared_lock<std::shared_mutex> lock(__topics_mutex);
+    auto it = __topics.find(stream_id);
+
+    if (it == __topics.end())
+        return;
+    for (const auto &subscriber : it->second) {
+        auto &frame = frames[static_cast<size_t>(subscriber->encoding)];
+
+        // Encoded on first use, then shared by every subscriber of the same encoding.
+        if (!frame)
+            frame = std::make_shared<const std::string>(Envelope::encode(event, subscriber->encoding));
+        std::lock_guard<std::mutex> subscriber_lock(subscriber->mutex);
+        if (subscriber->closed)
+            continue;
+        if (subscriber->queue.size() >= __max_queue) {
+            subscriber->queue.pop_front();
+            subscriber->dropped++;
+        }
+        subscriber->queue.push_back(frame);
+        if (!subscriber->scheduled) {
+            subscriber->scheduled = true;
+            woken.push_back(subscriber);
+        }
+    }
+    lock.unlock();
+    if (woken.empty())
+        return;
+    {
+        std::lock_guard<std::mutex> ready_lock(__ready_mutex);
+        for (auto &subscriber : woken)
+            __ready.push_back(std::move(subscriber));
+    }
+    __ready_cv.notify_one();
+}
+
+void talkup_network::Broadcaster::__remove(const std::string &stream_id,
+    crow::websocket::connection &conn)
+{
+    auto it = __topics.find(stream_id);
+
+    if (it == __topics.end())
+        return;
+    auto &subscribers = it->second;
+    for (auto sub = subscribers.begin(); sub != subscribers.end();) {
+        if ((*sub)->conn != &conn) {
+            ++sub;
+            continue;
+        }
+        // Waits for a send in progress on this connection to finish.
+        std::lock_guard<std::mutex> send_lock((*sub)->send_mutex);
+        std::lock_guard<std::mutex> subscriber_lock((*sub)->mutex);
+        (*sub)->closed = true;
+        (*sub)->queue.clear();
+        sub = subscribers.erase(sub);
+    }
+    if (subscribers.empty())
+        __topics.erase(it);
+}
+
+void talkup_network::Broadcaster::__run(void)
+{
+    while (true) {
+        std::shared_ptr<__Subscriber> subscriber;
+        std::deque<Frame> frames;
+
+        {
+            std::unique_lock<std::mutex> lock(__ready_mutex);
+            __ready_cv.wait(lock, [this]() { return __stopping || !__ready.empty(); });
+            if (__stopping)
+                return;
+            subscriber = std::move(__ready.front());
+            __ready.pop_front();
+        }
+        std::lock_guard<std::mutex> send_lock(subscriber->send_mutex);
+        {
+            // The publishers keep queuing while the frames are sent.
+            std::lock_guard<std::mutex> subscriber_lock(subscriber->mutex);
+
+            subscriber->scheduled = false;
+            if (subscriber->closed)
+                continue;
+            frames.swap(subscriber->queue);
+        }
+        for (const auto &frame : frames) {
+            if (subscriber->encoding == Envelope::Encoding::JSON)
+                subscriber->conn->send_text(*frame);
+            else
+                subscriber->conn->send_binary(*frame);
+        }
+    }
+}
@@ -0,0 +1,132 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the CircuitBreaker class
+*/
+
+#include <algorithm>
+#include <vector>
+
+#include "CircuitBreaker.hpp"
+
+talkup_network::CircuitBreaker::CircuitBreaker(void) : CircuitBreaker(Thresholds())
+{
+}
+
+talkup_network::CircuitBreaker::CircuitBreaker(const Thresholds &thresholds)
+    : __thresholds(thresholds)
+{
+}
+
+bool talkup_network::CircuitBreaker::allow(Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+
+    if (__state == State::OPEN) {
+        if (now - __opened_at < __thresholds.open_for)
+            return false;
+        __state = State::HALF_OPEN;
+        __probes_in_flight = 0;
+        __probes_passed = 0;
+    }
+    if (__state == State::HALF_OPEN) {
+        if (__probes_in_flight + __probes_passed >= __thresholds.probes)
+            return false;
+        __probes_in_flight++;
+    }
+    return true;
+}
+
+void talkup_network::CircuitBreaker::record(bool ok, int64_t latency_us, Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    bool slow = latency_us >= __thresholds.slow_call_us;
+
+    switch (__state) {
+        case State::OPEN:
+            // A call sent before the breaker tripped: it doesn't change anything.
+            return;
+        case State::HALF_OPEN:
+            if (__probes_in_flight)
+                __probes_in_flight--;
+            if (!ok || slow) {
+                __trip(now);
+                return;
+            }
+            if (++__probes_passed >= __thresholds.probes)
+                __close();
+            return;
+        default:
+            break;
+    }
+    __calls[__next] = { ok, latency_us };
+    __next = (__next + 1) % WINDOW;
+    __count = std::min(__count + 1, WINDOW);
+    if (__count < __thresholds.min_calls)
+        return;
+    size_t errors = 0;
+    size_t slow_calls = 0;
+    for (size_t i = 0; i < __count; i++) {
+        errors += !__calls[i].ok;
+        slow_calls += __calls[i].latency_us >= __thresholds.slow_call_us;
+    }
+    if (errors >= __thresholds.error_rate * __count
+        || slow_calls >= __thresholds.slow_rate * __count)
+        __trip(now);
+}
+
+talkup_network::CircuitBreaker::State talkup_network::CircuitBreaker::get_state(void) const
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+
+    return __state;
+}
+
+int64_t talkup_network::CircuitBreaker::get_latency_p95_us(int64_t fallback_us) const
+{
+    std::vector<int64_t> latencies;
+
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+
+        latencies.reserve(__count);
+        for (size_t i = 0; i < __count; i++) {
+            if (__calls[i].ok)
+                latencies.push_back(__calls[i].latency_us);
+        }
+    }
+    if (latencies.empty() || latencies.size() < __thresholds.min_calls)
+        return fallback_us;
+    size_t index = (latencies.size() * 95 + 99) / 100 - 1;
+    std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+    return latencies[index];
+}
+
+std::string talkup_network::CircuitBreaker::get_state_name(State state)
+{
+    switch (state) {
+        case State::OPEN:
+            return "open";
+        case State::HALF_OPEN:
+            return "half_open";
+        default:
+            return "closed";
+    }
+}
+
+void talkup_network::CircuitBreaker::__trip(Clock::time_point now)
+{
+    __state = State::OPEN;
+    __opened_at = now;
+    __probes_in_flight = 0;
+    __probes_passed = 0;
+}
+
+void talkup_network::CircuitBreaker::__close(void)
+{
+    // The replica starts over: the calls that tripped the breaker are forgotten.
+    __state = State::CLOSED;
+    __count = 0;
+    __next = 0;
+}
@@ -0,0 +1,54 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the CrowTransport class
+*/
+
+#include <iostream>
+
+#include "CrowTransport.hpp"
+
+talkup_network::CrowTransport::CrowTransport(std::shared_ptr<TlsContext> tls)
+    : __tls(std::move(tls))
+{
+}
+
+bool talkup_network::CrowTransport::run(Router &router, int port)
+{
+    router.set_routes_definitions(__app);
+    if (__tls) {
+#ifdef CROW_ENABLE_SSL
+        // Asio encrypts through memory BIOs, so kTLS never applies here.
+        crow::ssl_context_t context(crow::ssl_context_t::tls_server);
+
+        __tls->configure(context.native_handle());
+        __app.ssl(std::move(context));
+#else
+        std::cerr << "[CROW] This build has no TLS support (OpenSSL needed)" << std::endl;
+        return false;
+#endif
+    }
+    __app.port(port).multithreaded().run();
+    return true;
+}
+
+void talkup_network::CrowTransport::wait_for_start(void)
+{
+    __app.wait_for_server_start();
+}
+
+void talkup_network::CrowTransport::stop(void)
+{
+    __app.stop();
+}
+
+std::string talkup_network::CrowTransport::get_transport_name(void) const
+{
+    return "crow";
+}
+
+crow::SimpleApp &talkup_network::CrowTransport::get_app(void)
+{
+    return __app;
+}
@@ -0,0 +1,156 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the Envelope class
+*/
+
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+
+#include "ExceptionManager.hpp"
+#include "Envelope.hpp"
+
+namespace {
+    // Lets operator<< dump a message straight into a reused buffer.
+    class StringWriter : public std::streambuf {
+        public:
+            explicit StringWriter(std::string &out) : __out(out) {}
+
+        protected:
+            int_type overflow(int_type c) override
+            {
+                if (c != traits_type::eof())
+                    __out.push_back(static_cast<char>(c));
+                return c;
+            }
+
+            std::streamsize xsputn(const char *s, std::streamsize n) override
+            {
+                __out.append(s, static_cast<size_t>(n));
+                return n;
+            }
+
+        private:
+            std::string &__out;
+    };
+}
+
+talkup_network::Envelope::Encoding talkup_network::Envelope::negotiate(
+    const nlohmann::json &request)
+{
+    if (!request.contains("encodings") || !request["encodings"].is_array())
+        return Encoding::JSON;
+    for (const auto &name : request["encodings"]) {
+        Encoding encoding;
+
+        if (name.is_string() && get_encoding(name.get<std::string>(), encoding))
+            return encoding;
+    }
+    return Encoding::JSON;
+}
+
+std::string talkup_network::Envelope::get_encoding_name(Encoding encoding)
+{
+    switch (encoding) {
+        case Encoding::CBOR:
+            return "cbor";
+        case Encoding::MSGPACK:
+            return "msgpack";
+        default:
+            return "json";
+    }
+}
+
+bool talkup_network::Envelope::get_encoding(const std::string &name, Encoding &encoding)
+{
+    if (name == "cbor")
+        encoding = Encoding::CBOR;
+    else if (name == "msgpack")
+        encoding = Encoding::MSGPACK;
+    else if (name == "json")
+        encoding = Encoding::JSON;
+    else
+        return false;
+    return true;
+}
+
+talkup_network::message_json talkup_network::Envelope::decode(const std::string &data,
+    bool is_binary, Encoding &encoding)
+{
+    if (!is_binary) {
+        encoding = Encoding::JSON;
+        return message_json::parse(data);
+    }
+    if (data.empty())
+        throw ExceptionManager::NetworkEmptyBodyException();
+
+    const auto first = static_cast<uint8_t>(data[0]);
+
+    // Messages are maps: CBOR major type 5 (0xa0-0xbf), MessagePack
+    // fixmap (0x80-0x8f), map16 (0xde) or map32 (0xdf).
+    if (first >= 0xa0 && first <= 0xbf) {
+        encoding = Encoding::CBOR;
+        return message_json::from_cbor(data);
+    }
+    if ((first >= 0x80 && first <= 0x8f) || first == 0xde || first == 0xdf) {
+        encoding = Encoding::MSGPACK;
+        return message_json::from_msgpack(data);
+    }
+    throw ExceptionManager::NetworkUnsupportedEncodingException();
+}
+
+template <typename Json>
+std::string talkup_network::Envelope::encode(const Json &json, Encoding encoding)
+{
+    std::string out;
+
+    encode_into(json, encoding, out);
+    return out;
+}
+
+template <typename Json>
+void talkup_network::Envelope::encode_into(const Json &json, Encoding encoding,
+    std::string &out)
+{
+    switch (encoding) {
+        case Encoding::CBOR:
+            Json::to_cbor(json, out);
+            break;
+        case Encoding::MSGPACK:
+            Json::to_msgpack(json, out);
+            break;
+        default: {
+            StringWriter writer(out);
+            std::ostream stream(&writer);
+            stream << json;
+            break;
+        }
+    }
+}
+
+template <typename Json>
+void talkup_network::Envelope::send(crow::websocket::connection &conn,
+    const Json &json, Encoding encoding)
+{
+    static thread_local std::string frame;
+
+    frame.clear();
+    encode_into(json, encoding, frame);
+    if (encoding == Encoding::JSON)
+        conn.send_text(frame);
+    else
+        conn.send_binary(frame);
+}
+
+template std::string talkup_network::Envelope::encode(const nlohmann::json &, Encoding);
+template std::string talkup_network::Envelope::encode(const message_json &, Encoding);
+template void talkup_network::Envelope::encode_into(const nlohmann::json &, Encoding,
+    std::string &);
+template void talkup_network::Envelope::encode_into(const message_json &, Encoding,
+    std::string &);
+template void talkup_network::Envelope::send(crow::websocket::connection &,
+    const nlohmann::json &, Encoding);
+template void talkup_network::Envelope::send(crow::websocket::connection &,
+    const message_json &, Encoding);
@@ -0,0 +1,21 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the message schema codecs
+*/
+
+#include <crow.h>
+
+#include "MessageSchema.hpp"
+
+std::string talkup_network::schema::decode_base64(const std::string &text)
+{
+    return crow::utility::base64decode(text);
+}
+
+std::string talkup_network::schema::encode_base64(const std::string &bytes)
+{
+    return crow::utility::base64encode(reinterpret_cast<const unsigned char *>(bytes.data()),
+        bytes.size());
+}
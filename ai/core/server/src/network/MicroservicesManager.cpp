@@ -29,8 +29,14 @@ void talkup_network::MicroservicesManager::load_microservices_info(
             throw std::ios_base::failure("Failed to open file: " + file_path);
         file >> info;
         for (auto &[k, lv] : info.items()) {
-            for (auto &[lvk, value] : lv.items())
-                __services_list[k][lvk] = value;
+            __services_list[k];
+            for (auto &[lvk, value] : lv.items()) {
+                if (lvk == "Urls") {
+                    __replicas[k] = value.get<std::vector<std::string>>();
+                    continue;
+                }
+                __services_list[k][lvk] = value.is_string() ? value.get<std::string>() : value.dump();
+            }
         }
         file.close();
     }
@@ -40,6 +46,22 @@ void talkup_network::MicroservicesManager::load_microservices_info(
     }
 }
 
+std::vector<std::string> talkup_network::MicroservicesManager::get_replica_urls(
+    const std::string &service_name)
+{
+    auto replicas = __replicas.find(service_name);
+
+    if (replicas != __replicas.end() && !replicas->second.empty())
+        return replicas->second;
+    auto service = __services_list.find(service_name);
+    if (service == __services_list.end())
+        return {};
+    auto url = service->second.find("Url");
+    if (url == service->second.end())
+        return {};
+    return { url->second };
+}
+
 const std::unordered_map<std::string, std::unordered_map<std::string, std::string>>&
     talkup_network::MicroservicesManager::get_services_list()
 {
@@ -0,0 +1,291 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the PlacementRegistry class
+*/
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include <crow.h>
+
+#include "ServerMetrics.hpp"
+#include "PlacementRegistry.hpp"
+
+namespace {
+    constexpr size_t SHA1_BLOCK_SIZE = 64;
+    constexpr size_t SHA1_DIGEST_SIZE = 20;
+    const std::string EXTENSION = ".json";
+
+    int64_t wall_ms(void)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    std::string digest_sha1(const std::string &data)
+    {
+        sha1::SHA1 sha;
+        uint8_t digest[SHA1_DIGEST_SIZE];
+
+        sha.processBytes(data.data(), data.size());
+        sha.getDigestBytes(digest);
+        return std::string(reinterpret_cast<const char *>(digest), SHA1_DIGEST_SIZE);
+    }
+
+    // The IDs end up in file names and in URLs.
+    std::string sanitize(const std::string &id)
+    {
+        std::string clean = id;
+
+        for (char &c : clean) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+                c = '-';
+        }
+        return clean;
+    }
+
+    bool equals_constant_time(const std::string &a, const std::string &b)
+    {
+        unsigned char diff = a.size() != b.size();
+
+        for (size_t i = 0; i < a.size() && i < b.size(); i++)
+            diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+        return diff == 0;
+    }
+}
+
+void talkup_network::PlacementRegistry::configure(const Options &options)
+{
+    char host[256] = "";
+    std::error_code error;
+
+    __options = options;
+    if (__options.id.empty()) {
+        gethostname(host, sizeof(host) - 1);
+        __options.id = std::string(host) + "-" + std::to_string(getpid());
+    }
+    __options.id = sanitize(__options.id);
+    __enabled = !__options.directory.empty() && !__options.secret.empty();
+    if (__enabled)
+        std::filesystem::create_directories(__options.directory, error);
+}
+
+bool talkup_network::PlacementRegistry::is_enabled(void) const
+{
+    return __enabled;
+}
+
+const std::string &talkup_network::PlacementRegistry::get_id(void) const
+{
+    return __options.id;
+}
+
+std::chrono::milliseconds talkup_network::PlacementRegistry::get_publish_interval(void) const
+{
+    return __options.publish_interval;
+}
+
+bool talkup_network::PlacementRegistry::publish(void)
+{
+    if (!__enabled)
+        return false;
+    std::filesystem::path directory(__options.directory);
+    std::filesystem::path temporary = directory / (__options.id + EXTENSION + ".tmp");
+    std::error_code error;
+    nlohmann::json entry;
+
+    entry["id"] = __options.id;
+    entry["address"] = __options.address;
+    entry["sessions"] = ServerMetrics::open_connections.load(std::memory_order_relaxed);
+    entry["cpu"] = __sample_cpu();
+    entry["queue_depth"] = ServerMetrics::get_queue_depth();
+    entry["updated_ms"] = wall_ms();
+    {
+        std::ofstream file(temporary);
+
+        if (!(file << entry.dump()))
+            return false;
+    }
+    // Renamed over the previous entry, so a reader never sees half of it.
+    std::filesystem::rename(temporary, directory / (__options.id + EXTENSION), error);
+    return !error;
+}
+
+void talkup_network::PlacementRegistry::withdraw(void)
+{
+    std::error_code error;
+
+    if (__enabled)
+        std::filesystem::remove(std::filesystem::path(__options.directory)
+            / (__options.id + EXTENSION), error);
+}
+
+std::vector<talkup_network::PlacementRegistry::Instance>
+    talkup_network::PlacementRegistry::get_instances(void)
+{
+    std::vector<Instance> instances;
+    std::error_code error;
+    int64_t now = wall_ms();
+
+    if (!__enabled)
+        return instances;
+    for (const auto &file : std::filesystem::directory_iterator(__options.directory, error)) {
+        if (file.path().extension() != EXTENSION)
+            continue;
+        std::ifstream stream(file.path());
+        auto entry = nlohmann::json::parse(stream, nullptr, false);
+        Instance instance;
+
+        if (entry.is_discarded() || !entry.is_object())
+            continue;
+        instance.id = entry.value("id", "");
+        instance.address = entry.value("address", "");
+        instance.sessions = entry.value("sessions", int64_t(0));
+        instance.cpu = entry.value("cpu", 0.0);
+        instance.queue_depth = entry.value("queue_depth", int64_t(0));
+        instance.updated_ms = entry.value("updated_ms", int64_t(0));
+        if (instance.id.empty() || instance.address.empty()
+            || now - instance.updated_ms > __options.stale_after.count())
+            continue;
+        instances.push_back(std::move(instance));
+    }
+    return instances;
+}
+
+talkup_network::PlacementRegistry::Instance talkup_network::PlacementRegistry::place(
+    const std::string &preferred)
+{
+    std::vector<Instance> instances = get_instances();
+    std::lock_guard<std::mutex> lock(__mutex);
+    const Instance *chosen = nullptr;
+    double lowest = 0;
+
+    for (auto it = __placed.begin(); it != __placed.end();) {
+        bool alive = std::any_of(instances.begin(), instances.end(),
+            [&it](const Instance &instance) { return instance.id == it->first; });
+        it = alive ? std::next(it) : __placed.erase(it);
+    }
+    for (auto &instance : instances) {
+        __Placed &placed = __placed[instance.id];
+
+        // Its new publication already counts the sessions placed before it.
+        if (placed.since_ms < instance.updated_ms)
+            placed = { 0, instance.updated_ms };
+        instance.sessions += placed.count;
+        if (instance.id == preferred) {
+            chosen = &instance;
+            break;
+        }
+        double score = get_score(instance);
+        if (!chosen || score < lowest || (score == lowest && instance.id < chosen->id)) {
+            chosen = &instance;
+            lowest = score;
+        }
+    }
+    if (!chosen) {
+        Instance self;
+
+        self.id = __options.id;
+        self.address = __options.address;
+        return self;
+    }
+    __placed[chosen->id].count++;
+    return *chosen;
+}
+
+std::string talkup_network::PlacementRegistry::issue_token(const std::string &instance_id) const
+{
+    static thread_local std::mt19937_64 engine(std::random_device{}());
+    std::ostringstream payload;
+    int64_t expires_ms = wall_ms() + __options.token_ttl.count();
+
+    payload << instance_id << '.' << expires_ms << '.' << std::hex << std::setfill('0')
+        << std::setw(16) << engine();
+    return payload.str() + "." + sign(__options.secret, payload.str());
+}
+
+bool talkup_network::PlacementRegistry::validate_token(const std::string &token)
+{
+    size_t mac = token.rfind('.');
+    size_t nonce = mac == std::string::npos || mac == 0 ? std::string::npos : token.rfind('.', mac - 1);
+    size_t expiry = nonce == std::string::npos || nonce == 0 ? std::string::npos : token.rfind('.', nonce - 1);
+
+    if (!__enabled || expiry == std::string::npos)
+        return false;
+    std::string payload = token.substr(0, mac);
+    if (!equals_constant_time(sign(__options.secret, payload), token.substr(mac + 1)))
+        return false;
+    if (token.substr(0, expiry) != __options.id)
+        return false;
+    int64_t now = wall_ms();
+    int64_t expires_ms = std::strtoll(token.substr(expiry + 1, nonce - expiry - 1).c_str(), nullptr, 10);
+    if (expires_ms < now)
+        return false;
+    std::lock_guard<std::mutex> lock(__mutex);
+
+    // An expired token is refused anyway: its nonce can go.
+    while (!__nonce_expiries.empty() && __nonce_expiries.begin()->first < now) {
+        __used_nonces.erase(__nonce_expiries.begin()->second);
+        __nonce_expiries.erase(__nonce_expiries.begin());
+    }
+    std::string key = token.substr(nonce + 1, mac - nonce - 1);
+    if (!__used_nonces.insert(key).second)
+        return false;
+    __nonce_expiries.emplace(expires_ms, std::move(key));
+    return true;
+}
+
+double talkup_network::PlacementRegistry::get_score(const Instance &instance)
+{
+    return static_cast<double>(instance.sessions) / ServerMetrics::MAX_CONNECTIONS
+        + instance.cpu
+        + static_cast<double>(instance.queue_depth) / ServerMetrics::MAX_QUEUE_DEPTH;
+}
+
+std::string talkup_network::PlacementRegistry::sign(const std::string &key, const std::string &message)
+{
+    std::string block = key.size() > SHA1_BLOCK_SIZE ? digest_sha1(key) : key;
+    std::string inner(SHA1_BLOCK_SIZE, '\x36');
+    std::string outer(SHA1_BLOCK_SIZE, '\x5c');
+    std::ostringstream hex;
+
+    for (size_t i = 0; i < block.size(); i++) {
+        inner[i] ^= block[i];
+        outer[i] ^= block[i];
+    }
+    for (unsigned char c : digest_sha1(outer + digest_sha1(inner + message)))
+        hex << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(c);
+    return hex.str();
+}
+
+double talkup_network::PlacementRegistry::__sample_cpu(void)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    rusage usage;
+    auto now = std::chrono::steady_clock::now();
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    int64_t cpu_us = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+        + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    int64_t used_us = cpu_us - __cpu_time_us;
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - __cpu_sampled_at).count();
+    bool first = __cpu_time_us == 0;
+
+    __cpu_time_us = cpu_us;
+    __cpu_sampled_at = now;
+    if (first || elapsed <= 0)
+        return 0;
+    return std::clamp(static_cast<double>(used_us) / (static_cast<double>(elapsed) * cores), 0.0, 1.0);
+}
@@ -0,0 +1,169 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the RateLimiter class
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "RateLimiter.hpp"
+
+talkup_network::RateLimiter::RateLimiter()
+{
+    __classes["default"] = ServiceClass();
+}
+
+void talkup_network::RateLimiter::load_limits(const std::string &file_path)
+{
+    try
+    {
+        std::ifstream file(file_path);
+        nlohmann::json info;
+
+        if (!file.is_open())
+            throw std::ios_base::failure("Failed to open file: " + file_path);
+        file >> info;
+        if (info.contains("classes")) {
+            for (auto &[name, value] : info["classes"].items()) {
+                ServiceClass service_class;
+
+                service_class.key = __parse_limits(value.value("key", nlohmann::json::object()),
+                    service_class.key);
+                service_class.connection = __parse_limits(
+                    value.value("connection", nlohmann::json::object()), service_class.connection);
+                __classes[name] = service_class;
+            }
+        }
+        if (info.contains("keys")) {
+            for (auto &[key, name] : info["keys"].items())
+                __key_classes[key] = name.get<std::string>();
+        }
+        file.close();
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+talkup_network::RateLimiter::Decision talkup_network::RateLimiter::admit(
+    const std::string &key, const std::string &client, Buckets &connection, size_t bytes,
+    Clock::time_point now)
+{
+    const ServiceClass &service_class = get_service_class(key);
+    Decision decision;
+
+    __refill(connection, service_class.connection, now);
+    if (!__available(connection, service_class.connection, bytes, decision.retry_after_ms)) {
+        decision.allowed = false;
+        decision.scope = Scope::CONNECTION;
+        return decision;
+    }
+    if (service_class.key.messages_per_sec > 0) {
+        std::string scope = key + '\n' + client;
+        __Shard &shard = __shards[std::hash<std::string>{}(scope) % __SHARD_COUNT];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        // The buckets idle for longer than their burst are full again: they can go.
+        if (shard.buckets.size() >= __MAX_SHARD_BUCKETS) {
+            auto idle = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(service_class.key.burst));
+
+            for (auto it = shard.buckets.begin(); it != shard.buckets.end();)
+                it = now - it->second.last_refill > idle ? shard.buckets.erase(it) : std::next(it);
+        }
+        Buckets &buckets = shard.buckets[scope];
+
+        __refill(buckets, service_class.key, now);
+        if (!__available(buckets, service_class.key, bytes, decision.retry_after_ms)) {
+            decision.allowed = false;
+            decision.scope = Scope::KEY;
+            return decision;
+        }
+        __consume(buckets, bytes);
+    }
+    __consume(connection, bytes);
+    return decision;
+}
+
+const talkup_network::RateLimiter::ServiceClass &talkup_network::RateLimiter::get_service_class(
+    const std::string &key) const
+{
+    auto name = __key_classes.find(key);
+    if (name != __key_classes.end()) {
+        auto it = __classes.find(name->second);
+        if (it != __classes.end())
+            return it->second;
+    }
+    return __classes.at("default");
+}
+
+std::string talkup_network::RateLimiter::get_scope_name(Scope scope)
+{
+    switch (scope) {
+        case Scope::CONNECTION:
+            return "connection";
+        case Scope::KEY:
+            return "key";
+        default:
+            return "none";
+    }
+}
+
+talkup_network::RateLimiter::Limits talkup_network::RateLimiter::__parse_limits(
+    const nlohmann::json &json, const Limits &fallback)
+{
+    Limits limits;
+
+    limits.messages_per_sec = json.value("messages_per_sec", fallback.messages_per_sec);
+    limits.bytes_per_sec = json.value("bytes_per_sec", fallback.bytes_per_sec);
+    limits.burst = json.value("burst", fallback.burst);
+    return limits;
+}
+
+void talkup_network::RateLimiter::__refill(Buckets &buckets, const Limits &limits,
+    Clock::time_point now)
+{
+    double max_messages = limits.messages_per_sec * limits.burst;
+    double max_bytes = limits.bytes_per_sec * limits.burst;
+
+    if (buckets.messages < 0) {
+        buckets.messages = max_messages;
+        buckets.bytes = max_bytes;
+        buckets.last_refill = now;
+        return;
+    }
+    double elapsed = std::chrono::duration<double>(now - buckets.last_refill).count();
+    if (elapsed <= 0)
+        return;
+    buckets.messages = std::min(max_messages, buckets.messages + elapsed * limits.messages_per_sec);
+    buckets.bytes = std::min(max_bytes, buckets.bytes + elapsed * limits.bytes_per_sec);
+    buckets.last_refill = now;
+}
+
+bool talkup_network::RateLimiter::__available(const Buckets &buckets, const Limits &limits,
+    size_t bytes, int64_t &retry_after_ms)
+{
+    // A message bigger than the whole bucket passes once the bucket is full,
+    // the bucket then goes into debt.
+    double needed_bytes = std::min(static_cast<double>(bytes), limits.bytes_per_sec * limits.burst);
+    double wait = 0;
+
+    if (buckets.messages < 1)
+        wait = std::max(wait, (1 - buckets.messages) / limits.messages_per_sec);
+    if (buckets.bytes < needed_bytes)
+        wait = std::max(wait, (needed_bytes - buckets.bytes) / limits.bytes_per_sec);
+    retry_after_ms = static_cast<int64_t>(std::ceil(wait * 1000));
+    return wait <= 0;
+}
+
+void talkup_network::RateLimiter::__consume(Buckets &buckets, size_t bytes)
+{
+    buckets.messages -= 1;
+    buckets.bytes -= static_cast<double>(bytes);
+}
@@ -11,19 +11,55 @@
 #include <fstream>
 #include <cstdlib>
 #include <cctype>
+#include <algorithm>
 #include <vector>
 
+#include "ConnectionContext.hpp"
 #include "WebsocketManager.hpp"
 #include "ExceptionManager.hpp"
+#include "MessageArena.hpp"
+#include "MessageSchema.hpp"
+#include "Messages.hpp"
+#include "ServerMetrics.hpp"
+#include "ServicePool.hpp"
+#include "Tracer.hpp"
 #include "Router.hpp"
 
+namespace {
+    int64_t now_ms(void)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+talkup_network::Router::~Router()
+{
+    __timers.stop();
+    // A publication still running would write the entry back.
+    __publisher.stop();
+    __placement.withdraw();
+}
+
 void talkup_network::Router::get_env_key(void)
 {
     const char* comm = std::getenv("COMMUNICATION");
     const char* ws = std::getenv("WS_ADDRESS");
+    const char* trace = std::getenv("TRACE_SAMPLE_RATE");
+    const char* memory = std::getenv("MEMORY_BUDGET_MB");
+    const char* registry = std::getenv("PLACEMENT_REGISTRY_DIR");
+    const char* instance = std::getenv("PLACEMENT_INSTANCE_ID");
+    const char* secret = std::getenv("PLACEMENT_SECRET");
+    const char* idle = std::getenv("IDLE_TIMEOUT_MS");
 
     if (comm) __env_variables["COMMUNICATION"] = std::string(comm);
     if (ws) __env_variables["WS_ADDRESS"] = std::string(ws);
+    if (trace) __env_variables["TRACE_SAMPLE_RATE"] = std::string(trace);
+    if (memory) __env_variables["MEMORY_BUDGET_MB"] = std::string(memory);
+    if (registry) __env_variables["PLACEMENT_REGISTRY_DIR"] = std::string(registry);
+    if (instance) __env_variables["PLACEMENT_INSTANCE_ID"] = std::string(instance);
+    if (secret) __env_variables["PLACEMENT_SECRET"] = std::string(secret);
+    if (idle) __env_variables["IDLE_TIMEOUT_MS"] = std::string(idle);
     if (!__env_variables["COMMUNICATION"].empty() && !__env_variables["WS_ADDRESS"].empty())
         return;
 
@@ -48,142 +84,406 @@ void talkup_network::Router::get_env_key(void)
     env_file.close();
 }
 
-void talkup_network::Router::set_routes_definitions(crow::SimpleApp& app)
+void talkup_network::Router::init(void)
 {
+    if (__initialized)
+        return;
+    __initialized = true;
     get_env_key();
-    CROW_ROUTE(app, "/")([](){
-        return "Hello world";
+    __rate_limiter.load_limits("rate_limits.json");
+    if (!__env_variables["TRACE_SAMPLE_RATE"].empty())
+        Tracer::set_sample_rate(std::atof(__env_variables["TRACE_SAMPLE_RATE"].c_str()));
+    if (!__env_variables["MEMORY_BUDGET_MB"].empty())
+        __memory.set_limit(static_cast<size_t>(std::strtoull(
+            __env_variables["MEMORY_BUDGET_MB"].c_str(), nullptr, 10)) << 20);
+    if (std::atoll(__env_variables["IDLE_TIMEOUT_MS"].c_str()) > 0)
+        __idle_timeout = std::chrono::milliseconds(std::atoll(__env_variables["IDLE_TIMEOUT_MS"].c_str()));
+    if (!__env_variables["PLACEMENT_REGISTRY_DIR"].empty() && __env_variables["PLACEMENT_SECRET"].empty())
+        std::cerr << "[PLACEMENT] PLACEMENT_SECRET is not set, placement disabled" << std::endl;
+    else if (!__env_variables["PLACEMENT_REGISTRY_DIR"].empty()) {
+        PlacementRegistry::Options options;
+
+        options.directory = __env_variables["PLACEMENT_REGISTRY_DIR"];
+        options.id = __env_variables["PLACEMENT_INSTANCE_ID"];
+        options.address = __env_variables["WS_ADDRESS"];
+        // Not the server key: the clients know it, they could sign their own tokens.
+        options.secret = __env_variables["PLACEMENT_SECRET"];
+        __placement.configure(options);
+        __placement.publish();
+        __schedule_publication();
+    }
+}
+
+void talkup_network::Router::set_routes_definitions(crow::SimpleApp& app)
+{
+    init();
+    CROW_ROUTE(app, "/")([this](){
+        return handle_root();
+    });
+    CROW_ROUTE(app, "/live")([this](){
+        return handle_live();
+    });
+    CROW_ROUTE(app, "/ready")([this](){
+        return handle_ready();
+    });
+    CROW_ROUTE(app, "/debug/trace")([this](const crow::request& req){
+        return handle_debug_trace(req);
+    });
+    CROW_ROUTE(app, "/process/initialization").methods("POST"_method)([this](const crow::request& req){
+        return handle_initialization(req);
     });
-    CROW_ROUTE(app, "/process/initialization").methods("POST"_method)([&](const crow::request& req){
-        try {
-            static const std::string SERVER_KEY = __env_variables["COMMUNICATION"];
-            static const std::string WS_ADDRESS = __env_variables["WS_ADDRESS"];
 
-            if (req.body.empty()) {
-                nlohmann::json err;
-                err["type"] = "error";
-                err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::system_clock::now().time_since_epoch()).count();
-                err["data"] = { {"message", "empty request body"} };
-                crow::response res(err.dump());
-                res.set_header("Content-Type", "application/json");
-                res.code = __ErrorCode::FAILURE;
-                return res;
-            }
-            auto j = nlohmann::json::parse(req.body);
-            if (!j.contains("key") || !j.contains("type") || !j.contains("format")) {
-                nlohmann::json err;
-                err["type"] = "error";
-                err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::system_clock::now().time_since_epoch()).count();
-                err["data"] = { {"message", "missing required fields: key/type/format"} };
-                crow::response res(err.dump());
-                res.set_header("Content-Type", "application/json");
-                res.code = __ErrorCode::FAILURE;
-                return res;
-            }
-            if (!SERVER_KEY.empty()) {
-                try {
-                    std::string provided = j["key"].get<std::string>();
-                    if (provided != SERVER_KEY) {
-                        nlohmann::json err;
-                        err["type"] = "error";
-                        err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-                        err["data"] = { {"message", "unauthorized: invalid key"} };
-                        crow::response res(err.dump());
-                        res.set_header("Content-Type", "application/json");
-                        res.code = __ErrorCode::INV_KEY;
-                        return res;
-                    }
-                } catch (...) {
-                    nlohmann::json err;
-                    err["type"] = "error";
-                    err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-                    err["data"] = { {"message", "invalid key format"} };
-                    crow::response res(err.dump());
-                    res.set_header("Content-Type", "application/json");
-                    res.code = __ErrorCode::FAILURE;
-                    return res;
-                }
-            } else {
-                nlohmann::json err;
-                err["type"] = "error";
-                err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::system_clock::now().time_since_epoch()).count();
-                err["data"] = { {"message", "server key not set"} };
-                crow::response res(err.dump());
-                res.set_header("Content-Type", "application/json");
-                res.code = __ErrorCode::KEY_NOT_SET;
-                return res;
-            }
-            if (j["type"].get<std::string>() != "initialization") {
+    CROW_ROUTE(app, "/ws").websocket()
+    .onaccept([this](const crow::request& req, void** userdata){
+        return on_ws_accept(req, userdata);
+    })
+    .onopen([this](crow::websocket::connection& conn){
+        on_ws_open(conn);
+    })
+    .onclose([this](crow::websocket::connection& conn, const std::string& reason){
+        on_ws_close(conn, reason);
+    })
+    .onmessage([this](crow::websocket::connection& conn, const std::string& data, bool is_binary){
+        on_ws_message(conn, data, is_binary);
+    });
+}
+
+crow::response talkup_network::Router::handle_request(const crow::request& req)
+{
+    if (req.url == "/process/initialization") {
+        if (req.method != crow::HTTPMethod::Post)
+            return crow::response(__ErrorCode::METHOD_NOT_ALLOWED);
+        return handle_initialization(req);
+    }
+    if (req.url != "/" && req.url != "/live" && req.url != "/ready" && req.url != "/debug/trace")
+        return crow::response(__ErrorCode::NOT_FOUND);
+    if (req.method != crow::HTTPMethod::Get)
+        return crow::response(__ErrorCode::METHOD_NOT_ALLOWED);
+    if (req.url == "/live")
+        return handle_live();
+    if (req.url == "/ready")
+        return handle_ready();
+    if (req.url == "/debug/trace")
+        return handle_debug_trace(req);
+    return handle_root();
+}
+
+crow::response talkup_network::Router::handle_root(void)
+{
+    return crow::response("Hello world");
+}
+
+crow::response talkup_network::Router::handle_live(void)
+{
+    nlohmann::json ok;
+
+    ok["status"] = "alive";
+    crow::response res(ok.dump());
+    res.set_header("Content-Type", "application/json");
+    res.code = __ErrorCode::SUCCESS;
+    return res;
+}
+
+crow::response talkup_network::Router::handle_ready(void)
+{
+    bool ready = ServicePool::is_ready();
+    nlohmann::json state;
+
+    state["status"] = ready ? "ready" : "warming";
+    state["services"] = ServicePool::get_states();
+    state["circuits"] = ServicePool::get_circuits();
+    crow::response res(state.dump());
+    res.set_header("Content-Type", "application/json");
+    res.code = ready ? __ErrorCode::SUCCESS : __ErrorCode::UNAVAILABLE;
+    return res;
+}
+
+crow::response talkup_network::Router::handle_debug_trace(const crow::request& req)
+{
+    const std::string SERVER_KEY = __env_variables["COMMUNICATION"];
+    std::ostringstream oss;
+
+    if (SERVER_KEY.empty() || req.get_header_value("X-Talkup-Key") != SERVER_KEY)
+        return crow::response(__ErrorCode::INV_KEY);
+    Tracer::dump(oss);
+    crow::response res(oss.str());
+    res.set_header("Content-Type", "application/json");
+    res.code = __ErrorCode::SUCCESS;
+    return res;
+}
+
+crow::response talkup_network::Router::handle_initialization(const crow::request& req)
+{
+    try {
+        const std::string SERVER_KEY = __env_variables["COMMUNICATION"];
+        const std::string WS_ADDRESS = __env_variables["WS_ADDRESS"];
+
+        if (req.body.empty()) {
+            nlohmann::json err;
+            err["type"] = "error";
+            err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            err["data"] = { {"message", "empty request body"} };
+            crow::response res(err.dump());
+            res.set_header("Content-Type", "application/json");
+            res.code = __ErrorCode::FAILURE;
+            return res;
+        }
+        auto j = nlohmann::json::parse(req.body);
+        messages::InitializationRequest request;
+
+        if (!schema::parse(j, request)) {
+            nlohmann::json err;
+            err["type"] = "error";
+            err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            err["data"] = { {"message", "missing required fields: key/type/format"} };
+            crow::response res(err.dump());
+            res.set_header("Content-Type", "application/json");
+            res.code = __ErrorCode::FAILURE;
+            return res;
+        }
+        if (!SERVER_KEY.empty()) {
+            if (request.key != SERVER_KEY) {
                 nlohmann::json err;
                 err["type"] = "error";
-                err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::system_clock::now().time_since_epoch()).count();
-                err["data"] = { {"message", "invalid type for this endpoint"} };
+                err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+                err["data"] = { {"message", "unauthorized: invalid key"} };
                 crow::response res(err.dump());
                 res.set_header("Content-Type", "application/json");
-                res.code = __ErrorCode::FAILURE;
+                res.code = __ErrorCode::INV_KEY;
                 return res;
             }
-            nlohmann::json ok;
-            ok["key"] = SERVER_KEY;
-            ok["type"] = "initialization_response";
-            ok["format"] = "text";
-            ok["data"] = WS_ADDRESS;
-            crow::response res(ok.dump());
+        } else {
+            nlohmann::json err;
+            err["type"] = "error";
+            err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            err["data"] = { {"message", "server key not set"} };
+            crow::response res(err.dump());
             res.set_header("Content-Type", "application/json");
-            res.code = __ErrorCode::SUCCESS;
+            res.code = __ErrorCode::KEY_NOT_SET;
             return res;
-        } catch (const std::exception &e) {
+        }
+        if (request.type != "initialization") {
             nlohmann::json err;
             err["type"] = "error";
             err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count();
-            err["data"] = { {"message", std::string("invalid json: ") + e.what()} };
+            err["data"] = { {"message", "invalid type for this endpoint"} };
             crow::response res(err.dump());
             res.set_header("Content-Type", "application/json");
             res.code = __ErrorCode::FAILURE;
             return res;
         }
-    });
+        nlohmann::json ok;
+        ok["key"] = SERVER_KEY;
+        ok["type"] = "initialization_response";
+        ok["format"] = "text";
+        std::string address = WS_ADDRESS;
+        auto encoding = Envelope::negotiate(j);
+        if (__placement.is_enabled()) {
+            auto instance = __placement.place(request.instance.value_or(""));
+            std::string token = __placement.issue_token(instance.id);
 
-    CROW_ROUTE(app, "/ws").websocket()
-    .onopen([](crow::websocket::connection& conn){
-        std::ostringstream oss;
-        oss << "[WS] Connection opened: " << (void*)&conn;
-        std::cout << oss.str() << std::endl;
-    })
-    .onclose([](crow::websocket::connection& conn, const std::string& reason){
-        std::ostringstream oss;
-        oss << "[WS] Connection closed: " << (void*)&conn << " reason: " << reason;
-        std::cout << oss.str() << std::endl;
-    })
-    .onmessage([this](crow::websocket::connection& conn, const std::string& data, bool is_binary){
-        try {
-            if (is_binary) {
-                return;
-            }
-            talkup_network::WsManager wsManager;
-            auto j = nlohmann::json::parse(data);
+            address = instance.address + (instance.address.find('?') == std::string::npos ? "?" : "&")
+                + "placement=" + token;
+            ok["placement"] = { {"instance", instance.id}, {"token", token} };
+        }
+        // Bound to the connection when it opens: JSON without the parameter.
+        if (encoding != Envelope::Encoding::JSON)
+            address += (address.find('?') == std::string::npos ? "?" : "&")
+                + std::string("encoding=") + Envelope::get_encoding_name(encoding);
+        ok["data"] = address;
+        ok["encoding"] = Envelope::get_encoding_name(encoding);
+        ok["protocol_version"] = Envelope::PROTOCOL_VERSION;
+        crow::response res(ok.dump());
+        res.set_header("Content-Type", "application/json");
+        res.code = __ErrorCode::SUCCESS;
+        return res;
+    } catch (const std::exception &e) {
+        nlohmann::json err;
+        err["type"] = "error";
+        err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        err["data"] = { {"message", std::string("invalid json: ") + e.what()} };
+        crow::response res(err.dump());
+        res.set_header("Content-Type", "application/json");
+        res.code = __ErrorCode::FAILURE;
+        return res;
+    }
+}
 
-            if (!j.contains("type") || !j.contains("stream_id") || !j.contains("format") ||
-                !j.contains("timestamp") || !j.contains("data") || !j.contains("key") ) {
-                    throw ExceptionManager::NetworkInvalidJsonException();
-            }
-            if (__env_variables["COMMUNICATION"] != j["key"].get<std::string>()) {
-                nlohmann::json err;
-                throw ExceptionManager::NetworkInvalidKeyException();
-            }
-            wsManager.connection_type_manager(j, conn);
-        } catch (const std::exception &e) {
-            nlohmann::json err;
+bool talkup_network::Router::on_ws_accept(const crow::request& req, void **userdata)
+{
+    crow::query_string params(req.raw_url);
+    const char* token = params.get("placement");
+    const char* name = params.get("encoding");
+    auto encoding = Envelope::Encoding::JSON;
+
+    if (__placement.is_enabled() && !(token && __placement.validate_token(token)))
+        return false;
+    if (name && !Envelope::get_encoding(name, encoding))
+        return false;
+    if (userdata) {
+        auto *context = new talkup_network::ConnectionContext();
+
+        context->encoding = encoding;
+        *userdata = context;
+    }
+    return true;
+}
+
+void talkup_network::Router::on_ws_open(crow::websocket::connection& conn)
+{
+    std::ostringstream oss;
+    auto *context = talkup_network::ConnectionContext::get(conn);
+
+    // Created by on_ws_accept, unless the transport has no userdata to carry it.
+    if (!context) {
+        context = new talkup_network::ConnectionContext();
+        conn.userdata(context);
+    }
+    context->last_seen_ms = now_ms();
+    context->client = conn.get_remote_ip();
+    talkup_network::ServerMetrics::open_connections.fetch_add(1, std::memory_order_relaxed);
+    oss << "[WS] Connection opened: " << (void*)&conn;
+    std::cout << oss.str() << std::endl;
+    __schedule_heartbeat(conn, __idle_timeout);
+}
+
+void talkup_network::Router::on_ws_close(crow::websocket::connection& conn, const std::string& reason)
+{
+    std::ostringstream oss;
+    oss << "[WS] Connection closed: " << (void*)&conn << " reason: " << reason;
+    std::cout << oss.str() << std::endl;
+    auto *context = talkup_network::ConnectionContext::get(conn);
+    if (context) {
+        context->closed = true;
+        // A running check may schedule the next one before it sees closed.
+        while (context->heartbeat != TimerService::NONE)
+            __timers.cancel(context->heartbeat.exchange(TimerService::NONE));
+    }
+    __ws_manager.on_connection_closed(conn);
+    delete context;
+    conn.userdata(nullptr);
+    talkup_network::ServerMetrics::open_connections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void talkup_network::Router::on_ws_message(crow::websocket::connection& conn, const std::string& data,
+    bool is_binary)
+{
+    // Declared first: every message_json of this message is gone when the arena is reset.
+    MessageArena::Scope arena;
+    auto *context = talkup_network::ConnectionContext::get(conn);
+    auto encoding = context ? context->encoding.load() : Envelope::Encoding::JSON;
+    int64_t received_us = Tracer::now_us();
+
+    ServerMetrics::messages_received.fetch_add(1, std::memory_order_relaxed);
+    ServerMetrics::bytes_received.fetch_add(data.size(), std::memory_order_relaxed);
+    if (context)
+        context->last_seen_ms = now_ms();
+    try {
+        // The frame may be in another encoding (text frames are JSON): replies keep the negotiated one.
+        auto frame_encoding = encoding;
+        auto j = Envelope::decode(data, is_binary, frame_encoding);
+        int64_t parsed_us = Tracer::now_us();
+
+        if (context && j.contains("trace") && j["trace"].is_boolean())
+            context->trace = j["trace"].get<bool>();
+        if (Tracer::begin_trace(context && context->trace))
+            Tracer::record("envelope_parse", received_us, parsed_us);
+
+        messages::Header header;
+
+        if (!schema::parse(j, header)) {
+            throw ExceptionManager::NetworkInvalidJsonException();
+        }
+        if (__env_variables["COMMUNICATION"] != header.key) {
+            throw ExceptionManager::NetworkInvalidKeyException();
+        }
+        if (context && header.type == "ping") {
+            int64_t now = context->last_seen_ms;
+            int64_t previous = context->last_ping_ms.exchange(now);
+            int64_t average = context->ping_interval_ms;
+
+            // Smoothed over the last pings, so one late ping doesn't matter.
+            if (previous)
+                context->ping_interval_ms = average ? (average * 3 + now - previous) / 4 : now - previous;
+        }
+        auto decision = context ? __rate_limiter.admit(header.key,
+            context->client, context->limits, data.size()) : RateLimiter::Decision();
+
+        if (decision.allowed) {
+            __ws_manager.connection_type_manager(header, j, conn);
+        } else {
+            message_json err;
             err["type"] = "error";
+            err["stream_id"] = header.stream_id;
             err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count();
-            err["data"] = { {"message", std::string("invalid json: ") + e.what()} };
-            conn.send_text(err.dump());
+            err["data"] = { {"message", "rate limit exceeded"}, {"code", "rate_limited"},
+                {"scope", RateLimiter::get_scope_name(decision.scope)},
+                {"retry_after_ms", decision.retry_after_ms} };
+            Envelope::send(conn, err, encoding);
         }
+    } catch (const std::exception &e) {
+        message_json err;
+        err["type"] = "error";
+        err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        err["data"] = { {"message", std::string("invalid json: ") + e.what()} };
+        Envelope::send(conn, err, encoding);
+    }
+    Tracer::record("ws_receive", received_us, Tracer::now_us());
+    Tracer::end_trace();
+}
+
+void talkup_network::Router::__schedule_heartbeat(crow::websocket::connection& conn,
+    std::chrono::milliseconds delay)
+{
+    auto *context = talkup_network::ConnectionContext::get(conn);
+
+    if (!context || context->closed)
+        return;
+    context->heartbeat = __timers.schedule_after(delay, [this, &conn]() {
+        __check_heartbeat(conn);
+    }, reinterpret_cast<size_t>(&conn));
+}
+
+void talkup_network::Router::__check_heartbeat(crow::websocket::connection& conn)
+{
+    auto *context = talkup_network::ConnectionContext::get(conn);
+
+    if (!context || context->closed)
+        return;
+    int64_t interval = context->ping_interval_ms;
+    auto timeout = __idle_timeout;
+    auto idle = std::chrono::milliseconds(now_ms() - context->last_seen_ms);
+
+    // A client which pings is expected to keep doing it: missing 3 pings is enough.
+    if (interval > 0)
+        timeout = std::min(__idle_timeout, std::max(std::min(MIN_HEARTBEAT_TIMEOUT, __idle_timeout),
+            std::chrono::milliseconds(interval * 3)));
+    if (idle < timeout) {
+        __schedule_heartbeat(conn, timeout - idle);
+        return;
+    }
+    std::ostringstream oss;
+    oss << "[WS] Connection idle: " << (void*)&conn << " for " << idle.count() << " ms";
+    std::cout << oss.str() << std::endl;
+    context->heartbeat = TimerService::NONE;
+    // Its streams are detached now, the connection may take a while to be gone.
+    __ws_manager.on_connection_closed(conn);
+    conn.close("idle timeout");
+}
+
+void talkup_network::Router::__schedule_publication(void)
+{
+    __timers.schedule_after(__placement.get_publish_interval(), [this]() {
+        // The registry is a file: written off the timer thread. A publication
+        // still waiting makes this one useless.
+        __publisher.try_submit([this]() { __placement.publish(); });
+        __schedule_publication();
     });
 }
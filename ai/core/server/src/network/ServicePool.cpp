@@ -0,0 +1,426 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the ServicePool class
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <crow.h>
+
+#include "Messages.hpp"
+#include "MicroservicesManager.hpp"
+#include "ServerMetrics.hpp"
+#include "Tracer.hpp"
+#include "ServicePool.hpp"
+
+struct talkup_network::ServicePool::__Race {
+    std::mutex mutex;
+    std::condition_variable done;
+    Result result;
+    size_t pending = 0;
+};
+
+void talkup_network::ServicePool::open_pools(void)
+{
+    for (const auto &[name, info] : MicroservicesManager::get_services_list()) {
+        auto urls = MicroservicesManager::get_replica_urls(name);
+        CircuitBreaker::Thresholds thresholds;
+        auto slow_call = info.find("SlowCallMs");
+        auto open_for = info.find("OpenForMs");
+
+        if (urls.empty() || __pools.count(name))
+            continue;
+        if (slow_call != info.end())
+            thresholds.slow_call_us = std::strtoll(slow_call->second.c_str(), nullptr, 10) * 1000;
+        if (open_for != info.end())
+            thresholds.open_for = std::chrono::milliseconds(
+                std::strtoll(open_for->second.c_str(), nullptr, 10));
+        auto pool = std::make_unique<__Pool>();
+        auto shm = info.find("Shm");
+        for (const auto &url : urls)
+            pool->replicas.push_back(std::make_unique<__Replica>(url, thresholds));
+        if (shm != info.end())
+            pool->shm = std::make_unique<ShmChannel>(shm->second);
+        __pools[name] = std::move(pool);
+    }
+}
+
+talkup_network::ServicePool::Result talkup_network::ServicePool::post(
+    const std::string &service, const std::string &path, const std::string &body,
+    std::chrono::milliseconds timeout)
+{
+    return post(service, path, body, Clock::now() + timeout, false);
+}
+
+talkup_network::ServicePool::Result talkup_network::ServicePool::post(
+    const std::string &service, const std::string &path, const std::string &body,
+    Clock::time_point deadline, bool idempotent)
+{
+    __Pool *pool = __find(service);
+    Result result;
+
+    if (!pool) {
+        result.error = "unknown service: " + service;
+        return result;
+    }
+    Tracer::ScopedSpan span("ms_call:", service);
+    if (Clock::now() >= deadline) {
+        result.error = "deadline exceeded: " + service;
+        return result;
+    }
+    __Replica *primary = __pick(*pool, nullptr);
+    if (!primary) {
+        result.error = "circuit open: " + service;
+        return result;
+    }
+    if (!idempotent || pool->replicas.size() < 2)
+        return __send(service, *primary, path, body, deadline);
+    // Both calls run on the pool so the caller can take whichever answers first.
+    auto race = std::make_shared<__Race>();
+    auto hedge_at = std::min(deadline, Clock::now()
+        + std::chrono::microseconds(primary->breaker.get_latency_p95_us(HEDGE_DELAY_US)));
+    auto answered = [&race]() { return race->result.ok || race->pending == 0; };
+
+    if (!__launch(race, service, *primary, path, body, deadline))
+        return __send(service, *primary, path, body, deadline);
+    {
+        std::unique_lock<std::mutex> lock(race->mutex);
+
+        if (race->done.wait_until(lock, hedge_at, answered) && race->result.ok)
+            return race->result;
+    }
+    // The primary is slow or already failed: the second replica gets the call too.
+    if (Clock::now() < deadline) {
+        __Replica *hedge = __pick(*pool, primary);
+
+        // A full pool means a loaded server: the hedge would only add to it.
+        if (hedge && __launch(race, service, *hedge, path, body, deadline))
+            ServerMetrics::service_request_hedged(service);
+    }
+    std::unique_lock<std::mutex> lock(race->mutex);
+    if (!race->done.wait_until(lock, deadline + std::chrono::milliseconds(50), answered)) {
+        result.error = "deadline exceeded: " + service;
+        return result;
+    }
+    return race->result;
+}
+
+talkup_network::ServicePool::Result talkup_network::ServicePool::post_samples(
+    const std::string &service, const nlohmann::json &task, std::string_view samples,
+    Clock::time_point deadline, bool idempotent)
+{
+    __Pool *pool = __find(service);
+    nlohmann::json message = task;
+
+    if (pool && pool->shm && pool->shm->is_available()) {
+        Tracer::ScopedSpan span("ms_shm_call:", service);
+        int64_t start_us = Tracer::now_us();
+        Result result;
+
+        ServerMetrics::service_request_started(service);
+        auto status = pool->shm->call(task.dump(), samples, deadline, result.body);
+        result.latency_us = Tracer::now_us() - start_us;
+        ServerMetrics::service_request_finished(service, result.latency_us,
+            status == ShmChannel::Status::OK);
+        if (status == ShmChannel::Status::OK) {
+            result.ok = true;
+            result.status = 200;
+            return result;
+        }
+        if (status == ShmChannel::Status::TIMEOUT) {
+            result.error = "deadline exceeded: " + service;
+            return result;
+        }
+    }
+    if (!message["data"].is_object())
+        message["data"] = nlohmann::json::object();
+    message["data"]["payload"] = crow::utility::base64encode(
+        reinterpret_cast<const unsigned char *>(samples.data()), samples.size());
+    return post(service, "task", message.dump(), deadline, idempotent);
+}
+
+talkup_network::ServicePool::Result talkup_network::ServicePool::post_stream(
+    const std::string &service, const std::string &path, const std::string &body,
+    Clock::time_point deadline, const OnData &on_data)
+{
+    __Pool *pool = __find(service);
+    Result result;
+
+    if (!pool) {
+        result.error = "unknown service: " + service;
+        return result;
+    }
+    Tracer::ScopedSpan span("ms_stream:", service);
+    if (Clock::now() >= deadline) {
+        result.error = "deadline exceeded: " + service;
+        return result;
+    }
+    __Replica *replica = __pick(*pool, nullptr);
+    if (!replica) {
+        result.error = "circuit open: " + service;
+        return result;
+    }
+    return __send(service, *replica, path, body, deadline, &on_data);
+}
+
+nlohmann::json talkup_network::ServicePool::get_warmup_task(const std::string &service)
+{
+    messages::TaskRequest task;
+
+    task.services = { service };
+    task.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (service == "stt" || service == "ba" || service == "ea") {
+        // 250 ms of 16 kHz mono PCM16 silence: 8000 zero bytes in Base64.
+        std::string silence;
+
+        for (int i = 0; i < 2666; i++)
+            silence += "AAAA";
+        silence += "AAA=";
+        task.data = { {"warmup", true}, {"format", "audio/pcm16"}, {"sample_rate", 16000},
+            {"payload", silence} };
+    } else {
+        task.data = { {"warmup", true}, {"format", "text"},
+            {"payload", "Hello, welcome to your interview."} };
+    }
+    return schema::serialize(task);
+}
+
+void talkup_network::ServicePool::warmup_all(const std::atomic<bool> &stop)
+{
+    std::vector<std::thread> workers;
+
+    for (auto &[name, pool] : __pools) {
+        pool->state = State::WARMING;
+        for (auto &replica : pool->replicas) {
+            workers.emplace_back([&stop, name = name, pool = pool.get(), replica = replica.get()]() {
+                __warmup(name, *pool, *replica, stop);
+            });
+        }
+    }
+    for (auto &worker : workers)
+        worker.join();
+}
+
+bool talkup_network::ServicePool::is_ready(void)
+{
+    for (const auto &[name, pool] : __pools) {
+        if (pool->state != State::READY)
+            return false;
+    }
+    return true;
+}
+
+nlohmann::json talkup_network::ServicePool::get_states(void)
+{
+    nlohmann::json states = nlohmann::json::object();
+
+    for (const auto &[name, pool] : __pools)
+        states[name] = get_state_name(pool->state);
+    return states;
+}
+
+nlohmann::json talkup_network::ServicePool::get_circuits(void)
+{
+    nlohmann::json circuits = nlohmann::json::object();
+
+    for (const auto &[name, pool] : __pools) {
+        nlohmann::json replicas = nlohmann::json::array();
+
+        for (const auto &replica : pool->replicas) {
+            replicas.push_back({
+                {"url", replica->url},
+                {"state", CircuitBreaker::get_state_name(replica->breaker.get_state())},
+                {"p95_ms", replica->breaker.get_latency_p95_us(0) / 1000.0},
+                {"warm", replica->warm.load()},
+            });
+        }
+        circuits[name] = replicas;
+    }
+    return circuits;
+}
+
+std::string talkup_network::ServicePool::get_state_name(State state)
+{
+    switch (state) {
+        case State::WARMING:
+            return "warming";
+        case State::READY:
+            return "ready";
+        default:
+            return "cold";
+    }
+}
+
+talkup_network::ServicePool::__Pool *talkup_network::ServicePool::__find(
+    const std::string &service)
+{
+    auto it = __pools.find(service);
+
+    return it == __pools.end() ? nullptr : it->second.get();
+}
+
+talkup_network::ServicePool::__Replica *talkup_network::ServicePool::__pick(
+    __Pool &pool, const __Replica *skip)
+{
+    size_t count = pool.replicas.size();
+    size_t start = pool.next.fetch_add(1, std::memory_order_relaxed);
+
+    // Round robin over the replicas whose breaker lets the call through.
+    for (size_t i = 0; i < count; i++) {
+        __Replica *replica = pool.replicas[(start + i) % count].get();
+
+        if (replica != skip && replica->breaker.allow())
+            return replica;
+    }
+    return nullptr;
+}
+
+talkup_network::ServicePool::Result talkup_network::ServicePool::__send(
+    const std::string &service, __Replica &replica, const std::string &path,
+    const std::string &body, Clock::time_point deadline, const OnData *on_data)
+{
+    Result result;
+    int64_t start_us = Tracer::now_us();
+    auto session = __acquire(replica, deadline);
+
+    ServerMetrics::service_request_started(service);
+    if (!session) {
+        result.latency_us = Tracer::now_us() - start_us;
+        result.error = "no connection available before the deadline: " + service;
+        replica.breaker.record(false, result.latency_us);
+        ServerMetrics::service_request_finished(service, result.latency_us, false);
+        return result;
+    }
+    auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+    session->SetUrl(cpr::Url{replica.url + path});
+    session->SetHeader(cpr::Header{{"Content-Type", "application/json"}});
+    session->SetBody(cpr::Body{body});
+    session->SetTimeout(cpr::Timeout{std::max(timeout, std::chrono::milliseconds(1))});
+    bool aborted = false;
+    if (on_data) {
+        session->SetWriteCallback(cpr::WriteCallback{[on_data, &aborted](
+            const std::string_view &data, intptr_t) {
+            aborted = !(*on_data)(data);
+            return !aborted;
+        }});
+    }
+    cpr::Response response = session->Post();
+    // An empty callback puts the pooled session back to reading whole bodies.
+    if (on_data)
+        session->SetWriteCallback(cpr::WriteCallback{});
+    result.latency_us = Tracer::now_us() - start_us;
+    result.status = response.status_code;
+    result.ok = !response.error && response.status_code >= 200 && response.status_code < 300;
+    result.body = std::move(response.text);
+    result.error = aborted ? "aborted" : response.error.message;
+    // A stream the caller gave up on says nothing about the health of the replica.
+    replica.breaker.record(result.ok || aborted, result.latency_us);
+    ServerMetrics::service_request_finished(service, result.latency_us, result.ok || aborted);
+    __release(replica, std::move(session));
+    return result;
+}
+
+bool talkup_network::ServicePool::__launch(const std::shared_ptr<__Race> &race,
+    const std::string &service, __Replica &replica, const std::string &path,
+    const std::string &body, Clock::time_point deadline)
+{
+    {
+        std::lock_guard<std::mutex> lock(race->mutex);
+        race->pending++;
+    }
+    bool queued = __callers.try_submit([race, service, &replica, path, body, deadline]() {
+        Result result = __send(service, replica, path, body, deadline);
+
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+
+            race->pending--;
+            // The first successful answer wins, the slower one is dropped.
+            if (!race->result.ok)
+                race->result = std::move(result);
+        }
+        race->done.notify_all();
+    });
+
+    if (!queued) {
+        std::lock_guard<std::mutex> lock(race->mutex);
+        race->pending--;
+    }
+    return queued;
+}
+
+void talkup_network::ServicePool::__warmup(const std::string &service, __Pool &pool,
+    __Replica &replica, const std::atomic<bool> &stop)
+{
+    std::string body = get_warmup_task(service).dump();
+    auto backoff = std::chrono::milliseconds(500);
+
+    while (!stop) {
+        std::vector<std::unique_ptr<cpr::Session>> sessions;
+        auto deadline = Clock::now() + std::chrono::milliseconds(30000);
+        bool ok = true;
+
+        // Every pooled connection is opened and goes through the model once.
+        for (size_t i = 0; i < SESSIONS_PER_SERVICE; i++)
+            sessions.push_back(__acquire(replica, deadline));
+        for (auto &session : sessions) {
+            if (!session) {
+                ok = false;
+                continue;
+            }
+            session->SetUrl(cpr::Url{replica.url + "task"});
+            session->SetHeader(cpr::Header{{"Content-Type", "application/json"}});
+            session->SetBody(cpr::Body{body});
+            session->SetTimeout(cpr::Timeout{std::chrono::milliseconds(30000)});
+            cpr::Response response = session->Post();
+            ok = ok && !response.error && response.status_code >= 200
+                && response.status_code < 300;
+        }
+        for (auto &session : sessions) {
+            if (session)
+                __release(replica, std::move(session));
+        }
+        if (ok) {
+            replica.warm = true;
+            // One warm replica is enough to take traffic, the breakers keep the others out.
+            pool.state = State::READY;
+            std::cout << "[SERVICES] Warmed up: " << service << " (" << replica.url << ")"
+                << std::endl;
+            return;
+        }
+        for (auto waited = std::chrono::milliseconds(0); waited < backoff && !stop;
+            waited += std::chrono::milliseconds(100))
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        backoff = std::min(backoff * 2, std::chrono::milliseconds(10000));
+    }
+}
+
+std::unique_ptr<cpr::Session> talkup_network::ServicePool::__acquire(__Replica &replica,
+    Clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(replica.mutex);
+
+    if (replica.idle.empty() && replica.created < SESSIONS_PER_SERVICE) {
+        replica.created++;
+        return std::make_unique<cpr::Session>();
+    }
+    if (!replica.available.wait_until(lock, deadline, [&replica]() { return !replica.idle.empty(); }))
+        return nullptr;
+    auto session = std::move(replica.idle.back());
+    replica.idle.pop_back();
+    return session;
+}
+
+void talkup_network::ServicePool::__release(__Replica &replica, std::unique_ptr<cpr::Session> session)
+{
+    {
+        std::lock_guard<std::mutex> lock(replica.mutex);
+        replica.idle.push_back(std::move(session));
+    }
+    replica.available.notify_one();
+}
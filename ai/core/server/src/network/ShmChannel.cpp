@@ -0,0 +1,157 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the ShmChannel class
+*/
+
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ShmChannel.hpp"
+
+talkup_network::ShmChannel::ShmChannel(const std::string &name) : __name(name)
+{
+}
+
+talkup_network::ShmChannel::~ShmChannel()
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+
+    __detach();
+}
+
+bool talkup_network::ShmChannel::is_available(void)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto now = Clock::now();
+
+    if (__mapping && __is_alive())
+        return true;
+    if (__last_attempt != Clock::time_point() && now - __last_attempt < RETRY_DELAY)
+        return false;
+    __last_attempt = now;
+    // A restarted service creates a new segment: the old mapping is dropped.
+    __detach();
+    return __attach() && __is_alive();
+}
+
+talkup_network::ShmChannel::Status talkup_network::ShmChannel::call(std::string_view meta,
+    std::string_view data, Clock::time_point deadline, std::string &reply)
+{
+    __Pending pending;
+    uint64_t id = ++__next_id;
+    bool pushed = false;
+
+    {
+        std::lock_guard<std::mutex> lock(__pending_mutex);
+        __pending[id] = &pending;
+    }
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        pushed = __requests && __is_alive() && __requests->push(id, meta, data);
+    }
+    std::unique_lock<std::mutex> lock(__pending_mutex);
+    if (!pushed) {
+        __pending.erase(id);
+        return Status::UNAVAILABLE;
+    }
+    bool done = pending.replied.wait_until(lock, deadline, [&pending]() { return pending.done; });
+    __pending.erase(id);
+    if (!done)
+        return Status::TIMEOUT;
+    reply = std::move(pending.reply);
+    return Status::OK;
+}
+
+bool talkup_network::ShmChannel::__attach(void)
+{
+    std::string path = "/" + __name;
+    int fd = shm_open(path.c_str(), O_RDWR, 0);
+    struct stat info;
+    uint32_t header[3];
+
+    if (fd < 0)
+        return false;
+    if (fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) < SEGMENT_HEADER_SIZE) {
+        close(fd);
+        return false;
+    }
+    __size = static_cast<size_t>(info.st_size);
+    __mapping = mmap(nullptr, __size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (__mapping == MAP_FAILED) {
+        __mapping = nullptr;
+        return false;
+    }
+    std::memcpy(header, __mapping, sizeof(header));
+    size_t capacity = header[CAPACITY_OFFSET / sizeof(uint32_t)];
+    if (header[0] != MAGIC || header[1] != VERSION || capacity == 0
+        || (capacity & (capacity - 1)) != 0
+        || __size < SEGMENT_HEADER_SIZE + 2 * ShmRing::get_size(capacity)) {
+        std::cerr << "[SHM] Invalid segment: " << __name << std::endl;
+        __detach();
+        return false;
+    }
+    auto *base = static_cast<char *>(__mapping) + SEGMENT_HEADER_SIZE;
+    __requests = std::make_unique<ShmRing>(base, capacity);
+    __replies = std::make_unique<ShmRing>(base + ShmRing::get_size(capacity), capacity);
+    __stopping = false;
+    __reader = std::thread(&ShmChannel::__read_replies, this);
+    std::cout << "[SHM] Attached to " << __name << std::endl;
+    return true;
+}
+
+void talkup_network::ShmChannel::__detach(void)
+{
+    __stopping = true;
+    if (__reader.joinable())
+        __reader.join();
+    __requests.reset();
+    __replies.reset();
+    if (__mapping)
+        munmap(__mapping, __size);
+    __mapping = nullptr;
+    __size = 0;
+}
+
+bool talkup_network::ShmChannel::__is_alive(void) const
+{
+    timespec now;
+
+    if (!__mapping)
+        return false;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t now_ms = static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+    auto *heartbeat = reinterpret_cast<int64_t *>(static_cast<char *>(__mapping) + HEARTBEAT_OFFSET);
+    return now_ms - __atomic_load_n(heartbeat, __ATOMIC_ACQUIRE) < HEARTBEAT_TIMEOUT_MS;
+}
+
+void talkup_network::ShmChannel::__read_replies(void)
+{
+    ShmRing::Record record;
+
+    while (!__stopping) {
+        if (!__replies->wait(std::chrono::milliseconds(100)))
+            continue;
+        while (__replies->peek(record)) {
+            {
+                std::lock_guard<std::mutex> lock(__pending_mutex);
+                auto it = __pending.find(record.id);
+
+                // Replies to calls that gave up are dropped.
+                if (it != __pending.end()) {
+                    it->second->reply.assign(record.meta);
+                    it->second->done = true;
+                    it->second->replied.notify_one();
+                }
+            }
+            __replies->pop();
+        }
+    }
+}
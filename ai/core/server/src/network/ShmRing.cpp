@@ -0,0 +1,119 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the ShmRing class
+*/
+
+#include <cstring>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "ShmRing.hpp"
+
+talkup_network::ShmRing::ShmRing(void *base, size_t capacity)
+    : __base(static_cast<char *>(base)), __data(static_cast<char *>(base) + HEADER_SIZE),
+    __capacity(capacity)
+{
+}
+
+size_t talkup_network::ShmRing::get_size(size_t capacity)
+{
+    return HEADER_SIZE + capacity;
+}
+
+bool talkup_network::ShmRing::push(uint64_t id, std::string_view meta, std::string_view data)
+{
+    uint64_t head = __atomic_load_n(__field64(HEAD_OFFSET), __ATOMIC_ACQUIRE);
+    uint64_t tail = __atomic_load_n(__field64(TAIL_OFFSET), __ATOMIC_RELAXED);
+    size_t length = RECORD_HEADER_SIZE + meta.size() + data.size();
+    size_t padded = (length + 7) & ~static_cast<size_t>(7);
+    size_t offset = tail & (__capacity - 1);
+    // Records are contiguous: one that would cross the end starts over at the beginning.
+    size_t skip = offset + padded > __capacity ? __capacity - offset : 0;
+    uint32_t sizes[2] = { static_cast<uint32_t>(length), static_cast<uint32_t>(meta.size()) };
+
+    if (padded > __capacity / 2 || __capacity - (tail - head) < skip + padded)
+        return false;
+    if (skip) {
+        std::memcpy(__data + offset, &WRAP_MARKER, sizeof(WRAP_MARKER));
+        tail += skip;
+        offset = 0;
+    }
+    std::memcpy(__data + offset, sizes, sizeof(sizes));
+    std::memcpy(__data + offset + 8, &id, sizeof(id));
+    std::memcpy(__data + offset + RECORD_HEADER_SIZE, meta.data(), meta.size());
+    std::memcpy(__data + offset + RECORD_HEADER_SIZE + meta.size(), data.data(), data.size());
+    __atomic_store_n(__field64(TAIL_OFFSET), tail + padded, __ATOMIC_RELEASE);
+    __atomic_add_fetch(__field32(SEQ_OFFSET), 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(__field32(WAITING_OFFSET), __ATOMIC_SEQ_CST))
+        syscall(SYS_futex, __field32(SEQ_OFFSET), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    return true;
+}
+
+bool talkup_network::ShmRing::peek(Record &record)
+{
+    uint64_t head = __atomic_load_n(__field64(HEAD_OFFSET), __ATOMIC_RELAXED);
+    uint64_t tail = __atomic_load_n(__field64(TAIL_OFFSET), __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        size_t offset = head & (__capacity - 1);
+        uint32_t sizes[2];
+
+        std::memcpy(sizes, __data + offset, sizeof(uint32_t));
+        if (sizes[0] == WRAP_MARKER) {
+            head += __capacity - offset;
+            __atomic_store_n(__field64(HEAD_OFFSET), head, __ATOMIC_RELEASE);
+            continue;
+        }
+        std::memcpy(sizes, __data + offset, sizeof(sizes));
+        std::memcpy(&record.id, __data + offset + 8, sizeof(record.id));
+        record.meta = std::string_view(__data + offset + RECORD_HEADER_SIZE, sizes[1]);
+        record.data = std::string_view(__data + offset + RECORD_HEADER_SIZE + sizes[1],
+            sizes[0] - RECORD_HEADER_SIZE - sizes[1]);
+        __peeked = (sizes[0] + 7) & ~static_cast<size_t>(7);
+        return true;
+    }
+    return false;
+}
+
+void talkup_network::ShmRing::pop(void)
+{
+    uint64_t head = __atomic_load_n(__field64(HEAD_OFFSET), __ATOMIC_RELAXED);
+
+    __atomic_store_n(__field64(HEAD_OFFSET), head + __peeked, __ATOMIC_RELEASE);
+    __peeked = 0;
+}
+
+bool talkup_network::ShmRing::wait(std::chrono::milliseconds timeout)
+{
+    auto has_record = [this]() {
+        return __atomic_load_n(__field64(HEAD_OFFSET), __ATOMIC_RELAXED)
+            != __atomic_load_n(__field64(TAIL_OFFSET), __ATOMIC_ACQUIRE);
+    };
+    timespec delay = { static_cast<time_t>(timeout.count() / 1000),
+        static_cast<long>(timeout.count() % 1000) * 1000000 };
+
+    if (has_record())
+        return true;
+    // The producer bumps the futex word after publishing its tail: if it did so
+    // since seq was read, the wait returns right away.
+    __atomic_store_n(__field32(WAITING_OFFSET), 1, __ATOMIC_SEQ_CST);
+    uint32_t seq = __atomic_load_n(__field32(SEQ_OFFSET), __ATOMIC_SEQ_CST);
+    if (!has_record())
+        syscall(SYS_futex, __field32(SEQ_OFFSET), FUTEX_WAIT, seq, &delay, nullptr, 0);
+    __atomic_store_n(__field32(WAITING_OFFSET), 0, __ATOMIC_SEQ_CST);
+    return has_record();
+}
+
+uint64_t *talkup_network::ShmRing::__field64(size_t offset) const
+{
+    return reinterpret_cast<uint64_t *>(__base + offset);
+}
+
+uint32_t *talkup_network::ShmRing::__field32(size_t offset) const
+{
+    return reinterpret_cast<uint32_t *>(__base + offset);
+}
@@ -0,0 +1,252 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the StreamRegistry class
+*/
+
+#include <algorithm>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+#include "ServerMetrics.hpp"
+#include "StreamRegistry.hpp"
+
+talkup_network::StreamRegistry::StreamRegistry(size_t window_size,
+    std::chrono::seconds grace_period) : __window_size(window_size),
+    __grace_period(grace_period)
+{
+}
+
+void talkup_network::StreamRegistry::set_budget(MemoryBudget *budget)
+{
+    __budget = budget;
+}
+
+talkup_network::StreamRegistry::ChunkStatus talkup_network::StreamRegistry::submit_chunk(
+    const std::string &stream_id, int64_t seq, crow::websocket::connection &conn,
+    std::string &resume_token)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __streams.find(stream_id);
+
+    if (it == __streams.end()) {
+        __Stream stream;
+
+        stream.resume_token = __generate_token();
+        stream.conn = &conn;
+        stream.last_received_seq = seq;
+        resume_token = stream.resume_token;
+        __streams.emplace(stream_id, std::move(stream));
+        __streams_by_conn[&conn].push_back(stream_id);
+        ServerMetrics::active_streams.fetch_add(1, std::memory_order_relaxed);
+        return ChunkStatus::ACCEPTED;
+    }
+    if (it->second.conn != &conn)
+        return ChunkStatus::OWNED_ELSEWHERE;
+    if (seq <= it->second.last_received_seq)
+        return ChunkStatus::DUPLICATE;
+    it->second.last_received_seq = seq;
+    return ChunkStatus::ACCEPTED;
+}
+
+void talkup_network::StreamRegistry::deliver(const std::string &stream_id, int64_t seq,
+    const nlohmann::json &message, const Sender &sender)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __streams.find(stream_id);
+
+    if (it == __streams.end())
+        return;
+    auto &stream = it->second;
+    stream.window.emplace_back(seq, message);
+    if (__budget) {
+        size_t bytes = MemoryBudget::estimate(stream.window.back().second);
+
+        // Already answered: accounted even over the budget, the next chunk is refused instead.
+        __budget->charge(stream_id, MemoryBudget::Pool::STREAM_WINDOW, bytes);
+        stream.window_bytes += bytes;
+    }
+    if (stream.window.size() > __window_size) {
+        if (__budget) {
+            size_t bytes = MemoryBudget::estimate(stream.window.front().second);
+
+            __budget->release(stream_id, MemoryBudget::Pool::STREAM_WINDOW, bytes);
+            stream.window_bytes -= std::min(stream.window_bytes, bytes);
+        }
+        stream.window.pop_front();
+    }
+    // Sent under the lock so a closing connection can't be detached in between.
+    if (stream.conn)
+        sender(*stream.conn, message);
+}
+
+bool talkup_network::StreamRegistry::send(const std::string &stream_id,
+    const nlohmann::json &message, const Sender &sender)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __streams.find(stream_id);
+
+    if (it == __streams.end() || !it->second.conn)
+        return false;
+    sender(*it->second.conn, message);
+    return true;
+}
+
+bool talkup_network::StreamRegistry::resume(const std::string &stream_id,
+    const std::string &resume_token, int64_t last_acked_seq,
+    crow::websocket::connection &conn, int64_t &last_received_seq,
+    std::vector<nlohmann::json> &replay)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __streams.find(stream_id);
+
+    if (it == __streams.end() || it->second.resume_token != resume_token)
+        return false;
+    // Its timer may not have fired yet.
+    if (__is_expired(it->second, std::chrono::steady_clock::now())) {
+        __erase(it);
+        return false;
+    }
+
+    auto &stream = it->second;
+    if (stream.conn && stream.conn != &conn) {
+        auto &previous = __streams_by_conn[stream.conn];
+        previous.erase(std::remove(previous.begin(), previous.end(), stream_id), previous.end());
+    }
+    if (stream.conn != &conn)
+        __streams_by_conn[&conn].push_back(stream_id);
+    stream.conn = &conn;
+    last_received_seq = stream.last_received_seq;
+    for (const auto &[seq, message] : stream.window) {
+        if (seq > last_acked_seq)
+            replay.push_back(message);
+    }
+    return true;
+}
+
+std::vector<std::string> talkup_network::StreamRegistry::detach(crow::websocket::connection &conn)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto now = std::chrono::steady_clock::now();
+    auto it = __streams_by_conn.find(&conn);
+    std::vector<std::string> detached;
+
+    if (it == __streams_by_conn.end())
+        return detached;
+    for (const auto &stream_id : it->second) {
+        auto stream = __streams.find(stream_id);
+        if (stream != __streams.end() && stream->second.conn == &conn) {
+            stream->second.conn = nullptr;
+            stream->second.detached_at = now;
+            detached.push_back(stream_id);
+        }
+    }
+    __streams_by_conn.erase(it);
+    return detached;
+}
+
+bool talkup_network::StreamRegistry::expire(const std::string &stream_id)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __streams.find(stream_id);
+
+    if (it == __streams.end() || !__is_expired(it->second, std::chrono::steady_clock::now()))
+        return false;
+    __erase(it);
+    return true;
+}
+
+bool talkup_network::StreamRegistry::drop(const std::string &stream_id)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __streams.find(stream_id);
+
+    if (it == __streams.end() || it->second.conn)
+        return false;
+    __erase(it);
+    return true;
+}
+
+size_t talkup_network::StreamRegistry::trim(const std::string &stream_id)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __streams.find(stream_id);
+
+    if (it == __streams.end())
+        return 0;
+    auto &stream = it->second;
+    size_t dropped = stream.window.size();
+
+    if (__budget)
+        __budget->release(stream_id, MemoryBudget::Pool::STREAM_WINDOW, stream.window_bytes);
+    stream.window.clear();
+    stream.window_bytes = 0;
+    return dropped;
+}
+
+std::vector<std::string> talkup_network::StreamRegistry::get_streams(
+    crow::websocket::connection &conn)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __streams_by_conn.find(&conn);
+
+    if (it == __streams_by_conn.end())
+        return {};
+    return it->second;
+}
+
+talkup_network::StreamRegistry::Ownership talkup_network::StreamRegistry::get_ownership(
+    const std::string &stream_id, crow::websocket::connection &conn)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __streams.find(stream_id);
+
+    if (it == __streams.end())
+        return Ownership::NONE;
+    return it->second.conn == &conn ? Ownership::OWNED : Ownership::ELSEWHERE;
+}
+
+void talkup_network::StreamRegistry::reap_expired(void)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto it = __streams.begin(); it != __streams.end();) {
+        if (__is_expired(it->second, now))
+            __erase(it++);
+        else
+            ++it;
+    }
+}
+
+std::chrono::seconds talkup_network::StreamRegistry::get_grace_period(void) const
+{
+    return __grace_period;
+}
+
+bool talkup_network::StreamRegistry::__is_expired(const __Stream &stream,
+    std::chrono::steady_clock::time_point now) const
+{
+    return !stream.conn && now - stream.detached_at > __grace_period;
+}
+
+void talkup_network::StreamRegistry::__erase(
+    std::unordered_map<std::string, __Stream>::iterator it)
+{
+    if (__budget)
+        __budget->release(it->first, MemoryBudget::Pool::STREAM_WINDOW, it->second.window_bytes);
+    __streams.erase(it);
+    ServerMetrics::active_streams.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::string talkup_network::StreamRegistry::__generate_token(void)
+{
+    static thread_local std::mt19937_64 engine(std::random_device{}());
+    std::ostringstream oss;
+
+    oss << std::hex << std::setfill('0') << std::setw(16) << engine()
+        << std::setw(16) << engine();
+    return oss.str();
+}
@@ -0,0 +1,122 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the TlsContext class
+*/
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+#include "ExceptionManager.hpp"
+#include "TlsContext.hpp"
+
+#ifdef TALKUP_ENABLE_TLS
+#include <openssl/ssl.h>
+
+namespace {
+    // Sessions are only resumed by the server which issued them.
+    const unsigned char SESSION_ID_CONTEXT[] = "talkup";
+    // Name, HMAC key and AES key of the ticket key (OpenSSL's layout).
+    constexpr size_t TICKET_KEYS_SIZE = 80;
+    // Two tickets, so a client can open two connections without a full handshake.
+    constexpr size_t TLS13_TICKETS = 2;
+}
+#endif
+
+talkup_network::TlsContext::TlsContext(const Options &options) : __options(options)
+{
+#ifdef TALKUP_ENABLE_TLS
+    if (!__options.ticket_key_file.empty()) {
+        std::ifstream file(__options.ticket_key_file, std::ios::binary);
+
+        __ticket_keys.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (__ticket_keys.size() != TICKET_KEYS_SIZE)
+            throw ExceptionManager::ServerTlsException();
+    }
+    __context = SSL_CTX_new(TLS_server_method());
+    if (!__context)
+        throw ExceptionManager::ServerTlsException();
+    try {
+        configure(__context);
+    } catch (...) {
+        SSL_CTX_free(__context);
+        throw;
+    }
+#else
+    throw ExceptionManager::ServerTlsException();
+#endif
+}
+
+talkup_network::TlsContext::~TlsContext()
+{
+#ifdef TALKUP_ENABLE_TLS
+    SSL_CTX_free(__context);
+#endif
+}
+
+bool talkup_network::TlsContext::is_supported(void)
+{
+#ifdef TALKUP_ENABLE_TLS
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool talkup_network::TlsContext::get_env_options(Options &options)
+{
+    const char *cert = std::getenv("TLS_CERT_FILE");
+    const char *key = std::getenv("TLS_KEY_FILE");
+    const char *ticket_key = std::getenv("TLS_TICKET_KEY_FILE");
+    const char *ktls = std::getenv("TLS_KTLS");
+
+    if (cert) options.cert_file = cert;
+    if (key) options.key_file = key;
+    if (ticket_key) options.ticket_key_file = ticket_key;
+    if (ktls) options.ktls = std::string(ktls) != "0";
+    return !options.cert_file.empty();
+}
+
+void talkup_network::TlsContext::configure(ssl_ctx_st *context) const
+{
+#ifdef TALKUP_ENABLE_TLS
+    const std::string &key = __options.key_file.empty() ? __options.cert_file : __options.key_file;
+
+    SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+    SSL_CTX_set_options(context, SSL_OP_NO_RENEGOTIATION | SSL_OP_CIPHER_SERVER_PREFERENCE);
+    if (SSL_CTX_use_certificate_chain_file(context, __options.cert_file.c_str()) != 1
+        || SSL_CTX_use_PrivateKey_file(context, key.c_str(), SSL_FILETYPE_PEM) != 1
+        || SSL_CTX_check_private_key(context) != 1)
+        throw ExceptionManager::ServerTlsException();
+    // Resumption: a server-side cache for the TLS 1.2 session IDs, and tickets
+    // kept by the clients, so a reconnect skips the key exchange.
+    SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_set_session_id_context(context, SESSION_ID_CONTEXT, sizeof(SESSION_ID_CONTEXT) - 1);
+    SSL_CTX_sess_set_cache_size(context, static_cast<long>(__options.session_cache_size));
+    SSL_CTX_set_timeout(context, static_cast<long>(__options.session_timeout.count()));
+    SSL_CTX_set_num_tickets(context, TLS13_TICKETS);
+    if (!__ticket_keys.empty() && SSL_CTX_set_tlsext_ticket_keys(context,
+        const_cast<char *>(__ticket_keys.data()), static_cast<long>(__ticket_keys.size())) != 1)
+        throw ExceptionManager::ServerTlsException();
+#ifdef SSL_OP_ENABLE_KTLS
+    // Only taken up by the connections whose socket OpenSSL writes to directly.
+    if (__options.ktls)
+        SSL_CTX_set_options(context, SSL_OP_ENABLE_KTLS);
+#endif
+#else
+    (void)context;
+    throw ExceptionManager::ServerTlsException();
+#endif
+}
+
+ssl_ctx_st *talkup_network::TlsContext::get_native(void) const
+{
+    return __context;
+}
+
+const talkup_network::TlsContext::Options &talkup_network::TlsContext::get_options(void) const
+{
+    return __options;
+}
@@ -0,0 +1,216 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the TtsStreamer class
+*/
+
+#include <algorithm>
+#include <nlohmann/json.hpp>
+
+#include "Messages.hpp"
+#include "Tracer.hpp"
+#include "TtsStreamer.hpp"
+
+talkup_network::TtsStreamer::TtsStreamer(void)
+    : TtsStreamer(Options(), [](const std::string &text, Clock::time_point deadline,
+        const ServicePool::OnData &on_audio) {
+        messages::TaskRequest task;
+
+        task.services = { "tts" };
+        task.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        task.data = { {"format", "text"}, {"payload", text},
+            {"output_format", "audio/pcm16"}, {"sample_rate", 16000} };
+        return ServicePool::post_stream("tts", "stream", schema::serialize(task).dump(),
+            deadline, on_audio);
+    })
+{
+}
+
+talkup_network::TtsStreamer::TtsStreamer(const Options &options, Source source)
+    : __options(options), __source(std::move(source)),
+    __synthesizers("TTS", std::max<size_t>(options.max_utterances, 1), 1),
+    __pacers("TTS", std::max<size_t>(options.max_utterances, 1), 1)
+{
+    __options.frame_bytes = std::max<size_t>(__options.frame_bytes, 2);
+    __options.max_utterances = std::max<size_t>(__options.max_utterances, 1);
+}
+
+talkup_network::TtsStreamer::~TtsStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+
+        for (auto &[stream_id, utterance] : __utterances)
+            __stop(*utterance);
+        __utterances.clear();
+    }
+    // A synthesis stops on its next part of audio, or at its deadline.
+    __synthesizers.stop();
+    __pacers.stop();
+}
+
+talkup_network::TtsStreamer::SpeakStatus talkup_network::TtsStreamer::speak(
+    const std::string &stream_id, const void *owner, const std::string &text, Sink sink,
+    std::string &utterance_id)
+{
+    auto utterance = std::make_shared<__Utterance>();
+
+    utterance->stream_id = stream_id;
+    utterance->owner = owner;
+    utterance->trace_id = Tracer::current();
+    utterance->sink = std::move(sink);
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        auto &current = __utterances[stream_id];
+
+        if (current && current->owner != owner)
+            return SpeakStatus::OWNED_ELSEWHERE;
+        auto owned = __running_by_owner.find(owner);
+
+        // There is a thread of each pool for every utterance admitted here.
+        if (__running >= __options.max_utterances
+            || (owned != __running_by_owner.end() && owned->second >= __options.max_per_owner)) {
+            if (!current)
+                __utterances.erase(stream_id);
+            return SpeakStatus::BUSY;
+        }
+        utterance->id = stream_id + "-" + std::to_string(++__next_id);
+        // A stream says one thing at a time: a new utterance interrupts the previous one.
+        if (current)
+            __stop(*current);
+        current = utterance;
+        __running++;
+        __running_by_owner[owner]++;
+    }
+    utterance_id = utterance->id;
+    __synthesizers.submit([this, utterance, text, deadline = Clock::now() + __options.timeout]() {
+        __synthesize(utterance, text, deadline);
+    });
+    __pacers.submit([this, utterance]() { __pace(utterance); });
+    return SpeakStatus::STARTED;
+}
+
+bool talkup_network::TtsStreamer::cancel(const std::string &stream_id, const void *owner)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __utterances.find(stream_id);
+
+    if (it == __utterances.end() || it->second->owner != owner)
+        return false;
+    __stop(*it->second);
+    __utterances.erase(it);
+    return true;
+}
+
+void talkup_network::TtsStreamer::cancel_owner(const void *owner)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+
+    for (auto it = __utterances.begin(); it != __utterances.end();) {
+        if (it->second->owner != owner) {
+            ++it;
+            continue;
+        }
+        __stop(*it->second);
+        it = __utterances.erase(it);
+    }
+}
+
+void talkup_network::TtsStreamer::__synthesize(std::shared_ptr<__Utterance> utterance,
+    std::string text, Clock::time_point deadline)
+{
+    Tracer::TraceScope trace(utterance->trace_id);
+    ServicePool::Result result = __source(text, deadline, [&utterance](std::string_view audio) {
+        std::lock_guard<std::mutex> lock(utterance->mutex);
+
+        if (utterance->cancelled)
+            return false;
+        utterance->audio.append(audio);
+        utterance->changed.notify_all();
+        return true;
+    });
+    {
+        std::lock_guard<std::mutex> lock(utterance->mutex);
+
+        utterance->synthesized = true;
+        if (!result.ok)
+            utterance->error = result.error.empty() ? "speech synthesis failed" : result.error;
+        utterance->changed.notify_all();
+    }
+    __finish(*utterance);
+}
+
+void talkup_network::TtsStreamer::__pace(std::shared_ptr<__Utterance> utterance)
+{
+    Tracer::TraceScope trace(utterance->trace_id);
+    std::unique_lock<std::mutex> lock(utterance->mutex);
+    int64_t requested_us = Tracer::now_us();
+    Clock::time_point start;
+    size_t read = 0;
+    auto cancelled = [&utterance]() { return utterance->cancelled.load(); };
+
+    for (int64_t seq = 0; ; seq++) {
+        utterance->changed.wait(lock, [&]() {
+            return utterance->cancelled || utterance->synthesized
+                || utterance->audio.size() - read >= __options.frame_bytes;
+        });
+        if (utterance->cancelled)
+            break;
+        Frame frame;
+        size_t size = std::min(__options.frame_bytes, utterance->audio.size() - read);
+
+        frame.utterance_id = utterance->id;
+        frame.seq = seq;
+        frame.audio = utterance->audio.substr(read, size);
+        read += size;
+        frame.last = utterance->synthesized && read == utterance->audio.size();
+        if (frame.last)
+            frame.error = utterance->error;
+        // Sent audio is dropped once it is the larger part of the buffer.
+        if (read >= 65536 && read * 2 >= utterance->audio.size()) {
+            utterance->audio.erase(0, read);
+            read = 0;
+        }
+        if (seq == 0) {
+            start = Clock::now();
+            Tracer::record("tts_first_audio", requested_us, Tracer::now_us());
+        }
+        if (utterance->changed.wait_until(lock, start + seq * __options.frame_duration
+            - __options.lead, cancelled))
+            break;
+        utterance->sink(frame);
+        if (frame.last)
+            break;
+    }
+    lock.unlock();
+    {
+        std::lock_guard<std::mutex> streams_lock(__mutex);
+        auto it = __utterances.find(utterance->stream_id);
+
+        if (it != __utterances.end() && it->second == utterance)
+            __utterances.erase(it);
+    }
+    __finish(*utterance);
+}
+
+void talkup_network::TtsStreamer::__finish(__Utterance &utterance)
+{
+    if (--utterance.running > 0)
+        return;
+    std::lock_guard<std::mutex> lock(__mutex);
+    auto it = __running_by_owner.find(utterance.owner);
+
+    __running--;
+    if (it != __running_by_owner.end() && --it->second == 0)
+        __running_by_owner.erase(it);
+}
+
+void talkup_network::TtsStreamer::__stop(__Utterance &utterance)
+{
+    std::lock_guard<std::mutex> lock(utterance.mutex);
+
+    utterance.cancelled = true;
+    utterance.changed.notify_all();
+}
@@ -0,0 +1,1439 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the UringTransport class
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "WsFrame.hpp"
+#include "UringTransport.hpp"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+// Multishot receive, buffer rings and zero-copy send all came with Linux 6.0.
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_RECVSEND_FIXED_BUF)
+#define TALKUP_HAS_IO_URING 1
+#endif
+
+#ifdef TALKUP_HAS_IO_URING
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef TALKUP_ENABLE_TLS
+#include <openssl/ssl.h>
+#endif
+
+namespace {
+    constexpr uint16_t BUFFER_GROUP = 0;
+
+    enum class Op : uint64_t {
+        ACCEPT = 1,
+        RECV,
+        SEND,
+        SEND_ZC,
+        WAKE,
+        HANDSHAKE,
+    };
+
+    uint64_t make_user_data(Op op, uint64_t id)
+    {
+        return (static_cast<uint64_t>(op) << 56) | id;
+    }
+
+    Op get_op(uint64_t user_data)
+    {
+        return static_cast<Op>(user_data >> 56);
+    }
+
+    uint64_t get_id(uint64_t user_data)
+    {
+        return user_data & ((1ULL << 56) - 1);
+    }
+
+    /**
+     * @brief Submission and completion queues of an io_uring instance.
+     */
+    class Ring {
+        public:
+            ~Ring()
+            {
+                close();
+            }
+
+            void close(void)
+            {
+                if (__sqes)
+                    munmap(__sqes, __sqes_size);
+                if (__cq_ptr && __cq_ptr != __sq_ptr)
+                    munmap(__cq_ptr, __cq_size);
+                if (__sq_ptr)
+                    munmap(__sq_ptr, __sq_size);
+                if (fd >= 0)
+                    ::close(fd);
+                __sqes = nullptr;
+                __cq_ptr = nullptr;
+                __sq_ptr = nullptr;
+                fd = -1;
+            }
+
+            bool setup(unsigned entries)
+            {
+                io_uring_params params;
+
+                std::memset(&params, 0, sizeof(params));
+                params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL
+                    | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+                params.cq_entries = entries * 4;
+                fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+                if (fd < 0) {
+                    // The task-run flags need Linux 6.1.
+                    std::memset(&params, 0, sizeof(params));
+                    params.flags = IORING_SETUP_CQSIZE;
+                    params.cq_entries = entries * 4;
+                    fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+                }
+                if (fd < 0)
+                    return false;
+                __sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                __cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                if (params.features & IORING_FEAT_SINGLE_MMAP)
+                    __sq_size = __cq_size = std::max(__sq_size, __cq_size);
+                __sq_ptr = mmap(nullptr, __sq_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+                if (__sq_ptr == MAP_FAILED) {
+                    __sq_ptr = nullptr;
+                    return false;
+                }
+                __cq_ptr = __sq_ptr;
+                if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+                    __cq_ptr = mmap(nullptr, __cq_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                    if (__cq_ptr == MAP_FAILED) {
+                        __cq_ptr = nullptr;
+                        return false;
+                    }
+                }
+                __sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+                __sqes = static_cast<io_uring_sqe *>(mmap(nullptr, __sqes_size,
+                    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+                if (__sqes == MAP_FAILED) {
+                    __sqes = nullptr;
+                    return false;
+                }
+                auto *sq = static_cast<char *>(__sq_ptr);
+                auto *cq = static_cast<char *>(__cq_ptr);
+                __sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+                __sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+                __sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+                __sq_entries = params.sq_entries;
+                auto *array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+                for (unsigned i = 0; i < __sq_entries; i++)
+                    array[i] = i;
+                __cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+                __cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+                __cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+                __cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+                __local_tail = *__sq_tail;
+                return true;
+            }
+
+            io_uring_sqe *get_sqe(void)
+            {
+                if (__local_tail - __atomic_load_n(__sq_head, __ATOMIC_ACQUIRE) >= __sq_entries) {
+                    submit(0);
+                    if (__local_tail - __atomic_load_n(__sq_head, __ATOMIC_ACQUIRE) >= __sq_entries)
+                        return nullptr;
+                }
+                io_uring_sqe *sqe = &__sqes[__local_tail & __sq_mask];
+                __local_tail++;
+                std::memset(sqe, 0, sizeof(*sqe));
+                return sqe;
+            }
+
+            int submit(unsigned wait_nr)
+            {
+                unsigned to_submit = __local_tail - *__sq_tail;
+
+                __atomic_store_n(__sq_tail, __local_tail, __ATOMIC_RELEASE);
+                // Completions are only posted while entering with GETEVENTS
+                // when the ring defers its task work.
+                return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, wait_nr,
+                    IORING_ENTER_GETEVENTS, nullptr, 0));
+            }
+
+            template <typename Handler>
+            void for_each_cqe(Handler &&handler)
+            {
+                unsigned head = *__cq_head;
+                unsigned tail = __atomic_load_n(__cq_tail, __ATOMIC_ACQUIRE);
+
+                for (; head != tail; head++) {
+                    io_uring_cqe cqe = __cqes[head & __cq_mask];
+                    __atomic_store_n(__cq_head, head + 1, __ATOMIC_RELEASE);
+                    handler(cqe);
+                }
+            }
+
+            bool register_buffer_ring(void *ring, unsigned entries, uint16_t group)
+            {
+                io_uring_buf_reg reg;
+
+                std::memset(&reg, 0, sizeof(reg));
+                reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+                reg.ring_entries = entries;
+                reg.bgid = group;
+                return syscall(__NR_io_uring_register, fd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0;
+            }
+
+            int fd = -1;
+
+        private:
+            void *__sq_ptr = nullptr;
+            void *__cq_ptr = nullptr;
+            size_t __sq_size = 0;
+            size_t __cq_size = 0;
+            size_t __sqes_size = 0;
+            io_uring_sqe *__sqes = nullptr;
+            io_uring_cqe *__cqes = nullptr;
+            unsigned *__sq_head = nullptr;
+            unsigned *__sq_tail = nullptr;
+            unsigned *__cq_head = nullptr;
+            unsigned *__cq_tail = nullptr;
+            unsigned __sq_mask = 0;
+            unsigned __cq_mask = 0;
+            unsigned __sq_entries = 0;
+            unsigned __local_tail = 0;
+    };
+
+    int open_listener(int port)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int one = 1;
+        sockaddr_in addr;
+
+        if (fd < 0)
+            return -1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        // Every loop listens on the same port and the kernel spreads the connections.
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0
+            || listen(fd, SOMAXCONN) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    int get_bound_port(int fd)
+    {
+        sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+
+        if (getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) < 0)
+            return -1;
+        return ntohs(addr.sin_port);
+    }
+
+    bool equals_ignore_case(const std::string &a, const std::string &b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+            [](char x, char y) { return std::tolower(static_cast<unsigned char>(x))
+                == std::tolower(static_cast<unsigned char>(y)); });
+    }
+
+    bool contains_token(const std::string &value, const std::string &token)
+    {
+        std::string lower = value;
+
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+            [](unsigned char c) { return std::tolower(c); });
+        return lower.find(token) != std::string::npos;
+    }
+
+    std::string trim(const std::string &value)
+    {
+        size_t start = value.find_first_not_of(" \t");
+        size_t end = value.find_last_not_of(" \t\r");
+
+        return start == std::string::npos ? "" : value.substr(start, end - start + 1);
+    }
+
+    const char *get_reason_phrase(int code)
+    {
+        switch (code) {
+            case 101: return "Switching Protocols";
+            case 200: return "OK";
+            case 400: return "Bad Request";
+            case 401: return "Unauthorized";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 413: return "Payload Too Large";
+            case 431: return "Request Header Fields Too Large";
+            case 500: return "Internal Server Error";
+            case 503: return "Service Unavailable";
+            default: return "";
+        }
+    }
+
+    /**
+     * @brief The TLS state of a connection. OpenSSL does the handshake on the
+     * socket itself, so it can hand the record layer over to the kernel (kTLS).
+     * The directions the kernel doesn't take go through memory buffers fed by the ring.
+     */
+    class TlsSession {
+        public:
+            enum class Step {
+                DONE,
+                WANT_READ,
+                WANT_WRITE,
+                FAILED,
+            };
+
+#ifdef TALKUP_ENABLE_TLS
+            TlsSession(ssl_ctx_st *context, int fd) : __ssl(SSL_new(context))
+            {
+                if (__ssl && SSL_set_fd(__ssl, fd) == 1)
+                    SSL_set_accept_state(__ssl);
+            }
+
+            ~TlsSession()
+            {
+                SSL_free(__ssl);
+            }
+
+            Step handshake(void)
+            {
+                if (!__ssl)
+                    return Step::FAILED;
+                int ret = SSL_do_handshake(__ssl);
+                if (ret == 1)
+                    return __offload() ? Step::DONE : Step::FAILED;
+                switch (SSL_get_error(__ssl, ret)) {
+                    case SSL_ERROR_WANT_READ:
+                        return Step::WANT_READ;
+                    case SSL_ERROR_WANT_WRITE:
+                        return Step::WANT_WRITE;
+                    default:
+                        return Step::FAILED;
+                }
+            }
+
+            // Turns received records into plaintext. What TLS answers on its own
+            // (e.g. a key update) goes to records. False once the peer closed.
+            bool decrypt(const char *data, size_t size, std::string &plain, std::string &records)
+            {
+                char buffer[16 * 1024];
+                int ret;
+
+                if (BIO_write(SSL_get_rbio(__ssl), data, static_cast<int>(size)) != static_cast<int>(size))
+                    return false;
+                while ((ret = SSL_read(__ssl, buffer, sizeof(buffer))) > 0)
+                    plain.append(buffer, static_cast<size_t>(ret));
+                __drain(records);
+                return SSL_get_error(__ssl, ret) == SSL_ERROR_WANT_READ;
+            }
+
+            std::string encrypt(const std::string &plain)
+            {
+                std::string records;
+
+                if (!plain.empty() && SSL_write(__ssl, plain.data(), static_cast<int>(plain.size())) <= 0)
+                    return records;
+                __drain(records);
+                return records;
+            }
+
+            // The close_notify alert: a session closed without it can't be resumed.
+            std::string close(void)
+            {
+                std::string records;
+
+                closed = true;
+                SSL_shutdown(__ssl);
+                __drain(records);
+                return records;
+            }
+#else
+            TlsSession(ssl_ctx_st *, int) {}
+
+            Step handshake(void)
+            {
+                return Step::FAILED;
+            }
+
+            bool decrypt(const char *, size_t, std::string &, std::string &)
+            {
+                return false;
+            }
+
+            std::string encrypt(const std::string &)
+            {
+                return "";
+            }
+
+            std::string close(void)
+            {
+                closed = true;
+                return "";
+            }
+#endif
+
+            // Whether the kernel encrypts what is sent, or decrypts what is received.
+            bool kernel_send = false;
+            bool kernel_recv = false;
+            bool closed = false;
+
+        private:
+#ifdef TALKUP_ENABLE_TLS
+            bool __offload(void)
+            {
+#ifdef BIO_get_ktls_send
+                kernel_send = BIO_get_ktls_send(SSL_get_wbio(__ssl));
+                kernel_recv = BIO_get_ktls_recv(SSL_get_rbio(__ssl));
+#endif
+                // From now on the ring reads and writes the socket.
+                if (!kernel_recv) {
+                    BIO *rbio = BIO_new(BIO_s_mem());
+
+                    if (!rbio)
+                        return false;
+                    BIO_set_mem_eof_return(rbio, -1);
+                    SSL_set0_rbio(__ssl, rbio);
+                }
+                if (!kernel_send) {
+                    BIO *wbio = BIO_new(BIO_s_mem());
+
+                    if (!wbio)
+                        return false;
+                    SSL_set0_wbio(__ssl, wbio);
+                }
+                return true;
+            }
+
+            void __drain(std::string &records)
+            {
+                BIO *wbio = SSL_get_wbio(__ssl);
+                char buffer[16 * 1024];
+                int ret;
+
+                if (kernel_send)
+                    return;
+                while ((ret = BIO_read(wbio, buffer, sizeof(buffer))) > 0)
+                    records.append(buffer, static_cast<size_t>(ret));
+            }
+
+            SSL *__ssl;
+#endif
+    };
+
+    // eventfd of the running transport, written from the signal handler.
+    std::atomic<int> signal_fd{-1};
+
+    void on_stop_signal(int)
+    {
+        uint64_t one = 1;
+        int fd = signal_fd.load();
+
+        // Only async-signal-safe calls here: the thread blocked in run does the stop.
+        if (fd >= 0 && ::write(fd, &one, sizeof(one)) < 0)
+            return;
+    }
+}
+
+class talkup_network::UringTransport::__Loop {
+    public:
+        using Frame = std::shared_ptr<const std::string>;
+
+        class Connection : public crow::websocket::connection {
+            public:
+                Connection(__Loop &loop, uint64_t id, int fd, std::string ip)
+                    : id(id), fd(fd), __loop(loop), __ip(std::move(ip)) {}
+
+                void send_binary(const std::string &msg) override
+                {
+                    __loop.post(id, WsFrame::build(WsFrame::Opcode::BINARY, msg), false);
+                }
+
+                void send_text(const std::string &msg) override
+                {
+                    __loop.post(id, WsFrame::build(WsFrame::Opcode::TEXT, msg), false);
+                }
+
+                void send_ping(const std::string &msg) override
+                {
+                    __loop.post(id, WsFrame::build(WsFrame::Opcode::PING, msg), false);
+                }
+
+                void send_pong(const std::string &msg) override
+                {
+                    __loop.post(id, WsFrame::build(WsFrame::Opcode::PONG, msg), false);
+                }
+
+                void close(const std::string &msg) override
+                {
+                    __loop.post(id, WsFrame::build_close(WsFrame::CLOSE_NORMAL, msg), true);
+                }
+
+                std::string get_remote_ip() override
+                {
+                    return __ip;
+                }
+
+                const uint64_t id;
+                const int fd;
+                bool upgraded = false;
+                bool recv_armed = false;
+                bool sending = false;
+                bool close_after_flush = false;
+                bool shut = false;
+                bool polling = false;
+                bool zero_copy = true;
+                std::unique_ptr<TlsSession> tls;
+                std::string close_reason;
+                std::string input;
+                std::deque<Frame> outbox;
+                size_t sent = 0;
+                std::string message;
+                bool message_binary = false;
+                bool in_message = false;
+                // Messages waiting for a handler, one handled at a time so they keep their order.
+                std::deque<std::pair<std::string, bool>> pending;
+                bool handling = false;
+
+            private:
+                __Loop &__loop;
+                std::string __ip;
+        };
+
+        __Loop(Router &router, int listener, std::atomic<bool> &stopping, TlsContext *tls, WorkerPool &handlers)
+            : __router(router), __listener(listener), __stopping(stopping), __tls(tls), __handlers(handlers) {}
+
+        ~__Loop()
+        {
+            // Closing the ring cancels what is still pending before the buffers go away.
+            __ring.close();
+            if (__listener >= 0)
+                ::close(__listener);
+            if (__wake_fd >= 0)
+                ::close(__wake_fd);
+            if (__buf_ring)
+                munmap(__buf_ring, RECV_BUFFERS * sizeof(io_uring_buf));
+            if (__buffers)
+                munmap(__buffers, RECV_BUFFERS * RECV_BUFFER_SIZE);
+        }
+
+        bool setup(void)
+        {
+            // The ring is created by the thread which drives it (single issuer).
+            __owner = std::this_thread::get_id();
+            if (!__ring.setup(RING_ENTRIES))
+                return false;
+            __wake_fd = eventfd(0, EFD_CLOEXEC);
+            void *buffers = mmap(nullptr, RECV_BUFFERS * RECV_BUFFER_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            void *buf_ring = mmap(nullptr, RECV_BUFFERS * sizeof(io_uring_buf),
+                PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (__wake_fd < 0 || buffers == MAP_FAILED || buf_ring == MAP_FAILED)
+                return false;
+            __buffers = static_cast<char *>(buffers);
+            // Not io_uring_buf_ring: in C++ its flexible array starts 8 bytes too far.
+            // The tail shares its place with the reserved field of the first buffer.
+            __buf_ring = static_cast<io_uring_buf *>(buf_ring);
+            // The receive buffers are registered once and picked by the kernel,
+            // so an idle connection holds no buffer.
+            if (!__ring.register_buffer_ring(__buf_ring, RECV_BUFFERS, BUFFER_GROUP))
+                return false;
+            for (unsigned i = 0; i < RECV_BUFFERS; i++)
+                __recycle(static_cast<uint16_t>(i));
+            __arm_accept();
+            __arm_wake();
+            return true;
+        }
+
+        void run(void)
+        {
+            while (!__stopping) {
+                if (__ring.submit(1) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                    std::cerr << "[URING] io_uring_enter failed: " << std::strerror(errno) << std::endl;
+                    break;
+                }
+                __ring.for_each_cqe([this](const io_uring_cqe &cqe) { __handle(cqe); });
+                __drain();
+            }
+            {
+                // The handlers still running use their connection.
+                std::unique_lock<std::mutex> lock(__handling_mutex);
+
+                __handling_cv.wait(lock, [this]() { return __handling == 0; });
+            }
+            for (auto &[id, conn] : __connections) {
+                if (conn->upgraded)
+                    __router.on_ws_close(*conn, "server stopped");
+                ::close(conn->fd);
+            }
+            __connections.clear();
+        }
+
+        void wake(void)
+        {
+            uint64_t one = 1;
+
+            if (__wake_fd >= 0 && ::write(__wake_fd, &one, sizeof(one)) < 0)
+                std::cerr << "[URING] Failed to wake a loop" << std::endl;
+        }
+
+        void post(uint64_t id, std::string frame, bool close)
+        {
+            {
+                std::lock_guard<std::mutex> lock(__incoming_mutex);
+                __incoming.push_back({ id, std::make_shared<const std::string>(std::move(frame)), close });
+            }
+            // The loop drains the queue after each batch of completions anyway.
+            if (std::this_thread::get_id() != __owner && !__wake_pending.exchange(true))
+                wake();
+        }
+
+    private:
+        // A null frame tells the loop the handler of the connection is done.
+        struct __Outgoing {
+            uint64_t id;
+            Frame frame;
+            bool close;
+        };
+
+        struct __ZeroCopy {
+            uint64_t id;
+            Frame frame;
+        };
+
+        void __handle(const io_uring_cqe &cqe)
+        {
+            switch (get_op(cqe.user_data)) {
+                case Op::ACCEPT:
+                    __on_accept(cqe);
+                    break;
+                case Op::RECV:
+                    __on_recv(cqe);
+                    break;
+                case Op::SEND:
+                    __on_send(get_id(cqe.user_data), cqe.res);
+                    break;
+                case Op::SEND_ZC:
+                    __on_send_zc(cqe);
+                    break;
+                case Op::WAKE:
+                    __wake_pending = false;
+                    __arm_wake();
+                    break;
+                case Op::HANDSHAKE:
+                    __on_handshake(get_id(cqe.user_data));
+                    break;
+            }
+        }
+
+        void __arm_accept(void)
+        {
+            io_uring_sqe *sqe = __ring.get_sqe();
+
+            if (!sqe)
+                return;
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->fd = __listener;
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+            sqe->accept_flags = SOCK_CLOEXEC;
+            sqe->user_data = make_user_data(Op::ACCEPT, 0);
+        }
+
+        void __arm_wake(void)
+        {
+            io_uring_sqe *sqe = __ring.get_sqe();
+
+            if (!sqe)
+                return;
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = __wake_fd;
+            sqe->addr = reinterpret_cast<uint64_t>(&__wake_value);
+            sqe->len = sizeof(__wake_value);
+            sqe->user_data = make_user_data(Op::WAKE, 0);
+        }
+
+        void __arm_recv(Connection &conn)
+        {
+            io_uring_sqe *sqe = __ring.get_sqe();
+
+            if (!sqe) {
+                __shutdown(conn, "submission queue full");
+                return;
+            }
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = conn.fd;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = BUFFER_GROUP;
+            sqe->user_data = make_user_data(Op::RECV, conn.id);
+            conn.recv_armed = true;
+        }
+
+        void __arm_poll(Connection &conn, unsigned events)
+        {
+            io_uring_sqe *sqe = __ring.get_sqe();
+
+            if (!sqe) {
+                __shutdown(conn, "submission queue full");
+                return;
+            }
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = conn.fd;
+            sqe->poll32_events = events;
+            sqe->user_data = make_user_data(Op::HANDSHAKE, conn.id);
+            conn.polling = true;
+        }
+
+        void __recycle(uint16_t bid)
+        {
+            io_uring_buf *buf = &__buf_ring[__buf_tail & (RECV_BUFFERS - 1)];
+
+            buf->addr = reinterpret_cast<uint64_t>(__buffers + bid * RECV_BUFFER_SIZE);
+            buf->len = RECV_BUFFER_SIZE;
+            buf->bid = bid;
+            __buf_tail++;
+            __atomic_store_n(&__buf_ring[0].resv, __buf_tail, __ATOMIC_RELEASE);
+        }
+
+        void __on_accept(const io_uring_cqe &cqe)
+        {
+            if (!(cqe.flags & IORING_CQE_F_MORE) && !__stopping)
+                __arm_accept();
+            if (cqe.res < 0)
+                return;
+            int fd = cqe.res;
+            int one = 1;
+            sockaddr_in addr;
+            socklen_t len = sizeof(addr);
+            char ip[INET_ADDRSTRLEN] = "";
+
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (getpeername(fd, reinterpret_cast<sockaddr *>(&addr), &len) == 0)
+                inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+            uint64_t id = __next_id++;
+            auto conn = std::make_unique<Connection>(*this, id, fd, ip);
+            Connection &ref = *conn;
+            __connections[id] = std::move(conn);
+            if (!__tls) {
+                __arm_recv(ref);
+                return;
+            }
+            // OpenSSL drives the handshake on the socket, which must not block meanwhile.
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            ref.tls = std::make_unique<TlsSession>(__tls->get_native(), fd);
+            __handshake(ref);
+            __release_if_done(ref);
+        }
+
+        void __handshake(Connection &conn)
+        {
+            switch (conn.tls->handshake()) {
+                case TlsSession::Step::DONE:
+                    // The ring doesn't wait on a non-blocking socket, it fails with EAGAIN.
+                    fcntl(conn.fd, F_SETFL, fcntl(conn.fd, F_GETFL) & ~O_NONBLOCK);
+                    __arm_recv(conn);
+                    break;
+                case TlsSession::Step::WANT_READ:
+                    __arm_poll(conn, POLLIN);
+                    break;
+                case TlsSession::Step::WANT_WRITE:
+                    __arm_poll(conn, POLLOUT);
+                    break;
+                default:
+                    __shutdown(conn, "tls handshake failed");
+                    break;
+            }
+        }
+
+        void __on_handshake(uint64_t id)
+        {
+            auto it = __connections.find(id);
+
+            if (it == __connections.end())
+                return;
+            Connection &conn = *it->second;
+            conn.polling = false;
+            if (!conn.shut)
+                __handshake(conn);
+            __release_if_done(conn);
+        }
+
+        void __on_recv(const io_uring_cqe &cqe)
+        {
+            auto it = __connections.find(get_id(cqe.user_data));
+
+            if (it == __connections.end())
+                return;
+            Connection &conn = *it->second;
+            if (!(cqe.flags & IORING_CQE_F_MORE))
+                conn.recv_armed = false;
+            if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+                auto bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+                if (!conn.shut)
+                    __receive(conn, __buffers + bid * RECV_BUFFER_SIZE, static_cast<size_t>(cqe.res));
+                __recycle(bid);
+                if (!conn.shut)
+                    __process(conn);
+            } else if (cqe.res != -ENOBUFS) {
+                __shutdown(conn, conn.upgraded ? "uncleanly" : "closed");
+            }
+            // Out of buffers ends a multishot receive, it is armed again
+            // once this batch has given its buffers back.
+            if (!conn.recv_armed && !conn.shut)
+                __arm_recv(conn);
+            __release_if_done(conn);
+        }
+
+        void __receive(Connection &conn, const char *data, size_t size)
+        {
+            std::string records;
+
+            if (!conn.tls || conn.tls->kernel_recv) {
+                conn.input.append(data, size);
+                return;
+            }
+            if (!conn.tls->decrypt(data, size, conn.input, records))
+                __shutdown(conn, conn.upgraded ? "uncleanly" : "closed");
+            if (!records.empty() && !conn.shut) {
+                conn.outbox.push_back(std::make_shared<const std::string>(std::move(records)));
+                __flush(conn);
+            }
+        }
+
+        void __on_send(uint64_t id, int res)
+        {
+            auto it = __connections.find(id);
+
+            if (it == __connections.end())
+                return;
+            Connection &conn = *it->second;
+            conn.sending = false;
+            if (res < 0) {
+                __shutdown(conn, "uncleanly");
+            } else {
+                conn.sent += static_cast<size_t>(res);
+                if (conn.sent >= conn.outbox.front()->size()) {
+                    conn.outbox.pop_front();
+                    conn.sent = 0;
+                }
+                if (conn.outbox.empty() && conn.close_after_flush && conn.tls && !conn.tls->closed)
+                    __close_notify(conn);
+                else if (conn.outbox.empty() && conn.close_after_flush)
+                    __shutdown(conn, conn.close_reason);
+                else
+                    __flush(conn);
+            }
+            __release_if_done(conn);
+        }
+
+        void __close_notify(Connection &conn)
+        {
+            std::string alert = conn.tls->close();
+
+            // Written by the kernel itself under kTLS.
+            if (alert.empty()) {
+                __shutdown(conn, conn.close_reason);
+                return;
+            }
+            conn.outbox.push_back(std::make_shared<const std::string>(std::move(alert)));
+            __flush(conn);
+        }
+
+        void __on_send_zc(const io_uring_cqe &cqe)
+        {
+            auto it = __zero_copy.find(get_id(cqe.user_data));
+
+            if (it == __zero_copy.end())
+                return;
+            // The notification tells the kernel is done with the pages of the frame.
+            if (cqe.flags & IORING_CQE_F_NOTIF) {
+                __zero_copy.erase(it);
+                return;
+            }
+            uint64_t id = it->second.id;
+            if (!(cqe.flags & IORING_CQE_F_MORE))
+                __zero_copy.erase(it);
+            auto conn = __connections.find(id);
+            // A kTLS socket may not take zero-copy sends: sent again by copy.
+            if (cqe.res == -EOPNOTSUPP && conn != __connections.end()) {
+                conn->second->zero_copy = false;
+                conn->second->sending = false;
+                __flush(*conn->second);
+                __release_if_done(*conn->second);
+                return;
+            }
+            __on_send(id, cqe.res);
+        }
+
+        void __queue(Connection &conn, std::string data)
+        {
+            __push(conn, std::make_shared<const std::string>(std::move(data)));
+        }
+
+        void __push(Connection &conn, Frame frame)
+        {
+            // Encrypted in the order the frames are queued, on the loop thread.
+            if (conn.tls && !conn.tls->kernel_send)
+                frame = std::make_shared<const std::string>(conn.tls->encrypt(*frame));
+            conn.outbox.push_back(std::move(frame));
+            __flush(conn);
+        }
+
+        void __flush(Connection &conn)
+        {
+            if (conn.sending || conn.shut || conn.outbox.empty())
+                return;
+            io_uring_sqe *sqe = __ring.get_sqe();
+            if (!sqe) {
+                __shutdown(conn, "submission queue full");
+                return;
+            }
+            const Frame &frame = conn.outbox.front();
+            if (conn.zero_copy && frame->size() >= ZERO_COPY_THRESHOLD) {
+                uint64_t token = __next_token++;
+
+                __zero_copy[token] = { conn.id, frame };
+                sqe->opcode = IORING_OP_SEND_ZC;
+                sqe->user_data = make_user_data(Op::SEND_ZC, token);
+            } else {
+                sqe->opcode = IORING_OP_SEND;
+                sqe->user_data = make_user_data(Op::SEND, conn.id);
+            }
+            sqe->fd = conn.fd;
+            sqe->addr = reinterpret_cast<uint64_t>(frame->data() + conn.sent);
+            sqe->len = static_cast<uint32_t>(frame->size() - conn.sent);
+            sqe->msg_flags = MSG_NOSIGNAL;
+            conn.sending = true;
+        }
+
+        void __drain(void)
+        {
+            std::vector<__Outgoing> items;
+
+            {
+                std::lock_guard<std::mutex> lock(__incoming_mutex);
+                items.swap(__incoming);
+            }
+            for (auto &item : items) {
+                auto it = __connections.find(item.id);
+
+                if (it == __connections.end())
+                    continue;
+                Connection &conn = *it->second;
+                if (!item.frame) {
+                    conn.handling = false;
+                    __dispatch(conn);
+                    __release_if_done(conn);
+                    continue;
+                }
+                // Nothing goes after a close frame.
+                if (conn.shut || conn.close_after_flush)
+                    continue;
+                conn.close_after_flush = item.close;
+                __push(conn, std::move(item.frame));
+            }
+        }
+
+        void __shutdown(Connection &conn, const std::string &reason)
+        {
+            if (conn.shut)
+                return;
+            conn.shut = true;
+            if (conn.close_reason.empty())
+                conn.close_reason = reason;
+            // Ends the pending receive, the connection is released once
+            // no operation references it anymore.
+            ::shutdown(conn.fd, SHUT_RDWR);
+        }
+
+        void __release_if_done(Connection &conn)
+        {
+            if (!conn.shut || conn.recv_armed || conn.sending || conn.polling || conn.handling)
+                return;
+            if (conn.upgraded)
+                __router.on_ws_close(conn, conn.close_reason);
+            ::close(conn.fd);
+            __connections.erase(conn.id);
+        }
+
+        void __dispatch(Connection &conn)
+        {
+            if (conn.handling || conn.pending.empty())
+                return;
+            auto [message, binary] = std::move(conn.pending.front());
+
+            conn.pending.pop_front();
+            {
+                std::lock_guard<std::mutex> lock(__handling_mutex);
+                __handling++;
+            }
+            conn.handling = true;
+            // The handlers run off the loop, their replies come back through post.
+            bool queued = __handlers.try_submit([this, &conn, message = std::move(message), binary]() {
+                try {
+                    __router.on_ws_message(conn, message, binary);
+                } catch (const std::exception &e) {
+                    std::cerr << "[URING] Message handler failed: " << e.what() << std::endl;
+                }
+                __done(conn.id);
+            });
+            if (!queued) {
+                conn.handling = false;
+                conn.pending.clear();
+                __done_handling();
+                if (!conn.shut && !conn.close_after_flush)
+                    __fail(conn, WsFrame::CLOSE_TRY_AGAIN, "server busy");
+            }
+        }
+
+        void __done(uint64_t id)
+        {
+            {
+                std::lock_guard<std::mutex> lock(__incoming_mutex);
+                __incoming.push_back({ id, nullptr, false });
+            }
+            if (!__wake_pending.exchange(true))
+                wake();
+            __done_handling();
+        }
+
+        void __done_handling(void)
+        {
+            // Notified under the lock: the loop may be destroyed once it sees 0.
+            std::lock_guard<std::mutex> lock(__handling_mutex);
+
+            if (--__handling == 0)
+                __handling_cv.notify_all();
+        }
+
+        void __fail(Connection &conn, uint16_t code, const std::string &reason)
+        {
+            conn.close_reason = reason;
+            __queue(conn, WsFrame::build_close(code, reason));
+            conn.close_after_flush = true;
+        }
+
+        void __process(Connection &conn)
+        {
+            if (!conn.upgraded)
+                __process_http(conn);
+            if (conn.upgraded)
+                __process_ws(conn);
+        }
+
+        void __process_http(Connection &conn)
+        {
+            while (!conn.shut && !conn.close_after_flush && !conn.upgraded) {
+                size_t end = conn.input.find("\r\n\r\n");
+                crow::request req;
+                bool keep_alive = true;
+
+                if (end == std::string::npos) {
+                    if (conn.input.size() > MAX_HEADER_SIZE)
+                        __reply(conn, crow::response(431), false);
+                    return;
+                }
+                if (!__parse_head(conn.input.substr(0, end), req, keep_alive)) {
+                    __reply(conn, crow::response(400), false);
+                    return;
+                }
+                const std::string &length_header = req.get_header_value("Content-Length");
+                size_t length = length_header.empty() ? 0 : std::strtoull(length_header.c_str(), nullptr, 10);
+                if (length > MAX_BODY_SIZE) {
+                    __reply(conn, crow::response(413), false);
+                    return;
+                }
+                if (conn.input.size() < end + 4 + length)
+                    return;
+                req.body = conn.input.substr(end + 4, length);
+                conn.input.erase(0, end + 4 + length);
+                if (req.url == "/ws") {
+                    __upgrade(conn, req);
+                    continue;
+                }
+                __reply(conn, __router.handle_request(req), keep_alive);
+            }
+        }
+
+        bool __parse_head(const std::string &head, crow::request &req, bool &keep_alive)
+        {
+            size_t line_end = head.find("\r\n");
+            std::string line = head.substr(0, line_end);
+            size_t first = line.find(' ');
+            size_t second = line.find(' ', first + 1);
+
+            if (first == std::string::npos || second == std::string::npos)
+                return false;
+            std::string method = line.substr(0, first);
+            std::string version = line.substr(second + 1);
+            if (method == "GET")
+                req.method = crow::HTTPMethod::Get;
+            else if (method == "POST")
+                req.method = crow::HTTPMethod::Post;
+            else if (method == "PUT")
+                req.method = crow::HTTPMethod::Put;
+            else if (method == "DELETE")
+                req.method = crow::HTTPMethod::Delete;
+            else
+                return false;
+            req.raw_url = line.substr(first + 1, second - first - 1);
+            req.url = req.raw_url.substr(0, req.raw_url.find('?'));
+            while (line_end != std::string::npos) {
+                size_t start = line_end + 2;
+                line_end = head.find("\r\n", start);
+                line = head.substr(start, line_end == std::string::npos ? std::string::npos : line_end - start);
+                size_t colon = line.find(':');
+                if (colon == std::string::npos)
+                    continue;
+                req.headers.emplace(trim(line.substr(0, colon)), trim(line.substr(colon + 1)));
+            }
+            const std::string &connection = req.get_header_value("Connection");
+            if (version == "HTTP/1.0")
+                keep_alive = contains_token(connection, "keep-alive");
+            else
+                keep_alive = !contains_token(connection, "close");
+            return version == "HTTP/1.1" || version == "HTTP/1.0";
+        }
+
+        void __reply(Connection &conn, const crow::response &res, bool keep_alive)
+        {
+            std::string out = "HTTP/1.1 " + std::to_string(res.code) + " "
+                + get_reason_phrase(res.code) + "\r\n";
+
+            for (const auto &[name, value] : res.headers)
+                out += name + ": " + value + "\r\n";
+            out += "Content-Length: " + std::to_string(res.body.size()) + "\r\n";
+            out += keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+            out += res.body;
+            __queue(conn, std::move(out));
+            if (!keep_alive)
+                conn.close_after_flush = true;
+        }
+
+        void __upgrade(Connection &conn, const crow::request &req)
+        {
+            const std::string &key = req.get_header_value("Sec-WebSocket-Key");
+
+            if (req.method != crow::HTTPMethod::Get || key.empty()
+                || !equals_ignore_case(req.get_header_value("Upgrade"), "websocket")
+                || req.get_header_value("Sec-WebSocket-Version") != "13") {
+                __reply(conn, crow::response(400), false);
+                return;
+            }
+            void *userdata = nullptr;
+
+            if (!__router.on_ws_accept(req, &userdata)) {
+                __reply(conn, crow::response(401), false);
+                return;
+            }
+            __queue(conn, "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                "Connection: Upgrade\r\nSec-WebSocket-Accept: " + WsFrame::get_accept_key(key)
+                + "\r\n\r\n");
+            conn.upgraded = true;
+            conn.userdata(userdata);
+            __router.on_ws_open(conn);
+        }
+
+        void __process_ws(Connection &conn)
+        {
+            size_t offset = 0;
+
+            while (!conn.shut && !conn.close_after_flush) {
+                WsFrame::Header header;
+
+                if (!WsFrame::parse_header(conn.input.data() + offset, conn.input.size() - offset, header))
+                    break;
+                bool control = static_cast<uint8_t>(header.opcode) & 0x8;
+                if (!header.masked || (control && (!header.fin || header.length > 125))) {
+                    __fail(conn, WsFrame::CLOSE_PROTOCOL_ERROR, "protocol error");
+                    break;
+                }
+                if (header.length > MAX_MESSAGE_SIZE - conn.message.size()) {
+                    __fail(conn, WsFrame::CLOSE_TOO_BIG, "message too big");
+                    break;
+                }
+                if (conn.input.size() - offset < header.size + header.length)
+                    break;
+                char *payload = conn.input.data() + offset + header.size;
+                auto length = static_cast<size_t>(header.length);
+                WsFrame::unmask(payload, length, header.mask);
+                offset += header.size + length;
+                switch (header.opcode) {
+                    case WsFrame::Opcode::TEXT:
+                    case WsFrame::Opcode::BINARY:
+                        if (conn.in_message) {
+                            __fail(conn, WsFrame::CLOSE_PROTOCOL_ERROR, "protocol error");
+                            continue;
+                        }
+                        conn.in_message = true;
+                        conn.message_binary = header.opcode == WsFrame::Opcode::BINARY;
+                        conn.message.assign(payload, length);
+                        break;
+                    case WsFrame::Opcode::CONTINUATION:
+                        if (!conn.in_message) {
+                            __fail(conn, WsFrame::CLOSE_PROTOCOL_ERROR, "protocol error");
+                            continue;
+                        }
+                        conn.message.append(payload, length);
+                        break;
+                    case WsFrame::Opcode::PING:
+                        __queue(conn, WsFrame::build(WsFrame::Opcode::PONG, std::string(payload, length)));
+                        continue;
+                    case WsFrame::Opcode::PONG:
+                        continue;
+                    case WsFrame::Opcode::CLOSE:
+                        conn.close_reason = length > 2 ? std::string(payload + 2, length - 2) : "";
+                        __queue(conn, WsFrame::build_close(WsFrame::CLOSE_NORMAL, ""));
+                        conn.close_after_flush = true;
+                        continue;
+                    default:
+                        __fail(conn, WsFrame::CLOSE_PROTOCOL_ERROR, "protocol error");
+                        continue;
+                }
+                if (header.fin) {
+                    std::string message;
+
+                    message.swap(conn.message);
+                    conn.in_message = false;
+                    if (conn.pending.size() >= MAX_PENDING_MESSAGES) {
+                        __fail(conn, WsFrame::CLOSE_TRY_AGAIN, "too many messages");
+                        continue;
+                    }
+                    conn.pending.emplace_back(std::move(message), conn.message_binary);
+                    __dispatch(conn);
+                }
+            }
+            conn.input.erase(0, offset);
+        }
+
+        Router &__router;
+        int __listener;
+        std::atomic<bool> &__stopping;
+        TlsContext *__tls;
+        WorkerPool &__handlers;
+        std::mutex __handling_mutex;
+        std::condition_variable __handling_cv;
+        size_t __handling = 0;
+        std::thread::id __owner;
+        Ring __ring;
+        int __wake_fd = -1;
+        uint64_t __wake_value = 0;
+        std::atomic<bool> __wake_pending{false};
+        char *__buffers = nullptr;
+        io_uring_buf *__buf_ring = nullptr;
+        uint16_t __buf_tail = 0;
+        std::unordered_map<uint64_t, std::unique_ptr<Connection>> __connections;
+        uint64_t __next_id = 1;
+        std::unordered_map<uint64_t, __ZeroCopy> __zero_copy;
+        uint64_t __next_token = 1;
+        std::mutex __incoming_mutex;
+        std::vector<__Outgoing> __incoming;
+};
+
+bool talkup_network::UringTransport::is_supported(void)
+{
+    io_uring_params params;
+    std::vector<char> buffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+    auto *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+
+    std::memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, 4, &params));
+    if (fd < 0)
+        return false;
+    long ret = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256);
+    ::close(fd);
+    return ret == 0 && probe->last_op >= IORING_OP_SEND_ZC
+        && (probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED);
+}
+
+bool talkup_network::UringTransport::run(Router &router, int port)
+{
+    size_t count = __threads ? __threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    std::mutex setup_mutex;
+    std::condition_variable setup_cv;
+    size_t ready = 0;
+    size_t failed = 0;
+
+    router.init();
+    {
+        std::lock_guard<std::mutex> lock(__start_mutex);
+        __handlers = std::make_unique<WorkerPool>("URING", 0, HANDLER_QUEUE);
+        __stop_fd = eventfd(0, EFD_CLOEXEC);
+        for (size_t i = 0; i < count; i++) {
+            int fd = open_listener(port);
+
+            if (fd < 0) {
+                std::cerr << "[URING] Failed to listen on port " << port << ": "
+                    << std::strerror(errno) << std::endl;
+                __loops.clear();
+                ::close(__stop_fd);
+                __stop_fd = -1;
+                __started = true;
+                __start_cv.notify_all();
+                return false;
+            }
+            // With port 0 the first socket picks the port the others share.
+            if (port == 0)
+                port = get_bound_port(fd);
+            __loops.push_back(std::make_unique<__Loop>(router, fd, __stopping, __tls.get(), *__handlers));
+        }
+    }
+    for (auto &loop : __loops) {
+        threads.emplace_back([&, loop = loop.get()]() {
+            bool ok = loop->setup();
+
+            {
+                std::lock_guard<std::mutex> lock(setup_mutex);
+                ok ? ready++ : failed++;
+            }
+            setup_cv.notify_one();
+            if (ok)
+                loop->run();
+        });
+    }
+    {
+        std::unique_lock<std::mutex> lock(setup_mutex);
+        setup_cv.wait(lock, [&]() { return ready + failed == count; });
+    }
+    if (failed) {
+        std::cerr << "[URING] Failed to set up " << failed << " io_uring loop(s)" << std::endl;
+        stop();
+    }
+    {
+        std::lock_guard<std::mutex> lock(__start_mutex);
+        __started = true;
+    }
+    __start_cv.notify_all();
+    __wait_for_stop();
+    for (auto &thread : threads)
+        thread.join();
+    std::lock_guard<std::mutex> lock(__start_mutex);
+    __loops.clear();
+    __handlers.reset();
+    ::close(__stop_fd);
+    __stop_fd = -1;
+    return failed == 0;
+}
+
+void talkup_network::UringTransport::__wait_for_stop(void)
+{
+    struct sigaction action;
+    struct sigaction old_int;
+    struct sigaction old_term;
+    uint64_t value;
+
+    // Same as Crow: SIGINT and SIGTERM stop the server gracefully.
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = on_stop_signal;
+    sigemptyset(&action.sa_mask);
+    signal_fd = __stop_fd;
+    sigaction(SIGINT, &action, &old_int);
+    sigaction(SIGTERM, &action, &old_term);
+    while (!__stopping && __stop_fd >= 0) {
+        if (::read(__stop_fd, &value, sizeof(value)) > 0 || errno != EINTR)
+            break;
+    }
+    sigaction(SIGINT, &old_int, nullptr);
+    sigaction(SIGTERM, &old_term, nullptr);
+    signal_fd = -1;
+    stop();
+}
+
+void talkup_network::UringTransport::stop(void)
+{
+    std::lock_guard<std::mutex> lock(__start_mutex);
+
+    uint64_t one = 1;
+
+    __stopping = true;
+    for (auto &loop : __loops)
+        loop->wake();
+    if (__stop_fd >= 0 && ::write(__stop_fd, &one, sizeof(one)) < 0)
+        std::cerr << "[URING] Failed to signal the stop" << std::endl;
+}
+
+#else
+
+class talkup_network::UringTransport::__Loop {
+};
+
+bool talkup_network::UringTransport::is_supported(void)
+{
+    return false;
+}
+
+bool talkup_network::UringTransport::run(Router &, int)
+{
+    std::cerr << "[URING] This build has no io_uring support (Linux 6.0 headers needed)" << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(__start_mutex);
+        __started = true;
+    }
+    __start_cv.notify_all();
+    return false;
+}
+
+void talkup_network::UringTransport::stop(void)
+{
+    __stopping = true;
+}
+
+#endif
+
+talkup_network::UringTransport::UringTransport(size_t threads, std::shared_ptr<TlsContext> tls)
+    : __threads(threads), __tls(std::move(tls))
+{
+}
+
+talkup_network::UringTransport::~UringTransport()
+{
+    stop();
+}
+
+void talkup_network::UringTransport::wait_for_start(void)
+{
+    std::unique_lock<std::mutex> lock(__start_mutex);
+
+    __start_cv.wait(lock, [this]() { return __started; });
+}
+
+std::string talkup_network::UringTransport::get_transport_name(void) const
+{
+    return "io_uring";
+}
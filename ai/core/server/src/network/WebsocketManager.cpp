@@ -7,82 +7,540 @@
 
 #include <nlohmann/json.hpp>
 #include <chrono>
+#include <iostream>
 #include <sstream>
+#include <stdexcept>
 
 #include "ExceptionManager.hpp"
+#include "ConnectionContext.hpp"
+#include "MicroservicesManager.hpp"
+#include "ServerMetrics.hpp"
+#include "Tracer.hpp"
 #include "WebsocketManager.hpp"
 
-talkup_network::WsManager::WsManager()
+namespace {
+    // Services analyzing the audio of a stream.
+    const char *const AUDIO_SERVICES[] = { "stt" };
+    // Services analyzing the delivery of the speaker from its prosody features.
+    const char *const PROSODY_SERVICES[] = { "ba", "va" };
+    // When a client can send a chunk refused for lack of memory again.
+    constexpr int64_t MEMORY_RETRY_MS = 1000;
+    // When a transcript which couldn't be written is tried again, and how many times.
+    constexpr std::chrono::seconds STORAGE_RETRY{10};
+    constexpr int STORAGE_ATTEMPTS = 5;
+}
+
+talkup_network::WsManager::WsManager(TimerService &timers, MemoryBudget &memory)
+    : _timers(timers), _memory(memory)
 {
-    _type_handlers["ping"] = [this](const nlohmann::json& json,
-        crow::websocket::connection& conn){ handle_ping(json,conn); };
-    _type_handlers["stream_chunk"] = [this](const nlohmann::json& json,
-        crow::websocket::connection& conn){ handle_stream_chunk(json,conn); };
+    _sender = [this](crow::websocket::connection& conn,
+        const nlohmann::json& json){ send(conn, json); };
+    _streams.set_budget(&_memory);
+    _memory.set_evictor([this](const std::string &stream_id, bool detached) {
+        evict_stream(stream_id, detached);
+    });
 }
 
-void talkup_network::WsManager::connection_type_manager(nlohmann::json &json, crow::websocket::connection &conn)
+void talkup_network::WsManager::connection_type_manager(const messages::Header &header,
+    message_json &json, crow::websocket::connection &conn)
 {
     try {
-        std::string type = json["type"].get<std::string>();
+        Tracer::ScopedSpan span("dispatch:", header.type);
+        Handler handler = _type_handlers.find(header.type);
 
-        auto it = _type_handlers.find(type);
-        if (it != _type_handlers.end()) {
-            it->second(json, conn);
+        if (handler) {
+            (this->*handler)(header, json, conn);
         } else {
-            nlohmann::json err;
+            message_json err;
             err["type"] = "error";
             err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count();
-            err["data"] = { {"message", "unknown type: " + type} };
-            conn.send_text(err.dump());
+            err["data"] = { {"message", "unknown type: " + header.type} };
+            send(conn, err);
         }
     } catch (const std::exception &e) {
-        nlohmann::json err;
+        message_json err;
         err["type"] = "error";
         err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
             std::chrono::system_clock::now().time_since_epoch()).count();
         err["data"] = { {"message", e.what()} };
-        conn.send_text(err.dump());
+        send(conn, err);
     }
 }
 
-void talkup_network::WsManager::handle_ping(const nlohmann::json& json, crow::websocket::connection& conn)
+void talkup_network::WsManager::handle_ping(const messages::Header& header,
+    const message_json& json, crow::websocket::connection& conn)
 {
-    nlohmann::json pong;
+    message_json pong;
 
     pong["type"] = "pong";
     pong["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::system_clock::now().time_since_epoch()).count();
-    if (json.contains("key")) pong["key"] = json["key"];
-    if (json.contains("data")) pong["data"] = json["data"];
-    conn.send_text(pong.dump());
+    pong["key"] = header.key;
+    pong["data"] = json["data"];
+    send(conn, pong);
+}
+
+void talkup_network::WsManager::handle_status(const messages::Header& header,
+    const message_json&, crow::websocket::connection& conn)
+{
+    auto *context = ConnectionContext::get(conn);
+    message_json status;
+
+    status["type"] = "status";
+    status["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    status["key"] = header.key;
+    // Only atomics are read: a status never waits on the budget or the registry.
+    status["data"] = ServerMetrics::get_status_report();
+    status["data"]["memory"] = _memory.get_report();
+    status["data"]["memory"]["session"] = { {"used",
+        context ? context->memory->load(std::memory_order_relaxed) : 0} };
+    send(conn, status);
 }
 
-void talkup_network::WsManager::handle_stream_chunk(const nlohmann::json& json, crow::websocket::connection& conn)
+void talkup_network::WsManager::handle_stream_chunk(const messages::Header& header,
+    const message_json& json, crow::websocket::connection& conn)
 {
-    if (json["format"] == "audio") {
-        conn.send_text(set_respond_json_format({
-            .type = "acknowledge",
-            .key = json["key"].get<std::string>(),
-            .stream_id = json["stream_id"].get<std::string>(),
-            .format = json["format"].get<std::string>(),
-            .timestamp = json["timestamp"].get<int64_t>(),
-            .data = "audio chunk received"
-        }).dump());
+    if (messages::get_format(header.format) == messages::Format::AUDIO) {
+        WebSocketConnectionInfo ack = get_acknowledge(header, "audio chunk received");
+        messages::StreamChunk chunk;
 
+        if (!header.seq) {
+            send(conn, set_respond_json_format(ack));
             //call async microservice network manager to handle audio stream chunk
+            return;
+        }
+        // Base64 in JSON, a byte string in CBOR/MessagePack.
+        if (!schema::parse(json, chunk))
+            throw ExceptionManager::NetworkInvalidJsonException();
+        std::string resume_token;
+        std::string samples = std::move(chunk.data.value);
+        ack.seq = chunk.seq;
+        // Reserved before the chunk is registered, so it can be sent again.
+        if (!_memory.reserve(ack.stream_id, MemoryBudget::Pool::PENDING_AUDIO, samples.size())) {
+            message_json err;
+            err["type"] = "error";
+            err["key"] = ack.key;
+            err["stream_id"] = ack.stream_id;
+            err["seq"] = chunk.seq;
+            err["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            err["data"] = { {"message", "memory budget exceeded"}, {"code", "memory_exhausted"},
+                {"retry_after_ms", MEMORY_RETRY_MS} };
+            send(conn, err);
+            return;
+        }
+        auto reservation = std::make_shared<MemoryBudget::Reservation>(_memory, ack.stream_id,
+            MemoryBudget::Pool::PENDING_AUDIO, samples.size());
+        switch (_streams.submit_chunk(ack.stream_id, *ack.seq, conn, resume_token)) {
+            case StreamRegistry::ChunkStatus::OWNED_ELSEWHERE:
+                throw ExceptionManager::NetworkStreamOwnedException();
+            case StreamRegistry::ChunkStatus::DUPLICATE:
+                ack.data = "duplicate chunk ignored";
+                send(conn, set_respond_json_format(ack));
+                return;
+            default:
+                break;
+        }
+        auto reply = set_respond_json_format(ack);
+        if (!resume_token.empty()) {
+            auto *context = ConnectionContext::get(conn);
+
+            reply["resume_token"] = resume_token;
+            if (context)
+                _memory.bind(ack.stream_id, context->memory);
+        }
+        _streams.deliver(ack.stream_id, *ack.seq, reply, _sender);
+        submit_audio(ack, std::move(samples), std::move(reservation));
+    }
+}
+
+void talkup_network::WsManager::handle_resume(const messages::Header& header,
+    const message_json& json, crow::websocket::connection& conn)
+{
+    const std::string &stream_id = header.stream_id;
+    auto *context = ConnectionContext::get(conn);
+    messages::ResumeData data;
+    int64_t last_received_seq = -1;
+    std::vector<nlohmann::json> replay;
+    message_json response;
+
+    if (!schema::parse(json["data"], data))
+        throw ExceptionManager::NetworkInvalidJsonException();
+    if (!_streams.resume(stream_id, data.resume_token, data.last_acked_seq, conn,
+        last_received_seq, replay))
+        throw ExceptionManager::NetworkResumeFailedException();
+    _memory.set_detached(stream_id, false);
+    if (context)
+        _memory.bind(stream_id, context->memory);
+    response["type"] = "resume_response";
+    response["key"] = header.key;
+    response["stream_id"] = stream_id;
+    response["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    response["data"] = { {"last_received_seq", last_received_seq}, {"replayed", replay.size()} };
+    send(conn, response);
+    for (const auto &message : replay)
+        send(conn, message);
+}
+
+void talkup_network::WsManager::handle_transcript_query(const messages::Header& header,
+    const message_json& json, crow::websocket::connection& conn)
+{
+    const std::string &stream_id = header.stream_id;
+    messages::TranscriptRange range;
+    message_json response;
+    auto ownership = _streams.get_ownership(stream_id, conn);
+
+    if (ownership == StreamRegistry::Ownership::ELSEWHERE)
+        throw ExceptionManager::NetworkStreamOwnedException();
+    response["type"] = "transcript";
+    response["key"] = header.key;
+    response["stream_id"] = stream_id;
+    response["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (schema::parse(json["data"], range)) {
+        message_json words = message_json::array();
+
+        // A stream gone from the registry may still be in the store, on its way to the disk.
+        if (ownership == StreamRegistry::Ownership::OWNED) {
+            for (const auto &word : _transcripts.get_words(stream_id, range.from_ms, range.to_ms))
+                words.push_back({ {"word", word.text}, {"start_ms", word.start_ms}, {"end_ms", word.end_ms} });
+        }
+        response["data"] = { {"from_ms", range.from_ms}, {"to_ms", range.to_ms}, {"words", words} };
+    } else {
+        response["data"] = { {"text", ownership == StreamRegistry::Ownership::OWNED
+            ? _transcripts.get_text(stream_id) : ""} };
     }
+    send(conn, response);
+}
+
+void talkup_network::WsManager::handle_stream_end(const messages::Header& header,
+    const message_json&, crow::websocket::connection& conn)
+{
+    std::string key = header.key;
+    std::string stream_id = header.stream_id;
+    auto ownership = _streams.get_ownership(stream_id, conn);
+
+    if (ownership == StreamRegistry::Ownership::ELSEWHERE)
+        throw ExceptionManager::NetworkStreamOwnedException();
+    // A stream gone from the registry was written to the disk when it expired.
+    if (ownership != StreamRegistry::Ownership::OWNED) {
+        send(conn, set_respond_json_format(get_acknowledge(header, "stream ended")));
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_audio_mutex);
+        _audio_bytes.erase(stream_id);
+        _prosody.erase(stream_id);
+    }
+    auto reply = set_respond_json_format(get_acknowledge(header, "stream ended"));
+    // Written on the storage pool: the answer goes to the connection the stream is still bound to.
+    compact_stream(stream_id, 0, [this, key, stream_id, reply](
+        const TranscriptStore::Compaction &compaction) {
+        message_json response;
+
+        if (!compaction.ok) {
+            response["type"] = "error";
+            response["key"] = key;
+            response["stream_id"] = stream_id;
+            response["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            response["data"] = { {"message", compaction.error} };
+            _streams.send(stream_id, response, _sender);
+            return;
+        }
+        if (compaction.name.empty()) {
+            _streams.send(stream_id, reply, _sender);
+            return;
+        }
+        response["type"] = "transcript_name";
+        response["key"] = key;
+        response["stream_id"] = stream_id;
+        response["text_id"] = compaction.name;
+        response["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        _streams.send(stream_id, response, _sender);
+    });
+}
+
+void talkup_network::WsManager::handle_subscribe(const messages::Header& header,
+    const message_json&, crow::websocket::connection& conn)
+{
+    auto *context = ConnectionContext::get(conn);
+
+    _broadcaster.subscribe(header.stream_id, conn,
+        context ? context->encoding.load() : Envelope::Encoding::JSON);
+    send(conn, set_respond_json_format(get_acknowledge(header, "subscribed")));
+}
+
+void talkup_network::WsManager::handle_unsubscribe(const messages::Header& header,
+    const message_json&, crow::websocket::connection& conn)
+{
+    _broadcaster.unsubscribe(header.stream_id, conn);
+    send(conn, set_respond_json_format(get_acknowledge(header, "unsubscribed")));
+}
+
+void talkup_network::WsManager::handle_speak(const messages::Header& header,
+    const message_json& json, crow::websocket::connection& conn)
+{
+    std::string key = header.key;
+    std::string stream_id = header.stream_id;
+    messages::SpeakData data;
+
+    if (!schema::parse(json["data"], data))
+        throw ExceptionManager::NetworkInvalidJsonException();
+    if (_streams.get_ownership(stream_id, conn) == StreamRegistry::Ownership::ELSEWHERE)
+        throw ExceptionManager::NetworkStreamOwnedException();
+    auto reply = set_respond_json_format(get_acknowledge(header, "speaking"));
+    std::string utterance_id;
+    auto status = _speech.speak(stream_id, &conn, data.text,
+        [this, &conn, key, stream_id](const TtsStreamer::Frame &frame) {
+        auto *context = ConnectionContext::get(conn);
+        nlohmann::json output;
+
+        output["type"] = "stream_output";
+        output["key"] = key;
+        output["stream_id"] = stream_id;
+        output["format"] = "audio/pcm16";
+        output["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        output["utterance_id"] = frame.utterance_id;
+        output["seq"] = frame.seq;
+        output["last"] = frame.last;
+        // Raw bytes when the envelope can carry them, Base64 in JSON.
+        if (context && context->encoding != Envelope::Encoding::JSON)
+            output["data"] = nlohmann::json::binary(std::vector<uint8_t>(frame.audio.begin(),
+                frame.audio.end()));
+        else
+            output["data"] = crow::utility::base64encode(
+                reinterpret_cast<const unsigned char *>(frame.audio.data()), frame.audio.size());
+        if (!frame.error.empty())
+            output["error"] = frame.error;
+        send(conn, output);
+    }, utterance_id);
+
+    if (status == TtsStreamer::SpeakStatus::OWNED_ELSEWHERE)
+        throw ExceptionManager::NetworkStreamOwnedException();
+    if (status == TtsStreamer::SpeakStatus::BUSY)
+        throw ExceptionManager::NetworkSpeechBusyException();
+    reply["utterance_id"] = utterance_id;
+    send(conn, reply);
+}
+
+void talkup_network::WsManager::handle_interrupt(const messages::Header& header,
+    const message_json&, crow::websocket::connection& conn)
+{
+    if (_streams.get_ownership(header.stream_id, conn) == StreamRegistry::Ownership::ELSEWHERE)
+        throw ExceptionManager::NetworkStreamOwnedException();
+    bool speaking = _speech.cancel(header.stream_id, &conn);
+
+    send(conn, set_respond_json_format(get_acknowledge(header,
+        speaking ? "speech interrupted" : "nothing to interrupt")));
+}
+
+void talkup_network::WsManager::submit_audio(const WebSocketConnectionInfo& chunk,
+    std::string samples, std::shared_ptr<MemoryBudget::Reservation> reservation)
+{
+    nlohmann::json meta = { {"stream_id", chunk.stream_id}, {"seq", *chunk.seq},
+        {"format", "audio/pcm16"}, {"sample_rate", 16000} };
+    std::shared_ptr<ProsodyExtractor> prosody;
+    int64_t offset_ms = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(_audio_mutex);
+        int64_t &position = _audio_bytes[chunk.stream_id];
+        auto &extractor = _prosody[chunk.stream_id];
+
+        offset_ms = position / ServerMetrics::AUDIO_BYTES_PER_MS;
+        position += static_cast<int64_t>(samples.size());
+        if (!extractor)
+            extractor = std::make_shared<ProsodyExtractor>();
+        prosody = extractor;
+    }
+    // The reservation goes with the callbacks: it is released once every service answered.
+    auto on_result = [this, chunk, offset_ms, reservation](const std::string &service) {
+        return [this, chunk, offset_ms, service, reservation](bool ok,
+            const nlohmann::json &result) {
+            nlohmann::json event;
+
+            if (ok && service == "stt") {
+                on_stt_result(chunk.stream_id, result, offset_ms);
+                return;
+            }
+            event["type"] = ok ? "analysis_result" : "error";
+            event["key"] = chunk.key;
+            event["stream_id"] = chunk.stream_id;
+            event["seq"] = *chunk.seq;
+            event["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            event["data"] = { {"service", service} };
+            if (ok)
+                event["data"]["result"] = result;
+            else
+                event["data"]["message"] = result.value("message", "");
+            publish_event(chunk.stream_id, *chunk.seq, event);
+        };
+    };
+    // Extracted outside the lock: the chunks of a stream come in order on its connection.
+    auto features = prosody->push(samples);
+
+    if (!features.frames.empty()) {
+        nlohmann::json prosody_meta = { {"stream_id", chunk.stream_id}, {"seq", *chunk.seq},
+            {"format", "prosody"}, {"features", ProsodyExtractor::to_json(features)} };
+
+        for (const char *service : PROSODY_SERVICES) {
+            Batcher *batcher = get_batcher(service);
+
+            if (batcher)
+                batcher->submit({ prosody_meta, "", on_result(service) });
+        }
+    }
+    for (const char *service : AUDIO_SERVICES) {
+        Batcher *batcher = get_batcher(service);
+
+        if (batcher)
+            batcher->submit({ meta, samples, on_result(service) });
+    }
+}
+
+talkup_network::Batcher *talkup_network::WsManager::get_batcher(const std::string &service)
+{
+    std::lock_guard<std::mutex> lock(_batchers_mutex);
+    auto it = _batchers.find(service);
+
+    if (it != _batchers.end())
+        return it->second.get();
+    if (!MicroservicesManager::get_services_list().count(service))
+        return nullptr;
+    // Created on first use, once services.json is loaded.
+    return (_batchers[service] = std::make_unique<Batcher>(service, &_timers)).get();
+}
+
+void talkup_network::WsManager::on_stt_result(const std::string &stream_id,
+    const nlohmann::json &result, int64_t offset_ms)
+{
+    auto segment = TranscriptStore::parse_stt_result(result, offset_ms);
+    nlohmann::json event;
+
+    _transcripts.append(stream_id, segment);
+    event["type"] = "transcript";
+    event["stream_id"] = stream_id;
+    event["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    event["data"] = { {"text", segment.text}, {"start_ms", segment.start_ms},
+        {"end_ms", segment.end_ms} };
+    _broadcaster.publish(stream_id, event);
+}
+
+void talkup_network::WsManager::publish_event(const std::string &stream_id, int64_t seq,
+    const nlohmann::json &event)
+{
+    _streams.deliver(stream_id, seq, event, _sender);
+    _broadcaster.publish(stream_id, event);
+}
+
+void talkup_network::WsManager::on_connection_closed(crow::websocket::connection& conn)
+{
+    _speech.cancel_owner(&conn);
+    for (const auto &stream_id : _streams.detach(conn)) {
+        _memory.set_detached(stream_id, true);
+        // A second after the grace period, so the stream is past it for sure.
+        _timers.schedule_after(_streams.get_grace_period() + std::chrono::seconds(1),
+            [this, stream_id]() { expire_stream(stream_id); },
+            std::hash<std::string>{}(stream_id));
+    }
+    _broadcaster.unsubscribe_all(conn);
+}
+
+void talkup_network::WsManager::expire_stream(const std::string &stream_id)
+{
+    // Resumed in the meantime, or already gone.
+    if (!_streams.expire(stream_id))
+        return;
+    {
+        std::lock_guard<std::mutex> lock(_audio_mutex);
+        _audio_bytes.erase(stream_id);
+        _prosody.erase(stream_id);
+    }
+    compact_stream(stream_id);
+}
+
+void talkup_network::WsManager::compact_stream(const std::string &stream_id, int attempt,
+    std::function<void(const TranscriptStore::Compaction &)> on_done)
+{
+    size_t key = std::hash<std::string>{}(stream_id);
+    // Kept in memory until then, and for good after the last attempt.
+    auto retry = [this, stream_id, attempt, key]() {
+        if (attempt + 1 >= STORAGE_ATTEMPTS)
+            return;
+        _timers.schedule_after(STORAGE_RETRY, [this, stream_id, attempt]() {
+            compact_stream(stream_id, attempt + 1);
+        }, key);
+    };
+    bool queued = _storage.try_submit([this, stream_id, attempt, retry, on_done]() {
+        auto compaction = _transcripts.compact(stream_id);
+
+        if (on_done)
+            on_done(compaction);
+        if (compaction.ok) {
+            _memory.forget(stream_id);
+            return;
+        }
+        std::cerr << "[STORAGE] " << compaction.error << std::endl;
+        retry();
+    }, key);
+
+    // A full queue is tried again later rather than blocking the timer.
+    if (!queued) {
+        if (on_done)
+            on_done({ false, "", "storage queue full" });
+        retry();
+    }
+}
+
+void talkup_network::WsManager::evict_stream(const std::string &stream_id, bool detached)
+{
+    // A stream still bound to its connection only loses what could be replayed.
+    if (!detached) {
+        _streams.trim(stream_id);
+        return;
+    }
+    // Resumed in the meantime, or already gone.
+    if (!_streams.drop(stream_id))
+        return;
+    {
+        std::lock_guard<std::mutex> lock(_audio_mutex);
+        _audio_bytes.erase(stream_id);
+        _prosody.erase(stream_id);
+    }
+    // Called on the chunk path: the transcript is written in the background.
+    compact_stream(stream_id);
 }
 
 nlohmann::json talkup_network::WsManager::set_respond_json_format(const WebSocketConnectionInfo& info) const
 {
-    nlohmann::json json;
+    return schema::serialize(info);
+}
 
-    json["type"] = info.type;
-    json["key"] = info.key;
-    json["stream_id"] = info.stream_id;
-    json["format"] = info.format;
-    json["timestamp"] = info.timestamp;
-    json["data"] = info.data;
-    return json;
+talkup_network::WsManager::WebSocketConnectionInfo talkup_network::WsManager::get_acknowledge(
+    const messages::Header &header, const std::string &data)
+{
+    return { "acknowledge", header.key, header.stream_id, header.format, header.timestamp, data, {} };
+}
+
+template <typename Json>
+void talkup_network::WsManager::send(crow::websocket::connection &conn,
+    const Json &json) const
+{
+    auto *context = ConnectionContext::get(conn);
+    Tracer::ScopedSpan span("reply_send");
+
+    Envelope::send(conn, json, context ? context->encoding.load() : Envelope::Encoding::JSON);
 }
+
+template void talkup_network::WsManager::send(crow::websocket::connection &,
+    const nlohmann::json &) const;
+template void talkup_network::WsManager::send(crow::websocket::connection &,
+    const message_json &) const;
@@ -0,0 +1,96 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the WsFrame class
+*/
+
+#include <crow.h>
+
+#include "WsFrame.hpp"
+
+bool talkup_network::WsFrame::parse_header(const char *data, size_t size, Header &header)
+{
+    const auto *bytes = reinterpret_cast<const uint8_t *>(data);
+
+    if (size < 2)
+        return false;
+    header.fin = bytes[0] & 0x80;
+    header.opcode = static_cast<Opcode>(bytes[0] & 0x0f);
+    header.masked = bytes[1] & 0x80;
+    header.length = bytes[1] & 0x7f;
+    header.size = 2;
+    if (header.length == 126) {
+        if (size < 4)
+            return false;
+        header.length = (static_cast<uint64_t>(bytes[2]) << 8) | bytes[3];
+        header.size = 4;
+    } else if (header.length == 127) {
+        if (size < 10)
+            return false;
+        header.length = 0;
+        for (size_t i = 2; i < 10; i++)
+            header.length = (header.length << 8) | bytes[i];
+        header.size = 10;
+    }
+    if (header.masked) {
+        if (size < header.size + 4)
+            return false;
+        for (size_t i = 0; i < 4; i++)
+            header.mask[i] = bytes[header.size + i];
+        header.size += 4;
+    }
+    return true;
+}
+
+void talkup_network::WsFrame::unmask(char *data, size_t size, const uint8_t mask[4],
+    uint64_t offset)
+{
+    for (size_t i = 0; i < size; i++)
+        data[i] ^= static_cast<char>(mask[(offset + i) & 3]);
+}
+
+std::string talkup_network::WsFrame::build(Opcode opcode, const std::string &payload)
+{
+    std::string frame;
+    uint64_t length = payload.size();
+
+    frame.reserve(payload.size() + 10);
+    frame.push_back(static_cast<char>(0x80 | static_cast<uint8_t>(opcode)));
+    if (length < 126) {
+        frame.push_back(static_cast<char>(length));
+    } else if (length <= 0xffff) {
+        frame.push_back(static_cast<char>(126));
+        frame.push_back(static_cast<char>(length >> 8));
+        frame.push_back(static_cast<char>(length));
+    } else {
+        frame.push_back(static_cast<char>(127));
+        for (int shift = 56; shift >= 0; shift -= 8)
+            frame.push_back(static_cast<char>(length >> shift));
+    }
+    frame += payload;
+    return frame;
+}
+
+std::string talkup_network::WsFrame::build_close(uint16_t code, const std::string &reason)
+{
+    std::string payload;
+
+    payload.push_back(static_cast<char>(code >> 8));
+    payload.push_back(static_cast<char>(code));
+    // Control frames carry at most 125 bytes.
+    payload += reason.substr(0, 123);
+    return build(Opcode::CLOSE, payload);
+}
+
+std::string talkup_network::WsFrame::get_accept_key(const std::string &key)
+{
+    static const std::string GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    std::string input = key + GUID;
+    sha1::SHA1 sha;
+    uint8_t digest[20];
+
+    sha.processBytes(input.data(), input.size());
+    sha.getDigestBytes(digest);
+    return crow::utility::base64encode(digest, 20);
+}
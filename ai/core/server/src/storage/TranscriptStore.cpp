@@ -0,0 +1,203 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the TranscriptStore class
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "TranscriptStore.hpp"
+
+talkup_network::TranscriptStore::TranscriptStore(const std::string &directory)
+    : __directory(directory)
+{
+}
+
+talkup_network::TranscriptStore::Segment talkup_network::TranscriptStore::parse_stt_result(
+    const nlohmann::json &result, int64_t offset_ms)
+{
+    Segment segment;
+
+    segment.text = result.value("text", "");
+    segment.start_ms = offset_ms;
+    segment.end_ms = offset_ms;
+    if (result.contains("result") && result["result"].is_array()) {
+        for (const auto &word : result["result"]) {
+            segment.words.push_back({
+                word.value("word", ""),
+                offset_ms + static_cast<int64_t>(word.value("start", 0.0) * 1000),
+                offset_ms + static_cast<int64_t>(word.value("end", 0.0) * 1000),
+            });
+        }
+    }
+    if (!segment.words.empty()) {
+        segment.start_ms = segment.words.front().start_ms;
+        segment.end_ms = segment.words.back().end_ms;
+    }
+    return segment;
+}
+
+void talkup_network::TranscriptStore::append(const std::string &stream_id,
+    const Segment &segment)
+{
+    std::shared_ptr<__Transcript> transcript;
+    std::unique_lock<std::mutex> lock;
+
+    do {
+        std::shared_ptr<__Transcript> sealed = std::move(transcript);
+        {
+            std::unique_lock<std::shared_mutex> map_lock(__mutex);
+            auto &entry = __transcripts[stream_id];
+
+            // Compacted since it was looked up: the segment starts a new transcript.
+            if (!entry || entry == sealed)
+                entry = std::make_shared<__Transcript>();
+            transcript = entry;
+        }
+        lock = std::unique_lock<std::mutex>(transcript->mutex);
+    } while (transcript->sealed);
+    auto by_start = [](const auto &a, const auto &b) { return a.start_ms < b.start_ms; };
+    bool in_order = transcript->segments.empty()
+        || transcript->segments.back().start_ms <= segment.start_ms;
+
+    // Segments and words nearly always arrive in order, inserting is then an append.
+    transcript->segments.insert(std::upper_bound(transcript->segments.begin(),
+        transcript->segments.end(), segment, by_start), segment);
+    for (const auto &word : segment.words) {
+        transcript->words.insert(std::upper_bound(transcript->words.begin(),
+            transcript->words.end(), word, by_start), word);
+        transcript->max_word_ms = std::max(transcript->max_word_ms, word.end_ms - word.start_ms);
+    }
+    if (in_order) {
+        if (!transcript->text.empty() && !segment.text.empty())
+            transcript->text += ' ';
+        transcript->text += segment.text;
+        return;
+    }
+    transcript->text.clear();
+    for (const auto &previous : transcript->segments) {
+        if (!transcript->text.empty() && !previous.text.empty())
+            transcript->text += ' ';
+        transcript->text += previous.text;
+    }
+}
+
+std::vector<talkup_network::TranscriptStore::Word> talkup_network::TranscriptStore::get_words(
+    const std::string &stream_id, int64_t from_ms, int64_t to_ms) const
+{
+    std::vector<Word> words;
+    auto transcript = __find(stream_id);
+
+    if (!transcript)
+        return words;
+    std::lock_guard<std::mutex> lock(transcript->mutex);
+    // No word is longer than max_word_ms, so no word starting before
+    // from_ms - max_word_ms can overlap the range.
+    Word bound{"", from_ms - transcript->max_word_ms, 0};
+    auto it = std::lower_bound(transcript->words.begin(), transcript->words.end(), bound,
+        [](const Word &a, const Word &b) { return a.start_ms < b.start_ms; });
+    for (; it != transcript->words.end() && it->start_ms < to_ms; ++it) {
+        if (it->end_ms > from_ms)
+            words.push_back(*it);
+    }
+    return words;
+}
+
+std::string talkup_network::TranscriptStore::get_text(const std::string &stream_id) const
+{
+    auto transcript = __find(stream_id);
+
+    if (!transcript)
+        return "";
+    std::lock_guard<std::mutex> lock(transcript->mutex);
+    return transcript->text;
+}
+
+talkup_network::TranscriptStore::Compaction talkup_network::TranscriptStore::compact(
+    const std::string &stream_id)
+{
+    auto transcript = __find(stream_id);
+    Compaction result;
+
+    if (!transcript)
+        return result;
+    // Held until the transcript is sealed: append waits, then starts a new one.
+    std::lock_guard<std::mutex> lock(transcript->mutex);
+
+    if (transcript->sealed)
+        return result;
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm tm = {};
+    std::ostringstream name;
+    std::string safe_id = stream_id;
+    nlohmann::json json;
+
+    gmtime_r(&now, &tm);
+    std::replace_if(safe_id.begin(), safe_id.end(),
+        [](char c) { return !std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_'; }, '_');
+    name << "transcript_" << safe_id << "_" << std::put_time(&tm, "%Y%m%d_%H%M%S")
+        << "_" << ++__compactions << ".json";
+    json["stream_id"] = stream_id;
+    json["text"] = transcript->text;
+    json["segments"] = nlohmann::json::array();
+    for (const auto &segment : transcript->segments) {
+        nlohmann::json words = nlohmann::json::array();
+
+        for (const auto &word : segment.words)
+            words.push_back({ {"word", word.text}, {"start_ms", word.start_ms}, {"end_ms", word.end_ms} });
+        json["segments"].push_back({ {"text", segment.text}, {"start_ms", segment.start_ms},
+            {"end_ms", segment.end_ms}, {"words", words} });
+    }
+    std::filesystem::path path = std::filesystem::path(__directory) / name.str();
+    std::filesystem::path temporary = path;
+    std::error_code error;
+
+    temporary += ".tmp";
+    std::filesystem::create_directories(__directory, error);
+    {
+        std::ofstream file(temporary);
+
+        if (file.is_open())
+            file << json.dump();
+        file.close();
+        if (!file)
+            error = std::make_error_code(std::errc::io_error);
+    }
+    if (!error)
+        std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::error_code ignored;
+
+        std::filesystem::remove(temporary, ignored);
+        result.ok = false;
+        result.error = "failed to write " + name.str() + ": " + error.message();
+        return result;
+    }
+    transcript->sealed = true;
+    {
+        std::unique_lock<std::shared_mutex> map_lock(__mutex);
+        auto it = __transcripts.find(stream_id);
+
+        if (it != __transcripts.end() && it->second == transcript)
+            __transcripts.erase(it);
+    }
+    result.name = name.str();
+    return result;
+}
+
+std::shared_ptr<talkup_network::TranscriptStore::__Transcript>
+    talkup_network::TranscriptStore::__find(const std::string &stream_id) const
+{
+    std::shared_lock<std::shared_mutex> lock(__mutex);
+    auto it = __transcripts.find(stream_id);
+
+    return it == __transcripts.end() ? nullptr : it->second;
+}
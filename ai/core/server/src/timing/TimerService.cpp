@@ -0,0 +1,147 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the TimerService class
+*/
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include "TimerService.hpp"
+
+namespace {
+    // The top byte of a handle holds its shard.
+    constexpr unsigned SHARD_SHIFT = 56;
+}
+
+talkup_network::TimerService::TimerService(size_t shards, std::chrono::milliseconds tick)
+    : __tick(tick > std::chrono::milliseconds(0) ? tick : std::chrono::milliseconds(1)),
+      __start(Clock::now())
+{
+    if (shards == 0)
+        shards = std::max(1u, std::thread::hardware_concurrency());
+    shards = std::min<size_t>(shards, 256);
+    for (size_t i = 0; i < shards; i++)
+        __shards.push_back(std::make_unique<__Shard>());
+    for (auto &shard : __shards) {
+        shard->worker = std::thread(&TimerService::__run, this, std::ref(*shard));
+        shard->worker_id = shard->worker.get_id();
+    }
+}
+
+talkup_network::TimerService::~TimerService()
+{
+    stop();
+}
+
+void talkup_network::TimerService::stop(void)
+{
+    for (auto &shard : __shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+
+        __stopping = true;
+        shard->changed.notify_all();
+    }
+    for (auto &shard : __shards) {
+        if (shard->worker.joinable())
+            shard->worker.join();
+    }
+}
+
+talkup_network::TimerService::Handle talkup_network::TimerService::schedule_after(
+    std::chrono::milliseconds delay, Callback callback, size_t key)
+{
+    // Keys are often addresses: mixed so their alignment doesn't skew the shards.
+    size_t index = key ? static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) % __shards.size()
+        : __next.fetch_add(1, std::memory_order_relaxed) % __shards.size();
+    __Shard &shard = *__shards[index];
+    // The next tick boundary after the delay, so a timer never fires early.
+    uint64_t tick = __ticks(Clock::now() + delay) + 1;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::vector<TimerWheel::Expired> none;
+
+    if (shard.wheel.get_size() == 0) {
+        // The thread sleeps while its wheel is empty: catch up, then wake it up.
+        shard.wheel.advance(__ticks(Clock::now()), none);
+        shard.changed.notify_all();
+    }
+    return shard.wheel.schedule(tick, std::move(callback)) | (static_cast<Handle>(index) << SHARD_SHIFT);
+}
+
+bool talkup_network::TimerService::cancel(Handle handle)
+{
+    size_t index = handle >> SHARD_SHIFT;
+    TimerWheel::Handle timer = handle & ((Handle(1) << SHARD_SHIFT) - 1);
+
+    if (handle == NONE || index >= __shards.size())
+        return false;
+    __Shard &shard = *__shards[index];
+    std::unique_lock<std::mutex> lock(shard.mutex);
+
+    if (shard.wheel.cancel(timer))
+        return true;
+    for (auto &expired : shard.firing) {
+        if (expired.first == timer && expired.second && shard.running != timer) {
+            expired.second = nullptr;
+            return true;
+        }
+    }
+    if (std::this_thread::get_id() != shard.worker_id)
+        shard.changed.wait(lock, [&shard, timer]() { return shard.running != timer; });
+    return false;
+}
+
+size_t talkup_network::TimerService::get_size(void)
+{
+    size_t size = 0;
+
+    for (auto &shard : __shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+
+        size += shard->wheel.get_size();
+    }
+    return size;
+}
+
+void talkup_network::TimerService::__run(__Shard &shard)
+{
+    std::unique_lock<std::mutex> lock(shard.mutex);
+
+    while (!__stopping) {
+        shard.wheel.advance(__ticks(Clock::now()), shard.firing);
+        for (size_t i = 0; i < shard.firing.size() && !__stopping; i++) {
+            Callback callback = std::move(shard.firing[i].second);
+
+            if (!callback)
+                continue;
+            shard.firing[i].second = nullptr;
+            shard.running = shard.firing[i].first;
+            lock.unlock();
+            // A failing callback mustn't take the other timers down with it.
+            try {
+                callback();
+            } catch (const std::exception &e) {
+                std::cerr << "[TIMER] Callback failed: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "[TIMER] Callback failed" << std::endl;
+            }
+            callback = nullptr;
+            lock.lock();
+            shard.running = TimerWheel::NONE;
+            shard.changed.notify_all();
+        }
+        shard.firing.clear();
+        if (__stopping)
+            break;
+        if (shard.wheel.get_size() == 0)
+            shard.changed.wait(lock);
+        else
+            shard.changed.wait_until(lock, __start + __tick * (shard.wheel.get_tick() + 1));
+    }
+}
+
+uint64_t talkup_network::TimerService::__ticks(Clock::time_point time) const
+{
+    return static_cast<uint64_t>((time - __start) / __tick);
+}
@@ -0,0 +1,142 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the TimerWheel class
+*/
+
+#include "TimerWheel.hpp"
+
+talkup_network::TimerWheel::TimerWheel(void)
+{
+    __slots.fill(NIL);
+}
+
+talkup_network::TimerWheel::Handle talkup_network::TimerWheel::schedule(uint64_t tick,
+    Callback callback)
+{
+    uint32_t index;
+
+    if (__free.empty()) {
+        index = static_cast<uint32_t>(__nodes.size());
+        __nodes.emplace_back();
+    } else {
+        index = __free.back();
+        __free.pop_back();
+    }
+    __Node &node = __nodes[index];
+    node.tick = tick > __tick ? tick : __tick + 1;
+    node.callback = std::move(callback);
+    node.pending = true;
+    __insert(index);
+    __size++;
+    return (static_cast<Handle>(node.generation) << 32) | index;
+}
+
+bool talkup_network::TimerWheel::cancel(Handle handle)
+{
+    uint32_t index = static_cast<uint32_t>(handle);
+
+    if (index >= __nodes.size() || __nodes[index].generation != handle >> 32
+        || !__nodes[index].pending)
+        return false;
+    __unlink(index);
+    __release(index);
+    return true;
+}
+
+void talkup_network::TimerWheel::advance(uint64_t tick, std::vector<Expired> &expired)
+{
+    while (__tick < tick) {
+        __tick++;
+        // Each time a level wraps around, the next slot of the level above is due
+        // to be split over the levels below.
+        for (size_t level = 1; level < LEVELS; level++) {
+            if ((__tick & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) != 0)
+                break;
+            __cascade(level);
+        }
+        uint32_t &head = __slots[__tick & (SLOTS - 1)];
+
+        while (head != NIL) {
+            uint32_t index = head;
+
+            __unlink(index);
+            expired.emplace_back((static_cast<Handle>(__nodes[index].generation) << 32) | index,
+                std::move(__nodes[index].callback));
+            __release(index);
+        }
+        if (__size == 0) {
+            __tick = tick;
+            break;
+        }
+    }
+}
+
+uint64_t talkup_network::TimerWheel::get_tick(void) const
+{
+    return __tick;
+}
+
+size_t talkup_network::TimerWheel::get_size(void) const
+{
+    return __size;
+}
+
+void talkup_network::TimerWheel::__insert(uint32_t index)
+{
+    __Node &node = __nodes[index];
+    uint64_t delta = node.tick - __tick;
+    size_t level = 0;
+
+    while (level + 1 < LEVELS && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1))))
+        level++;
+    // Further than the wheel reaches: parked in the farthest slot, and moved down later.
+    uint64_t tick = delta >> (SLOT_BITS * LEVELS) ? __tick + (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1
+        : node.tick;
+    node.slot = static_cast<uint16_t>(level * SLOTS + ((tick >> (SLOT_BITS * level)) & (SLOTS - 1)));
+    node.prev = NIL;
+    node.next = __slots[node.slot];
+    if (node.next != NIL)
+        __nodes[node.next].prev = index;
+    __slots[node.slot] = index;
+}
+
+void talkup_network::TimerWheel::__unlink(uint32_t index)
+{
+    __Node &node = __nodes[index];
+
+    if (node.prev != NIL)
+        __nodes[node.prev].next = node.next;
+    else
+        __slots[node.slot] = node.next;
+    if (node.next != NIL)
+        __nodes[node.next].prev = node.prev;
+    node.prev = NIL;
+    node.next = NIL;
+}
+
+void talkup_network::TimerWheel::__release(uint32_t index)
+{
+    __Node &node = __nodes[index];
+
+    node.pending = false;
+    node.callback = nullptr;
+    node.generation = node.generation == GENERATIONS ? 1 : node.generation + 1;
+    __free.push_back(index);
+    __size--;
+}
+
+void talkup_network::TimerWheel::__cascade(size_t level)
+{
+    size_t slot = level * SLOTS + ((__tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+    uint32_t index = __slots[slot];
+
+    __slots[slot] = NIL;
+    while (index != NIL) {
+        uint32_t next = __nodes[index].next;
+
+        __insert(index);
+        index = next;
+    }
+}
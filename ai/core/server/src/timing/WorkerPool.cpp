@@ -0,0 +1,128 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Implementation of the WorkerPool class
+*/
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include "WorkerPool.hpp"
+
+talkup_network::WorkerPool::WorkerPool(const std::string &name, size_t threads, size_t capacity)
+    : __name(name), __capacity(std::max<size_t>(capacity, 1))
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; i++)
+        __shards.push_back(std::make_unique<__Shard>());
+    for (auto &shard : __shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+
+        shard->worker = std::thread(&WorkerPool::__run, this, std::ref(*shard));
+        shard->worker_id = shard->worker.get_id();
+    }
+}
+
+talkup_network::WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void talkup_network::WorkerPool::stop(void)
+{
+    for (auto &shard : __shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+
+        __stopping = true;
+        shard->ready.notify_all();
+        shard->room.notify_all();
+    }
+    for (auto &shard : __shards) {
+        if (shard->worker.joinable() && shard->worker.get_id() != std::this_thread::get_id())
+            shard->worker.join();
+    }
+}
+
+bool talkup_network::WorkerPool::submit(Task task, size_t key)
+{
+    return __push(std::move(task), key, true);
+}
+
+bool talkup_network::WorkerPool::try_submit(Task task, size_t key)
+{
+    return __push(std::move(task), key, false);
+}
+
+size_t talkup_network::WorkerPool::get_size(void)
+{
+    size_t size = 0;
+
+    for (auto &shard : __shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+
+        size += shard->tasks.size();
+    }
+    return size;
+}
+
+talkup_network::WorkerPool::__Shard &talkup_network::WorkerPool::__pick(size_t key)
+{
+    // Keys are often addresses: mixed so their alignment doesn't skew the shards.
+    if (key)
+        return *__shards[static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) % __shards.size()];
+    size_t start = __next.fetch_add(1, std::memory_order_relaxed);
+    size_t best = start % __shards.size();
+
+    for (size_t i = 1; i < __shards.size(); i++) {
+        size_t index = (start + i) % __shards.size();
+
+        if (__shards[index]->load < __shards[best]->load)
+            best = index;
+    }
+    return *__shards[best];
+}
+
+bool talkup_network::WorkerPool::__push(Task task, size_t key, bool wait)
+{
+    __Shard &shard = __pick(key);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    bool worker = std::any_of(__shards.begin(), __shards.end(),
+        [](const auto &other) { return other->worker_id == std::this_thread::get_id(); });
+
+    if (wait && !worker)
+        shard.room.wait(lock, [this, &shard]() { return __stopping || shard.tasks.size() < __capacity; });
+    if (__stopping || (!worker && shard.tasks.size() >= __capacity))
+        return false;
+    shard.tasks.push_back(std::move(task));
+    shard.load++;
+    shard.ready.notify_one();
+    return true;
+}
+
+void talkup_network::WorkerPool::__run(__Shard &shard)
+{
+    std::unique_lock<std::mutex> lock(shard.mutex);
+
+    while (true) {
+        shard.ready.wait(lock, [this, &shard]() { return __stopping || !shard.tasks.empty(); });
+        if (shard.tasks.empty())
+            break;
+        Task task = std::move(shard.tasks.front());
+
+        shard.tasks.pop_front();
+        shard.room.notify_one();
+        lock.unlock();
+        try {
+            task();
+        } catch (const std::exception &e) {
+            std::cerr << "[" << __name << "] Task failed: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "[" << __name << "] Task failed" << std::endl;
+        }
+        task = nullptr;
+        shard.load--;
+        lock.lock();
+    }
+}
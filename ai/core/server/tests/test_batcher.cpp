@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "Batcher.hpp"
+#include "Tracer.hpp"
+
+using Clock = talkup_network::Batcher::Clock;
+
+// Test fixture for Batcher tests
+class BatcherTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        options.max_batch = 4;
+        options.budget = std::chrono::milliseconds(20);
+    }
+
+    void TearDown() override {
+    }
+
+    // Answers every segment of a batch with its stream_id and its samples.
+    talkup_network::Batcher::Sender echo_sender(void) {
+        return [this](const std::string &, const nlohmann::json &task, std::string_view samples,
+            Clock::time_point) {
+            talkup_network::ServicePool::Result result;
+            nlohmann::json results = nlohmann::json::array();
+
+            for (const auto &item : task["data"]["batch"]) {
+                results.push_back({ {"id", item["id"]}, {"stream_id", item["stream_id"]},
+                    {"samples", std::string(samples.substr(item["offset"].get<size_t>(),
+                        item["length"].get<size_t>()))} });
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batch_sizes.push_back(task["data"]["batch"].size());
+            }
+            result.ok = true;
+            result.body = nlohmann::json{ {"type", "task_result"},
+                {"data", { {"results", results} }} }.dump();
+            return result;
+        };
+    }
+
+    talkup_network::Batcher::Segment segment(const std::string &stream_id,
+        const std::string &samples) {
+        return { { {"stream_id", stream_id} }, samples,
+            [this, stream_id, samples](bool ok, const nlohmann::json &result) {
+                ok = ok && result["stream_id"] == stream_id && result["samples"] == samples;
+                (ok ? answered : failed)++;
+            } };
+    }
+
+    void wait_for(size_t count) {
+        auto deadline = Clock::now() + std::chrono::seconds(2);
+
+        while (answered + failed < count && Clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    talkup_network::Batcher::Options options;
+    std::mutex mutex;
+    std::vector<size_t> batch_sizes;
+    std::atomic<size_t> answered{0};
+    std::atomic<size_t> failed{0};
+};
+
+/**
+ * @brief A full batch is sent right away, and each segment gets its own result.
+ *
+ */
+TEST_F(BatcherTest, FlushesFullBatch) {
+    options.budget = std::chrono::milliseconds(10000);
+    talkup_network::Batcher batcher("stt", options, echo_sender());
+    auto start = Clock::now();
+
+    for (int i = 0; i < 8; i++)
+        batcher.submit(segment("stream" + std::to_string(i), std::string(i + 1, 'a' + i)));
+    wait_for(8);
+    EXPECT_LT(Clock::now() - start, std::chrono::seconds(1));
+    EXPECT_EQ(answered, 8u);
+    EXPECT_EQ(batch_sizes, std::vector<size_t>({4, 4}));
+}
+
+/**
+ * @brief A partial batch is sent once its oldest segment waited for the latency budget.
+ *
+ */
+TEST_F(BatcherTest, FlushesOnBudget) {
+    talkup_network::Batcher batcher("stt", options, echo_sender());
+    auto start = Clock::now();
+
+    batcher.submit(segment("a", "1234"));
+    batcher.submit(segment("b", "5678"));
+    wait_for(2);
+    EXPECT_GE(Clock::now() - start, options.budget);
+    EXPECT_EQ(answered, 2u);
+    EXPECT_EQ(batch_sizes, std::vector<size_t>({2}));
+}
+
+/**
+ * @brief Every segment of a failed batch fails, as does a segment missing from the result.
+ *
+ */
+TEST_F(BatcherTest, FailsSegments) {
+    talkup_network::Batcher failing("stt", options, [](const std::string &,
+        const nlohmann::json &, std::string_view, Clock::time_point) {
+        return talkup_network::ServicePool::Result();
+    });
+    talkup_network::Batcher partial("stt", options, [](const std::string &,
+        const nlohmann::json &, std::string_view, Clock::time_point) {
+        talkup_network::ServicePool::Result result;
+
+        result.ok = true;
+        result.body = R"({"type":"task_result","data":{"results":[]}})";
+        return result;
+    });
+
+    failing.submit(segment("a", "1"));
+    failing.submit(segment("b", "2"));
+    partial.submit(segment("c", "3"));
+    wait_for(3);
+    EXPECT_EQ(failed, 3u);
+    EXPECT_EQ(answered, 0u);
+}
+
+/**
+ * @brief Destroying the batcher fails the waiting segments.
+ *
+ */
+TEST_F(BatcherTest, FailsWaitingOnStop) {
+    options.budget = std::chrono::milliseconds(10000);
+    {
+        talkup_network::Batcher batcher("stt", options, echo_sender());
+
+        batcher.submit(segment("a", "1"));
+    }
+    EXPECT_EQ(failed, 1u);
+    EXPECT_TRUE(batch_sizes.empty());
+}
+
+/**
+ * @brief With timers, a segment fails at its deadline even while its batch
+ * is still on the way, and its late result is dropped.
+ *
+ */
+TEST_F(BatcherTest, FailsAtDeadline) {
+    talkup_network::TimerService timers(1, std::chrono::milliseconds(1));
+    auto echo = echo_sender();
+    options.budget = std::chrono::milliseconds(1);
+    options.timeout = std::chrono::milliseconds(30);
+    talkup_network::Batcher batcher("stt", options, [echo](const std::string &service,
+        const nlohmann::json &task, std::string_view samples, Clock::time_point deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        return echo(service, task, samples, deadline);
+    }, &timers);
+    auto start = Clock::now();
+
+    batcher.submit(segment("abc", "aaaa"));
+    wait_for(1);
+    EXPECT_LT(Clock::now() - start, std::chrono::milliseconds(120));
+    EXPECT_EQ(failed, 1u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_EQ(answered, 0u);
+    EXPECT_EQ(failed, 1u);
+}
+
+/**
+ * @brief No more than max_in_flight batches are sent at once: the segments
+ * which come meanwhile make bigger batches, and all of them are answered.
+ *
+ */
+TEST_F(BatcherTest, BoundsBatchesInFlight) {
+    auto echo = echo_sender();
+    std::atomic<int> sending{0};
+    std::atomic<int> most{0};
+    options.max_in_flight = 2;
+    options.budget = std::chrono::milliseconds(1);
+    talkup_network::Batcher batcher("stt", options, [&](const std::string &service,
+        const nlohmann::json &task, std::string_view samples, Clock::time_point deadline) {
+        int now = ++sending;
+
+        most = std::max(most.load(), now);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        sending--;
+        return echo(service, task, samples, deadline);
+    });
+
+    for (int i = 0; i < 40; i++) {
+        batcher.submit(segment("stream" + std::to_string(i), "aa"));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    wait_for(40);
+    EXPECT_EQ(answered, 40u);
+    EXPECT_LE(most, 2);
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_LT(batch_sizes.size(), 40u);
+}
+
+/**
+ * @brief A segment submitted while its message is traced is sent in that
+ * trace: the spans of the call, recorded on a sender thread, carry it, and
+ * so does its result callback.
+ *
+ */
+TEST_F(BatcherTest, SendsInTraceOfSegment) {
+    auto sender = echo_sender();
+    std::atomic<uint64_t> callback_trace{0};
+    talkup_network::Batcher batcher("stt", options, [&sender](const std::string &service,
+        const nlohmann::json &task, std::string_view samples, Clock::time_point deadline) {
+        talkup_network::Tracer::ScopedSpan span("batch_call:", service);
+
+        return sender(service, task, samples, deadline);
+    });
+    uint64_t trace_id = talkup_network::Tracer::begin_trace(true);
+    auto traced = segment("stream", "abc");
+    auto on_result = traced.on_result;
+
+    ASSERT_NE(trace_id, 0u);
+    traced.on_result = [&callback_trace, on_result](bool ok, const nlohmann::json &result) {
+        callback_trace = talkup_network::Tracer::current();
+        on_result(ok, result);
+    };
+    batcher.submit(std::move(traced));
+    talkup_network::Tracer::end_trace();
+    batcher.submit(segment("untraced", "def"));
+    wait_for(2);
+    EXPECT_EQ(answered, 2u);
+    EXPECT_EQ(callback_trace, trace_id);
+
+    std::ostringstream out;
+    size_t spans = 0;
+    talkup_network::Tracer::dump(out);
+    auto events = nlohmann::json::parse(out.str())["traceEvents"];
+
+    for (const auto &event : events) {
+        std::string name = event["name"];
+
+        if (name != "batch_call:stt" && name != "ms_batch")
+            continue;
+        EXPECT_EQ(event["args"]["trace_id"], trace_id);
+        spans++;
+    }
+    EXPECT_EQ(spans, 2u);
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <crow.h>
+#include "Broadcaster.hpp"
+
+using talkup_network::Broadcaster;
+using Encoding = talkup_network::Envelope::Encoding;
+
+namespace {
+    // Keeps the frames sent by the Broadcaster thread, and can hold it in a send.
+    class FakeConnection : public crow::websocket::connection {
+        public:
+            void send_binary(const std::string &msg) override { __receive(msg, true); }
+            void send_text(const std::string &msg) override { __receive(msg, false); }
+            void send_ping(const std::string &) override {}
+            void send_pong(const std::string &) override {}
+            void close(const std::string &) override {}
+            std::string get_remote_ip() override { return "127.0.0.1"; }
+
+            void hold(void)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                held = true;
+            }
+
+            void release(void)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    held = false;
+                }
+                changed.notify_all();
+            }
+
+            // Waits for count frames, or for the first send to be held.
+            bool wait_for(size_t count, bool sending = false)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                return changed.wait_for(lock, std::chrono::seconds(2), [this, count, sending]() {
+                    return sending ? in_send : frames.size() >= count;
+                });
+            }
+
+            std::vector<nlohmann::json> get_events(void)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                std::vector<nlohmann::json> events;
+
+                for (const auto &[frame, binary] : frames)
+                    events.push_back(binary ? nlohmann::json::from_cbor(frame) : nlohmann::json::parse(frame));
+                return events;
+            }
+
+            size_t get_binary_count(void)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                return std::count_if(frames.begin(), frames.end(), [](const auto &f) { return f.second; });
+            }
+
+            std::mutex mutex;
+            std::condition_variable changed;
+            std::vector<std::pair<std::string, bool>> frames;
+            bool held = false;
+            bool in_send = false;
+
+        private:
+            void __receive(const std::string &msg, bool binary)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                in_send = true;
+                changed.notify_all();
+                changed.wait(lock, [this]() { return !held; });
+                in_send = false;
+                frames.emplace_back(msg, binary);
+                changed.notify_all();
+            }
+    };
+
+    nlohmann::json make_event(int index)
+    {
+        return { {"type", "transcript"}, {"stream_id", "stream"}, {"index", index} };
+    }
+}
+
+// Test fixture for Broadcaster tests
+class BroadcasterTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+
+    void TearDown() override {}
+
+    FakeConnection first;
+    FakeConnection second;
+    FakeConnection other;
+};
+
+/**
+ * @brief An event reaches every subscriber of its stream once, in the
+ * encoding each asked for, and no one else.
+ *
+ */
+TEST_F(BroadcasterTest, FansOutToSubscribers) {
+    Broadcaster broadcaster;
+
+    broadcaster.subscribe("stream", first, Encoding::JSON);
+    broadcaster.subscribe("stream", first, Encoding::JSON);
+    broadcaster.subscribe("stream", second, Encoding::CBOR);
+    broadcaster.subscribe("other", other, Encoding::JSON);
+    for (int i = 0; i < 3; i++)
+        broadcaster.publish("stream", make_event(i));
+    broadcaster.publish("nobody", make_event(9));
+
+    ASSERT_TRUE(first.wait_for(3));
+    ASSERT_TRUE(second.wait_for(3));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(first.get_events(), std::vector<nlohmann::json>({ make_event(0), make_event(1), make_event(2) }));
+    EXPECT_EQ(second.get_events(), first.get_events());
+    EXPECT_EQ(first.get_binary_count(), 0u);
+    EXPECT_EQ(second.get_binary_count(), 3u);
+    EXPECT_TRUE(other.get_events().empty());
+}
+
+/**
+ * @brief A subscriber slower than the events doesn't hold the publisher:
+ * its queue keeps the latest events and drops the oldest.
+ *
+ */
+TEST_F(BroadcasterTest, DropsOldestForSlowSubscriber) {
+    Broadcaster broadcaster(4);
+    auto start = std::chrono::steady_clock::now();
+
+    broadcaster.subscribe("stream", first, Encoding::JSON);
+    first.hold();
+    broadcaster.publish("stream", make_event(0));
+    ASSERT_TRUE(first.wait_for(0, true));
+    for (int i = 1; i <= 20; i++)
+        broadcaster.publish("stream", make_event(i));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    first.release();
+
+    ASSERT_TRUE(first.wait_for(5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(first.get_events(), std::vector<nlohmann::json>({ make_event(0), make_event(17),
+        make_event(18), make_event(19), make_event(20) }));
+}
+
+/**
+ * @brief Nothing is sent to a connection once it unsubscribed, from one
+ * stream or from all of them, while the others still get the events.
+ *
+ */
+TEST_F(BroadcasterTest, StopsAfterUnsubscribe) {
+    Broadcaster broadcaster;
+
+    broadcaster.subscribe("stream", first, Encoding::JSON);
+    broadcaster.subscribe("stream", second, Encoding::JSON);
+    broadcaster.subscribe("other", second, Encoding::JSON);
+    broadcaster.publish("stream", make_event(0));
+    ASSERT_TRUE(first.wait_for(1));
+    ASSERT_TRUE(second.wait_for(1));
+
+    broadcaster.unsubscribe("stream", first);
+    broadcaster.publish("stream", make_event(1));
+    ASSERT_TRUE(second.wait_for(2));
+    broadcaster.unsubscribe_all(second);
+    broadcaster.publish("stream", make_event(2));
+    broadcaster.publish("other", make_event(3));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(first.get_events(), std::vector<nlohmann::json>({ make_event(0) }));
+    EXPECT_EQ(second.get_events(), std::vector<nlohmann::json>({ make_event(0), make_event(1) }));
+}
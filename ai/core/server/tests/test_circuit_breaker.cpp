@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include "CircuitBreaker.hpp"
+
+using Clock = talkup_network::CircuitBreaker::Clock;
+using State = talkup_network::CircuitBreaker::State;
+
+// Test fixture for CircuitBreaker tests
+class CircuitBreakerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        now = Clock::now();
+        thresholds.slow_call_us = 100000;
+        thresholds.min_calls = 4;
+        thresholds.open_for = std::chrono::milliseconds(1000);
+    }
+
+    void TearDown() override {
+    }
+
+    void call(talkup_network::CircuitBreaker &breaker, bool ok, int64_t latency_us) {
+        ASSERT_TRUE(breaker.allow(now));
+        breaker.record(ok, latency_us, now);
+    }
+
+    talkup_network::CircuitBreaker::Thresholds thresholds;
+    Clock::time_point now;
+};
+
+/**
+ * @brief The breaker opens once half of the recent calls failed, and rejects calls.
+ *
+ */
+TEST_F(CircuitBreakerTest, OpensOnErrors) {
+    talkup_network::CircuitBreaker breaker(thresholds);
+
+    call(breaker, true, 1000);
+    call(breaker, true, 1000);
+    call(breaker, false, 1000);
+    EXPECT_EQ(breaker.get_state(), State::CLOSED);
+    call(breaker, false, 1000);
+    EXPECT_EQ(breaker.get_state(), State::OPEN);
+    EXPECT_FALSE(breaker.allow(now));
+}
+
+/**
+ * @brief Successful but slow calls open the breaker too.
+ *
+ */
+TEST_F(CircuitBreakerTest, OpensOnSlowCalls) {
+    talkup_network::CircuitBreaker breaker(thresholds);
+
+    for (int i = 0; i < 4; i++)
+        call(breaker, true, 500000);
+    EXPECT_EQ(breaker.get_state(), State::OPEN);
+}
+
+/**
+ * @brief After the cooldown a single probe goes through; its success closes the breaker.
+ *
+ */
+TEST_F(CircuitBreakerTest, HalfOpenProbeCloses) {
+    talkup_network::CircuitBreaker breaker(thresholds);
+
+    for (int i = 0; i < 4; i++)
+        call(breaker, false, 1000);
+    now += std::chrono::milliseconds(1000);
+    EXPECT_TRUE(breaker.allow(now));
+    EXPECT_EQ(breaker.get_state(), State::HALF_OPEN);
+    EXPECT_FALSE(breaker.allow(now));
+    breaker.record(true, 1000, now);
+    EXPECT_EQ(breaker.get_state(), State::CLOSED);
+    EXPECT_TRUE(breaker.allow(now));
+}
+
+/**
+ * @brief A failed probe opens the breaker for another cooldown.
+ *
+ */
+TEST_F(CircuitBreakerTest, HalfOpenProbeFailureReopens) {
+    talkup_network::CircuitBreaker breaker(thresholds);
+
+    for (int i = 0; i < 4; i++)
+        call(breaker, false, 1000);
+    now += std::chrono::milliseconds(1000);
+    ASSERT_TRUE(breaker.allow(now));
+    breaker.record(false, 1000, now);
+    EXPECT_EQ(breaker.get_state(), State::OPEN);
+    EXPECT_FALSE(breaker.allow(now + std::chrono::milliseconds(500)));
+}
+
+/**
+ * @brief The p95 comes from the successful calls, with a fallback until there are enough.
+ *
+ */
+TEST_F(CircuitBreakerTest, LatencyP95) {
+    talkup_network::CircuitBreaker breaker(thresholds);
+
+    EXPECT_EQ(breaker.get_latency_p95_us(42), 42);
+    for (int i = 1; i <= 20; i++)
+        call(breaker, true, i * 1000);
+    EXPECT_EQ(breaker.get_latency_p95_us(42), 19000);
+}
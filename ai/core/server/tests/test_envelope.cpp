@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <crow.h>
+#include "Envelope.hpp"
+#include "MessageArena.hpp"
+
+using talkup_network::Envelope;
+using Encoding = Envelope::Encoding;
+
+namespace {
+    // Keeps the frames sent on the connection and their kind.
+    class FakeConnection : public crow::websocket::connection {
+        public:
+            void send_binary(const std::string &msg) override { frames.emplace_back(msg, true); }
+            void send_text(const std::string &msg) override { frames.emplace_back(msg, false); }
+            void send_ping(const std::string &) override {}
+            void send_pong(const std::string &) override {}
+            void close(const std::string &) override {}
+            std::string get_remote_ip() override { return "127.0.0.1"; }
+
+            std::vector<std::pair<std::string, bool>> frames;
+    };
+
+    nlohmann::json make_message(void)
+    {
+        return { {"type", "stream_chunk"}, {"key", "test_key"}, {"stream_id", "stream"},
+            {"seq", 3}, {"timestamp", 1700000000},
+            {"data", nlohmann::json::binary({ 0, 1, 2, 255 })} };
+    }
+}
+
+// Test fixture for Envelope tests
+class EnvelopeTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+
+    void TearDown() override {}
+
+    talkup_network::MessageArena::Scope arena;
+};
+
+/**
+ * @brief The first encoding the client lists and the server knows is used,
+ * JSON when there is none.
+ *
+ */
+TEST_F(EnvelopeTest, NegotiatesEncoding) {
+    EXPECT_EQ(Envelope::negotiate({ {"encodings", { "cbor", "json" }} }), Encoding::CBOR);
+    EXPECT_EQ(Envelope::negotiate({ {"encodings", { "bson", "msgpack" }} }), Encoding::MSGPACK);
+    EXPECT_EQ(Envelope::negotiate({ {"encodings", { 42, "json", "cbor" }} }), Encoding::JSON);
+    EXPECT_EQ(Envelope::negotiate({ {"encodings", { "bson" }} }), Encoding::JSON);
+    EXPECT_EQ(Envelope::negotiate({ {"encodings", "cbor"} }), Encoding::JSON);
+    EXPECT_EQ(Envelope::negotiate({ {"type", "initialization"} }), Encoding::JSON);
+    EXPECT_EQ(Envelope::get_encoding_name(Encoding::CBOR), "cbor");
+    EXPECT_EQ(Envelope::get_encoding_name(Encoding::MSGPACK), "msgpack");
+    EXPECT_EQ(Envelope::get_encoding_name(Encoding::JSON), "json");
+
+    Encoding encoding = Encoding::JSON;
+    EXPECT_TRUE(Envelope::get_encoding("msgpack", encoding));
+    EXPECT_EQ(encoding, Encoding::MSGPACK);
+    EXPECT_FALSE(Envelope::get_encoding("bson", encoding));
+    EXPECT_EQ(encoding, Encoding::MSGPACK);
+}
+
+/**
+ * @brief A message encoded in CBOR or MessagePack decodes to the same
+ * message, raw bytes included, and the decoder tells which encoding it was.
+ *
+ */
+TEST_F(EnvelopeTest, RoundTripsBinaryEncodings) {
+    nlohmann::json message = make_message();
+
+    for (Encoding expected : { Encoding::CBOR, Encoding::MSGPACK }) {
+        Encoding encoding = Encoding::JSON;
+        auto decoded = Envelope::decode(Envelope::encode(message, expected), true, encoding);
+
+        EXPECT_EQ(encoding, expected);
+        EXPECT_EQ(decoded["type"], "stream_chunk");
+        EXPECT_EQ(decoded["seq"], 3);
+        ASSERT_TRUE(decoded["data"].is_binary());
+        const auto &bytes = decoded["data"].get_binary();
+        EXPECT_EQ(std::vector<std::uint8_t>(bytes.begin(), bytes.end()),
+            std::vector<std::uint8_t>({ 0, 1, 2, 255 }));
+        EXPECT_EQ(Envelope::encode(decoded, expected), Envelope::encode(message, expected));
+    }
+}
+
+/**
+ * @brief Text frames are always JSON, whatever was negotiated, and a
+ * binary frame which isn't a CBOR or MessagePack map is refused.
+ *
+ */
+TEST_F(EnvelopeTest, FallsBackToJson) {
+    nlohmann::json message = { {"type", "ping"}, {"key", "test_key"} };
+    Encoding encoding = Encoding::CBOR;
+
+    auto decoded = Envelope::decode(message.dump(), false, encoding);
+    EXPECT_EQ(encoding, Encoding::JSON);
+    EXPECT_EQ(decoded["type"], "ping");
+    EXPECT_EQ(nlohmann::json::parse(Envelope::encode(message, Encoding::JSON)), message);
+    EXPECT_THROW(Envelope::decode("", true, encoding), std::exception);
+    EXPECT_THROW(Envelope::decode("\x01\x02", true, encoding), std::exception);
+    EXPECT_THROW(Envelope::decode("{not json", false, encoding), std::exception);
+}
+
+/**
+ * @brief A reply goes as a text frame in JSON and as a binary frame otherwise.
+ *
+ */
+TEST_F(EnvelopeTest, SendsFrameKind) {
+    FakeConnection conn;
+    nlohmann::json message = { {"type", "pong"}, {"data", "hello"} };
+
+    Envelope::send(conn, message, Encoding::JSON);
+    Envelope::send(conn, message, Encoding::CBOR);
+    Envelope::send(conn, message, Encoding::MSGPACK);
+    ASSERT_EQ(conn.frames.size(), 3u);
+    EXPECT_FALSE(conn.frames[0].second);
+    EXPECT_EQ(nlohmann::json::parse(conn.frames[0].first), message);
+    EXPECT_TRUE(conn.frames[1].second);
+    EXPECT_EQ(nlohmann::json::from_cbor(conn.frames[1].first), message);
+    EXPECT_TRUE(conn.frames[2].second);
+    EXPECT_EQ(nlohmann::json::from_msgpack(conn.frames[2].first), message);
+}
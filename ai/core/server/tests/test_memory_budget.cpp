@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "MemoryBudget.hpp"
+#include "ServerMetrics.hpp"
+
+using Budget = talkup_network::MemoryBudget;
+using Pool = talkup_network::MemoryBudget::Pool;
+
+// Test fixture for MemoryBudget tests
+class MemoryBudgetTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        options.limit = 1000;
+        options.min_idle = std::chrono::milliseconds(0);
+    }
+
+    void TearDown() override {
+        talkup_network::ServerMetrics::memory_used = 0;
+        talkup_network::ServerMetrics::memory_limit = 0;
+    }
+
+    Budget::Options options;
+};
+
+/**
+ * @brief Memory is accounted per stream and per pool, up to the cap.
+ *
+ */
+TEST_F(MemoryBudgetTest, AccountsUpToLimit) {
+    options.min_idle = std::chrono::hours(1);
+    Budget budget(options);
+
+    EXPECT_TRUE(budget.reserve("a", Pool::PENDING_AUDIO, 600));
+    budget.charge("b", Pool::STREAM_WINDOW, 300);
+    EXPECT_FALSE(budget.reserve("a", Pool::PENDING_AUDIO, 200));
+    EXPECT_EQ(budget.get_used(), 900u);
+    EXPECT_EQ(budget.get_used("a"), 600u);
+
+    auto report = budget.get_report();
+    EXPECT_EQ(report["limit"], 1000);
+    EXPECT_EQ(report["pools"]["pending_audio"], 600);
+    EXPECT_EQ(report["pools"]["stream_window"], 300);
+    EXPECT_EQ(report["rejected"], 1);
+
+    budget.release("a", Pool::PENDING_AUDIO, 600);
+    EXPECT_TRUE(budget.reserve("a", Pool::PENDING_AUDIO, 200));
+    EXPECT_EQ(budget.get_used(), 500u);
+}
+
+/**
+ * @brief Detached streams are evicted first, then the longest idle,
+ * and the cap is met as soon as enough was given back.
+ *
+ */
+TEST_F(MemoryBudgetTest, EvictsStalestFirst) {
+    Budget budget(options);
+    std::vector<std::string> evicted;
+
+    budget.set_evictor([&](const std::string &stream_id, bool detached) {
+        evicted.push_back(stream_id + (detached ? ":detached" : ""));
+        budget.release(stream_id, Pool::STREAM_WINDOW, 300);
+    });
+    budget.charge("old", Pool::STREAM_WINDOW, 300);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    budget.charge("recent", Pool::STREAM_WINDOW, 300);
+    budget.charge("gone", Pool::STREAM_WINDOW, 300);
+    budget.set_detached("gone", true);
+
+    EXPECT_TRUE(budget.reserve("new", Pool::PENDING_AUDIO, 300));
+    EXPECT_TRUE(budget.reserve("new", Pool::PENDING_AUDIO, 300));
+    ASSERT_EQ(evicted.size(), 2u);
+    EXPECT_EQ(evicted[0], "gone:detached");
+    EXPECT_EQ(evicted[1], "old");
+    EXPECT_EQ(budget.get_report()["evicted"], 2);
+}
+
+/**
+ * @brief Streams active within min_idle are never evicted: the chunk is refused.
+ *
+ */
+TEST_F(MemoryBudgetTest, KeepsActiveStreams) {
+    options.min_idle = std::chrono::hours(1);
+    Budget budget(options);
+    int evictions = 0;
+
+    budget.set_evictor([&](const std::string &, bool) { evictions++; });
+    budget.charge("active", Pool::STREAM_WINDOW, 900);
+    EXPECT_FALSE(budget.reserve("new", Pool::PENDING_AUDIO, 200));
+    EXPECT_EQ(evictions, 0);
+    budget.set_detached("active", true);
+    budget.reserve("new", Pool::PENDING_AUDIO, 200);
+    EXPECT_EQ(evictions, 1);
+}
+
+/**
+ * @brief A reservation gives its memory back when it is destroyed,
+ * and the usage is published for the load report.
+ *
+ */
+TEST_F(MemoryBudgetTest, ReleasesReservation) {
+    Budget budget(options);
+
+    ASSERT_TRUE(budget.reserve("a", Pool::PENDING_AUDIO, 500));
+    auto reservation = std::make_shared<Budget::Reservation>(budget, "a", Pool::PENDING_AUDIO, 500);
+    EXPECT_EQ(talkup_network::ServerMetrics::memory_used, 500);
+    EXPECT_GE(talkup_network::ServerMetrics::get_load(), 0.5);
+    reservation.reset();
+    EXPECT_EQ(budget.get_used(), 0u);
+    EXPECT_EQ(budget.get_used("a"), 0u);
+    EXPECT_EQ(budget.get_report()["streams"], 0);
+}
+
+/**
+ * @brief The estimate grows with the payload of a message.
+ *
+ */
+TEST_F(MemoryBudgetTest, EstimatesJson) {
+    nlohmann::json small = { {"type", "acknowledge"}, {"seq", 1} };
+    nlohmann::json large = small;
+
+    large["data"] = std::string(10000, 'x');
+    EXPECT_GT(Budget::estimate(small), 2 * sizeof(nlohmann::json));
+    EXPECT_GE(Budget::estimate(large), Budget::estimate(small) + 10000);
+}
+
+/**
+ * @brief The usage of a session follows its streams: what a stream holds
+ * moves with it to its new session, and leaves once it is forgotten.
+ *
+ */
+TEST_F(MemoryBudgetTest, CountsSessionUsage) {
+    Budget budget(options);
+    auto first = std::make_shared<std::atomic<int64_t>>(0);
+    auto second = std::make_shared<std::atomic<int64_t>>(0);
+
+    budget.charge("a", Pool::STREAM_WINDOW, 100);
+    budget.bind("a", first);
+    budget.bind("b", first);
+    budget.charge("b", Pool::PENDING_AUDIO, 50);
+    EXPECT_EQ(*first, 150);
+
+    budget.release("a", Pool::STREAM_WINDOW, 100);
+    budget.charge("a", Pool::STREAM_WINDOW, 30);
+    EXPECT_EQ(*first, 80);
+    budget.bind("a", second);
+    EXPECT_EQ(*first, 50);
+    EXPECT_EQ(*second, 30);
+
+    budget.forget("a");
+    EXPECT_EQ(*second, 0);
+    budget.release("a", Pool::STREAM_WINDOW, 30);
+    EXPECT_EQ(*second, 0);
+    EXPECT_EQ(budget.get_used(), 50u);
+    EXPECT_EQ(budget.get_report()["streams"], 1);
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <nlohmann/json.hpp>
+#include "MessageArena.hpp"
+#include "ServerMetrics.hpp"
+
+using talkup_network::ArenaAllocator;
+using talkup_network::MessageArena;
+using talkup_network::message_json;
+
+namespace {
+    message_json make_message(void)
+    {
+        message_json json;
+
+        json["type"] = "stream_chunk";
+        json["seq"] = 7;
+        json["data"] = message_json::array({ 1, 2, 3, 4 });
+        return json;
+    }
+}
+
+// Test fixture for MessageArena tests
+class MessageArenaTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+
+    void TearDown() override {}
+};
+
+/**
+ * @brief Inside a Scope the allocations come from the arena of the thread,
+ * outside of it from the heap.
+ *
+ */
+TEST_F(MessageArenaTest, AllocatesInScope) {
+    ArenaAllocator<int> allocator;
+    int *heap = allocator.allocate(4);
+
+    EXPECT_FALSE(MessageArena::local().owns(heap));
+    {
+        MessageArena::Scope arena;
+        int *value = allocator.allocate(4);
+
+        EXPECT_EQ(MessageArena::active(), &MessageArena::local());
+        EXPECT_TRUE(MessageArena::local().owns(value));
+        EXPECT_GT(MessageArena::local().get_allocations(), 0u);
+        allocator.deallocate(value, 4);
+    }
+    EXPECT_EQ(MessageArena::active(), nullptr);
+    allocator.deallocate(heap, 4);
+}
+
+/**
+ * @brief A message built and destroyed on the same thread, within its scope.
+ *
+ */
+TEST_F(MessageArenaTest, FreesOnSameThread) {
+    MessageArena::Scope arena;
+
+    for (int i = 0; i < 100; i++) {
+        message_json json = make_message();
+
+        EXPECT_EQ(json["seq"], 7);
+    }
+}
+
+/**
+ * @brief A message built in the arena of a thread is destroyed on another
+ * one, before and after its scope ended, and the heap only takes back its own.
+ *
+ */
+TEST_F(MessageArenaTest, FreesOnOtherThread) {
+    message_json during;
+    message_json after;
+    message_json heap = make_message();
+
+    {
+        MessageArena::Scope arena;
+
+        during = make_message();
+        after = make_message();
+        std::thread([json = std::move(during)]() mutable {
+            EXPECT_EQ(json["type"], "stream_chunk");
+            json = nullptr;
+        }).join();
+    }
+    std::thread([&after, &heap]() {
+        MessageArena::Scope arena;
+
+        EXPECT_EQ(after["data"].size(), 4u);
+        after = nullptr;
+        heap = nullptr;
+    }).join();
+}
+
+/**
+ * @brief A value kept after its scope isn't overwritten by the next
+ * messages: its blocks are left to it.
+ *
+ */
+TEST_F(MessageArenaTest, KeepsValuesOutlivingScope) {
+    message_json kept;
+
+    {
+        MessageArena::Scope arena;
+
+        kept = make_message();
+    }
+    for (int i = 0; i < 10; i++) {
+        MessageArena::Scope arena;
+        message_json other;
+
+        other["type"] = "overwrite";
+        other["seq"] = i;
+        other["data"] = message_json::array({ 9, 9, 9, 9 });
+    }
+    EXPECT_EQ(kept["type"], "stream_chunk");
+    EXPECT_EQ(kept["seq"], 7);
+    EXPECT_EQ(kept["data"], message_json::array({ 1, 2, 3, 4 }));
+}
+
+/**
+ * @brief The end of a scope reports its allocations and resets the counters;
+ * a nested scope belongs to the outer one.
+ *
+ */
+TEST_F(MessageArenaTest, ReportsAndResets) {
+    using talkup_network::ServerMetrics;
+    uint64_t messages = ServerMetrics::arena_messages.load();
+    uint64_t allocations = ServerMetrics::arena_allocations.load();
+    uint64_t bytes = ServerMetrics::arena_bytes.load();
+    size_t used = 0;
+
+    {
+        MessageArena::Scope arena;
+        message_json json = make_message();
+
+        {
+            MessageArena::Scope nested;
+            message_json inner = make_message();
+        }
+        EXPECT_EQ(ServerMetrics::arena_messages.load(), messages);
+        used = MessageArena::local().get_allocations();
+        EXPECT_GT(used, 0u);
+        EXPECT_GT(MessageArena::local().get_bytes(), 0u);
+    }
+    EXPECT_EQ(ServerMetrics::arena_messages.load(), messages + 1);
+    EXPECT_EQ(ServerMetrics::arena_allocations.load(), allocations + used);
+    EXPECT_GT(ServerMetrics::arena_bytes.load(), bytes);
+    EXPECT_EQ(MessageArena::local().get_allocations(), 0u);
+    EXPECT_EQ(MessageArena::local().get_bytes(), 0u);
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "MessageArena.hpp"
+#include "MessageSchema.hpp"
+#include "Messages.hpp"
+#include "WebsocketManager.hpp"
+
+namespace schema = talkup_network::schema;
+namespace messages = talkup_network::messages;
+
+namespace {
+    constexpr std::array<std::string_view, 10> TYPES = { "ping", "stream_chunk", "status",
+        "resume", "transcript_query", "stream_end", "subscribe", "unsubscribe", "speak", "interrupt" };
+    constexpr schema::PerfectHash<10> TYPE_HASH(TYPES);
+
+    // Built and looked up by the compiler.
+    static_assert(TYPE_HASH.find("transcript_query") == 4);
+    static_assert(TYPE_HASH.find("pong") == -1);
+    static_assert(messages::get_format("audio") == messages::Format::AUDIO);
+
+    int route_a(int value) { return value + 1; }
+    int route_b(int value) { return value * 2; }
+
+    nlohmann::json make_header(void)
+    {
+        return { {"type", "stream_chunk"}, {"key", "test_key"}, {"stream_id", "stream"},
+            {"format", "audio"}, {"timestamp", 1700000000}, {"data", "AAAA"} };
+    }
+}
+
+// Test fixture for MessageSchema tests
+class MessageSchemaTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+
+    void TearDown() override {}
+};
+
+/**
+ * @brief Every name has its own slot, and anything else is unknown,
+ * even when it hashes to a used slot.
+ *
+ */
+TEST_F(MessageSchemaTest, PerfectHashFindsEveryName) {
+    for (size_t i = 0; i < TYPES.size(); i++) {
+        EXPECT_EQ(TYPE_HASH.find(TYPES[i]), static_cast<int>(i));
+        EXPECT_EQ(TYPE_HASH.get_name(i), TYPES[i]);
+    }
+    EXPECT_EQ(TYPE_HASH.find(""), -1);
+    EXPECT_EQ(TYPE_HASH.find("pin"), -1);
+    EXPECT_EQ(TYPE_HASH.find("stream_chunks"), -1);
+    EXPECT_EQ(messages::get_format("text"), messages::Format::TEXT);
+    EXPECT_EQ(messages::get_format("video"), messages::Format::UNKNOWN);
+}
+
+/**
+ * @brief A dispatcher calls the handler of a name, and has none for the others.
+ *
+ */
+TEST_F(MessageSchemaTest, DispatchesByName) {
+    using Handler = int (*)(int);
+    constexpr auto dispatcher = schema::make_dispatcher<Handler>({
+        { "a", &route_a },
+        { "b", &route_b },
+    });
+
+    static_assert(dispatcher.find("a") == &route_a);
+    ASSERT_NE(dispatcher.find("b"), nullptr);
+    EXPECT_EQ(dispatcher.find("b")(21), 42);
+    EXPECT_EQ(dispatcher.find("c"), nullptr);
+}
+
+/**
+ * @brief The validator reports the first field missing or of the wrong type,
+ * the optional ones only when they have the wrong type.
+ *
+ */
+TEST_F(MessageSchemaTest, ValidatesHeader) {
+    nlohmann::json json = make_header();
+
+    EXPECT_EQ(schema::check<messages::Header>(json), "");
+    json.erase("stream_id");
+    EXPECT_EQ(schema::check<messages::Header>(json), "stream_id");
+    json = make_header();
+    json["key"] = 42;
+    EXPECT_EQ(schema::check<messages::Header>(json), "key");
+    json = make_header();
+    json["seq"] = "3";
+    EXPECT_FALSE(schema::validate<messages::Header>(json));
+    json["seq"] = 3;
+    EXPECT_TRUE(schema::validate<messages::Header>(json));
+    // data only has to be there, whatever it holds.
+    json["data"] = { {"text", "hello"} };
+    EXPECT_TRUE(schema::validate<messages::Header>(json));
+    EXPECT_FALSE(schema::validate<messages::Header>(nlohmann::json::array()));
+}
+
+/**
+ * @brief A message is read in place from a message_json, raw bytes from
+ * CBOR as well as Base64 from JSON.
+ *
+ */
+TEST_F(MessageSchemaTest, ParsesMessageJson) {
+    talkup_network::MessageArena::Scope arena;
+    nlohmann::json json = make_header();
+    messages::Header header;
+    messages::StreamChunk chunk;
+
+    json["seq"] = 7;
+    auto text = talkup_network::message_json::parse(json.dump());
+    ASSERT_TRUE(schema::parse(text, header));
+    EXPECT_EQ(header.type, "stream_chunk");
+    EXPECT_EQ(header.key, "test_key");
+    EXPECT_EQ(header.timestamp, 1700000000);
+    ASSERT_TRUE(header.seq.has_value());
+    EXPECT_EQ(*header.seq, 7);
+    ASSERT_TRUE(schema::parse(text, chunk));
+    EXPECT_EQ(chunk.data.value, std::string(3, '\0'));
+
+    json["data"] = nlohmann::json::binary({ 1, 2, 3, 4 });
+    auto binary = talkup_network::message_json::from_cbor(nlohmann::json::to_cbor(json));
+    ASSERT_TRUE(schema::parse(binary, chunk));
+    EXPECT_EQ(chunk.data.value, std::string("\x01\x02\x03\x04"));
+    EXPECT_EQ(chunk.seq, 7);
+
+    json.erase("seq");
+    ASSERT_TRUE(schema::parse(json, header));
+    EXPECT_FALSE(header.seq.has_value());
+    EXPECT_FALSE(schema::parse(json, chunk));
+}
+
+/**
+ * @brief Serialized messages have every field, but the optional ones
+ * without a value.
+ *
+ */
+TEST_F(MessageSchemaTest, SerializesMessages) {
+    talkup_network::WsManager::WebSocketConnectionInfo ack = { "acknowledge", "test_key",
+        "stream", "audio", 1700000000, "audio chunk received", {} };
+    messages::TaskRequest task;
+
+    auto json = schema::serialize(ack);
+    EXPECT_EQ(json, nlohmann::json({ {"type", "acknowledge"}, {"key", "test_key"},
+        {"stream_id", "stream"}, {"format", "audio"}, {"timestamp", 1700000000},
+        {"data", "audio chunk received"} }));
+    ack.seq = 3;
+    EXPECT_EQ(schema::serialize(ack)["seq"], 3);
+
+    task.services = { "stt" };
+    task.timestamp = 1700000000;
+    task.data = { {"format", "text"} };
+    json = schema::serialize(task);
+    EXPECT_EQ(json["type"], "task_request");
+    EXPECT_EQ(json["services"], nlohmann::json::array({ "stt" }));
+    EXPECT_EQ(json["data"]["format"], "text");
+    messages::TaskRequest read;
+    ASSERT_TRUE(schema::parse(json, read));
+    EXPECT_EQ(read.services, task.services);
+    EXPECT_EQ(read.data, task.data);
+}
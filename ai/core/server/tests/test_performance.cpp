@@ -0,0 +1,316 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <crow.h>
+#include <nlohmann/json.hpp>
+#include "CrowTransport.hpp"
+#include "MicroservicesManager.hpp"
+#include "ServicePool.hpp"
+#include "UringTransport.hpp"
+#include "ws_client.hpp"
+
+using namespace ws_client;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    const char *const KEY = "perf_key";
+
+    // Stands in for the audio microservices: each segment of a batch gets a one-word result.
+    class StubService {
+        public:
+            StubService(void) {
+                CROW_ROUTE(app, "/task").methods("POST"_method)([](const crow::request &req) {
+                    auto task = nlohmann::json::parse(req.body, nullptr, false);
+                    nlohmann::json results = nlohmann::json::array();
+
+                    if (task.is_object() && task.contains("data") && task["data"].contains("batch")) {
+                        for (const auto &item : task["data"]["batch"])
+                            results.push_back({ {"id", item["id"]}, {"text", "hello"},
+                                {"result", { { {"word", "hello"}, {"start", 0.0}, {"end", 0.02} } }} });
+                    }
+                    crow::response res(nlohmann::json{ {"type", "task_result"},
+                        {"data", { {"results", results} }} }.dump());
+                    res.set_header("Content-Type", "application/json");
+                    return res;
+                });
+                port = get_free_port();
+                server = app.port(port).concurrency(4).run_async();
+                app.wait_for_server_start();
+            }
+
+            ~StubService() {
+                app.stop();
+                server.wait();
+            }
+
+            crow::SimpleApp app;
+            decltype(app.run_async()) server;
+            int port = 0;
+    };
+
+    nlohmann::json thresholds;
+    std::unique_ptr<StubService> stub;
+}
+
+// Test fixture for the performance tests: the real routes on an ephemeral port,
+// driven by many clients, against the thresholds of thresholds.json.
+class PerformanceTest : public ::testing::TestWithParam<std::string> {
+protected:
+    struct Report {
+        size_t requests = 0;
+        size_t failures = 0;
+        double per_sec = 0;
+        double p99_ms = 0;
+    };
+
+    // Runs in tests/performance, next to thresholds.json and rate_limits.json.
+    static void SetUpTestSuite() {
+        std::ifstream file("thresholds.json");
+        auto services = std::filesystem::temp_directory_path() / "talkup_perf_services.json";
+
+        ASSERT_TRUE(file.is_open()) << "thresholds.json not found";
+        file >> thresholds;
+        stub = std::make_unique<StubService>();
+        std::string url = "http://127.0.0.1:" + std::to_string(stub->port) + "/";
+        std::ofstream(services) << nlohmann::json{
+            {"stt", { {"Url", url}, {"BatchSize", 16}, {"BatchBudgetMs", 5} }},
+            {"ba", { {"Url", url} }} }.dump();
+        talkup_network::MicroservicesManager::load_microservices_info(services.string());
+        talkup_network::ServicePool::open_pools();
+        std::filesystem::remove(services);
+    }
+
+    static void TearDownTestSuite() {
+        stub.reset();
+    }
+
+    void SetUp() override {
+        setenv("COMMUNICATION", KEY, 1);
+        setenv("WS_ADDRESS", "ws://localhost/ws", 1);
+        if (GetParam() == "io_uring") {
+            if (!talkup_network::UringTransport::is_supported())
+                GTEST_SKIP() << "io_uring is not supported here";
+            transport = std::make_unique<talkup_network::UringTransport>();
+        } else {
+            transport = std::make_unique<talkup_network::CrowTransport>();
+        }
+        port = get_free_port();
+        server_thread = std::thread([this]() { transport->run(router, port); });
+        transport->wait_for_start();
+        clients = thresholds.value("clients", 16);
+        requests = thresholds.value("requests_per_client", 200);
+    }
+
+    void TearDown() override {
+        if (!transport)
+            return;
+        transport->stop();
+        server_thread.join();
+    }
+
+    // Runs every client on its own thread; each one times its requests.
+    Report run(const std::function<size_t(int client, std::vector<double> &latencies_ms)> &client) {
+        std::vector<std::vector<double>> latencies(clients);
+        std::vector<std::thread> threads;
+        std::atomic<size_t> failures{0};
+        auto start = Clock::now();
+        Report report;
+
+        for (int i = 0; i < clients; i++)
+            threads.emplace_back([&, i]() { failures += client(i, latencies[i]); });
+        for (auto &thread : threads)
+            thread.join();
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        std::vector<double> all;
+
+        for (const auto &part : latencies)
+            all.insert(all.end(), part.begin(), part.end());
+        std::sort(all.begin(), all.end());
+        report.requests = all.size();
+        report.failures = failures;
+        report.per_sec = all.size() / elapsed;
+        if (!all.empty())
+            report.p99_ms = all[std::min(all.size() - 1, all.size() * 99 / 100)];
+        return report;
+    }
+
+    void check(const std::string &scenario, const Report &report) {
+        const auto &limits = thresholds["scenarios"][scenario];
+
+        std::cout << "[PERF] " << GetParam() << " " << scenario << ": " << report.per_sec
+            << " req/s, p99 " << report.p99_ms << " ms" << std::endl;
+        EXPECT_EQ(report.failures, 0u);
+        EXPECT_EQ(report.requests, static_cast<size_t>(clients * requests));
+        EXPECT_GE(report.per_sec, limits["min_per_sec"].get<double>()) << scenario;
+        EXPECT_LE(report.p99_ms, limits["max_p99_ms"].get<double>()) << scenario;
+    }
+
+    int ws_open(void) {
+        int fd = ws_connect(port);
+        timeval timeout = {5, 0};
+
+        if (fd >= 0)
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        return fd;
+    }
+
+    std::string ws_message(const std::string &type, const std::string &stream_id,
+        const std::string &format, const std::string &data, int64_t seq = -1) {
+        nlohmann::json message;
+
+        message["type"] = type;
+        message["key"] = KEY;
+        message["stream_id"] = stream_id;
+        message["format"] = format;
+        message["timestamp"] = 0;
+        message["data"] = data;
+        if (seq >= 0)
+            message["seq"] = seq;
+        return message.dump();
+    }
+
+    static double since_ms(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    talkup_network::Router router;
+    std::unique_ptr<ITransport> transport;
+    std::thread server_thread;
+    int port = 0;
+    int clients = 0;
+    int requests = 0;
+};
+
+/**
+ * @brief ping round-trips from many connections at once.
+ *
+ */
+TEST_P(PerformanceTest, Ping) {
+    auto report = run([this](int client, std::vector<double> &latencies) {
+        int fd = ws_open();
+        size_t failures = 0;
+
+        if (fd < 0)
+            return size_t(requests);
+        for (int i = 0; i < requests; i++) {
+            auto start = Clock::now();
+
+            ws_send(fd, ws_message("ping", "perf-" + std::to_string(client), "text", "hello"));
+            auto reply = nlohmann::json::parse(ws_receive(fd), nullptr, false);
+            if (!reply.is_object() || reply.value("type", "") != "pong") {
+                failures++;
+                continue;
+            }
+            latencies.push_back(since_ms(start));
+        }
+        close(fd);
+        return failures;
+    });
+
+    check("ping", report);
+}
+
+/**
+ * @brief Audio chunks are acknowledged on the hot path, and each one gets its
+ * transcript and analysis back from the stub services.
+ *
+ */
+TEST_P(PerformanceTest, StreamChunk) {
+    // 20 ms of 16 kHz PCM16.
+    std::string samples(640, '\0');
+    std::string audio = crow::utility::base64encode(
+        reinterpret_cast<const unsigned char *>(samples.data()), samples.size());
+
+    auto report = run([this, &audio](int client, std::vector<double> &latencies) {
+        std::string stream_id = "perf-" + std::to_string(client);
+        int fd = ws_open();
+        size_t failures = 0;
+        int results = 0;
+
+        if (fd < 0)
+            return size_t(requests);
+        auto receive = [&]() {
+            auto reply = nlohmann::json::parse(ws_receive(fd), nullptr, false);
+            std::string type = reply.is_object() ? reply.value("type", "") : "";
+
+            if (type == "transcript" || type == "analysis_result")
+                results++;
+            else if (type != "acknowledge")
+                failures++;
+            return reply;
+        };
+        for (int i = 0; i < requests; i++) {
+            auto start = Clock::now();
+            bool acked = false;
+
+            ws_send(fd, ws_message("stream_chunk", stream_id, "audio", audio, i));
+            while (!acked) {
+                auto reply = receive();
+
+                if (!reply.is_object())
+                    break;
+                acked = reply.value("type", "") == "acknowledge" && reply.value("seq", -1) == i;
+            }
+            if (!acked) {
+                failures++;
+                break;
+            }
+            latencies.push_back(since_ms(start));
+        }
+        // One transcript (stt) and one analysis (ba) per chunk.
+        while (failures == 0 && results < 2 * requests && receive().is_object());
+        if (results != 2 * requests)
+            failures++;
+        close(fd);
+        return failures;
+    });
+
+    check("stream_chunk", report);
+}
+
+/**
+ * @brief /process/initialization requests, each on a new connection.
+ *
+ */
+TEST_P(PerformanceTest, Initialization) {
+    std::string body = nlohmann::json{ {"key", KEY}, {"type", "initialization"},
+        {"format", "text"} }.dump();
+    std::string request = "POST /process/initialization HTTP/1.1\r\nHost: localhost\r\n"
+        "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size())
+        + "\r\nConnection: close\r\n\r\n" + body;
+
+    auto report = run([this, &request](int, std::vector<double> &latencies) {
+        size_t failures = 0;
+
+        for (int i = 0; i < requests; i++) {
+            auto start = Clock::now();
+            std::string response = http_request(port, request);
+
+            if (response.find(" 200 ") == std::string::npos) {
+                failures++;
+                continue;
+            }
+            latencies.push_back(since_ms(start));
+        }
+        return failures;
+    });
+
+    check("initialization", report);
+}
+
+INSTANTIATE_TEST_SUITE_P(Transports, PerformanceTest, ::testing::Values("crow", "io_uring"),
+    [](const ::testing::TestParamInfo<std::string> &info) {
+        return info.param == "io_uring" ? std::string("IoUring") : std::string("Crow");
+    });
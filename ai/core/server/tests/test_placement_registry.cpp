@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include <crow.h>
+#include "ConnectionContext.hpp"
+#include "PlacementRegistry.hpp"
+#include "Router.hpp"
+
+using Registry = talkup_network::PlacementRegistry;
+
+// Test fixture for PlacementRegistry tests
+class PlacementRegistryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char dir[] = "/tmp/talkup_placement_XXXXXX";
+
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        directory = dir;
+        options.directory = directory;
+        options.id = "self";
+        options.address = "ws://self/ws";
+        options.secret = "secret";
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    // What another instance would have published.
+    void write_instance(const std::string &id, int64_t sessions, double cpu,
+        int64_t queue_depth, int64_t age_ms = 0) {
+        int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        nlohmann::json entry = { {"id", id}, {"address", "ws://" + id + "/ws"},
+            {"sessions", sessions}, {"cpu", cpu}, {"queue_depth", queue_depth},
+            {"updated_ms", now - age_ms} };
+        std::ofstream file(directory + "/" + id + ".json");
+
+        file << entry.dump();
+    }
+
+    std::string directory;
+    Registry::Options options;
+};
+
+/**
+ * @brief A new session goes to the instance with the lowest load,
+ * sessions, CPU and queue depth together.
+ *
+ */
+TEST_F(PlacementRegistryTest, PlacesOnLeastLoaded) {
+    Registry registry;
+
+    registry.configure(options);
+    write_instance("sessions", 800, 0.1, 0);
+    write_instance("cpu", 10, 0.9, 0);
+    write_instance("queue", 10, 0.1, 30);
+    write_instance("idle", 50, 0.2, 2);
+
+    auto instance = registry.place();
+    EXPECT_EQ(instance.id, "idle");
+    EXPECT_EQ(instance.address, "ws://idle/ws");
+    EXPECT_EQ(registry.place("cpu").id, "cpu");
+}
+
+/**
+ * @brief Instances which stopped publishing are left out, and this one is
+ * used when no other is there.
+ *
+ */
+TEST_F(PlacementRegistryTest, IgnoresStaleInstances) {
+    Registry registry;
+
+    registry.configure(options);
+    write_instance("gone", 0, 0, 0, 60000);
+    EXPECT_TRUE(registry.get_instances().empty());
+    EXPECT_EQ(registry.place("gone").id, "self");
+
+    ASSERT_TRUE(registry.publish());
+    auto instances = registry.get_instances();
+    ASSERT_EQ(instances.size(), 1u);
+    EXPECT_EQ(instances[0].address, "ws://self/ws");
+    registry.withdraw();
+    EXPECT_TRUE(registry.get_instances().empty());
+}
+
+/**
+ * @brief Sessions placed since the last publication count, so a burst is spread.
+ *
+ */
+TEST_F(PlacementRegistryTest, SpreadsBurst) {
+    Registry registry;
+
+    registry.configure(options);
+    write_instance("a", 0, 0, 0);
+    write_instance("b", 0, 0, 0);
+    std::string first = registry.place().id;
+    std::string second = registry.place().id;
+    EXPECT_NE(first, second);
+}
+
+/**
+ * @brief A token is only accepted by the instance it names, intact,
+ * signed with the shared secret and before it expires.
+ *
+ */
+TEST_F(PlacementRegistryTest, ValidatesTokens) {
+    Registry registry;
+    Registry other;
+
+    registry.configure(options);
+    options.id = "other";
+    other.configure(options);
+    std::string token = registry.issue_token("self");
+    EXPECT_TRUE(registry.validate_token(token));
+    EXPECT_FALSE(other.validate_token(token));
+    EXPECT_TRUE(other.validate_token(registry.issue_token("other")));
+
+    std::string tampered = token;
+    tampered[tampered.find('.') + 1] = tampered[tampered.find('.') + 1] == '9' ? '8' : '9';
+    EXPECT_FALSE(registry.validate_token(tampered));
+    EXPECT_FALSE(registry.validate_token("self"));
+    EXPECT_FALSE(registry.validate_token(""));
+
+    Registry forged;
+    options.id = "self";
+    options.secret = "guessed";
+    forged.configure(options);
+    EXPECT_FALSE(registry.validate_token(forged.issue_token("self")));
+
+    Registry expiring;
+    options.secret = "secret";
+    options.token_ttl = std::chrono::milliseconds(1);
+    expiring.configure(options);
+    token = expiring.issue_token("self");
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_FALSE(registry.validate_token(token));
+}
+
+/**
+ * @brief A token is used once, and its nonce is forgotten once it expired.
+ *
+ */
+TEST_F(PlacementRegistryTest, RefusesReplayedTokens) {
+    Registry registry;
+    Registry unsigned_registry;
+
+    options.token_ttl = std::chrono::milliseconds(50);
+    registry.configure(options);
+    std::string token = registry.issue_token("self");
+    EXPECT_TRUE(registry.validate_token(token));
+    EXPECT_FALSE(registry.validate_token(token));
+    EXPECT_TRUE(registry.validate_token(registry.issue_token("self")));
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_FALSE(registry.validate_token(token));
+    EXPECT_TRUE(registry.validate_token(registry.issue_token("self")));
+
+    options.secret = "";
+    unsigned_registry.configure(options);
+    EXPECT_FALSE(unsigned_registry.is_enabled());
+}
+
+/**
+ * @brief HMAC-SHA1 matches the RFC 2202 test vector.
+ *
+ */
+TEST_F(PlacementRegistryTest, SignsWithHmac) {
+    EXPECT_EQ(Registry::sign("Jefe", "what do ya want for nothing?"),
+        "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79");
+}
+
+/**
+ * @brief /process/initialization hands out the chosen address with a token,
+ * which /ws then requires.
+ *
+ */
+TEST_F(PlacementRegistryTest, RouterPlacesAndChecksToken) {
+    setenv("COMMUNICATION", "test_key", 1);
+    setenv("WS_ADDRESS", "ws://self/ws", 1);
+    setenv("PLACEMENT_REGISTRY_DIR", directory.c_str(), 1);
+    setenv("PLACEMENT_INSTANCE_ID", "self", 1);
+    setenv("PLACEMENT_SECRET", "secret", 1);
+    {
+        talkup_network::Router router;
+        crow::request req;
+        crow::request upgrade;
+
+        router.init();
+        req.method = crow::HTTPMethod::Post;
+        req.body = R"({"key":"test_key","type":"initialization","format":"text"})";
+        auto response = nlohmann::json::parse(router.handle_initialization(req).body);
+        std::string token = response["placement"]["token"];
+        EXPECT_EQ(response["placement"]["instance"], "self");
+        EXPECT_EQ(response["data"], "ws://self/ws?placement=" + token);
+
+        upgrade.raw_url = "/ws?placement=" + token;
+        EXPECT_TRUE(router.on_ws_accept(upgrade));
+        EXPECT_FALSE(router.on_ws_accept(upgrade));
+        upgrade.raw_url = "/ws";
+        EXPECT_FALSE(router.on_ws_accept(upgrade));
+        upgrade.raw_url = "/ws?placement=" + Registry().issue_token("self");
+        EXPECT_FALSE(router.on_ws_accept(upgrade));
+    }
+    EXPECT_FALSE(std::filesystem::exists(directory + "/self.json"));
+    unsetenv("PLACEMENT_REGISTRY_DIR");
+    unsetenv("PLACEMENT_INSTANCE_ID");
+    unsetenv("PLACEMENT_SECRET");
+}
+
+/**
+ * @brief Without PLACEMENT_SECRET the placement stays off: the server key
+ * is known to the clients.
+ *
+ */
+TEST_F(PlacementRegistryTest, RouterNeedsSecret) {
+    setenv("COMMUNICATION", "test_key", 1);
+    setenv("WS_ADDRESS", "ws://self/ws", 1);
+    setenv("PLACEMENT_REGISTRY_DIR", directory.c_str(), 1);
+    unsetenv("PLACEMENT_SECRET");
+    {
+        talkup_network::Router router;
+        crow::request req;
+        crow::request upgrade;
+
+        router.init();
+        req.method = crow::HTTPMethod::Post;
+        req.body = R"({"key":"test_key","type":"initialization","format":"text"})";
+        auto response = nlohmann::json::parse(router.handle_initialization(req).body);
+        EXPECT_EQ(response["data"], "ws://self/ws");
+        EXPECT_FALSE(response.contains("placement"));
+        upgrade.raw_url = "/ws";
+        EXPECT_TRUE(router.on_ws_accept(upgrade));
+    }
+    unsetenv("PLACEMENT_REGISTRY_DIR");
+}
+
+/**
+ * @brief The negotiated encoding goes in the /ws address, and the context
+ * of the connection is created with it when the upgrade is accepted.
+ *
+ */
+TEST_F(PlacementRegistryTest, RouterBindsEncoding) {
+    setenv("COMMUNICATION", "test_key", 1);
+    setenv("WS_ADDRESS", "ws://self/ws", 1);
+    unsetenv("PLACEMENT_SECRET");
+    {
+        talkup_network::Router router;
+        crow::request req;
+        crow::request upgrade;
+        void *userdata = nullptr;
+
+        router.init();
+        req.method = crow::HTTPMethod::Post;
+        req.body = R"({"key":"test_key","type":"initialization","format":"text","encodings":["cbor"]})";
+        auto response = nlohmann::json::parse(router.handle_initialization(req).body);
+        EXPECT_EQ(response["encoding"], "cbor");
+        EXPECT_EQ(response["data"], "ws://self/ws?encoding=cbor");
+
+        upgrade.raw_url = "/ws?encoding=cbor";
+        ASSERT_TRUE(router.on_ws_accept(upgrade, &userdata));
+        auto *context = static_cast<talkup_network::ConnectionContext *>(userdata);
+        ASSERT_NE(context, nullptr);
+        EXPECT_EQ(context->encoding, talkup_network::Envelope::Encoding::CBOR);
+        delete context;
+
+        userdata = nullptr;
+        upgrade.raw_url = "/ws?encoding=bson";
+        EXPECT_FALSE(router.on_ws_accept(upgrade, &userdata));
+        EXPECT_EQ(userdata, nullptr);
+    }
+}
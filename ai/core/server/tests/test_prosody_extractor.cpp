@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ProsodyExtractor.hpp"
+
+using Extractor = talkup_network::ProsodyExtractor;
+
+// Test fixture for ProsodyExtractor tests
+class ProsodyExtractorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+    }
+
+    void TearDown() override {
+    }
+
+    // Appends a sine (amplitude 0 for silence) as 16 kHz PCM16.
+    void tone(std::string &pcm, double frequency, double amplitude, int duration_ms) {
+        size_t count = static_cast<size_t>(duration_ms) * Extractor::SAMPLE_RATE / 1000;
+
+        for (size_t i = 0; i < count; i++, phase++) {
+            auto sample = static_cast<int16_t>(std::lround(amplitude * 32767
+                * std::sin(2 * M_PI * frequency * phase / Extractor::SAMPLE_RATE)));
+            pcm.push_back(static_cast<char>(sample & 0xff));
+            pcm.push_back(static_cast<char>((sample >> 8) & 0xff));
+        }
+    }
+
+    size_t phase = 0;
+};
+
+/**
+ * @brief A steady tone is voiced at its pitch and loudness, silence isn't.
+ *
+ */
+TEST_F(ProsodyExtractorTest, MeasuresToneAndSilence) {
+    Extractor extractor;
+    std::string pcm;
+
+    tone(pcm, 200, 0.5, 200);
+    tone(pcm, 0, 0, 200);
+    auto features = extractor.push(pcm);
+
+    ASSERT_EQ(features.frames.size(), 20u);
+    for (size_t i = 1; i < 10; i++) {
+        EXPECT_EQ(features.frames[i].start_ms, static_cast<int64_t>(i) * 20);
+        EXPECT_TRUE(features.frames[i].voiced);
+        EXPECT_NEAR(features.frames[i].pitch_hz, 200, 2);
+        EXPECT_NEAR(features.frames[i].rms_db, -9.03, 0.5);
+        EXPECT_NEAR(features.frames[i].zcr, 2 * 200.0 / Extractor::SAMPLE_RATE, 0.005);
+    }
+    for (size_t i = 11; i < 20; i++) {
+        EXPECT_TRUE(features.frames[i].silent);
+        EXPECT_FALSE(features.frames[i].voiced);
+        EXPECT_EQ(features.frames[i].pitch_hz, 0);
+    }
+}
+
+/**
+ * @brief The audio can come in pieces of any size, odd ones included.
+ *
+ */
+TEST_F(ProsodyExtractorTest, StreamsInPieces) {
+    Extractor whole;
+    Extractor pieces;
+    std::string pcm;
+    std::vector<Extractor::Frame> frames;
+
+    tone(pcm, 150, 0.3, 500);
+    auto expected = whole.push(pcm).frames;
+    for (size_t offset = 0; offset < pcm.size(); offset += 777) {
+        auto part = pieces.push(std::string_view(pcm).substr(offset, 777));
+        frames.insert(frames.end(), part.frames.begin(), part.frames.end());
+    }
+    ASSERT_EQ(frames.size(), expected.size());
+    for (size_t i = 0; i < frames.size(); i++) {
+        EXPECT_EQ(frames[i].start_ms, expected[i].start_ms);
+        EXPECT_FLOAT_EQ(frames[i].rms_db, expected[i].rms_db);
+        EXPECT_FLOAT_EQ(frames[i].pitch_hz, expected[i].pitch_hz);
+    }
+}
+
+/**
+ * @brief A silence between two stretches of speech is a pause, a short gap isn't.
+ *
+ */
+TEST_F(ProsodyExtractorTest, DetectsPauses) {
+    Extractor extractor;
+    std::string pcm;
+
+    tone(pcm, 0, 0, 300);
+    tone(pcm, 180, 0.4, 500);
+    tone(pcm, 0, 0, 100);
+    tone(pcm, 180, 0.4, 300);
+    tone(pcm, 0, 0, 400);
+    tone(pcm, 180, 0.4, 300);
+    auto features = extractor.push(pcm);
+
+    ASSERT_EQ(features.pauses.size(), 1u);
+    EXPECT_NEAR(features.pauses[0].start_ms, 1200, 40);
+    EXPECT_NEAR(features.pauses[0].duration_ms, 400, 40);
+}
+
+/**
+ * @brief Bursts of voice count as syllables, per second of speech.
+ *
+ */
+TEST_F(ProsodyExtractorTest, EstimatesSpeakingRate) {
+    Extractor extractor;
+    std::string pcm;
+
+    // 4 syllables of 160 ms per second, 640 ms of speech: 6.25 per second of speech.
+    for (int i = 0; i < 20; i++) {
+        tone(pcm, 160, 0.4, 160);
+        tone(pcm, 0, 0, 90);
+    }
+    auto features = extractor.push(pcm);
+
+    EXPECT_NEAR(features.speaking_rate, 6.25, 1.0);
+}
+
+/**
+ * @brief The features of a second of audio weigh far less than its samples.
+ *
+ */
+TEST_F(ProsodyExtractorTest, EncodesCompactly) {
+    Extractor extractor;
+    std::string pcm;
+
+    tone(pcm, 200, 0.5, 1000);
+    auto json = Extractor::to_json(extractor.push(pcm));
+
+    EXPECT_EQ(json["rms_db"].size(), 50u);
+    EXPECT_EQ(json["frame_ms"], 20);
+    EXPECT_EQ(json["start_ms"], 0);
+    EXPECT_LT(json.dump().size() * 10, pcm.size());
+}
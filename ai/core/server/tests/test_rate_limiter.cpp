@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include "RateLimiter.hpp"
+
+using Clock = talkup_network::RateLimiter::Clock;
+
+// Test fixture for RateLimiter tests
+class RateLimiterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        now = Clock::now();
+    }
+
+    void TearDown() override {
+    }
+
+    talkup_network::RateLimiter limiter;
+    Clock::time_point now;
+};
+
+/**
+ * @brief A connection can send its burst, then has to wait for the refill.
+ *
+ */
+TEST_F(RateLimiterTest, ConnectionBurstThenRefill) {
+    talkup_network::RateLimiter::Buckets connection;
+    const auto &limits = limiter.get_service_class("k").connection;
+    int burst = static_cast<int>(limits.messages_per_sec * limits.burst);
+
+    for (int i = 0; i < burst; i++)
+        EXPECT_TRUE(limiter.admit("k", "10.0.0.1", connection, 10, now).allowed);
+    auto decision = limiter.admit("k", "10.0.0.1", connection, 10, now);
+    EXPECT_FALSE(decision.allowed);
+    EXPECT_EQ(decision.scope, talkup_network::RateLimiter::Scope::CONNECTION);
+    EXPECT_GT(decision.retry_after_ms, 0);
+    EXPECT_TRUE(limiter.admit("k", "10.0.0.1", connection, 10, now + std::chrono::seconds(1)).allowed);
+}
+
+/**
+ * @brief Every client presents the same key: the key scope is off unless
+ * rate_limits.json sets it.
+ *
+ */
+TEST_F(RateLimiterTest, KeyScopeOffByDefault) {
+    const auto &service_class = limiter.get_service_class("k");
+    int conn_burst = static_cast<int>(
+        service_class.connection.messages_per_sec * service_class.connection.burst);
+
+    EXPECT_EQ(service_class.key.messages_per_sec, 0);
+    for (int round = 0; round < 100; round++) {
+        talkup_network::RateLimiter::Buckets connection;
+
+        for (int i = 0; i < conn_burst; i++)
+            ASSERT_TRUE(limiter.admit("k", "10.0.0.1", connection, 10, now).allowed);
+    }
+}
+
+/**
+ * @brief The key bucket is shared by all the connections of a client,
+ * and each client using the key has its own.
+ *
+ */
+TEST_F(RateLimiterTest, KeySharedAcrossClientConnections) {
+    auto file = std::filesystem::temp_directory_path() / "talkup_rate_limits.json";
+    std::ofstream(file) << nlohmann::json{ {"classes", { {"default", {
+        {"key", { {"messages_per_sec", 200}, {"bytes_per_sec", 1 << 20}, {"burst", 2} }} }} }} }.dump();
+    limiter.load_limits(file.string());
+    std::filesystem::remove(file);
+    const auto &service_class = limiter.get_service_class("k");
+    int key_burst = static_cast<int>(service_class.key.messages_per_sec * service_class.key.burst);
+    int conn_burst = static_cast<int>(
+        service_class.connection.messages_per_sec * service_class.connection.burst);
+    talkup_network::RateLimiter::Decision decision;
+
+    ASSERT_EQ(key_burst, 400);
+    for (int sent = 0; sent <= key_burst; sent += conn_burst) {
+        talkup_network::RateLimiter::Buckets connection;
+
+        for (int i = 0; i < conn_burst && decision.allowed; i++)
+            decision = limiter.admit("k", "10.0.0.1", connection, 10, now);
+    }
+    EXPECT_FALSE(decision.allowed);
+    EXPECT_EQ(decision.scope, talkup_network::RateLimiter::Scope::KEY);
+
+    talkup_network::RateLimiter::Buckets other;
+    EXPECT_TRUE(limiter.admit("k", "10.0.0.2", other, 10, now).allowed);
+}
+
+/**
+ * @brief A message bigger than the byte bucket passes once, then the bucket is in debt.
+ *
+ */
+TEST_F(RateLimiterTest, OversizedMessageGoesIntoDebt) {
+    talkup_network::RateLimiter::Buckets connection;
+    const auto &limits = limiter.get_service_class("k").connection;
+    size_t oversized = static_cast<size_t>(limits.bytes_per_sec * limits.burst) * 2;
+
+    EXPECT_TRUE(limiter.admit("k", "10.0.0.1", connection, oversized, now).allowed);
+    EXPECT_FALSE(limiter.admit("k", "10.0.0.1", connection, 1, now).allowed);
+}
@@ -3,6 +3,7 @@
 #include <thread>
 #include <chrono>
 #include <crow.h>
+#include "CrowTransport.hpp"
 #include "Server.hpp"
 
 // Mock class for Server
@@ -11,7 +12,7 @@ public:
     MockServer(const std::string &name, const std::string &version, int port)
         : talkup_network::Server(name, version, port) {}
 
-    MOCK_METHOD(bool, start_server, (crow::SimpleApp &app), (override));
+    MOCK_METHOD(bool, start_server, (ITransport &transport), (override));
     MOCK_METHOD(std::string, get_name, (), (const));
     MOCK_METHOD(std::string, get_version, (), (const));
     MOCK_METHOD(int, get_port, (), (const));
@@ -33,7 +34,7 @@ protected:
  */
 TEST_F(ServerTest, ServerInitialization) {
     MockServer server("TalkUp.AI Server", "1.0.0", 8088);
-    crow::SimpleApp app;
+    talkup_network::CrowTransport transport;
 
     EXPECT_CALL(server, get_name())
         .WillOnce(::testing::Return("TalkUp.AI Server"));
@@ -44,11 +45,11 @@ TEST_F(ServerTest, ServerInitialization) {
     EXPECT_CALL(server, get_port())
         .WillOnce(::testing::Return(8088));
 
-    EXPECT_CALL(server, start_server(::testing::Ref(app)))
+    EXPECT_CALL(server, start_server(::testing::Ref(transport)))
         .Times(1);
 
     std::thread server_thread([&]() {
-        server.start_server(app);
+        server.start_server(transport);
     });
     EXPECT_EQ(server.get_name(), "TalkUp.AI Server");
     EXPECT_EQ(server.get_version(), "1.0.0");
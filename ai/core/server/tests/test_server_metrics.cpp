@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "ServerMetrics.hpp"
+
+using talkup_network::ServerMetrics;
+
+// Test fixture for ServerMetrics tests
+class ServerMetricsTest : public ::testing::Test {
+protected:
+    // The counters are global: the other tests of the binary find them as they were.
+    void SetUp() override {
+        connections = ServerMetrics::open_connections.exchange(0);
+        memory_used = ServerMetrics::memory_used.exchange(0);
+        memory_limit = ServerMetrics::memory_limit.exchange(0);
+    }
+
+    void TearDown() override {
+        ServerMetrics::open_connections = connections;
+        ServerMetrics::memory_used = memory_used;
+        ServerMetrics::memory_limit = memory_limit;
+    }
+
+    int64_t connections = 0;
+    int64_t memory_used = 0;
+    int64_t memory_limit = 0;
+};
+
+/**
+ * @brief The requests of a service are counted, failed, hedged and batched
+ * ones included, and an unknown service is ignored.
+ *
+ */
+TEST_F(ServerMetricsTest, CountsServiceRequests) {
+    ServerMetrics::register_service("metrics_counts");
+    ServerMetrics::register_service("metrics_counts");
+    ServerMetrics::ServiceStats *stats = ServerMetrics::get_service("metrics_counts");
+
+    ASSERT_NE(stats, nullptr);
+    for (int i = 0; i < 3; i++)
+        ServerMetrics::service_request_started("metrics_counts");
+    EXPECT_EQ(stats->queue_depth, 3);
+    ServerMetrics::service_request_finished("metrics_counts", 1000, true);
+    ServerMetrics::service_request_finished("metrics_counts", 1000, true);
+    ServerMetrics::service_request_finished("metrics_counts", 1000, false);
+    ServerMetrics::service_request_hedged("metrics_counts");
+    ServerMetrics::service_batch_sent("metrics_counts", 4);
+    EXPECT_EQ(stats->queue_depth, 0);
+    EXPECT_EQ(stats->requests, 3u);
+    EXPECT_EQ(stats->errors, 1u);
+    EXPECT_EQ(stats->hedged, 1u);
+    EXPECT_EQ(stats->batched, 4u);
+
+    EXPECT_EQ(ServerMetrics::get_service("metrics_unknown"), nullptr);
+    ServerMetrics::service_request_started("metrics_unknown");
+    ServerMetrics::service_request_finished("metrics_unknown", 1000, false);
+    EXPECT_EQ(ServerMetrics::get_service("metrics_unknown"), nullptr);
+}
+
+/**
+ * @brief The latency starts at the first request and then moves an eighth
+ * of the way toward each new one.
+ *
+ */
+TEST_F(ServerMetricsTest, AveragesLatency) {
+    ServerMetrics::register_service("metrics_latency");
+    ServerMetrics::ServiceStats *stats = ServerMetrics::get_service("metrics_latency");
+
+    ASSERT_NE(stats, nullptr);
+    ServerMetrics::service_request_started("metrics_latency");
+    ServerMetrics::service_request_finished("metrics_latency", 8000, true);
+    EXPECT_EQ(stats->latency_us, 8000);
+    ServerMetrics::service_request_started("metrics_latency");
+    ServerMetrics::service_request_finished("metrics_latency", 16000, true);
+    EXPECT_EQ(stats->latency_us, 9000);
+    EXPECT_DOUBLE_EQ(ServerMetrics::get_status_report()["services"]["metrics_latency"]["latency_ms"]
+        .get<double>(), 9.0);
+}
+
+/**
+ * @brief The load is the highest of the connection, memory and queue usages,
+ * and caps at 1.
+ *
+ */
+TEST_F(ServerMetricsTest, ComputesLoad) {
+    ServerMetrics::register_service("metrics_load");
+
+    EXPECT_DOUBLE_EQ(ServerMetrics::get_load(), 0.0);
+    ServerMetrics::open_connections = ServerMetrics::MAX_CONNECTIONS / 2;
+    EXPECT_DOUBLE_EQ(ServerMetrics::get_load(), 0.5);
+    ServerMetrics::memory_limit = 1000;
+    ServerMetrics::memory_used = 900;
+    EXPECT_DOUBLE_EQ(ServerMetrics::get_load(), 0.9);
+    for (int64_t i = 0; i < ServerMetrics::MAX_QUEUE_DEPTH * 2; i++)
+        ServerMetrics::service_request_started("metrics_load");
+    EXPECT_DOUBLE_EQ(ServerMetrics::get_load(), 1.0);
+    EXPECT_EQ(ServerMetrics::get_queue_depth(), ServerMetrics::MAX_QUEUE_DEPTH * 2);
+    for (int64_t i = 0; i < ServerMetrics::MAX_QUEUE_DEPTH * 2; i++)
+        ServerMetrics::service_request_finished("metrics_load", 1000, true);
+    EXPECT_EQ(ServerMetrics::get_queue_depth(), 0);
+}
+
+/**
+ * @brief The report holds the counters and every service, and its
+ * recommended settings scale down as the load grows.
+ *
+ */
+TEST_F(ServerMetricsTest, BuildsStatusReport) {
+    ServerMetrics::register_service("metrics_report");
+    ServerMetrics::open_connections = 3;
+    auto idle = ServerMetrics::get_status_report();
+
+    EXPECT_EQ(idle["open_connections"], 3);
+    for (const char *key : { "load", "active_streams", "messages_received", "bytes_received",
+        "allocations_per_message", "arena_bytes_per_message" })
+        EXPECT_TRUE(idle.contains(key)) << key;
+    ASSERT_TRUE(idle["services"].contains("metrics_report"));
+    EXPECT_EQ(idle["services"]["metrics_report"]["queue_depth"], 0);
+    EXPECT_EQ(idle["recommended"]["chunk_ms"], 101);
+    EXPECT_EQ(idle["recommended"]["chunk_bytes"], 101 * ServerMetrics::AUDIO_BYTES_PER_MS);
+    EXPECT_EQ(idle["recommended"]["frame_rate"], 14);
+
+    ServerMetrics::open_connections = 0;
+    auto low = ServerMetrics::get_status_report();
+    EXPECT_EQ(low["recommended"], nlohmann::json({ {"chunk_ms", 100}, {"chunk_bytes", 3200},
+        {"frame_rate", 15} }));
+
+    ServerMetrics::open_connections = ServerMetrics::MAX_CONNECTIONS;
+    auto high = ServerMetrics::get_status_report();
+    EXPECT_DOUBLE_EQ(high["load"].get<double>(), 1.0);
+    EXPECT_EQ(high["recommended"], nlohmann::json({ {"chunk_ms", 500}, {"chunk_bytes", 16000},
+        {"frame_rate", 5} }));
+}
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <crow.h>
+#include <nlohmann/json.hpp>
+#include "MicroservicesManager.hpp"
+#include "Router.hpp"
+#include "ServicePool.hpp"
+#include "ws_client.hpp"
+
+using talkup_network::ServicePool;
+
+namespace {
+    // Stands in for a microservice: answers its tasks with the status it is
+    // given, and can hold them until it is released.
+    class StubService {
+        public:
+            StubService(void) {
+                CROW_ROUTE(app, "/task").methods("POST"_method)([this](const crow::request &) {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    waiting++;
+                    changed.notify_all();
+                    changed.wait(lock, [this]() { return !held; });
+                    waiting--;
+                    crow::response res(nlohmann::json{ {"type", "task_result"} }.dump());
+                    res.set_header("Content-Type", "application/json");
+                    res.code = status;
+                    return res;
+                });
+                port = ws_client::get_free_port();
+                server = app.port(port).concurrency(4).run_async();
+                app.wait_for_server_start();
+            }
+
+            ~StubService() {
+                release();
+                app.stop();
+                server.wait();
+            }
+
+            void hold(void)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                held = true;
+            }
+
+            void release(void)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    held = false;
+                }
+                changed.notify_all();
+            }
+
+            // Waits for a task to be held by the service.
+            bool wait_for_task(void)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                return changed.wait_for(lock, std::chrono::seconds(2), [this]() { return waiting > 0; });
+            }
+
+            crow::SimpleApp app;
+            decltype(app.run_async()) server;
+            std::mutex mutex;
+            std::condition_variable changed;
+            std::atomic<int> status{200};
+            bool held = false;
+            int waiting = 0;
+            int port = 0;
+    };
+
+    std::unique_ptr<StubService> stub;
+
+    std::string get_breaker_state(const std::string &service)
+    {
+        return ServicePool::get_circuits()[service][0]["state"];
+    }
+}
+
+// Test fixture for ServicePool tests
+class ServicePoolTest : public ::testing::Test {
+protected:
+    // The pools are global: every test of the binary shares these two services.
+    static void SetUpTestSuite() {
+        auto services = std::filesystem::temp_directory_path() / "talkup_pool_services.json";
+
+        stub = std::make_unique<StubService>();
+        std::string url = "http://127.0.0.1:" + std::to_string(stub->port) + "/";
+        std::ofstream(services) << nlohmann::json{
+            {"pool_ready", { {"Url", url} }},
+            {"pool_breaker", { {"Url", url}, {"OpenForMs", 200} }} }.dump();
+        talkup_network::MicroservicesManager::load_microservices_info(services.string());
+        ServicePool::open_pools();
+        std::filesystem::remove(services);
+    }
+
+    static void TearDownTestSuite() {
+        stub.reset();
+    }
+
+    void SetUp() override {
+        stub->status = 200;
+        stub->release();
+    }
+
+    void TearDown() override {}
+
+    talkup_network::Router router;
+};
+
+/**
+ * @brief /live always answers, while /ready only does once every service
+ * went through its warmup task.
+ *
+ */
+TEST_F(ServicePoolTest, ReadyAfterWarmup) {
+    std::atomic<bool> stop{false};
+
+    auto live = router.handle_live();
+    EXPECT_EQ(live.code, 200);
+    EXPECT_EQ(nlohmann::json::parse(live.body)["status"], "alive");
+
+    auto cold = router.handle_ready();
+    auto state = nlohmann::json::parse(cold.body);
+    EXPECT_EQ(cold.code, 503);
+    EXPECT_EQ(state["status"], "warming");
+    EXPECT_EQ(state["services"]["pool_ready"], "cold");
+    EXPECT_FALSE(ServicePool::is_ready());
+
+    ServicePool::warmup_all(stop);
+    auto warm = router.handle_ready();
+    state = nlohmann::json::parse(warm.body);
+    EXPECT_EQ(warm.code, 200);
+    EXPECT_EQ(state["status"], "ready");
+    EXPECT_EQ(state["services"]["pool_ready"], "ready");
+    EXPECT_EQ(state["circuits"]["pool_ready"][0]["warm"], true);
+    EXPECT_EQ(router.handle_live().code, 200);
+}
+
+/**
+ * @brief Failed calls open the breaker of a replica, which then refuses
+ * calls until its cooldown is over, lets one probe through half-open, and
+ * closes once the probe succeeds.
+ *
+ */
+TEST_F(ServicePoolTest, BreakerOpensAndRecovers) {
+    ASSERT_EQ(get_breaker_state("pool_breaker"), "closed");
+    stub->status = 500;
+    for (size_t i = 0; i < talkup_network::CircuitBreaker::Thresholds{}.min_calls; i++)
+        EXPECT_FALSE(ServicePool::post("pool_breaker", "task", "{}").ok);
+    EXPECT_EQ(get_breaker_state("pool_breaker"), "open");
+    auto refused = ServicePool::post("pool_breaker", "task", "{}");
+    EXPECT_FALSE(refused.ok);
+    EXPECT_EQ(refused.error, "circuit open: pool_breaker");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    stub->status = 200;
+    stub->hold();
+    auto probe = std::async(std::launch::async, []() {
+        return ServicePool::post("pool_breaker", "task", "{}");
+    });
+    ASSERT_TRUE(stub->wait_for_task());
+    EXPECT_EQ(get_breaker_state("pool_breaker"), "half_open");
+    EXPECT_EQ(ServicePool::post("pool_breaker", "task", "{}").error, "circuit open: pool_breaker");
+    stub->release();
+    EXPECT_TRUE(probe.get().ok);
+    EXPECT_EQ(get_breaker_state("pool_breaker"), "closed");
+    EXPECT_TRUE(ServicePool::post("pool_breaker", "task", "{}").ok);
+}
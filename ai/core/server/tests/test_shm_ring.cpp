@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ShmRing.hpp"
+
+// Test fixture for ShmRing tests
+class ShmRingTest : public ::testing::Test {
+protected:
+    static constexpr size_t CAPACITY = 1024;
+
+    void SetUp() override {
+        memory = static_cast<char *>(std::aligned_alloc(64,
+            talkup_network::ShmRing::get_size(CAPACITY)));
+        std::fill(memory, memory + talkup_network::ShmRing::get_size(CAPACITY), 0);
+    }
+
+    void TearDown() override {
+        std::free(memory);
+    }
+
+    char *memory = nullptr;
+};
+
+/**
+ * @brief Records come out in order, with their id, metadata and raw bytes untouched.
+ *
+ */
+TEST_F(ShmRingTest, PushPeekPop) {
+    talkup_network::ShmRing ring(memory, CAPACITY);
+    talkup_network::ShmRing::Record record;
+    std::string samples("\x00\x01\xff\x7f", 4);
+
+    EXPECT_FALSE(ring.peek(record));
+    ASSERT_TRUE(ring.push(1, R"({"type":"task_request"})", samples));
+    ASSERT_TRUE(ring.push(2, "{}", ""));
+    ASSERT_TRUE(ring.peek(record));
+    EXPECT_EQ(record.id, 1u);
+    EXPECT_EQ(record.meta, R"({"type":"task_request"})");
+    EXPECT_EQ(record.data, samples);
+    ring.pop();
+    ASSERT_TRUE(ring.peek(record));
+    EXPECT_EQ(record.id, 2u);
+    EXPECT_TRUE(record.data.empty());
+    ring.pop();
+    EXPECT_FALSE(ring.peek(record));
+}
+
+/**
+ * @brief A full ring refuses records until the consumer frees space,
+ * and records too big for the ring are refused.
+ *
+ */
+TEST_F(ShmRingTest, FullAndTooBig) {
+    talkup_network::ShmRing ring(memory, CAPACITY);
+    talkup_network::ShmRing::Record record;
+    std::string data(200, 'x');
+    int pushed = 0;
+
+    EXPECT_FALSE(ring.push(0, "{}", std::string(CAPACITY, 'x')));
+    while (ring.push(pushed, "{}", data))
+        pushed++;
+    EXPECT_GT(pushed, 0);
+    ASSERT_TRUE(ring.peek(record));
+    ring.pop();
+    EXPECT_TRUE(ring.push(pushed, "{}", data));
+}
+
+/**
+ * @brief Records keep their content when the ring wraps around.
+ *
+ */
+TEST_F(ShmRingTest, WrapAround) {
+    talkup_network::ShmRing ring(memory, CAPACITY);
+    talkup_network::ShmRing::Record record;
+
+    for (uint64_t i = 0; i < 100; i++) {
+        std::string data(100 + i * 7 % 300, static_cast<char>('a' + i % 26));
+
+        ASSERT_TRUE(ring.push(i, "{}", data));
+        ASSERT_TRUE(ring.peek(record));
+        EXPECT_EQ(record.id, i);
+        EXPECT_EQ(record.data, data);
+        ring.pop();
+    }
+}
+
+/**
+ * @brief A sleeping consumer is woken up by the producer.
+ *
+ */
+TEST_F(ShmRingTest, WaitWakesUp) {
+    talkup_network::ShmRing ring(memory, CAPACITY);
+    talkup_network::ShmRing producer(memory, CAPACITY);
+    std::vector<uint64_t> received;
+
+    std::thread consumer([&]() {
+        talkup_network::ShmRing::Record record;
+
+        while (received.size() < 50) {
+            if (!ring.wait(std::chrono::milliseconds(2000)))
+                break;
+            while (ring.peek(record)) {
+                received.push_back(record.id);
+                ring.pop();
+            }
+        }
+    });
+    for (uint64_t i = 0; i < 50; i++) {
+        while (!producer.push(i, "{}", "data"))
+            std::this_thread::yield();
+        if (i % 10 == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    consumer.join();
+    ASSERT_EQ(received.size(), 50u);
+    for (uint64_t i = 0; i < 50; i++)
+        EXPECT_EQ(received[i], i);
+}
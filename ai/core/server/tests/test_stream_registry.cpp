@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <crow.h>
+#include "StreamRegistry.hpp"
+
+using Registry = talkup_network::StreamRegistry;
+using Status = Registry::ChunkStatus;
+using Ownership = Registry::Ownership;
+
+namespace {
+    // Keeps what the registry sends instead of writing to a socket.
+    class FakeConnection : public crow::websocket::connection {
+        public:
+            void send_binary(const std::string &msg) override { sent.push_back(msg); }
+            void send_text(const std::string &msg) override { sent.push_back(msg); }
+            void send_ping(const std::string &) override {}
+            void send_pong(const std::string &) override {}
+            void close(const std::string &) override {}
+            std::string get_remote_ip() override { return "127.0.0.1"; }
+
+            std::vector<std::string> sent;
+    };
+
+    nlohmann::json make_reply(int64_t seq)
+    {
+        return { {"type", "task_result"}, {"stream_id", "stream"}, {"seq", seq} };
+    }
+}
+
+// Test fixture for StreamRegistry tests
+class StreamRegistryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        sender = [](crow::websocket::connection &conn, const nlohmann::json &message) {
+            conn.send_text(message.dump());
+        };
+    }
+
+    void TearDown() override {}
+
+    // Registers chunks first to last of the stream and answers each of them.
+    void stream(Registry &registry, crow::websocket::connection &conn, int64_t first, int64_t last) {
+        for (int64_t seq = first; seq <= last; seq++) {
+            std::string ignored;
+
+            ASSERT_EQ(registry.submit_chunk("stream", seq, conn, ignored), Status::ACCEPTED);
+            registry.deliver("stream", seq, make_reply(seq), sender);
+        }
+    }
+
+    Registry::Sender sender;
+    FakeConnection first;
+    FakeConnection second;
+};
+
+/**
+ * @brief A stream detached by a disconnect is bound to the new connection
+ * with its token, which then owns it, and the old one can't use it anymore.
+ *
+ */
+TEST_F(StreamRegistryTest, ResumesAfterDisconnect) {
+    Registry registry;
+    std::string token;
+    int64_t last_received = -1;
+    std::vector<nlohmann::json> replay;
+
+    EXPECT_EQ(registry.submit_chunk("stream", 0, first, token), Status::ACCEPTED);
+    EXPECT_FALSE(token.empty());
+    stream(registry, first, 1, 2);
+    EXPECT_EQ(registry.submit_chunk("stream", 2, first, token), Status::DUPLICATE);
+    EXPECT_EQ(registry.get_streams(first), std::vector<std::string>({ "stream" }));
+
+    EXPECT_EQ(registry.detach(first), std::vector<std::string>({ "stream" }));
+    EXPECT_EQ(registry.get_ownership("stream", first), Ownership::ELSEWHERE);
+    EXPECT_FALSE(registry.resume("stream", "wrong", -1, second, last_received, replay));
+    ASSERT_TRUE(registry.resume("stream", token, 2, second, last_received, replay));
+    EXPECT_EQ(last_received, 2);
+    EXPECT_TRUE(replay.empty());
+
+    EXPECT_EQ(registry.get_ownership("stream", second), Ownership::OWNED);
+    EXPECT_EQ(registry.get_ownership("stream", first), Ownership::ELSEWHERE);
+    EXPECT_EQ(registry.get_ownership("other", second), Ownership::NONE);
+    EXPECT_EQ(registry.get_streams(second), std::vector<std::string>({ "stream" }));
+    EXPECT_TRUE(registry.get_streams(first).empty());
+    EXPECT_EQ(registry.submit_chunk("stream", 3, first, token), Status::OWNED_ELSEWHERE);
+    EXPECT_EQ(registry.submit_chunk("stream", 3, second, token), Status::ACCEPTED);
+}
+
+/**
+ * @brief The messages answered while the stream was detached are kept,
+ * and only those after the last acknowledged chunk are replayed.
+ *
+ */
+TEST_F(StreamRegistryTest, ReplaysFromAck) {
+    Registry registry;
+    std::string token;
+    int64_t last_received = -1;
+    std::vector<nlohmann::json> replay;
+
+    ASSERT_EQ(registry.submit_chunk("stream", 0, first, token), Status::ACCEPTED);
+    registry.deliver("stream", 0, make_reply(0), sender);
+    stream(registry, first, 1, 2);
+    EXPECT_EQ(first.sent.size(), 3u);
+    registry.detach(first);
+    registry.deliver("stream", 3, make_reply(3), sender);
+    registry.deliver("stream", 4, make_reply(4), sender);
+    EXPECT_EQ(first.sent.size(), 3u);
+
+    ASSERT_TRUE(registry.resume("stream", token, 2, second, last_received, replay));
+    EXPECT_EQ(last_received, 2);
+    ASSERT_EQ(replay.size(), 2u);
+    EXPECT_EQ(replay[0]["seq"], 3);
+    EXPECT_EQ(replay[1]["seq"], 4);
+    registry.deliver("stream", 5, make_reply(5), sender);
+    EXPECT_EQ(second.sent.size(), 1u);
+}
+
+/**
+ * @brief Past its window, a stream keeps only its latest messages: the
+ * oldest can't be replayed anymore.
+ *
+ */
+TEST_F(StreamRegistryTest, DropsPastWindow) {
+    Registry registry(3);
+    std::string token;
+    int64_t last_received = -1;
+    std::vector<nlohmann::json> replay;
+
+    ASSERT_EQ(registry.submit_chunk("stream", 0, first, token), Status::ACCEPTED);
+    registry.deliver("stream", 0, make_reply(0), sender);
+    stream(registry, first, 1, 5);
+    registry.detach(first);
+    ASSERT_TRUE(registry.resume("stream", token, -1, second, last_received, replay));
+    ASSERT_EQ(replay.size(), 3u);
+    EXPECT_EQ(replay.front()["seq"], 3);
+    EXPECT_EQ(replay.back()["seq"], 5);
+    EXPECT_EQ(registry.trim("stream"), 3u);
+    EXPECT_EQ(registry.trim("stream"), 0u);
+}
+
+/**
+ * @brief A detached stream can't be resumed after its grace period,
+ * and a bound one never expires.
+ *
+ */
+TEST_F(StreamRegistryTest, ExpiresAfterGracePeriod) {
+    Registry registry(512, std::chrono::seconds(0));
+    std::string token;
+    int64_t last_received = -1;
+    std::vector<nlohmann::json> replay;
+
+    ASSERT_EQ(registry.submit_chunk("stream", 0, first, token), Status::ACCEPTED);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_FALSE(registry.expire("stream"));
+    registry.detach(first);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_TRUE(registry.expire("stream"));
+    EXPECT_FALSE(registry.resume("stream", token, -1, second, last_received, replay));
+    EXPECT_EQ(registry.get_ownership("stream", first), Ownership::NONE);
+}
+
+/**
+ * @brief A message sent outside the window reaches the bound connection
+ * only, and is not replayed after a resume.
+ *
+ */
+TEST_F(StreamRegistryTest, SendsWithoutRetaining) {
+    Registry registry;
+    std::string token;
+    int64_t last_received = -1;
+    std::vector<nlohmann::json> replay;
+
+    EXPECT_FALSE(registry.send("stream", make_reply(0), sender));
+    ASSERT_EQ(registry.submit_chunk("stream", 0, first, token), Status::ACCEPTED);
+    EXPECT_TRUE(registry.send("stream", make_reply(0), sender));
+    EXPECT_EQ(first.sent.size(), 1u);
+    registry.detach(first);
+    EXPECT_FALSE(registry.send("stream", make_reply(0), sender));
+    EXPECT_EQ(first.sent.size(), 1u);
+
+    ASSERT_TRUE(registry.resume("stream", token, -1, second, last_received, replay));
+    EXPECT_TRUE(replay.empty());
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "TimerService.hpp"
+#include "TimerWheel.hpp"
+
+using Expired = talkup_network::TimerWheel::Expired;
+
+// Test fixture for TimerWheel tests
+class TimerWheelTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fired.clear();
+    }
+
+    void TearDown() override {
+    }
+
+    // Advances the wheel tick by tick, recording when each timer fires.
+    void advance(uint64_t tick) {
+        std::vector<Expired> expired;
+
+        while (wheel.get_tick() < tick) {
+            wheel.advance(wheel.get_tick() + 1, expired);
+            for (auto &timer : expired) {
+                now = wheel.get_tick();
+                timer.second();
+            }
+            expired.clear();
+        }
+    }
+
+    talkup_network::TimerWheel::Callback record(int id) {
+        return [this, id]() { fired.push_back({ id, now }); };
+    }
+
+    talkup_network::TimerWheel wheel;
+    uint64_t now = 0;
+    std::vector<std::pair<int, uint64_t>> fired;
+};
+
+/**
+ * @brief Timers fire at their tick, in order.
+ *
+ */
+TEST_F(TimerWheelTest, FiresInOrder) {
+    wheel.schedule(5, record(2));
+    wheel.schedule(3, record(1));
+    wheel.schedule(70, record(3));
+    EXPECT_EQ(wheel.get_size(), 3u);
+    advance(100);
+    ASSERT_EQ(fired.size(), 3u);
+    EXPECT_EQ(fired[0], std::make_pair(1, uint64_t(3)));
+    EXPECT_EQ(fired[1], std::make_pair(2, uint64_t(5)));
+    EXPECT_EQ(fired[2], std::make_pair(3, uint64_t(70)));
+    EXPECT_EQ(wheel.get_size(), 0u);
+}
+
+/**
+ * @brief A cancelled timer never fires, and its handle stays invalid once reused.
+ *
+ */
+TEST_F(TimerWheelTest, Cancels) {
+    auto first = wheel.schedule(10, record(1));
+    wheel.schedule(20, record(2));
+
+    EXPECT_TRUE(wheel.cancel(first));
+    EXPECT_FALSE(wheel.cancel(first));
+    auto reused = wheel.schedule(30, record(3));
+    EXPECT_NE(reused, first);
+    EXPECT_FALSE(wheel.cancel(first));
+    EXPECT_FALSE(wheel.cancel(talkup_network::TimerWheel::NONE));
+    advance(40);
+    ASSERT_EQ(fired.size(), 2u);
+    EXPECT_EQ(fired[0].first, 2);
+    EXPECT_EQ(fired[1].first, 3);
+    EXPECT_FALSE(wheel.cancel(reused));
+}
+
+/**
+ * @brief Timers far ahead move down the levels and still fire on their tick,
+ * even past the reach of the wheel.
+ *
+ */
+TEST_F(TimerWheelTest, CascadesLongDelays) {
+    std::vector<uint64_t> ticks = { 63, 64, 65, 4095, 4096, 4160, 262143, 262144, 300001 };
+
+    advance(17);
+    for (size_t i = 0; i < ticks.size(); i++)
+        wheel.schedule(17 + ticks[i], record(static_cast<int>(i)));
+    advance(17 + 300001);
+    ASSERT_EQ(fired.size(), ticks.size());
+    for (size_t i = 0; i < ticks.size(); i++) {
+        EXPECT_EQ(fired[i].first, static_cast<int>(i));
+        EXPECT_EQ(fired[i].second, 17 + ticks[i]);
+    }
+
+    uint64_t beyond = wheel.get_tick() + (uint64_t(1) << 24) + 100;
+    std::vector<Expired> expired;
+    wheel.schedule(beyond, record(-1));
+    wheel.advance(beyond - 1, expired);
+    EXPECT_TRUE(expired.empty());
+    wheel.advance(beyond, expired);
+    EXPECT_EQ(expired.size(), 1u);
+}
+
+/**
+ * @brief Hundreds of thousands of timers are scheduled, half cancelled, and
+ * the other half fires once each.
+ *
+ */
+TEST_F(TimerWheelTest, ManyTimers) {
+    constexpr size_t COUNT = 200000;
+    std::vector<talkup_network::TimerWheel::Handle> handles;
+    size_t count = 0;
+    std::vector<Expired> expired;
+
+    handles.reserve(COUNT);
+    for (size_t i = 0; i < COUNT; i++)
+        handles.push_back(wheel.schedule(1 + (i * 7919) % 30000, [&count]() { count++; }));
+    for (size_t i = 0; i < COUNT; i += 2)
+        EXPECT_TRUE(wheel.cancel(handles[i]));
+    EXPECT_EQ(wheel.get_size(), COUNT / 2);
+    wheel.advance(30000, expired);
+    for (auto &timer : expired)
+        timer.second();
+    EXPECT_EQ(count, COUNT / 2);
+    EXPECT_EQ(wheel.get_size(), 0u);
+}
+
+/**
+ * @brief The service fires its timers on time from its threads, and a cancelled
+ * one never fires.
+ *
+ */
+TEST_F(TimerWheelTest, ServiceFires) {
+    talkup_network::TimerService timers(2, std::chrono::milliseconds(1));
+    std::atomic<int> count{0};
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<int64_t> elapsed_ms{0};
+
+    for (size_t i = 0; i < 10; i++)
+        timers.schedule_after(std::chrono::milliseconds(20), [&]() { count++; }, i);
+    auto cancelled = timers.schedule_after(std::chrono::milliseconds(20), [&]() { count += 100; });
+    timers.schedule_after(std::chrono::milliseconds(30), [&]() {
+        elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    });
+    EXPECT_TRUE(timers.cancel(cancelled));
+    EXPECT_EQ(timers.get_size(), 11u);
+    for (int i = 0; i < 200 && elapsed_ms == 0; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(count, 10);
+    EXPECT_GE(elapsed_ms, 30);
+    EXPECT_EQ(timers.get_size(), 0u);
+}
+
+/**
+ * @brief A callback which throws is logged, and the service keeps firing.
+ *
+ */
+TEST_F(TimerWheelTest, ServiceSurvivesThrowingCallback) {
+    talkup_network::TimerService timers(1, std::chrono::milliseconds(1));
+    std::atomic<bool> fired{false};
+
+    timers.schedule_after(std::chrono::milliseconds(5), []() { throw std::runtime_error("disk full"); });
+    timers.schedule_after(std::chrono::milliseconds(10), [&]() { fired = true; });
+    for (int i = 0; i < 200 && !fired; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_TRUE(fired);
+}
@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#ifdef TALKUP_ENABLE_TLS
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "CrowTransport.hpp"
+#include "ExceptionManager.hpp"
+#include "TlsContext.hpp"
+#include "UringTransport.hpp"
+#include "ws_client.hpp"
+
+using namespace ws_client;
+
+namespace {
+    // Self-signed certificate and its key, in a single PEM file.
+    bool write_certificate(const std::string &path)
+    {
+        EVP_PKEY *key = EVP_EC_gen("P-256");
+        X509 *cert = X509_new();
+        FILE *file = nullptr;
+        bool written = false;
+
+        if (key && cert) {
+            X509_NAME *name = X509_get_subject_name(cert);
+
+            ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+            X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+            X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+            X509_set_pubkey(cert, key);
+            X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+            X509_set_issuer_name(cert, name);
+            file = X509_sign(cert, key, EVP_sha256()) > 0 ? fopen(path.c_str(), "w") : nullptr;
+        }
+        if (file) {
+            written = PEM_write_X509(file, cert) == 1
+                && PEM_write_PrivateKey(file, key, nullptr, nullptr, 0, nullptr, nullptr) == 1;
+            fclose(file);
+        }
+        X509_free(cert);
+        EVP_PKEY_free(key);
+        return written;
+    }
+}
+
+// Test fixture for the TLS termination tests, run on every transport
+class TlsTest : public ::testing::TestWithParam<std::string> {
+protected:
+    void SetUp() override {
+        char dir[] = "/tmp/talkup_tls_XXXXXX";
+        talkup_network::TlsContext::Options options;
+
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        cert_file = std::string(dir) + "/server.pem";
+        ASSERT_TRUE(write_certificate(cert_file));
+        options.cert_file = cert_file;
+        tls = std::make_shared<talkup_network::TlsContext>(options);
+        client = SSL_CTX_new(TLS_client_method());
+        ASSERT_NE(client, nullptr);
+        ASSERT_EQ(SSL_CTX_load_verify_locations(client, cert_file.c_str(), nullptr), 1);
+        SSL_CTX_set_verify(client, SSL_VERIFY_PEER, nullptr);
+
+        setenv("COMMUNICATION", "test_key", 1);
+        setenv("WS_ADDRESS", "wss://localhost/ws", 1);
+        if (GetParam() == "io_uring") {
+            if (!talkup_network::UringTransport::is_supported())
+                GTEST_SKIP() << "io_uring is not supported here";
+            transport = std::make_unique<talkup_network::UringTransport>(2, tls);
+        } else {
+            transport = std::make_unique<talkup_network::CrowTransport>(tls);
+        }
+        port = get_free_port();
+        server_thread = std::thread([this]() { transport->run(router, port); });
+        transport->wait_for_start();
+    }
+
+    void TearDown() override {
+        if (transport) {
+            transport->stop();
+            server_thread.join();
+        }
+        SSL_CTX_free(client);
+        if (!cert_file.empty()) {
+            unlink(cert_file.c_str());
+            rmdir(cert_file.substr(0, cert_file.rfind('/')).c_str());
+        }
+    }
+
+    // Handshake with the server, resuming the session when one is given.
+    SSL *tls_connect(SSL_SESSION *session = nullptr) {
+        int fd = connect_to(port);
+        SSL *ssl = fd < 0 ? nullptr : SSL_new(client);
+
+        if (!ssl) {
+            if (fd >= 0)
+                close(fd);
+            return nullptr;
+        }
+        SSL_set_fd(ssl, fd);
+        SSL_set_tlsext_host_name(ssl, "localhost");
+        SSL_set1_host(ssl, "localhost");
+        if (session)
+            SSL_set_session(ssl, session);
+        if (SSL_connect(ssl) != 1) {
+            tls_close(ssl);
+            return nullptr;
+        }
+        return ssl;
+    }
+
+    // Without close_notify, OpenSSL drops the session as unresumable.
+    void tls_close(SSL *ssl) {
+        int fd = SSL_get_fd(ssl);
+
+        SSL_shutdown(ssl);
+        SSL_free(ssl);
+        close(fd);
+    }
+
+    std::string tls_request(SSL *ssl, const std::string &request) {
+        std::string response;
+        char buffer[4096];
+        int n;
+
+        SSL_write(ssl, request.data(), static_cast<int>(request.size()));
+        while ((n = SSL_read(ssl, buffer, sizeof(buffer))) > 0)
+            response.append(buffer, static_cast<size_t>(n));
+        return response;
+    }
+
+    std::string tls_read_until(SSL *ssl, const std::string &end) {
+        std::string response;
+        char c;
+
+        while (response.find(end) == std::string::npos && SSL_read(ssl, &c, 1) == 1)
+            response += c;
+        return response;
+    }
+
+    talkup_network::Router router;
+    std::shared_ptr<talkup_network::TlsContext> tls;
+    std::unique_ptr<ITransport> transport;
+    std::thread server_thread;
+    SSL_CTX *client = nullptr;
+    std::string cert_file;
+    int port = 0;
+};
+
+/**
+ * @brief /live answers over HTTPS.
+ *
+ */
+TEST_P(TlsTest, LiveOverHttps) {
+    SSL *ssl = tls_connect();
+
+    ASSERT_NE(ssl, nullptr);
+    std::string response = tls_request(ssl,
+        "GET /live HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    EXPECT_NE(response.find(" 200 "), std::string::npos);
+    EXPECT_NE(response.find("alive"), std::string::npos);
+    tls_close(ssl);
+}
+
+/**
+ * @brief A ping over WSS is answered with a pong.
+ *
+ */
+TEST_P(TlsTest, WebSocketPingOverWss) {
+    SSL *ssl = tls_connect();
+    const unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
+    nlohmann::json message = { {"type", "ping"}, {"key", "test_key"}, {"stream_id", "stream"},
+        {"format", "text"}, {"timestamp", 0}, {"data", "hello"} };
+    std::string text = message.dump();
+    std::string frame = {static_cast<char>(0x81), static_cast<char>(0x80 | text.size())};
+
+    ASSERT_NE(ssl, nullptr);
+    std::string request = "GET /ws HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+        "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+        "Sec-WebSocket-Version: 13\r\n\r\n";
+    SSL_write(ssl, request.data(), static_cast<int>(request.size()));
+    EXPECT_NE(tls_read_until(ssl, "\r\n\r\n").find(" 101 "), std::string::npos);
+
+    ASSERT_LT(text.size(), 126u);
+    frame.append(reinterpret_cast<const char *>(mask), 4);
+    for (size_t i = 0; i < text.size(); i++)
+        frame.push_back(static_cast<char>(text[i] ^ mask[i & 3]));
+    SSL_write(ssl, frame.data(), static_cast<int>(frame.size()));
+    std::string reply = tls_read_until(ssl, "}");
+    ASSERT_GT(reply.size(), 2u);
+    EXPECT_EQ(nlohmann::json::parse(reply.substr(2))["type"], "pong");
+    tls_close(ssl);
+}
+
+/**
+ * @brief A reconnect resumes the previous session instead of a full handshake.
+ *
+ */
+TEST_P(TlsTest, ResumesSession) {
+    SSL *first = tls_connect();
+
+    ASSERT_NE(first, nullptr);
+    // TLS 1.3 tickets come after the handshake: read a response first, on a
+    // connection kept open so the client is the one closing it cleanly.
+    std::string request = "GET /live HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    SSL_write(first, request.data(), static_cast<int>(request.size()));
+    EXPECT_NE(tls_read_until(first, "}").find(" 200 "), std::string::npos);
+    SSL_SESSION *session = SSL_get1_session(first);
+    tls_close(first);
+    ASSERT_NE(session, nullptr);
+    EXPECT_TRUE(SSL_SESSION_is_resumable(session));
+
+    SSL *second = tls_connect(session);
+    ASSERT_NE(second, nullptr);
+    EXPECT_TRUE(SSL_session_reused(second));
+    std::string response = tls_request(second,
+        "GET /live HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    EXPECT_NE(response.find(" 200 "), std::string::npos);
+    tls_close(second);
+    SSL_SESSION_free(session);
+}
+
+/**
+ * @brief A missing certificate is refused before the server starts.
+ *
+ */
+TEST(TlsContextTest, RejectsMissingCertificate) {
+    talkup_network::TlsContext::Options options;
+
+    options.cert_file = "/nonexistent/server.pem";
+    EXPECT_THROW(talkup_network::TlsContext context(options), ExceptionManager::ServerTlsException);
+}
+
+INSTANTIATE_TEST_SUITE_P(Transports, TlsTest, ::testing::Values("crow", "io_uring"),
+    [](const ::testing::TestParamInfo<std::string> &info) {
+        return info.param == "io_uring" ? std::string("IoUring") : std::string("Crow");
+    });
+#endif
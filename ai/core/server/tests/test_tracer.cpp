@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "Tracer.hpp"
+
+using talkup_network::Tracer;
+
+namespace {
+    nlohmann::json dump_events(void)
+    {
+        std::ostringstream out;
+
+        Tracer::dump(out);
+        return nlohmann::json::parse(out.str())["traceEvents"];
+    }
+
+    size_t count_events(const std::string &prefix)
+    {
+        size_t count = 0;
+
+        for (const auto &event : dump_events()) {
+            if (event["name"].get<std::string>().rfind(prefix, 0) == 0)
+                count++;
+        }
+        return count;
+    }
+}
+
+// Test fixture for Tracer tests
+class TracerTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+
+    void TearDown() override {
+        Tracer::end_trace();
+    }
+};
+
+/**
+ * @brief Nothing is recorded for a message which isn't traced.
+ *
+ */
+TEST_F(TracerTest, SkipsUntracedMessages) {
+    Tracer::set_sample_rate(0);
+    EXPECT_EQ(Tracer::begin_trace(false), 0u);
+    EXPECT_FALSE(Tracer::enabled());
+    {
+        Tracer::ScopedSpan span("untraced:", "stt");
+    }
+    Tracer::record("untraced:record", 1, 2);
+    EXPECT_EQ(count_events("untraced:"), 0u);
+}
+
+/**
+ * @brief A traced span is named prefix + name, cut to the size of a span
+ * name, and tagged with its trace.
+ *
+ */
+TEST_F(TracerTest, RecordsNamedSpans) {
+    uint64_t trace_id = Tracer::begin_trace(true);
+
+    ASSERT_NE(trace_id, 0u);
+    EXPECT_TRUE(Tracer::enabled());
+    {
+        Tracer::ScopedSpan span("named:", "stt");
+        Tracer::ScopedSpan fixed("named_fixed");
+        Tracer::ScopedSpan cut("named:", std::string(64, 'x'));
+    }
+    Tracer::end_trace();
+    bool found = false;
+    for (const auto &event : dump_events()) {
+        std::string name = event["name"];
+
+        if (name == "named:stt") {
+            found = true;
+            EXPECT_EQ(event["args"]["trace_id"], trace_id);
+            EXPECT_GE(event["dur"].get<int64_t>(), 0);
+        }
+        if (name.rfind("named:x", 0) == 0) {
+            EXPECT_EQ(name.size(), sizeof(Tracer::Span::name) - 1);
+        }
+    }
+    EXPECT_TRUE(found);
+    EXPECT_EQ(count_events("named_fixed"), 1u);
+}
+
+/**
+ * @brief Dumping while a thread overwrites its ring buffer only gives
+ * whole spans: a torn slot is skipped.
+ *
+ */
+TEST_F(TracerTest, DumpsWhileRecording) {
+    std::atomic<bool> done{false};
+    std::thread writer([&done]() {
+        Tracer::begin_trace(true);
+        for (int64_t i = 1; i <= static_cast<int64_t>(Tracer::BUFFER_SIZE) * 4; i++) {
+            std::string name = "torn:" + std::to_string(i);
+
+            Tracer::record(name.c_str(), i, i * 2);
+        }
+        Tracer::end_trace();
+        done = true;
+    });
+
+    while (!done) {
+        for (const auto &event : dump_events()) {
+            std::string name = event["name"];
+
+            if (name.rfind("torn:", 0) != 0)
+                continue;
+            int64_t start = event["ts"];
+            EXPECT_EQ(name, "torn:" + std::to_string(start));
+            EXPECT_EQ(event["dur"], start);
+        }
+    }
+    writer.join();
+    EXPECT_EQ(count_events("torn:"), Tracer::BUFFER_SIZE);
+}
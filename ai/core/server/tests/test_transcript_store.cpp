@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "TranscriptStore.hpp"
+
+// Test fixture for TranscriptStore tests
+class TranscriptStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        directory = std::filesystem::temp_directory_path() / "talkup_transcripts_test";
+        store = std::make_unique<talkup_network::TranscriptStore>(directory.string());
+        // Vosk-like result: words timed in seconds.
+        store->append("s1", talkup_network::TranscriptStore::parse_stt_result(nlohmann::json::parse(R"({
+            "text": "hello my name",
+            "result": [
+                {"word": "hello", "start": 0.0, "end": 0.4},
+                {"word": "my", "start": 0.5, "end": 0.6},
+                {"word": "name", "start": 0.7, "end": 1.0}
+            ]})")));
+        store->append("s1", talkup_network::TranscriptStore::parse_stt_result(nlohmann::json::parse(R"({
+            "text": "is alex",
+            "result": [
+                {"word": "is", "start": 0.1, "end": 0.2},
+                {"word": "alex", "start": 0.3, "end": 0.8}
+            ]})"), 1000));
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::filesystem::path directory;
+    std::unique_ptr<talkup_network::TranscriptStore> store;
+};
+
+/**
+ * @brief The full transcript is kept up to date as segments arrive.
+ *
+ */
+TEST_F(TranscriptStoreTest, FullTextSoFar) {
+    EXPECT_EQ(store->get_text("s1"), "hello my name is alex");
+    EXPECT_EQ(store->get_text("unknown"), "");
+}
+
+/**
+ * @brief A time range returns the words overlapping it, including a word started before it.
+ *
+ */
+TEST_F(TranscriptStoreTest, WordsInRange) {
+    auto words = store->get_words("s1", 800, 1350);
+
+    ASSERT_EQ(words.size(), 3u);
+    EXPECT_EQ(words[0].text, "name");
+    EXPECT_EQ(words[1].text, "is");
+    EXPECT_EQ(words[2].text, "alex");
+}
+
+/**
+ * @brief A segment received late is put back in place.
+ *
+ */
+TEST_F(TranscriptStoreTest, OutOfOrderSegment) {
+    talkup_network::TranscriptStore::Segment segment{"well", -500, -200, {{"well", -500, -200}}};
+
+    store->append("s1", segment);
+    EXPECT_EQ(store->get_text("s1"), "well hello my name is alex");
+    EXPECT_EQ(store->get_words("s1", -1000, 0).front().text, "well");
+}
+
+/**
+ * @brief A finished transcript is written to disk and released.
+ *
+ */
+TEST_F(TranscriptStoreTest, CompactToDisk) {
+    auto compaction = store->compact("s1");
+
+    ASSERT_TRUE(compaction.ok);
+    ASSERT_FALSE(compaction.name.empty());
+    EXPECT_TRUE(std::filesystem::exists(directory / compaction.name));
+    EXPECT_FALSE(std::filesystem::exists(directory / (compaction.name + ".tmp")));
+    EXPECT_EQ(store->get_text("s1"), "");
+    compaction = store->compact("s1");
+    EXPECT_TRUE(compaction.ok);
+    EXPECT_EQ(compaction.name, "");
+}
+
+/**
+ * @brief A transcript which can't be written is reported and kept,
+ * so it can be compacted again.
+ *
+ */
+TEST_F(TranscriptStoreTest, KeepsTranscriptOnFailedWrite) {
+    // A file where the directory should be.
+    std::filesystem::path blocked = directory.string() + "_blocked";
+    talkup_network::TranscriptStore failing(blocked.string());
+
+    std::ofstream(blocked) << "";
+    failing.append("s1", {"hello", 0, 400, {{"hello", 0, 400}}});
+    auto compaction = failing.compact("s1");
+    EXPECT_FALSE(compaction.ok);
+    EXPECT_FALSE(compaction.error.empty());
+    EXPECT_EQ(failing.get_text("s1"), "hello");
+
+    std::filesystem::remove(blocked);
+    compaction = failing.compact("s1");
+    EXPECT_TRUE(compaction.ok);
+    EXPECT_TRUE(std::filesystem::exists(blocked / compaction.name));
+    EXPECT_EQ(failing.get_text("s1"), "");
+    std::filesystem::remove_all(blocked);
+}
+
+/**
+ * @brief Two compactions of a stream in the same second write two files.
+ *
+ */
+TEST_F(TranscriptStoreTest, UniqueNamePerCompaction) {
+    auto first = store->compact("s1");
+
+    store->append("s1", {"again", 2000, 2400, {{"again", 2000, 2400}}});
+    auto second = store->compact("s1");
+    ASSERT_TRUE(first.ok);
+    ASSERT_TRUE(second.ok);
+    EXPECT_NE(first.name, second.name);
+    EXPECT_TRUE(std::filesystem::exists(directory / first.name));
+    EXPECT_TRUE(std::filesystem::exists(directory / second.name));
+}
+
+/**
+ * @brief A segment appended while the transcript is compacted is either
+ * in the written file or in the next transcript, never lost.
+ *
+ */
+TEST_F(TranscriptStoreTest, KeepsSegmentsAppendedDuringCompaction) {
+    std::atomic<bool> done{false};
+    std::thread writer([this, &done]() {
+        for (int64_t i = 0; i < 200; i++)
+            store->append("s2", {"w" + std::to_string(i), i * 10, i * 10 + 5, {{"w", i * 10, i * 10 + 5}}});
+        done = true;
+    });
+    size_t written = 0;
+
+    while (!done) {
+        auto compaction = store->compact("s2");
+
+        ASSERT_TRUE(compaction.ok);
+        if (compaction.name.empty())
+            continue;
+        std::ifstream file(directory / compaction.name);
+        written += nlohmann::json::parse(file)["segments"].size();
+    }
+    writer.join();
+    auto last = store->compact("s2");
+    if (!last.name.empty()) {
+        std::ifstream file(directory / last.name);
+        written += nlohmann::json::parse(file)["segments"].size();
+    }
+    EXPECT_EQ(written, 200u);
+}
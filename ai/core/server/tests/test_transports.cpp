@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "CrowTransport.hpp"
+#include "UringTransport.hpp"
+#include "ws_client.hpp"
+
+using namespace ws_client;
+
+// Test fixture for the route and handler tests, run on every transport
+class TransportTest : public ::testing::TestWithParam<std::string> {
+protected:
+    void SetUp() override {
+        setenv("COMMUNICATION", "test_key", 1);
+        setenv("WS_ADDRESS", "ws://localhost/ws", 1);
+        if (GetParam() == "io_uring") {
+            if (!talkup_network::UringTransport::is_supported())
+                GTEST_SKIP() << "io_uring is not supported here";
+            transport = std::make_unique<talkup_network::UringTransport>(2);
+        } else {
+            transport = std::make_unique<talkup_network::CrowTransport>();
+        }
+        port = get_free_port();
+        server_thread = std::thread([this]() { transport->run(router, port); });
+        transport->wait_for_start();
+    }
+
+    void TearDown() override {
+        if (!transport)
+            return;
+        transport->stop();
+        server_thread.join();
+    }
+
+    std::string ws_message(const std::string &type, const std::string &key) {
+        nlohmann::json message;
+
+        message["type"] = type;
+        message["key"] = key;
+        message["stream_id"] = "stream";
+        message["format"] = "text";
+        message["timestamp"] = 0;
+        message["data"] = "hello";
+        return message.dump();
+    }
+
+    talkup_network::Router router;
+    std::unique_ptr<ITransport> transport;
+    std::thread server_thread;
+    int port = 0;
+};
+
+/**
+ * @brief /live answers as long as the server runs.
+ *
+ */
+TEST_P(TransportTest, Live) {
+    std::string response = http_request(port,
+        "GET /live HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+
+    EXPECT_NE(response.find(" 200 "), std::string::npos);
+    EXPECT_NE(response.find("alive"), std::string::npos);
+}
+
+/**
+ * @brief /process/initialization gives the WebSocket address for the server key.
+ *
+ */
+TEST_P(TransportTest, Initialization) {
+    std::string body = R"({"key":"test_key","type":"initialization","format":"text"})";
+    std::string response = http_request(port, "POST /process/initialization HTTP/1.1\r\n"
+        "Host: localhost\r\nContent-Type: application/json\r\nContent-Length: "
+        + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+
+    EXPECT_NE(response.find(" 200 "), std::string::npos);
+    EXPECT_NE(response.find("initialization_response"), std::string::npos);
+    EXPECT_NE(response.find("ws://localhost/ws"), std::string::npos);
+}
+
+/**
+ * @brief An unknown route answers 404.
+ *
+ */
+TEST_P(TransportTest, UnknownRoute) {
+    std::string response = http_request(port,
+        "GET /unknown HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+
+    EXPECT_NE(response.find(" 404 "), std::string::npos);
+}
+
+/**
+ * @brief A ping on /ws is answered with a pong carrying the same data.
+ *
+ */
+TEST_P(TransportTest, WebSocketPing) {
+    int fd = ws_connect(port);
+
+    ASSERT_GE(fd, 0);
+    ws_send(fd, ws_message("ping", "test_key"));
+    auto reply = nlohmann::json::parse(ws_receive(fd));
+    EXPECT_EQ(reply["type"], "pong");
+    EXPECT_EQ(reply["data"], "hello");
+    close(fd);
+}
+
+/**
+ * @brief A /ws message with a wrong key is answered with an error.
+ *
+ */
+TEST_P(TransportTest, WebSocketInvalidKey) {
+    int fd = ws_connect(port);
+
+    ASSERT_GE(fd, 0);
+    ws_send(fd, ws_message("ping", "wrong_key"));
+    auto reply = nlohmann::json::parse(ws_receive(fd));
+    EXPECT_EQ(reply["type"], "error");
+    close(fd);
+}
+
+/**
+ * @brief Messages sent at once are answered in the order they were sent.
+ *
+ */
+TEST_P(TransportTest, WebSocketKeepsOrder) {
+    int fd = ws_connect(port);
+
+    ASSERT_GE(fd, 0);
+    for (int i = 0; i < 8; i++)
+        ws_send(fd, ws_message("ping", i % 2 ? "wrong_key" : "test_key"));
+    for (int i = 0; i < 8; i++) {
+        auto reply = nlohmann::json::parse(ws_receive(fd));
+        EXPECT_EQ(reply["type"], i % 2 ? "error" : "pong");
+    }
+    close(fd);
+}
+
+INSTANTIATE_TEST_SUITE_P(Transports, TransportTest,::testing::Values("crow", "io_uring"),
+    [](const ::testing::TestParamInfo<std::string> &info) {
+        return info.param == "io_uring" ? std::string("IoUring") : std::string("Crow");
+    });
+
+// Test fixture for the heartbeat tests, with a short idle timeout
+class HeartbeatTest : public TransportTest {
+protected:
+    void SetUp() override {
+        setenv("IDLE_TIMEOUT_MS", "300", 1);
+        TransportTest::SetUp();
+    }
+
+    void TearDown() override {
+        TransportTest::TearDown();
+        unsetenv("IDLE_TIMEOUT_MS");
+    }
+};
+
+/**
+ * @brief A silent connection is closed once the idle timeout is over.
+ *
+ */
+TEST_P(HeartbeatTest, ClosesIdleConnection) {
+    int fd = ws_connect(port);
+
+    ASSERT_GE(fd, 0);
+    EXPECT_TRUE(ws_wait_close(fd, 3000));
+    close(fd);
+}
+
+/**
+ * @brief A connection which keeps pinging stays open past the idle timeout.
+ *
+ */
+TEST_P(HeartbeatTest, KeepsPingingConnection) {
+    int fd = ws_connect(port);
+
+    ASSERT_GE(fd, 0);
+    for (int i = 0; i < 10; i++) {
+        ws_send(fd, ws_message("ping", "test_key"));
+        auto reply = nlohmann::json::parse(ws_receive(fd));
+        ASSERT_EQ(reply["type"], "pong");
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    ws_send(fd, ws_message("ping", "test_key"));
+    EXPECT_EQ(nlohmann::json::parse(ws_receive(fd))["type"], "pong");
+    close(fd);
+}
+
+INSTANTIATE_TEST_SUITE_P(Transports, HeartbeatTest, ::testing::Values("crow", "io_uring"),
+    [](const ::testing::TestParamInfo<std::string> &info) {
+        return info.param == "io_uring" ? std::string("IoUring") : std::string("Crow");
+    });
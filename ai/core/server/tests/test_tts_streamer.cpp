@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "Tracer.hpp"
+#include "TtsStreamer.hpp"
+
+using Clock = talkup_network::TtsStreamer::Clock;
+using Frame = talkup_network::TtsStreamer::Frame;
+using Status = talkup_network::TtsStreamer::SpeakStatus;
+
+// Test fixture for TtsStreamer tests
+class TtsStreamerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        options.frame_bytes = 100;
+        options.frame_duration = std::chrono::milliseconds(10);
+        options.lead = std::chrono::milliseconds(30);
+    }
+
+    void TearDown() override {
+    }
+
+    // Produces size bytes of audio in parts of part bytes, one part every delay.
+    talkup_network::TtsStreamer::Source source(size_t size, size_t part,
+        std::chrono::milliseconds delay) {
+        return [size, part, delay](const std::string &, Clock::time_point,
+            const talkup_network::ServicePool::OnData &on_audio) {
+            talkup_network::ServicePool::Result result;
+
+            for (size_t sent = 0; sent < size; sent += part) {
+                std::this_thread::sleep_for(delay);
+                if (!on_audio(std::string(std::min(part, size - sent), 'a')))
+                    return result;
+            }
+            result.ok = true;
+            return result;
+        };
+    }
+
+    talkup_network::TtsStreamer::Sink sink(void) {
+        return [this](const Frame &frame) {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            frames.push_back(frame);
+            times.push_back(Clock::now());
+        };
+    }
+
+    bool wait_for_last(std::chrono::milliseconds timeout) {
+        auto deadline = Clock::now() + timeout;
+
+        while (Clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!frames.empty() && frames.back().last)
+                    return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    talkup_network::TtsStreamer::Options options;
+    std::mutex mutex;
+    std::vector<Frame> frames;
+    std::vector<Clock::time_point> times;
+};
+
+/**
+ * @brief The audio comes back as numbered fixed-size frames, the last one flagged.
+ *
+ */
+TEST_F(TtsStreamerTest, SendsNumberedFrames) {
+    talkup_network::TtsStreamer streamer(options, source(1050, 70, std::chrono::milliseconds(0)));
+
+    std::string id;
+
+    ASSERT_EQ(streamer.speak("abc", nullptr, "Hello", sink(), id), Status::STARTED);
+    ASSERT_TRUE(wait_for_last(std::chrono::seconds(2)));
+    ASSERT_EQ(frames.size(), 11u);
+    for (size_t i = 0; i < frames.size(); i++) {
+        EXPECT_EQ(frames[i].utterance_id, id);
+        EXPECT_EQ(frames[i].seq, static_cast<int64_t>(i));
+        EXPECT_EQ(frames[i].audio.size(), i < 10 ? 100u : 50u);
+        EXPECT_EQ(frames[i].last, i == 10);
+    }
+    EXPECT_TRUE(frames.back().error.empty());
+}
+
+/**
+ * @brief The first frame goes out before the synthesis is over, then frames
+ * follow the playback pace with lead of advance.
+ *
+ */
+TEST_F(TtsStreamerTest, PacesFrames) {
+    auto start = Clock::now();
+    talkup_network::TtsStreamer streamer(options, source(2000, 500, std::chrono::milliseconds(20)));
+    std::string id;
+
+    streamer.speak("abc", nullptr, "Hello", sink(), id);
+    ASSERT_TRUE(wait_for_last(std::chrono::seconds(2)));
+    ASSERT_EQ(frames.size(), 20u);
+    EXPECT_LT(times[0] - start, std::chrono::milliseconds(60));
+    // 20 frames of 10 ms, 30 ms ahead: the last one is due 160 ms after the first.
+    EXPECT_GE(times.back() - times[0], std::chrono::milliseconds(150));
+    EXPECT_LT(times[3] - times[0], std::chrono::milliseconds(10));
+}
+
+/**
+ * @brief No frame is sent once the utterance is interrupted, and a new
+ * utterance replaces the current one.
+ *
+ */
+TEST_F(TtsStreamerTest, Cancels) {
+    talkup_network::TtsStreamer streamer(options, source(100000, 100, std::chrono::milliseconds(1)));
+    std::string id;
+
+    streamer.speak("abc", nullptr, "Hello", sink(), id);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(streamer.cancel("abc", nullptr));
+    size_t sent = frames.size();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_GT(sent, 0u);
+    EXPECT_EQ(frames.size(), sent);
+    EXPECT_FALSE(frames.back().last);
+    EXPECT_FALSE(streamer.cancel("abc", nullptr));
+
+    int owner = 0;
+    streamer.speak("def", &owner, "Hello", sink(), id);
+    id.clear();
+    streamer.speak("def", &owner, "Again", sink(), id);
+    streamer.cancel_owner(&owner);
+    EXPECT_FALSE(streamer.cancel("def", &owner));
+    EXPECT_FALSE(id.empty());
+}
+
+/**
+ * @brief A failed synthesis ends the utterance with an error.
+ *
+ */
+TEST_F(TtsStreamerTest, ReportsErrors) {
+    talkup_network::TtsStreamer streamer(options, [](const std::string &, Clock::time_point,
+        const talkup_network::ServicePool::OnData &) {
+        talkup_network::ServicePool::Result result;
+
+        result.error = "circuit open: tts";
+        return result;
+    });
+    std::string id;
+
+    streamer.speak("abc", nullptr, "Hello", sink(), id);
+    ASSERT_TRUE(wait_for_last(std::chrono::seconds(2)));
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_TRUE(frames[0].audio.empty());
+    EXPECT_EQ(frames[0].error, "circuit open: tts");
+}
+
+/**
+ * @brief A stream speaking to a connection can't be interrupted nor taken
+ * over by another one.
+ *
+ */
+TEST_F(TtsStreamerTest, KeepsUtterancesToTheirOwner) {
+    talkup_network::TtsStreamer streamer(options, source(100000, 100, std::chrono::milliseconds(1)));
+    int owner = 0;
+    int other = 0;
+    std::string id;
+
+    ASSERT_EQ(streamer.speak("abc", &owner, "Hello", sink(), id), Status::STARTED);
+    EXPECT_EQ(streamer.speak("abc", &other, "Hello", sink(), id), Status::OWNED_ELSEWHERE);
+    EXPECT_FALSE(streamer.cancel("abc", &other));
+    EXPECT_TRUE(streamer.cancel("abc", &owner));
+}
+
+/**
+ * @brief Past max_per_owner utterances running for a connection, or
+ * max_utterances in all, speak is refused until one is over.
+ *
+ */
+TEST_F(TtsStreamerTest, BoundsUtterances) {
+    options.max_utterances = 3;
+    options.max_per_owner = 2;
+    talkup_network::TtsStreamer streamer(options, source(1000, 100, std::chrono::milliseconds(20)));
+    int owner = 0;
+    int other = 0;
+    std::string id;
+
+    EXPECT_EQ(streamer.speak("a", &owner, "Hello", sink(), id), Status::STARTED);
+    EXPECT_EQ(streamer.speak("b", &owner, "Hello", sink(), id), Status::STARTED);
+    EXPECT_EQ(streamer.speak("c", &owner, "Hello", sink(), id), Status::BUSY);
+    EXPECT_EQ(streamer.speak("d", &other, "Hello", sink(), id), Status::STARTED);
+    EXPECT_EQ(streamer.speak("e", &other, "Hello", sink(), id), Status::BUSY);
+    // An interrupted utterance counts until its synthesis has stopped.
+    EXPECT_TRUE(streamer.cancel("a", &owner));
+    auto deadline = Clock::now() + std::chrono::seconds(2);
+    Status status = Status::BUSY;
+    while (status == Status::BUSY && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        status = streamer.speak("c", &owner, "Hello", sink(), id);
+    }
+    EXPECT_EQ(status, Status::STARTED);
+}
+
+/**
+ * @brief An utterance started while its message is traced records the time
+ * to its first audio in that trace, from the pacing thread.
+ *
+ */
+TEST_F(TtsStreamerTest, TracesFirstAudio) {
+    talkup_network::TtsStreamer streamer(options, source(200, 100, std::chrono::milliseconds(0)));
+    std::string id;
+    uint64_t trace_id = talkup_network::Tracer::begin_trace(true);
+
+    ASSERT_NE(trace_id, 0u);
+    ASSERT_EQ(streamer.speak("traced", nullptr, "Hello", sink(), id), Status::STARTED);
+    talkup_network::Tracer::end_trace();
+    ASSERT_TRUE(wait_for_last(std::chrono::seconds(2)));
+
+    std::ostringstream out;
+    bool found = false;
+    talkup_network::Tracer::dump(out);
+    auto events = nlohmann::json::parse(out.str())["traceEvents"];
+
+    for (const auto &event : events) {
+        if (event["name"] == "tts_first_audio" && event["args"]["trace_id"] == trace_id)
+            found = true;
+    }
+    EXPECT_TRUE(found);
+}
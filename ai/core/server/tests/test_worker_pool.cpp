@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "WorkerPool.hpp"
+
+// Test fixture for WorkerPool tests
+class WorkerPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+
+    void TearDown() override {}
+};
+
+/**
+ * @brief The tasks of a key run in order, and every task is run before
+ * stop returns.
+ *
+ */
+TEST_F(WorkerPoolTest, RunsKeyInOrder) {
+    talkup_network::WorkerPool pool("TEST", 4);
+    std::mutex mutex;
+    std::vector<int> order;
+    std::atomic<int> count{0};
+
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(pool.submit([&, i]() {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            order.push_back(i);
+        }, 42));
+        EXPECT_TRUE(pool.submit([&]() { count++; }));
+    }
+    pool.stop();
+    ASSERT_EQ(order.size(), 100u);
+    for (int i = 0; i < 100; i++)
+        EXPECT_EQ(order[i], i);
+    EXPECT_EQ(count, 100);
+    EXPECT_FALSE(pool.submit([]() {}));
+}
+
+/**
+ * @brief A full queue refuses try_submit, and a task which throws doesn't
+ * stop its thread.
+ *
+ */
+TEST_F(WorkerPoolTest, BoundsQueue) {
+    talkup_network::WorkerPool pool("TEST", 1, 2);
+    std::atomic<bool> release{false};
+    std::atomic<bool> started{false};
+    std::atomic<bool> ran{false};
+
+    ASSERT_TRUE(pool.submit([&]() {
+        started = true;
+        while (!release)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        throw std::runtime_error("task failed");
+    }));
+    while (!started)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_TRUE(pool.try_submit([]() {}));
+    EXPECT_TRUE(pool.try_submit([]() {}));
+    EXPECT_FALSE(pool.try_submit([]() {}));
+    EXPECT_EQ(pool.get_size(), 2u);
+    release = true;
+    EXPECT_TRUE(pool.submit([&]() { ran = true; }));
+    pool.stop();
+    EXPECT_TRUE(ran);
+}
@@ -0,0 +1,169 @@
+/*
+** Talkup Project, 2025
+** TalkUp.AI
+** File description:
+** Minimal blocking HTTP and WebSocket client used by the tests
+** which talk to a running server.
+*/
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace ws_client {
+    inline int connect_to(int port)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr;
+
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    inline int get_free_port(void)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+        close(fd);
+        return ntohs(addr.sin_port);
+    }
+
+    inline std::string http_request(int port, const std::string &request)
+    {
+        int fd = connect_to(port);
+        std::string response;
+        char buffer[4096];
+        ssize_t n;
+
+        if (fd < 0)
+            return "";
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+        while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+            response.append(buffer, static_cast<size_t>(n));
+        close(fd);
+        return response;
+    }
+
+    inline bool read_exactly(int fd, char *data, size_t size)
+    {
+        while (size > 0) {
+            ssize_t n = recv(fd, data, size, 0);
+
+            if (n <= 0)
+                return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    inline int ws_connect(int port)
+    {
+        int fd = connect_to(port);
+        std::string request = "GET /ws HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+            "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+            "Sec-WebSocket-Version: 13\r\n\r\n";
+        std::string response;
+        char c;
+
+        if (fd < 0)
+            return -1;
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+        while (response.find("\r\n\r\n") == std::string::npos && read_exactly(fd, &c, 1))
+            response += c;
+        if (response.find("101") == std::string::npos
+            || response.find("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == std::string::npos) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    inline void ws_send(int fd, const std::string &text)
+    {
+        const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+        std::string frame;
+
+        frame.push_back(static_cast<char>(0x81));
+        if (text.size() < 126) {
+            frame.push_back(static_cast<char>(0x80 | text.size()));
+        } else {
+            frame.push_back(static_cast<char>(0x80 | 126));
+            frame.push_back(static_cast<char>(text.size() >> 8));
+            frame.push_back(static_cast<char>(text.size()));
+        }
+        frame.append(reinterpret_cast<const char *>(mask), 4);
+        for (size_t i = 0; i < text.size(); i++)
+            frame.push_back(static_cast<char>(text[i] ^ mask[i & 3]));
+        send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+    }
+
+    inline std::string ws_receive(int fd)
+    {
+        unsigned char header[2];
+        uint64_t length;
+        std::string payload;
+
+        if (!read_exactly(fd, reinterpret_cast<char *>(header), 2))
+            return "";
+        length = header[1] & 0x7f;
+        if (length >= 126) {
+            unsigned char extended[8];
+            size_t size = length == 126 ? 2 : 8;
+
+            if (!read_exactly(fd, reinterpret_cast<char *>(extended), size))
+                return "";
+            length = 0;
+            for (size_t i = 0; i < size; i++)
+                length = (length << 8) | extended[i];
+        }
+        payload.resize(length);
+        if (!read_exactly(fd, payload.data(), length))
+            return "";
+        return payload;
+    }
+
+    // Whether the server closes the connection (close frame or EOF) within timeout_ms.
+    inline bool ws_wait_close(int fd, int timeout_ms)
+    {
+        timeval timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+        unsigned char header[2];
+
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        while (true) {
+            ssize_t n = recv(fd, header, 1, MSG_PEEK);
+
+            if (n == 0)
+                return true;
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                return false;
+            if ((header[0] & 0x0f) == 0x08)
+                return true;
+            ws_receive(fd);
+        }
+    }
+}
@@ -0,0 +1,266 @@
+##
+## Talkup Project, 2025
+## TalkUp.AI
+## File description:
+## This is the shm_ring.py of the microservices network.
+##
+
+"""
+Shared-memory transport between the AI Server and a microservice running on
+the same host. It mirrors ShmRing and ShmChannel of the AI Server: the service
+creates the segment /dev/shm/<name>, with one ring for the requests of the
+server and one for its replies. Records carry the JSON message and the raw
+payload (e.g. PCM16 samples) as they are, without Base64 or JSON encoding.
+
+The rings are single-producer/single-consumer and the consumer sleeps on a
+futex. The head, tail, seq and waiting words are read and written through
+libatomic with the memory orders of the C++ side, so the records are published
+by the tail store and the WAITING/seq handshake can't lose a wakeup.
+"""
+
+from network.protocol import create_message
+
+import ctypes
+import json
+import mmap
+import os
+import platform
+import struct
+import threading
+import time
+
+MAGIC = 0x4B4C4154
+VERSION = 1
+SEGMENT_HEADER_SIZE = 64
+HEARTBEAT_OFFSET = 16
+HEARTBEAT_INTERVAL = 0.5
+RING_HEADER_SIZE = 128
+TAIL_OFFSET = 0
+SEQ_OFFSET = 8
+WAITING_OFFSET = 12
+HEAD_OFFSET = 64
+RECORD_HEADER_SIZE = 16
+WRAP_MARKER = 0xFFFFFFFF
+DEFAULT_CAPACITY = 4 << 20
+
+_FUTEX_WAIT = 0
+_FUTEX_WAKE = 1
+_SYS_FUTEX = {"x86_64": 202, "aarch64": 98}.get(platform.machine())
+_libc = ctypes.CDLL(None, use_errno=True)
+
+_RELAXED = 0
+_ACQUIRE = 2
+_RELEASE = 3
+_SEQ_CST = 5
+_atomic = ctypes.CDLL("libatomic.so.1")
+# Looked up by name: inside the classes, __atomic_* would be mangled.
+_load_8 = getattr(_atomic, "__atomic_load_8")
+_store_8 = getattr(_atomic, "__atomic_store_8")
+_load_4 = getattr(_atomic, "__atomic_load_4")
+_store_4 = getattr(_atomic, "__atomic_store_4")
+_fetch_add_4 = getattr(_atomic, "__atomic_fetch_add_4")
+_load_8.argtypes = [ctypes.c_void_p, ctypes.c_int]
+_load_8.restype = ctypes.c_uint64
+_store_8.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.c_int]
+_store_8.restype = None
+_load_4.argtypes = [ctypes.c_void_p, ctypes.c_int]
+_load_4.restype = ctypes.c_uint32
+_store_4.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_int]
+_store_4.restype = None
+_fetch_add_4.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_int]
+_fetch_add_4.restype = ctypes.c_uint32
+
+
+class _Timespec(ctypes.Structure):
+    _fields_ = [("tv_sec", ctypes.c_long), ("tv_nsec", ctypes.c_long)]
+
+
+class ShmRing:
+    def __init__(self, buffer: mmap.mmap, offset: int, capacity: int):
+        """
+        Initialize a ring over the mapped segment, at offset.
+        """
+        self.buffer = buffer
+        self.base = offset
+        self.data = offset + RING_HEADER_SIZE
+        self.capacity = capacity
+        self.peeked = 0
+        self._head = ctypes.c_uint64.from_buffer(buffer, offset + HEAD_OFFSET)
+        self._tail = ctypes.c_uint64.from_buffer(buffer, offset + TAIL_OFFSET)
+        self._seq = ctypes.c_uint32.from_buffer(buffer, offset + SEQ_OFFSET)
+        self._waiting = ctypes.c_uint32.from_buffer(buffer, offset + WAITING_OFFSET)
+
+    def close(self) -> None:
+        """
+        Release the header words so the segment can be unmapped.
+        """
+        del self._head
+        del self._tail
+        del self._seq
+        del self._waiting
+
+    def push(self, record_id: int, meta: bytes, data=b"") -> bool:
+        """
+        Write a record and wake the consumer if it sleeps.
+        Returns False if the ring is full.
+        """
+        head = _load_8(ctypes.byref(self._head), _ACQUIRE)
+        tail = _load_8(ctypes.byref(self._tail), _RELAXED)
+        length = RECORD_HEADER_SIZE + len(meta) + len(data)
+        padded = (length + 7) & ~7
+        offset = tail & (self.capacity - 1)
+        skip = self.capacity - offset if offset + padded > self.capacity else 0
+
+        if padded > self.capacity // 2 or self.capacity - (tail - head) < skip + padded:
+            return False
+        if skip:
+            struct.pack_into("<I", self.buffer, self.data + offset, WRAP_MARKER)
+            tail += skip
+            offset = 0
+        start = self.data + offset
+        struct.pack_into("<IIQ", self.buffer, start, length, len(meta), record_id)
+        start += RECORD_HEADER_SIZE
+        self.buffer[start:start + len(meta)] = meta
+        start += len(meta)
+        self.buffer[start:start + len(data)] = data
+        _store_8(ctypes.byref(self._tail), tail + padded, _RELEASE)
+        _fetch_add_4(ctypes.byref(self._seq), 1, _SEQ_CST)
+        waiting = _load_4(ctypes.byref(self._waiting), _SEQ_CST)
+        if waiting and _SYS_FUTEX is not None:
+            _libc.syscall(_SYS_FUTEX, ctypes.byref(self._seq), _FUTEX_WAKE, 1, None, None, 0)
+        return True
+
+    def peek(self):
+        """
+        Read the oldest record without consuming it: (id, meta, payload), or None.
+        The payload is a view into the ring, valid until pop is called.
+        """
+        head = _load_8(ctypes.byref(self._head), _RELAXED)
+        tail = _load_8(ctypes.byref(self._tail), _ACQUIRE)
+
+        while head != tail:
+            offset = head & (self.capacity - 1)
+            start = self.data + offset
+            length = struct.unpack_from("<I", self.buffer, start)[0]
+            if length == WRAP_MARKER:
+                head += self.capacity - offset
+                _store_8(ctypes.byref(self._head), head, _RELEASE)
+                continue
+            length, meta_length, record_id = struct.unpack_from("<IIQ", self.buffer, start)
+            start += RECORD_HEADER_SIZE
+            meta = bytes(self.buffer[start:start + meta_length])
+            payload = memoryview(self.buffer)[start + meta_length:start + length - RECORD_HEADER_SIZE]
+            self.peeked = (length + 7) & ~7
+            return record_id, meta, payload
+        return None
+
+    def pop(self) -> None:
+        """
+        Consume the record read by peek.
+        """
+        head = _load_8(ctypes.byref(self._head), _RELAXED)
+
+        _store_8(ctypes.byref(self._head), head + self.peeked, _RELEASE)
+        self.peeked = 0
+
+    def wait(self, timeout: float) -> bool:
+        """
+        Sleep until the ring has a record or the timeout (in seconds) is over.
+        """
+        def has_record():
+            return (_load_8(ctypes.byref(self._head), _RELAXED)
+                != _load_8(ctypes.byref(self._tail), _ACQUIRE))
+
+        if has_record():
+            return True
+        if _SYS_FUTEX is None:
+            time.sleep(min(timeout, 0.001))
+            return has_record()
+        # Sequentially consistent, as in C++: either the writer sees WAITING and
+        # wakes the futex, or this reads its record or its new seq.
+        _store_4(ctypes.byref(self._waiting), 1, _SEQ_CST)
+        seq = _load_4(ctypes.byref(self._seq), _SEQ_CST)
+        if not has_record():
+            delay = _Timespec(int(timeout), int((timeout % 1) * 1e9))
+            _libc.syscall(_SYS_FUTEX, ctypes.byref(self._seq), _FUTEX_WAIT,
+                ctypes.c_uint32(seq), ctypes.byref(delay), None, 0)
+        _store_4(ctypes.byref(self._waiting), 0, _SEQ_CST)
+        return has_record()
+
+
+class ShmEndpoint:
+    def __init__(self, name: str, capacity: int = DEFAULT_CAPACITY):
+        """
+        Create the segment of the service (e.g. talkup_stt, the "Shm" value of
+        services.json). A segment left by a previous run is replaced.
+        """
+        self.path = "/dev/shm/" + name
+        self.size = SEGMENT_HEADER_SIZE + 2 * (RING_HEADER_SIZE + capacity)
+        self.running = True
+        try:
+            os.unlink(self.path)
+        except FileNotFoundError:
+            pass
+        fd = os.open(self.path, os.O_CREAT | os.O_EXCL | os.O_RDWR, 0o600)
+        try:
+            os.ftruncate(fd, self.size)
+            self.buffer = mmap.mmap(fd, self.size)
+        finally:
+            os.close(fd)
+        struct.pack_into("<IIII", self.buffer, 0, MAGIC, VERSION, capacity, os.getpid())
+        self.requests = ShmRing(self.buffer, SEGMENT_HEADER_SIZE, capacity)
+        self.replies = ShmRing(self.buffer, SEGMENT_HEADER_SIZE + RING_HEADER_SIZE + capacity, capacity)
+        self._beat()
+        # The heartbeat has its own thread so a long task doesn't look like a dead service.
+        self.heartbeat = threading.Thread(target=self._heartbeat_loop, daemon=True)
+        self.heartbeat.start()
+
+    def _beat(self) -> None:
+        struct.pack_into("<q", self.buffer, HEARTBEAT_OFFSET, int(time.monotonic() * 1000))
+
+    def _heartbeat_loop(self) -> None:
+        while self.running:
+            self._beat()
+            time.sleep(HEARTBEAT_INTERVAL)
+
+    def serve(self, handler, stop: threading.Event = None) -> None:
+        """
+        Answer the requests of the AI Server until stop is set.
+        handler(message: dict, payload: memoryview) returns the reply message
+        (a dict or a Message). The payload must not be kept after it returns.
+        """
+        while self.running and (stop is None or not stop.is_set()):
+            if not self.requests.wait(HEARTBEAT_INTERVAL):
+                continue
+            record = self.requests.peek()
+            while record is not None:
+                record_id, meta, payload = record
+                try:
+                    reply = handler(json.loads(meta), payload)
+                    if hasattr(reply, "model_dump"):
+                        reply = reply.model_dump()
+                except Exception as e:
+                    reply = create_message(["internal"], "error", {"message": str(e)}).model_dump()
+                finally:
+                    payload.release()
+                self.requests.pop()
+                body = json.dumps(reply).encode()
+                while not self.replies.push(record_id, body):
+                    if stop is not None and stop.is_set():
+                        return
+                    time.sleep(0.001)
+                record = self.requests.peek()
+
+    def close(self) -> None:
+        """
+        Stop the heartbeat and remove the segment: the AI Server goes back to the network.
+        """
+        self.running = False
+        self.heartbeat.join()
+        self.requests.close()
+        self.replies.close()
+        self.buffer.close()
+        try:
+            os.unlink(self.path)
+        except FileNotFoundError:
+            pass
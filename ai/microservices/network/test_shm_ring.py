@@ -0,0 +1,99 @@
+##
+## Talkup Project, 2025
+## TalkUp.AI
+## File description:
+## This is the test_shm_ring.py of the microservices network.
+## Run from ai/microservices: python -m unittest network.test_shm_ring
+##
+
+from network.shm_ring import ShmEndpoint
+
+import json
+import os
+import threading
+import unittest
+
+
+class ShmRingTest(unittest.TestCase):
+    def setUp(self):
+        """
+        A small segment, so the records wrap around the end of the rings.
+        """
+        self.endpoint = ShmEndpoint("talkup_test_%d" % os.getpid(), 4096)
+        self.stop = threading.Event()
+        self.server = None
+
+    def tearDown(self):
+        self.stop.set()
+        if self.server is not None:
+            self.server.join()
+        self.endpoint.close()
+
+    def serve(self, handler):
+        self.server = threading.Thread(target=self.endpoint.serve, args=(handler, self.stop))
+        self.server.start()
+
+    def call(self, record_id: int, message: dict, payload: bytes) -> dict:
+        """
+        Send a request as the AI Server does and wait for its reply.
+        """
+        self.assertTrue(self.endpoint.requests.push(record_id, json.dumps(message).encode(), payload))
+        self.assertTrue(self.endpoint.replies.wait(2.0))
+        reply_id, meta, data = self.endpoint.replies.peek()
+        data.release()
+        self.endpoint.replies.pop()
+        self.assertEqual(reply_id, record_id)
+        return json.loads(meta)
+
+    def test_round_trip(self):
+        """
+        Every request reaches the handler with its raw payload, and its reply
+        comes back with the same id, across many wraps of the rings.
+        """
+        def handler(message, payload):
+            return {"type": "task_result", "data": {"seq": message["data"]["seq"],
+                "length": len(payload), "sum": sum(bytes(payload))}}
+
+        self.serve(handler)
+        for seq in range(200):
+            payload = bytes((seq + i) % 256 for i in range(seq * 7 % 900))
+            reply = self.call(seq, {"type": "task_request", "data": {"seq": seq}}, payload)
+            self.assertEqual(reply["data"], {"seq": seq, "length": len(payload), "sum": sum(payload)})
+
+    def test_handler_error(self):
+        """
+        A handler which raises gets an error reply, and the next request is served.
+        """
+        def handler(message, payload):
+            if message["data"].get("fail"):
+                raise ValueError("bad segment")
+            return {"type": "task_result", "data": {}}
+
+        self.serve(handler)
+        reply = self.call(1, {"type": "task_request", "data": {"fail": True}}, b"\x00\x01")
+        self.assertEqual(reply["type"], "error")
+        self.assertEqual(reply["data"]["message"], "bad segment")
+        self.assertEqual(self.call(2, {"type": "task_request", "data": {}}, b"")["type"], "task_result")
+
+    def test_full_ring(self):
+        """
+        A record larger than half the ring is refused, and a full ring refuses
+        records until the consumer pops.
+        """
+        requests = self.endpoint.requests
+
+        self.assertFalse(requests.push(1, b"{}", bytes(3000)))
+        pushed = 0
+        while requests.push(pushed, b"{}", bytes(500)):
+            pushed += 1
+        self.assertGreater(pushed, 0)
+        self.assertTrue(requests.wait(0.01))
+        record_id, _, payload = requests.peek()
+        payload.release()
+        requests.pop()
+        self.assertEqual(record_id, 0)
+        self.assertTrue(requests.push(pushed, b"{}", bytes(500)))
+
+
+if __name__ == "__main__":
+    unittest.main()
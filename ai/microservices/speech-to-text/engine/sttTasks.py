@@ -0,0 +1,73 @@
+##
+## Talkup Project, 2025
+## TalkUp.AI
+## File description:
+## This module answers the task_request of the AI Server: single audio
+## segments (the warmup task) and batches of segments of many sessions.
+##
+
+import base64
+import json
+import time
+
+from vosk import Model, KaldiRecognizer
+
+DEFAULT_SAMPLE_RATE = 16000
+
+class STTTasks():
+    def __init__(self, model_type: str):
+        """
+        Class constructor
+        """
+        self.model: Model = Model(lang=model_type)
+
+    def transcribe(self, samples: bytes, sample_rate: int = DEFAULT_SAMPLE_RATE) -> dict:
+        """
+        Transcribe one segment of 16-bit mono PCM.
+        Returns the text and its words with their start and end, in seconds
+        from the start of the segment.
+        """
+        rec = KaldiRecognizer(self.model, sample_rate)
+
+        rec.SetWords(True)
+        rec.AcceptWaveform(bytes(samples))
+        result = json.loads(rec.FinalResult())
+        return {"text": result.get("text", ""), "result": result.get("result", [])}
+
+    def handle(self, message: dict, samples) -> dict:
+        """
+        Answer a task_request whose samples are given raw (shared memory, or
+        decoded from data.payload). A batch gets one result per segment,
+        tagged with its id.
+        """
+        data = message.get("data") or {}
+        batch = data.get("batch")
+
+        if batch is None:
+            result = self.transcribe(samples, data.get("sample_rate", DEFAULT_SAMPLE_RATE))
+            return self._task_result(result)
+        results = []
+        for item in batch:
+            # Prosody items carry no samples: only the analyzers read them.
+            if item.get("format") != "audio/pcm16":
+                continue
+            start = item["offset"]
+            result = self.transcribe(samples[start:start + item["length"]],
+                item.get("sample_rate", DEFAULT_SAMPLE_RATE))
+            result.update({"id": item["id"], "stream_id": item.get("stream_id"),
+                "seq": item.get("seq")})
+            results.append(result)
+        return self._task_result({"results": results})
+
+    def handle_json(self, message: dict) -> dict:
+        """
+        Answer a task_request received over HTTP, its samples in Base64 in data.payload.
+        """
+        data = message.get("data") or {}
+        samples = base64.b64decode(data.get("payload", ""))
+
+        return self.handle(message, samples)
+
+    def _task_result(self, data: dict) -> dict:
+        return {"services": ["stt"], "type": "task_result",
+            "timestamp": int(time.time()), "data": data}
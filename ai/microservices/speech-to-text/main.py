@@ -5,12 +5,65 @@
 ## This is the main.py of the speech-to-text microservice.
 ##
 
+import os
+import sys
+import threading
+
+from flask import Flask, jsonify, request
+
 import engine.sttServices
+import engine.sttTasks
+
+def create_app(tasks: engine.sttTasks.STTTasks) -> Flask:
+    """
+    The task endpoint of the AI Server: POST /task, single or batched.
+    """
+    app = Flask(__name__)
+
+    @app.post("/task")
+    def task():
+        message = request.get_json(silent=True)
+
+        if not isinstance(message, dict):
+            return jsonify({"type": "error", "data": {"message": "invalid json"}}), 400
+        try:
+            return jsonify(tasks.handle_json(message))
+        except (KeyError, TypeError, ValueError) as e:
+            return jsonify({"type": "error", "data": {"message": str(e)}}), 400
+
+    return app
+
+def start_shm(tasks: engine.sttTasks.STTTasks):
+    """
+    Serve the AI Server over shared memory too, when it runs on the same host:
+    the segment is the "Shm" value of services.json. Returns None without /dev/shm
+    or outside of the image, where network/ isn't next to main.py.
+    """
+    try:
+        from network.shm_ring import ShmEndpoint
+
+        endpoint = ShmEndpoint(os.environ.get("SHM_NAME", "talkup_stt"))
+    except (ImportError, OSError) as e:
+        print(f"[STT] Shared memory disabled: {e}", file=sys.stderr)
+        return None
+    threading.Thread(target=endpoint.serve, args=(tasks.handle,), daemon=True).start()
+    return endpoint
 
 def main() -> bool:
-    stt = engine.sttServices.STT("fr")
+    # --mic transcribes the local microphone instead of serving the AI Server.
+    if "--mic" in sys.argv:
+        stt = engine.sttServices.STT("fr")
+
+        stt.start_stt_process()
+        return True
+    tasks = engine.sttTasks.STTTasks("fr")
+    endpoint = start_shm(tasks)
 
-    stt.start_stt_process()
+    try:
+        create_app(tasks).run(host="0.0.0.0", port=int(os.environ.get("PORT", 5000)), threaded=True)
+    finally:
+        if endpoint is not None:
+            endpoint.close()
     return True
 
 if __name__ == "__main__":